@@ -0,0 +1,681 @@
+// Standalone benchmark for the Grappolo clustering engine.
+//
+// Usage: fastpg_bench [bench options] [clustering options] <graph file>
+//        fastpg_bench [bench options] [clustering options] --generate=<model>[,key=value...]
+//
+// The options and their values are listed by fastpg_bench --help (usage() below).
+// Clustering options are those of clustering_parameters::parse(); the variant
+// decides the kernel, so -c/-y/-b/-n are ignored.
+//
+// The drivers do not free their input graph, so runs share one copy of it; the
+// sync variants, which sort adjacency lists in place, get a private copy.
+// The JSON output has one
+// record per timed run (time, iterations, phases, clusters, modularity of the
+// final clustering on the input graph) and a summary per variant and thread count.
+
+#include "defs.h"
+#include "input_output.h"
+#include "basic_util.h"
+#include "basic_comm.h"
+#include "color_comm.h"
+#include "sync_comm.h"
+#include "utilityClusteringFunctions.h"
+#include "parallel_sort.h"
+#include <string>
+#include <algorithm>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum driverType { DriverBasic, DriverColoring, DriverSync, DriverApprox, DriverFastTrack };
+
+struct variant {
+  const char *name;
+  driverType driver;
+  int option;     //basicOpt, coloring, syncType or sampling
+  int threadsOpt; //Basic kernels: 1 for parallelLouvianMethod, 0 for the Scale kernel
+};
+
+static const variant allVariants[] = {
+  {"basic",     DriverBasic,     0, 1},
+  {"nomap",     DriverBasic,     1, 1},
+  {"scale",     DriverBasic,     0, 0},
+  {"color1",    DriverColoring,  1, 1},
+  {"color2",    DriverColoring,  2, 1},
+  {"color3",    DriverColoring,  3, 1},
+  {"color4",    DriverColoring,  4, 1},
+  {"sync1",     DriverSync,      1, 1},
+  {"sync2",     DriverSync,      2, 1},
+  {"sync3",     DriverSync,      3, 1},
+  {"sync4",     DriverSync,      4, 1},
+  {"approx",    DriverApprox,    SampleUniform, 1},
+  {"approxdeg", DriverApprox,    SampleDegree,  1},
+  {"approxgain", DriverApprox,   SampleGain,    1},
+  {"fasttrack", DriverFastTrack, 0, 1}
+};
+static const int numVariants = sizeof(allVariants) / sizeof(variant);
+
+struct benchRun {
+  const variant *v;
+  int threads;
+  int rep;
+  double time;
+  long iterations;
+  long phases;
+  long clusters;
+  double modularity;
+  double fScore;  //Against the planted communities, if any
+  double nmi;
+  long cacheMisses; //-1 if not counted
+  long remoteMisses;
+};
+
+static const char *reorderNames[] = {"none", "rcm", "degree", "community"};
+static const char *bindNames[] = {"none", "close", "spread"};
+
+//Index of value in names, which may also be given by its number as in the R API
+//(reorder = 1, bind_threads(2)); -1 if unknown
+static int lookupName(const std::string &value, const char *const *names, int numNames) {
+  for (int j=0; j<numNames; j++)
+    if ((value == names[j]) || (value == std::to_string(j)))
+      return j;
+  return -1;
+}
+
+//Hardware events of the threads of a parallel region: every thread of the
+//region opens a counter for itself, as the OpenMP threads already exist
+struct cacheMissCounter {
+  std::vector<int> fds;
+
+  //All last-level cache misses, or with remote only the loads that miss the
+  //local memory node
+  bool open(int nThreads, bool remote = false) {
+    fds.assign(nThreads, -1);
+#ifdef __linux__
+#pragma omp parallel num_threads(nThreads)
+    {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = remote ? PERF_TYPE_HW_CACHE : PERF_TYPE_HARDWARE;
+      attr.config = remote ? (PERF_COUNT_HW_CACHE_NODE | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+                           : PERF_COUNT_HW_CACHE_MISSES;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fds[omp_get_thread_num()] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+    for (size_t t=0; t<fds.size(); t++)
+      if (fds[t] < 0) {
+        close();
+        return false;
+      }
+    return true;
+  }
+  void enable(bool on) {
+#ifdef __linux__
+    for (size_t t=0; t<fds.size(); t++) {
+      if (on)
+        ioctl(fds[t], PERF_EVENT_IOC_RESET, 0);
+      ioctl(fds[t], on ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+    }
+#endif
+  }
+  long total() {
+    long sum = 0;
+#ifdef __linux__
+    for (size_t t=0; t<fds.size(); t++) {
+      long long count = 0;
+      if (read(fds[t], &count, sizeof(count)) != sizeof(count))
+        return -1;
+      sum += (long) count;
+    }
+#endif
+    return sum;
+  }
+  void close() {
+#ifdef __linux__
+    for (size_t t=0; t<fds.size(); t++)
+      if (fds[t] >= 0)
+        ::close(fds[t]);
+#endif
+    fds.clear();
+  }
+};
+
+static std::vector<std::string> splitList(const std::string &list) {
+  std::vector<std::string> items;
+  size_t start = 0;
+  while (start <= list.size()) {
+    size_t end = list.find(',', start);
+    if (end == std::string::npos)
+      end = list.size();
+    if (end > start)
+      items.push_back(list.substr(start, end - start));
+    start = end + 1;
+  }
+  return items;
+}
+
+//Value of key in a generator spec, or def if the key is absent
+static double specValue(const std::vector<std::string> &items, const char *key, double def) {
+  std::string prefix = std::string(key) + "=";
+  for (size_t i=1; i<items.size(); i++)
+    if (items[i].compare(0, prefix.size(), prefix) == 0)
+      return atof(items[i].c_str() + prefix.size());
+  return def;
+}
+
+//Build the graph described by spec into G and its planted communities into *truth.
+//Return the number of communities, or -1 on errors.
+static long generateGraph(const std::string &spec, graph *G, long **truth) {
+  std::vector<std::string> items = splitList(spec);
+  const char *keys[] = {"n", "k", "deg", "mu", "maxdeg", "t1", "t2", "minc", "maxc",
+                        "dim", "comps", "sep", "knn", "seed"};
+  for (size_t i=1; i<items.size(); i++) {
+    bool known = false;
+    for (size_t j=0; j<sizeof(keys)/sizeof(keys[0]); j++)
+      if (items[i].compare(0, strlen(keys[j]) + 1, std::string(keys[j]) + "=") == 0)
+        known = true;
+    if (!known) {
+      fprintf(stderr, "Unknown generator parameter: %s\n", items[i].c_str());
+      return -1;
+    }
+  }
+  long NV = (long) specValue(items, "n", 100000);
+  unsigned long long seed = (unsigned long long) specValue(items, "seed", 1);
+  if (NV < 2) {
+    fprintf(stderr, "Generated graphs need at least two vertices\n");
+    return -1;
+  }
+  *truth = (long *) malloc (NV * sizeof(long)); assert(*truth != 0);
+  long numCommunities = -1;
+  std::string model = items.empty() ? "" : items[0];
+  if (model == "sbm")
+    numCommunities = generatePlantedPartition(G, *truth, NV, (long) specValue(items, "k", 100),
+                                              specValue(items, "deg", 16), specValue(items, "mu", 0.3), seed);
+  else if (model == "lfr")
+    numCommunities = generateLFR(G, *truth, NV, specValue(items, "deg", 20), (long) specValue(items, "maxdeg", 50),
+                                 specValue(items, "mu", 0.3), specValue(items, "t1", 2), specValue(items, "t2", 1),
+                                 (long) specValue(items, "minc", 20), (long) specValue(items, "maxc", 100), seed);
+  else if (model == "gmm")
+    numCommunities = generateGaussianMixtureKNN(G, *truth, NV, (int) specValue(items, "dim", 10),
+                                                (long) specValue(items, "comps", 20), specValue(items, "sep", 4),
+                                                (int) specValue(items, "knn", 15), seed);
+  else
+    fprintf(stderr, "Unknown generator: %s (sbm, lfr or gmm)\n", model.c_str());
+  if (numCommunities < 0) {
+    free(*truth);
+    *truth = NULL;
+  }
+  return numCommunities;
+}//End of generateGraph()
+
+//Cluster G with variant v
+static void runVariant(const variant *v, graph *G0, long *truth, clustering_parameters &opts, int nThreads,
+                       bool countCacheMisses, bool countRemoteMisses, benchRun *r) {
+  long NV = G0->numVertices;
+  //The full-sync kernels sort the adjacency lists of their input: give them a
+  //copy so that the variants run after them see the same graph
+  graph *G = G0;
+  if (v->driver == DriverSync) {
+    G = (graph *) malloc (sizeof(graph)); assert(G != 0);
+    duplicateGivenGraph(G0, G);
+  }
+  long *C_orig = (long *) malloc (NV * sizeof(long)); assert(C_orig != 0);
+#pragma omp parallel for
+  for (long i=0; i<NV; i++) {
+    C_orig[i] = -1;
+  }
+  clusteringStats stats;
+  omp_set_num_threads(nThreads);
+  cacheMissCounter counter, remoteCounter;
+  bool counting = countCacheMisses && counter.open(nThreads);
+  bool countingRemote = countRemoteMisses && remoteCounter.open(nThreads, true);
+  if (counting)
+    counter.enable(true);
+  if (countingRemote)
+    remoteCounter.enable(true);
+
+  double time1 = omp_get_wtime();
+  switch (v->driver) {
+    case DriverBasic:
+      runMultiPhaseBasic(G, C_orig, v->option, opts.minGraphSize, opts.threshold, opts.C_thresh,
+                         nThreads, v->threadsOpt, &stats);
+      break;
+    case DriverColoring:
+      runMultiPhaseColoring(G, C_orig, v->option, opts.numColors, opts.replaceMap ? 1 : 0, opts.minGraphSize,
+                            opts.threshold, opts.C_thresh, nThreads, v->threadsOpt, 0, &stats);
+      break;
+    case DriverSync:
+      runMultiPhaseSyncType(G, C_orig, v->option, opts.minGraphSize, opts.threshold, opts.C_thresh,
+                            nThreads, v->threadsOpt, &stats);
+      break;
+    case DriverApprox:
+      runMultiPhaseBasicApprox(G, C_orig, 1, opts.minGraphSize, opts.threshold, opts.C_thresh,
+                               nThreads, v->threadsOpt, opts.percentage, v->option, &stats);
+      break;
+    case DriverFastTrack:
+      runMultiPhaseBasicFastTrackResistance(G, C_orig, v->option, opts.minGraphSize, opts.threshold,
+                                            opts.C_thresh, nThreads, v->threadsOpt, &stats);
+      break;
+  }
+  r->time = omp_get_wtime() - time1;
+  r->cacheMisses = -1;
+  if (counting) {
+    counter.enable(false);
+    r->cacheMisses = counter.total();
+    counter.close();
+  }
+  r->remoteMisses = -1;
+  if (countingRemote) {
+    remoteCounter.enable(false);
+    r->remoteMisses = remoteCounter.total();
+    remoteCounter.close();
+  }
+  logFlush();
+  if (G != G0) {
+    freeGraph(G);
+  }
+
+  r->iterations = 0;
+  for (size_t p=0; p<stats.size(); p++)
+    r->iterations += stats[p].numIterations;
+  r->phases = stats.size();
+  long maxCluster = -1;
+  for (long i=0; i<NV; i++)
+    maxCluster = max(maxCluster, C_orig[i]);
+  r->clusters = maxCluster + 1;
+  r->modularity = computeModularity(G0, C_orig);
+  r->fScore = -1;
+  r->nmi = -1;
+  if (truth != NULL) {
+    double precision, recall;
+    computeCommunityComparisonScores(truth, C_orig, NV, &precision, &recall, &r->fScore, &r->nmi);
+  }
+  free(C_orig);
+}//End of runVariant()
+
+//Free a graph that was read, generated or opened from a CSR file
+static void freeBenchGraph(graph *G, csrFile *file) {
+  if (file->base != NULL)
+    closeGraphCSR(G, file); //Leaves the graph arrays NULL
+  freeGraph(G);
+}
+
+//Replace *G with its vertices renumbered by old2New, and the planted communities
+//with them
+static void renumberBenchGraph(graph **G, csrFile *file, long *truth, const long *old2New) {
+  long NV = (*G)->numVertices;
+  graph *Gnew = (graph *) malloc (sizeof(graph)); assert(Gnew != 0);
+  permuteGraph(*G, Gnew, old2New);
+  freeBenchGraph(*G, file);
+  *G = Gnew;
+  if (truth != NULL) {
+    std::vector<long> old(truth, truth + NV);
+#pragma omp parallel for
+    for (long i=0; i<NV; i++)
+      truth[old2New[i]] = old[i];
+  }
+}//End of renumberBenchGraph()
+
+static double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  size_t n = values.size();
+  return (n % 2) ? values[n/2] : 0.5 * (values[n/2 - 1] + values[n/2]);
+}
+
+static void writeJson(FILE *out, const char *fileName, graph *G, long numCommunities, int reorder,
+                      double reorderTime, int bind, bool cacheMisses, bool remoteMisses,
+                      const std::vector<benchRun> &runs, int reps, int warmup) {
+  fprintf(out, "{\n  \"graph\": \"%s\",\n  \"numVertices\": %ld,\n  \"numEdges\": %ld,\n",
+          fileName, G->numVertices, G->numEdges);
+  fprintf(out, "  \"reorder\": \"%s\",\n  \"reorderTime\": %.6f,\n", reorderNames[reorder], reorderTime);
+  fprintf(out, "  \"bind\": \"%s\",\n", bindNames[bind]);
+  if (numCommunities >= 0)
+    fprintf(out, "  \"plantedCommunities\": %ld,\n", numCommunities);
+  fprintf(out, "  \"reps\": %d,\n  \"warmup\": %d,\n  \"runs\": [\n", reps, warmup);
+  for (size_t i=0; i<runs.size(); i++) {
+    const benchRun &r = runs[i];
+    fprintf(out, "    {\"variant\": \"%s\", \"threads\": %d, \"rep\": %d, \"time\": %.6f, "
+            "\"iterations\": %ld, \"phases\": %ld, \"clusters\": %ld, \"modularity\": %.6f",
+            r.v->name, r.threads, r.rep, r.time, r.iterations, r.phases, r.clusters, r.modularity);
+    if (numCommunities >= 0)
+      fprintf(out, ", \"fScore\": %.6f, \"nmi\": %.6f", r.fScore, r.nmi);
+    if (cacheMisses)
+      fprintf(out, ", \"cacheMisses\": %ld", r.cacheMisses);
+    if (remoteMisses)
+      fprintf(out, ", \"remoteMisses\": %ld", r.remoteMisses);
+    fprintf(out, "}%s\n", (i+1 < runs.size()) ? "," : "");
+  }
+  fprintf(out, "  ],\n  \"summary\": [\n");
+  //Runs of one (variant, threads) pair are consecutive
+  size_t first = 0;
+  while (first < runs.size()) {
+    size_t last = first;
+    while ((last < runs.size()) && (runs[last].v == runs[first].v) && (runs[last].threads == runs[first].threads))
+      last++;
+    std::vector<double> times;
+    double sumTime = 0, sumMod = 0, sumItr = 0, sumF = 0, sumNmi = 0, sumMisses = 0, sumRemote = 0;
+    for (size_t i=first; i<last; i++) {
+      times.push_back(runs[i].time);
+      sumTime += runs[i].time;
+      sumMod += runs[i].modularity;
+      sumItr += runs[i].iterations;
+      sumF += runs[i].fScore;
+      sumNmi += runs[i].nmi;
+      sumMisses += runs[i].cacheMisses;
+      sumRemote += runs[i].remoteMisses;
+    }
+    double n = (double) (last - first);
+    fprintf(out, "    {\"variant\": \"%s\", \"threads\": %d, \"timeMin\": %.6f, \"timeMedian\": %.6f, "
+            "\"timeMean\": %.6f, \"iterationsMean\": %.2f, \"modularityMean\": %.6f",
+            runs[first].v->name, runs[first].threads, *std::min_element(times.begin(), times.end()),
+            median(times), sumTime / n, sumItr / n, sumMod / n);
+    if (numCommunities >= 0)
+      fprintf(out, ", \"fScoreMean\": %.6f, \"nmiMean\": %.6f", sumF / n, sumNmi / n);
+    if (cacheMisses)
+      fprintf(out, ", \"cacheMissesMean\": %.0f", sumMisses / n);
+    if (remoteMisses)
+      fprintf(out, ", \"remoteMissesMean\": %.0f", sumRemote / n);
+    fprintf(out, "}%s\n", (last < runs.size()) ? "," : "");
+    first = last;
+  }
+  fprintf(out, "  ]\n}\n");
+}//End of writeJson()
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+    "Usage: %s [bench options] [clustering options] <graph file>\n"
+    "       %s [bench options] [clustering options] --generate=<model>[,key=value...]\n"
+    "\n"
+    "Bench options:\n"
+    "  --variants=<list>  Comma separated kernel variants, or \"all\" (default: basic)\n"
+    "                     basic, nomap, scale, color1, color2, color3, color4,\n"
+    "                     sync1, sync2, sync3, sync4, approx, approxdeg, approxgain,\n"
+    "                     fasttrack\n"
+    "  --threads=<list>   Comma separated thread counts, or \"sweep\" for powers of two\n"
+    "                     up to the number of available threads (default: all threads)\n"
+    "  --reps=<n>         Timed repetitions per variant and thread count (default: 3)\n"
+    "  --warmup=<n>       Untimed runs before the timed ones (default: 1)\n"
+    "  --json=<file>      Write the results to <file> instead of stdout\n"
+    "  --verbose=<0-4>    Verbosity of the clustering code (default: 0)\n"
+    "  --write-binary=<file>  Write the graph in binary CSR format (-f 7) and exit\n"
+    "  --write-csr=<file>[,<0|4|8>]  Write the graph in FastPG CSR format (-f 9) and\n"
+    "                     exit; 0 (default) for edge records, 4 or 8 for index bytes\n"
+    "  --ingest=<file>    Convert the SNAP edge list (-f 8) to FastPG CSR <file> without\n"
+    "                     holding the graph in memory, then cluster that file\n"
+    "  --ingest-memory=<MB>  Temporary memory the text parsers may use besides the graph\n"
+    "                     (default: a quarter of the physical memory); above it the\n"
+    "                     file is parsed again in every pass instead of being stored\n"
+    "  --shuffle=<seed>   Renumber the vertices in a random order first, as in a kNN\n"
+    "                     graph of cells listed in input order\n"
+    "  --reorder=<order>  Renumber the vertices for locality before the runs, by name or\n"
+    "                     by the number of the R argument reorder: none or 0 (default),\n"
+    "                     rcm or 1, degree or 2, community or 3\n"
+    "  --cache-misses     Count the hardware cache misses of every run (Linux perf\n"
+    "                     events; reported as -1 where they are not available)\n"
+    "  --remote-misses    Count the loads of every run served by another memory node\n"
+    "                     (NUMA node misses, Linux perf events; -1 if not available)\n"
+    "  --bind=<mode>      Pin the threads to CPUs, as bind_threads(): none or 0\n"
+    "                     (default), close or 1, spread or 2\n"
+    "  --generate=<spec>  Cluster a synthetic graph with planted communities instead of\n"
+    "                     a file; runs then also report the F-score and NMI against them.\n"
+    "                     sbm,n=100000,k=100,deg=16,mu=0.3\n"
+    "                     lfr,n=100000,deg=20,maxdeg=50,mu=0.3,t1=2,t2=1,minc=20,maxc=100\n"
+    "                     gmm,n=100000,dim=10,comps=20,sep=4,knn=15\n"
+    "                     Omitted keys take the values above; seed=<n> picks the graph.\n"
+    "  --help, -h         Print this message\n"
+    "\n"
+    "Clustering options:\n"
+    "  -f <1|3|5|7|8|9>   Input format: 1 Matrix Market, 3 Pajek, 5 METIS, 7 binary,\n"
+    "                     8 SNAP edge list (default), 9 FastPG CSR\n"
+    "  -m <int>           Minimum graph size (default: 1000)\n"
+    "  -d <float>         C_thresh, the threshold of the colored phases (default: 1e-6)\n"
+    "  -t <float>         Threshold (default: 1e-9)\n"
+    "  -p <int>           Number of colors of color3 (default: 16)\n"
+    "  -x <1-100>         Percentage of the approx variants (default: 80)\n"
+    "  The variant decides the kernel, so -c, -y, -b and -n are ignored.\n",
+    prog, prog);
+}//End of usage()
+
+int main(int argc, char *argv[]) {
+  std::string variantList = "basic", threadList, jsonFile, binaryFile, csrFileName, generateSpec;
+  std::string ingestFile;
+  long ingestMemory = 0, shuffleSeed = -1;
+  int reps = 3, warmup = 1, verbosity = 0, reorder = ReorderNone, bind = BindNone;
+  bool cacheMisses = false, remoteMisses = false;
+
+  //Take out the bench options, pass the rest to clustering_parameters::parse()
+  std::vector<char *> clusterArgs;
+  clusterArgs.push_back(argv[0]);
+  for (int i=1; i<argc; i++) {
+    std::string arg(argv[i]);
+    size_t eq = arg.find('=');
+    std::string key = arg.substr(0, eq), value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+    if ((arg == "--help") || (arg == "-h")) {
+      usage(argv[0]);
+      return 0;
+    }
+    else if (key == "--variants")     variantList = value;
+    else if (key == "--threads")      threadList = value;
+    else if (key == "--reps")         reps = atoi(value.c_str());
+    else if (key == "--warmup")       warmup = atoi(value.c_str());
+    else if (key == "--json")         jsonFile = value;
+    else if (key == "--verbose")      verbosity = atoi(value.c_str());
+    else if (key == "--write-binary") binaryFile = value;
+    else if (key == "--write-csr")    csrFileName = value;
+    else if (key == "--generate")     generateSpec = value;
+    else if (key == "--ingest")       ingestFile = value;
+    else if (key == "--ingest-memory") ingestMemory = atol(value.c_str());
+    else if (key == "--shuffle")      shuffleSeed = atol(value.c_str());
+    else if (key == "--cache-misses") cacheMisses = true;
+    else if (key == "--remote-misses") remoteMisses = true;
+    else if (key == "--bind") {
+      bind = lookupName(value, bindNames, 3);
+      if (bind < 0) {
+        fprintf(stderr, "Unknown thread binding: %s (none, close or spread, or 0-2)\n", value.c_str());
+        return 1;
+      }
+    }
+    else if (key == "--reorder") {
+      reorder = lookupName(value, reorderNames, 4);
+      if (reorder < 0) {
+        fprintf(stderr, "Unknown vertex order: %s (none, rcm, degree or community, or 0-3)\n", value.c_str());
+        return 1;
+      }
+    }
+    else if (arg.compare(0, 2, "--") == 0) {
+      fprintf(stderr, "Unknown option: %s\n\n", argv[i]);
+      usage(argv[0]);
+      return 1;
+    }
+    else clusterArgs.push_back(argv[i]);
+  }
+  setLogLevel(verbosity);
+  setIngestMemoryLimit(ingestMemory << 20);
+  //Before the graph is built, so that its pages are placed for the pinned threads
+  if ((bind != BindNone) && (bindThreads(bind, NULL) < 0)) {
+    fprintf(stderr, "Could not bind the threads\n");
+    return 1;
+  }
+  if (reps < 1 || warmup < 0) {
+    fprintf(stderr, "--reps must be positive and --warmup non-negative\n");
+    return 1;
+  }
+
+  //A generated graph stands in for the file name
+  if (!generateSpec.empty())
+    clusterArgs.push_back(const_cast<char *>(generateSpec.c_str()));
+
+  clustering_parameters opts;
+  if (!opts.parse((int) clusterArgs.size(), clusterArgs.data())) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  //Variants
+  std::vector<const variant *> variants;
+  std::vector<std::string> names = splitList(variantList);
+  for (size_t i=0; i<names.size(); i++) {
+    bool found = false;
+    for (int j=0; j<numVariants; j++) {
+      if ((names[i] == "all") || (names[i] == allVariants[j].name)) {
+        variants.push_back(&allVariants[j]);
+        found = true;
+      }
+    }
+    if (!found) {
+      fprintf(stderr, "Unknown variant: %s\n", names[i].c_str());
+      return 1;
+    }
+  }
+
+  //Thread counts
+  int maxThreads = omp_get_max_threads();
+  std::vector<int> threads;
+  if (threadList.empty()) {
+    threads.push_back(maxThreads);
+  } else if (threadList == "sweep") {
+    for (int t=1; t<maxThreads; t*=2)
+      threads.push_back(t);
+    threads.push_back(maxThreads);
+  } else {
+    std::vector<std::string> items = splitList(threadList);
+    for (size_t i=0; i<items.size(); i++) {
+      int t = atoi(items[i].c_str());
+      if (t < 1) {
+        fprintf(stderr, "Invalid thread count: %s\n", items[i].c_str());
+        return 1;
+      }
+      threads.push_back(t);
+    }
+  }
+
+  //Load or generate the graph
+  graph *G = (graph *) malloc (sizeof(graph)); assert(G != 0);
+  char *fileName = const_cast<char *>(opts.inFile);
+  long *truth = NULL;
+  long numCommunities = -1;
+  csrFile file;
+  file.base = NULL;
+  double time1 = omp_get_wtime();
+  bool loaded;
+  if (!generateSpec.empty()) {
+    numCommunities = generateGraph(generateSpec, G, &truth);
+    loaded = (numCommunities >= 0);
+  } else if (!ingestFile.empty()) {
+    if (opts.ftype != 8) {
+      fprintf(stderr, "--ingest reads SNAP edge lists (-f 8) only\n");
+      free(G);
+      return 1;
+    }
+    loaded = ingestSNAPToCSR(fileName, ingestFile.c_str()) && openGraphCSR(G, ingestFile.c_str(), &file);
+  } else {
+    switch (opts.ftype) {
+      case 1:  loaded = parse_MatrixMarket(G, fileName); break;
+      case 3:  loaded = parse_PajekFormat(G, fileName); break;
+      case 5:  loaded = loadMetisFileFormat(G, fileName); break;
+      case 7:  loaded = parse_EdgeListBinaryNew(G, fileName); break;
+      case 9:  loaded = openGraphCSR(G, fileName, &file); break;
+      default: loaded = parse_SNAP(G, fileName); break;
+    }
+  }
+  if (!loaded) {
+    free(G);
+    return 1;
+  }
+  fprintf(stderr, "%s %s: |V|= %ld |E|= %ld in %.3f sec\n", generateSpec.empty() ? "Loaded" : "Generated",
+          fileName, G->numVertices, G->numEdges, omp_get_wtime() - time1);
+  if (!binaryFile.empty() || !csrFileName.empty()) {
+    bool written;
+    if (!binaryFile.empty()) {
+      written = writeGraphBinaryFormatNew(G, const_cast<char *>(binaryFile.c_str()), 1);
+    } else {
+      std::vector<std::string> items = splitList(csrFileName);
+      int indexBytes = (items.size() > 1) ? atoi(items[1].c_str()) : 0;
+      written = writeGraphCSR(G, items.empty() ? "" : items[0].c_str(), indexBytes,
+                              (file.base != NULL) ? file.vertexIds : NULL);
+    }
+    freeBenchGraph(G, &file);
+    free(truth);
+    return written ? 0 : 1;
+  }
+
+  //Random order, then the order to measure
+  long NV = G->numVertices;
+  long *old2New = (long *) malloc (NV * sizeof(long)); assert(old2New != 0);
+  if (shuffleSeed >= 0) {
+#pragma omp parallel for
+    for (long i=0; i<NV; i++)
+      old2New[i] = i;
+    parallelSort(old2New, NV, [=](long a, long b) {
+        unsigned long long ka = hashRandom(a, shuffleSeed, 0), kb = hashRandom(b, shuffleSeed, 0);
+        return (ka < kb) || ((ka == kb) && (a < b));
+      });
+    std::vector<long> order(old2New, old2New + NV);
+#pragma omp parallel for
+    for (long i=0; i<NV; i++)
+      old2New[order[i]] = i;
+    renumberBenchGraph(&G, &file, truth, old2New);
+  }
+  double reorderTime = 0;
+  if (reorder != ReorderNone) {
+    time1 = omp_get_wtime();
+    reorderVertices(G, old2New, reorder);
+    renumberBenchGraph(&G, &file, truth, old2New);
+    reorderTime = omp_get_wtime() - time1;
+    fprintf(stderr, "Reordered (%s) in %.3f sec\n", reorderNames[reorder], reorderTime);
+  }
+  free(old2New);
+
+  std::vector<benchRun> runs;
+  for (size_t t=0; t<threads.size(); t++) {
+    if (bind != BindNone) { //Rebind for the size of the team
+      omp_set_num_threads(threads[t]);
+      bindThreads(bind, NULL);
+    }
+    for (size_t v=0; v<variants.size(); v++) {
+      for (int rep = -warmup; rep < reps; rep++) {
+        benchRun r;
+        r.v = variants[v];
+        r.threads = threads[t];
+        r.rep = rep;
+        runVariant(variants[v], G, truth, opts, threads[t], cacheMisses, remoteMisses, &r);
+        fprintf(stderr, "%-10s threads= %3d %s %3d  time= %9.4f  itrs= %5ld  mod= %.6f", r.v->name, r.threads,
+                (rep < 0) ? "warmup" : "rep   ", (rep < 0) ? rep + warmup : rep, r.time, r.iterations, r.modularity);
+        if (truth != NULL)
+          fprintf(stderr, "  F= %.4f  NMI= %.4f", r.fScore, r.nmi);
+        if (cacheMisses)
+          fprintf(stderr, "  misses= %ld", r.cacheMisses);
+        if (remoteMisses)
+          fprintf(stderr, "  remote= %ld", r.remoteMisses);
+        fprintf(stderr, "\n");
+        if (rep >= 0)
+          runs.push_back(r);
+      }
+    }
+  }
+
+  FILE *out = stdout;
+  if (!jsonFile.empty()) {
+    out = fopen(jsonFile.c_str(), "w");
+    if (out == NULL) {
+      fprintf(stderr, "Could not open %s\n", jsonFile.c_str());
+      return 1;
+    }
+  }
+  writeJson(out, opts.inFile, G, numCommunities, reorder, reorderTime, bind, cacheMisses, remoteMisses, runs, reps,
+            warmup);
+  if (out != stdout)
+    fclose(out);
+
+  freeBenchGraph(G, &file);
+  free(truth);
+  return 0;
+}
@@ -0,0 +1,252 @@
+// Micro-benchmarks of the priority queues of dataStructureHeap.h.
+//
+// Usage: heap_bench [--n=<vertices>] [--reps=<n>] [--seed=<n>]
+//
+// Compares the binary heap of terms (heapAdd()/heapRemoveMin()) with the
+// indexed dAryHeap for D = 2, 4 and 8 and with the bucketQueue, on three
+// workloads:
+//   sort      push n random keys, then remove them all
+//   dijkstra  shortest paths on a kNN graph of n vertices (Gaussian mixture,
+//             15 neighbors). heap has no decrease-key: a vertex is added again
+//             when its distance drops and stale entries are skipped
+//   degree    smallest-last order of the same graph (repeatedly remove a vertex
+//             of smallest remaining degree), the order of degree-based colorings
+// Each line reports the best time over the repetitions and a checksum that must
+// agree between the queues of a workload.
+
+#include "defs.h"
+#include "input_output.h"
+#include "basic_util.h"
+#include "dataStructureHeap.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+
+//Best time of reps runs of f(), which returns the checksum
+template <typename F>
+static void timeIt(const char *workload, const char *queue, int reps, F f) {
+  double best = 1e30, check = 0;
+  for (int r=0; r<reps; r++) {
+    double time1 = omp_get_wtime();
+    check = f();
+    best = std::min(best, omp_get_wtime() - time1);
+  }
+  printf("%-9s %-16s %10.4f s   check %.6g\n", workload, queue, best, check);
+}
+
+static double sortOldHeap(const std::vector<double> &keys) {
+  long n = keys.size();
+  heap h;
+  heapInitializeToN(&h, n);
+  for (long i=0; i<n; i++) {
+    term t = {i, keys[i]};
+    heapAdd(&h, t);
+  }
+  double check = 0, last = -1;
+  while (h.size > 0) {
+    double w = h.elements[0].weight;
+    heapRemoveMin(&h);
+    check += (w >= last); //Count the keys removed in order
+    last = w;
+  }
+  free(h.elements);
+  return check;
+}
+
+template <int D>
+static double sortDAry(const std::vector<double> &keys) {
+  long n = keys.size();
+  dAryHeap<double, D> h(n);
+  for (long i=0; i<n; i++)
+    h.push(i, keys[i]);
+  double check = 0, last = -1;
+  while (!h.empty()) {
+    double w = h.topKey();
+    h.pop();
+    check += (w >= last);
+    last = w;
+  }
+  return check;
+}
+
+static double dijkstraOldHeap(graph *G) {
+  long NV = G->numVertices;
+  long *vtxPtr = G->edgeListPtrs;
+  edge *vtxInd = G->edgeList;
+  std::vector<double> dist(NV, 1e300);
+  heap h;
+  heapInitializeToN(&h, vtxPtr[NV] + 1); //Every edge may add an entry
+  dist[0] = 0;
+  term t = {0, 0};
+  heapAdd(&h, t);
+  while (h.size > 0) {
+    term u = h.elements[0];
+    heapRemoveMin(&h);
+    if (u.weight > dist[u.id])
+      continue; //Stale entry
+    for (long k=vtxPtr[u.id]; k<vtxPtr[u.id+1]; k++) {
+      double d = u.weight + vtxInd[k].weight;
+      if (d < dist[vtxInd[k].tail]) {
+        dist[vtxInd[k].tail] = d;
+        term x = {vtxInd[k].tail, d};
+        heapAdd(&h, x);
+      }
+    }
+  }
+  free(h.elements);
+  double check = 0;
+  for (long i=0; i<NV; i++)
+    if (dist[i] < 1e300) check += dist[i];
+  return check;
+}
+
+template <int D>
+static double dijkstraDAry(graph *G) {
+  long NV = G->numVertices;
+  long *vtxPtr = G->edgeListPtrs;
+  edge *vtxInd = G->edgeList;
+  std::vector<double> dist(NV, 1e300);
+  dAryHeap<double, D> h(NV);
+  dist[0] = 0;
+  h.push(0, 0);
+  while (!h.empty()) {
+    long u = h.top();
+    h.pop();
+    for (long k=vtxPtr[u]; k<vtxPtr[u+1]; k++) {
+      long x = vtxInd[k].tail;
+      double d = dist[u] + vtxInd[k].weight;
+      if (d < dist[x]) {
+        if (h.contains(x)) h.decreaseKey(x, d);
+        else h.push(x, d);
+        dist[x] = d;
+      }
+    }
+  }
+  double check = 0;
+  for (long i=0; i<NV; i++)
+    if (dist[i] < 1e300) check += dist[i];
+  return check;
+}
+
+//Checksum of a smallest-last order: the largest degree met when a vertex is
+//removed (the degeneracy of the graph)
+static double smallestLastOldHeap(graph *G) {
+  long NV = G->numVertices;
+  long *vtxPtr = G->edgeListPtrs;
+  edge *vtxInd = G->edgeList;
+  std::vector<long> degree(NV);
+  std::vector<char> removed(NV, 0);
+  heap h;
+  heapInitializeToN(&h, vtxPtr[NV] + NV + 1);
+  for (long i=0; i<NV; i++) {
+    degree[i] = vtxPtr[i+1] - vtxPtr[i];
+    term t = {i, (double) degree[i]};
+    heapAdd(&h, t);
+  }
+  long degeneracy = 0;
+  while (h.size > 0) {
+    term u = h.elements[0];
+    heapRemoveMin(&h);
+    if (removed[u.id] || (u.weight > degree[u.id]))
+      continue; //Stale entry
+    removed[u.id] = 1;
+    degeneracy = std::max(degeneracy, degree[u.id]);
+    for (long k=vtxPtr[u.id]; k<vtxPtr[u.id+1]; k++) {
+      long x = vtxInd[k].tail;
+      if (!removed[x]) {
+        term t = {x, (double) --degree[x]};
+        heapAdd(&h, t);
+      }
+    }
+  }
+  free(h.elements);
+  return degeneracy;
+}
+
+static double smallestLastDAry(graph *G) {
+  long NV = G->numVertices;
+  long *vtxPtr = G->edgeListPtrs;
+  edge *vtxInd = G->edgeList;
+  dAryHeap<long, 4> h(NV);
+  for (long i=0; i<NV; i++)
+    h.push(i, vtxPtr[i+1] - vtxPtr[i]);
+  long degeneracy = 0;
+  while (!h.empty()) {
+    long u = h.top();
+    degeneracy = std::max(degeneracy, h.topKey());
+    h.pop();
+    for (long k=vtxPtr[u]; k<vtxPtr[u+1]; k++) {
+      long x = vtxInd[k].tail;
+      if (h.contains(x))
+        h.decreaseKey(x, h.key(x) - 1);
+    }
+  }
+  return degeneracy;
+}
+
+static double smallestLastBuckets(graph *G) {
+  long NV = G->numVertices;
+  long *vtxPtr = G->edgeListPtrs;
+  edge *vtxInd = G->edgeList;
+  long maxDegree = 0;
+  for (long i=0; i<NV; i++)
+    maxDegree = std::max(maxDegree, vtxPtr[i+1] - vtxPtr[i]);
+  bucketQueue q(NV, maxDegree);
+  for (long i=0; i<NV; i++)
+    q.push(i, vtxPtr[i+1] - vtxPtr[i]);
+  long degeneracy = 0;
+  while (!q.empty()) {
+    long u = q.top();
+    degeneracy = std::max(degeneracy, q.topKey());
+    q.pop();
+    for (long k=vtxPtr[u]; k<vtxPtr[u+1]; k++) {
+      long x = vtxInd[k].tail;
+      if (q.contains(x))
+        q.changeKey(x, q.key(x) - 1);
+    }
+  }
+  return degeneracy;
+}
+
+int main(int argc, char *argv[]) {
+  long n = 1000000;
+  int reps = 3;
+  long seed = 1;
+  for (int i=1; i<argc; i++) {
+    std::string arg(argv[i]);
+    if (arg.compare(0, 4, "--n=") == 0) n = atol(arg.c_str() + 4);
+    else if (arg.compare(0, 7, "--reps=") == 0) reps = atoi(arg.c_str() + 7);
+    else if (arg.compare(0, 7, "--seed=") == 0) seed = atol(arg.c_str() + 7);
+    else {
+      fprintf(stderr, "Usage: %s [--n=<vertices>] [--reps=<n>] [--seed=<n>]\n", argv[0]);
+      return 1;
+    }
+  }
+  if ((n < 1) || (reps < 1)) {
+    fprintf(stderr, "--n and --reps must be positive\n");
+    return 1;
+  }
+  setLogLevel(0);
+
+  std::vector<double> keys(n);
+  for (long i=0; i<n; i++)
+    keys[i] = hashRandomU01(i, seed, 0);
+  timeIt("sort", "heap", reps, [&]() { return sortOldHeap(keys); });
+  timeIt("sort", "dAryHeap<2>", reps, [&]() { return sortDAry<2>(keys); });
+  timeIt("sort", "dAryHeap<4>", reps, [&]() { return sortDAry<4>(keys); });
+  timeIt("sort", "dAryHeap<8>", reps, [&]() { return sortDAry<8>(keys); });
+
+  graph G;
+  std::vector<long> truth(n);
+  generateGaussianMixtureKNN(&G, truth.data(), n, 10, 20, 4, 15, seed);
+  timeIt("dijkstra", "heap", reps, [&]() { return dijkstraOldHeap(&G); });
+  timeIt("dijkstra", "dAryHeap<2>", reps, [&]() { return dijkstraDAry<2>(&G); });
+  timeIt("dijkstra", "dAryHeap<4>", reps, [&]() { return dijkstraDAry<4>(&G); });
+  timeIt("dijkstra", "dAryHeap<8>", reps, [&]() { return dijkstraDAry<8>(&G); });
+  timeIt("degree", "heap", reps, [&]() { return smallestLastOldHeap(&G); });
+  timeIt("degree", "dAryHeap<4>", reps, [&]() { return smallestLastDAry(&G); });
+  timeIt("degree", "bucketQueue", reps, [&]() { return smallestLastBuckets(&G); });
+  free(G.edgeListPtrs);
+  free(G.edgeList);
+  return 0;
+}
@@ -0,0 +1,100 @@
+// Micro-benchmark of the prefix sums of parallel_scan.h.
+//
+// Usage: scan_bench [--n=<entries>] [--reps=<n>] [--threads=<list>]
+//
+// Times the serial loop that the CSR builders used (p[i+1] += p[i]) against
+// parallelInclusiveScan() and parallelExclusiveScan() on n random degrees, as
+// long and as double, for every thread count of the list (default: 1 and all
+// threads). Each line reports the best time over the repetitions, the
+// bandwidth (one read and one write of every entry) and the last entry, which
+// must agree between the scans of a type.
+
+#include "defs.h"
+#include "basic_util.h"
+#include "parallel_scan.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+
+//Best time of reps scans of a copy of input by f(), which returns the last entry
+template <typename T, typename F>
+static void timeIt(const char *scan, const char *type, int nT, int reps,
+                   const std::vector<T> &input, F f) {
+  std::vector<T> a(input.size());
+  double best = 1e30, check = 0;
+  for (int r=0; r<reps; r++) {
+#pragma omp parallel for
+    for (long i=0; i<(long) a.size(); i++)
+      a[i] = input[i];
+    double time1 = omp_get_wtime();
+    check = (double) f(a.data(), (long) a.size());
+    best = std::min(best, omp_get_wtime() - time1);
+  }
+  double gbs = 2.0 * a.size() * sizeof(T) / best / 1e9;
+  printf("%-10s %-7s %3d threads %10.4f s %7.2f GB/s   last %.6g\n", scan, type, nT, best, gbs, check);
+}
+
+template <typename T>
+static T serialScan(T *a, long N) {
+  for (long i=0; i+1<N; i++)
+    a[i+1] += a[i];
+  return a[N-1];
+}
+
+template <typename T>
+static void runType(const char *type, long n, int nT, int reps) {
+  std::vector<T> degrees(n + 1);
+  degrees[0] = 0;
+  for (long i=1; i<=n; i++)
+    degrees[i] = (T) (1 + hashRandom(i, 1, 0) % 32);
+  omp_set_num_threads(nT);
+  timeIt("serial", type, nT, reps, degrees, serialScan<T>);
+  timeIt("inclusive", type, nT, reps, degrees, [](T *a, long N) {
+    parallelInclusiveScan(a, N);
+    return a[N-1];
+  });
+  timeIt("exclusive", type, nT, reps, degrees, [](T *a, long N) {
+    return parallelExclusiveScan(a, N);
+  });
+}
+
+int main(int argc, char *argv[]) {
+  long n = 50000000;
+  int reps = 5;
+  std::vector<int> threads;
+  threads.push_back(1);
+  if (omp_get_max_threads() > 1)
+    threads.push_back(omp_get_max_threads());
+  for (int i=1; i<argc; i++) {
+    std::string arg(argv[i]);
+    if (arg.compare(0, 4, "--n=") == 0) n = atol(arg.c_str() + 4);
+    else if (arg.compare(0, 7, "--reps=") == 0) reps = atoi(arg.c_str() + 7);
+    else if (arg.compare(0, 10, "--threads=") == 0) {
+      threads.clear();
+      for (const char *p = arg.c_str() + 10; *p; ) {
+        threads.push_back(atoi(p));
+        while (*p && (*p != ',')) p++;
+        if (*p == ',') p++;
+      }
+    } else {
+      fprintf(stderr, "Usage: %s [--n=<entries>] [--reps=<n>] [--threads=<list>]\n", argv[0]);
+      return 1;
+    }
+  }
+  if ((n < 1) || (reps < 1)) {
+    fprintf(stderr, "--n and --reps must be positive\n");
+    return 1;
+  }
+  for (size_t t=0; t<threads.size(); t++) {
+    if (threads[t] < 1) {
+      fprintf(stderr, "--threads must list positive counts\n");
+      return 1;
+    }
+  }
+  setLogLevel(0);
+  for (size_t t=0; t<threads.size(); t++) {
+    runType<long>("long", n, threads[t], reps);
+    runType<double>("double", n, threads[t], reps);
+  }
+  return 0;
+}
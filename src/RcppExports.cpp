@@ -17,19 +17,20 @@ BEGIN_RCPP
 END_RCPP
 }
 // rcpp_parallel_jce
-NumericMatrix rcpp_parallel_jce(NumericMatrix mat);
-RcppExport SEXP _FastPG_rcpp_parallel_jce(SEXP matSEXP) {
+NumericMatrix rcpp_parallel_jce(NumericMatrix mat, int numThreads);
+RcppExport SEXP _FastPG_rcpp_parallel_jce(SEXP matSEXP, SEXP numThreadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericMatrix >::type mat(matSEXP);
-    rcpp_result_gen = Rcpp::wrap(rcpp_parallel_jce(mat));
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(rcpp_parallel_jce(mat, numThreads));
     return rcpp_result_gen;
 END_RCPP
 }
 // parallel_louvain
-Rcpp::List parallel_louvain(NumericMatrix links, int minGraphSize, double C_thresh, double threshold, int numColors, int coloring, int syncType, int basicOpt);
-RcppExport SEXP _FastPG_parallel_louvain(SEXP linksSEXP, SEXP minGraphSizeSEXP, SEXP C_threshSEXP, SEXP thresholdSEXP, SEXP numColorsSEXP, SEXP coloringSEXP, SEXP syncTypeSEXP, SEXP basicOptSEXP) {
+Rcpp::List parallel_louvain(NumericMatrix links, int minGraphSize, double C_thresh, double threshold, int numColors, int coloring, int syncType, int basicOpt, bool incrementalColoring, bool stats, int reorder, int backend, int numThreads, int sampling, int samplePercentage);
+RcppExport SEXP _FastPG_parallel_louvain(SEXP linksSEXP, SEXP minGraphSizeSEXP, SEXP C_threshSEXP, SEXP thresholdSEXP, SEXP numColorsSEXP, SEXP coloringSEXP, SEXP syncTypeSEXP, SEXP basicOptSEXP, SEXP incrementalColoringSEXP, SEXP statsSEXP, SEXP reorderSEXP, SEXP backendSEXP, SEXP numThreadsSEXP, SEXP samplingSEXP, SEXP samplePercentageSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -41,15 +42,152 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type coloring(coloringSEXP);
     Rcpp::traits::input_parameter< int >::type syncType(syncTypeSEXP);
     Rcpp::traits::input_parameter< int >::type basicOpt(basicOptSEXP);
-    rcpp_result_gen = Rcpp::wrap(parallel_louvain(links, minGraphSize, C_thresh, threshold, numColors, coloring, syncType, basicOpt));
+    Rcpp::traits::input_parameter< bool >::type incrementalColoring(incrementalColoringSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< int >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< int >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    Rcpp::traits::input_parameter< int >::type sampling(samplingSEXP);
+    Rcpp::traits::input_parameter< int >::type samplePercentage(samplePercentageSEXP);
+    rcpp_result_gen = Rcpp::wrap(parallel_louvain(links, minGraphSize, C_thresh, threshold, numColors, coloring, syncType, basicOpt, incrementalColoring, stats, reorder, backend, numThreads, sampling, samplePercentage));
+    return rcpp_result_gen;
+END_RCPP
+}
+// parallel_louvain_scaling
+DataFrame parallel_louvain_scaling(NumericMatrix links, Rcpp::Nullable<IntegerVector> threads, int repeats, int minGraphSize, double C_thresh, double threshold, int numColors, int coloring, int syncType, int basicOpt, bool incrementalColoring, int reorder, int backend, int sampling, int samplePercentage);
+RcppExport SEXP _FastPG_parallel_louvain_scaling(SEXP linksSEXP, SEXP threadsSEXP, SEXP repeatsSEXP, SEXP minGraphSizeSEXP, SEXP C_threshSEXP, SEXP thresholdSEXP, SEXP numColorsSEXP, SEXP coloringSEXP, SEXP syncTypeSEXP, SEXP basicOptSEXP, SEXP incrementalColoringSEXP, SEXP reorderSEXP, SEXP backendSEXP, SEXP samplingSEXP, SEXP samplePercentageSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix >::type links(linksSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<IntegerVector> >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< int >::type repeats(repeatsSEXP);
+    Rcpp::traits::input_parameter< int >::type minGraphSize(minGraphSizeSEXP);
+    Rcpp::traits::input_parameter< double >::type C_thresh(C_threshSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type numColors(numColorsSEXP);
+    Rcpp::traits::input_parameter< int >::type coloring(coloringSEXP);
+    Rcpp::traits::input_parameter< int >::type syncType(syncTypeSEXP);
+    Rcpp::traits::input_parameter< int >::type basicOpt(basicOptSEXP);
+    Rcpp::traits::input_parameter< bool >::type incrementalColoring(incrementalColoringSEXP);
+    Rcpp::traits::input_parameter< int >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< int >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< int >::type sampling(samplingSEXP);
+    Rcpp::traits::input_parameter< int >::type samplePercentage(samplePercentageSEXP);
+    rcpp_result_gen = Rcpp::wrap(parallel_louvain_scaling(links, threads, repeats, minGraphSize, C_thresh, threshold, numColors, coloring, syncType, basicOpt, incrementalColoring, reorder, backend, sampling, samplePercentage));
+    return rcpp_result_gen;
+END_RCPP
+}
+// write_graph_file
+SEXP write_graph_file(NumericMatrix links, std::string fileName, int indexBytes);
+RcppExport SEXP _FastPG_write_graph_file(SEXP linksSEXP, SEXP fileNameSEXP, SEXP indexBytesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix >::type links(linksSEXP);
+    Rcpp::traits::input_parameter< std::string >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< int >::type indexBytes(indexBytesSEXP);
+    rcpp_result_gen = Rcpp::wrap(write_graph_file(links, fileName, indexBytes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// parallel_louvain_file
+Rcpp::List parallel_louvain_file(std::string fileName, std::string format, int minGraphSize, double C_thresh, double threshold, int numColors, int coloring, int syncType, int basicOpt, bool incrementalColoring, bool stats, int reorder, int backend, int numThreads, int sampling, int samplePercentage);
+RcppExport SEXP _FastPG_parallel_louvain_file(SEXP fileNameSEXP, SEXP formatSEXP, SEXP minGraphSizeSEXP, SEXP C_threshSEXP, SEXP thresholdSEXP, SEXP numColorsSEXP, SEXP coloringSEXP, SEXP syncTypeSEXP, SEXP basicOptSEXP, SEXP incrementalColoringSEXP, SEXP statsSEXP, SEXP reorderSEXP, SEXP backendSEXP, SEXP numThreadsSEXP, SEXP samplingSEXP, SEXP samplePercentageSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type fileName(fileNameSEXP);
+    Rcpp::traits::input_parameter< std::string >::type format(formatSEXP);
+    Rcpp::traits::input_parameter< int >::type minGraphSize(minGraphSizeSEXP);
+    Rcpp::traits::input_parameter< double >::type C_thresh(C_threshSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type numColors(numColorsSEXP);
+    Rcpp::traits::input_parameter< int >::type coloring(coloringSEXP);
+    Rcpp::traits::input_parameter< int >::type syncType(syncTypeSEXP);
+    Rcpp::traits::input_parameter< int >::type basicOpt(basicOptSEXP);
+    Rcpp::traits::input_parameter< bool >::type incrementalColoring(incrementalColoringSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< int >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< int >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    Rcpp::traits::input_parameter< int >::type sampling(samplingSEXP);
+    Rcpp::traits::input_parameter< int >::type samplePercentage(samplePercentageSEXP);
+    rcpp_result_gen = Rcpp::wrap(parallel_louvain_file(fileName, format, minGraphSize, C_thresh, threshold, numColors, coloring, syncType, basicOpt, incrementalColoring, stats, reorder, backend, numThreads, sampling, samplePercentage));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fpg_graph
+SEXP fpg_graph(NumericMatrix links, int reorder, int numThreads);
+RcppExport SEXP _FastPG_fpg_graph(SEXP linksSEXP, SEXP reorderSEXP, SEXP numThreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix >::type links(linksSEXP);
+    Rcpp::traits::input_parameter< int >::type reorder(reorderSEXP);
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(fpg_graph(links, reorder, numThreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fpg_cluster
+Rcpp::List fpg_cluster(SEXP graph, int minGraphSize, double C_thresh, double threshold, int numColors, int coloring, int syncType, int basicOpt, bool incrementalColoring, bool stats, int backend, int numThreads, int sampling, int samplePercentage);
+RcppExport SEXP _FastPG_fpg_cluster(SEXP graphSEXP, SEXP minGraphSizeSEXP, SEXP C_threshSEXP, SEXP thresholdSEXP, SEXP numColorsSEXP, SEXP coloringSEXP, SEXP syncTypeSEXP, SEXP basicOptSEXP, SEXP incrementalColoringSEXP, SEXP statsSEXP, SEXP backendSEXP, SEXP numThreadsSEXP, SEXP samplingSEXP, SEXP samplePercentageSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type graph(graphSEXP);
+    Rcpp::traits::input_parameter< int >::type minGraphSize(minGraphSizeSEXP);
+    Rcpp::traits::input_parameter< double >::type C_thresh(C_threshSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type numColors(numColorsSEXP);
+    Rcpp::traits::input_parameter< int >::type coloring(coloringSEXP);
+    Rcpp::traits::input_parameter< int >::type syncType(syncTypeSEXP);
+    Rcpp::traits::input_parameter< int >::type basicOpt(basicOptSEXP);
+    Rcpp::traits::input_parameter< bool >::type incrementalColoring(incrementalColoringSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< int >::type backend(backendSEXP);
+    Rcpp::traits::input_parameter< int >::type numThreads(numThreadsSEXP);
+    Rcpp::traits::input_parameter< int >::type sampling(samplingSEXP);
+    Rcpp::traits::input_parameter< int >::type samplePercentage(samplePercentageSEXP);
+    rcpp_result_gen = Rcpp::wrap(fpg_cluster(graph, minGraphSize, C_thresh, threshold, numColors, coloring, syncType, basicOpt, incrementalColoring, stats, backend, numThreads, sampling, samplePercentage));
+    return rcpp_result_gen;
+END_RCPP
+}
+// set_verbosity
+int set_verbosity(int level);
+RcppExport SEXP _FastPG_set_verbosity(SEXP levelSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type level(levelSEXP);
+    rcpp_result_gen = Rcpp::wrap(set_verbosity(level));
+    return rcpp_result_gen;
+END_RCPP
+}
+// bind_threads
+IntegerVector bind_threads(int bind);
+RcppExport SEXP _FastPG_bind_threads(SEXP bindSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type bind(bindSEXP);
+    rcpp_result_gen = Rcpp::wrap(bind_threads(bind));
     return rcpp_result_gen;
 END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
     {"_FastPG_dedup_links", (DL_FUNC) &_FastPG_dedup_links, 1},
-    {"_FastPG_rcpp_parallel_jce", (DL_FUNC) &_FastPG_rcpp_parallel_jce, 1},
-    {"_FastPG_parallel_louvain", (DL_FUNC) &_FastPG_parallel_louvain, 8},
+    {"_FastPG_rcpp_parallel_jce", (DL_FUNC) &_FastPG_rcpp_parallel_jce, 2},
+    {"_FastPG_parallel_louvain", (DL_FUNC) &_FastPG_parallel_louvain, 15},
+    {"_FastPG_parallel_louvain_scaling", (DL_FUNC) &_FastPG_parallel_louvain_scaling, 15},
+    {"_FastPG_write_graph_file", (DL_FUNC) &_FastPG_write_graph_file, 3},
+    {"_FastPG_parallel_louvain_file", (DL_FUNC) &_FastPG_parallel_louvain_file, 16},
+    {"_FastPG_fpg_graph", (DL_FUNC) &_FastPG_fpg_graph, 3},
+    {"_FastPG_fpg_cluster", (DL_FUNC) &_FastPG_fpg_cluster, 14},
+    {"_FastPG_set_verbosity", (DL_FUNC) &_FastPG_set_verbosity, 1},
+    {"_FastPG_bind_threads", (DL_FUNC) &_FastPG_bind_threads, 1},
     {NULL, NULL, 0}
 };
 
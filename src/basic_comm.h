@@ -1,9 +1,12 @@
 #ifndef __BASIC__COMM__
 #define __BASIC__COMM__
 
+#include "clustering_stats.h"
+
 // Define in louvainMultiPhaseRun.cpp
 void runMultiPhaseBasic(graph *G, long *C_orig, int basicOpt, long minGraphSize,
-			double threshold, double C_threshold, int numThreads, int threadsOpt);
+			double threshold, double C_threshold, int numThreads, int threadsOpt,
+			clusteringStats *stats = NULL);
 
 // same as above, but runs exactly one phase
 void runMultiPhaseBasicOnce(graph *G, long *C_orig, int basicOpt, long minGraphSize,
@@ -11,25 +14,36 @@ void runMultiPhaseBasicOnce(graph *G, long *C_orig, int basicOpt, long minGraphS
 
 // uses Granell, Arenas, et al. Fast track resistance
 void runMultiPhaseBasicFastTrackResistance(graph *G, long *C_orig, int basicOpt, long minGraphSize,
-			double threshold, double C_threshold, int numThreads, int threadsOpt);
+			double threshold, double C_threshold, int numThreads, int threadsOpt,
+			clusteringStats *stats = NULL);
 
 
-void runMultiPhaseBasicApprox(graph *G, long *C_orig, int basicOpt, long minGraphSize,
-			double threshold, double C_threshold, int numThreads, int threadsOpt, int percentage);
+// runs the Approx kernel in every phase (basicOpt and threadsOpt are ignored)
+// and returns the modularity of C_orig
+double runMultiPhaseBasicApprox(graph *G, long *C_orig, int basicOpt, long minGraphSize,
+			double threshold, double C_threshold, int numThreads, int threadsOpt, int percentage,
+			int sampling, clusteringStats *stats = NULL);
 
 // Define in parallelLouvianMethod.cpp
 double parallelLouvianMethod(graph *G, long *C, int nThreads, double Lower, 
-				double thresh, double *totTime, int *numItr);
+				double thresh, double *totTime, int *numItr, phaseStats *stats = NULL);
 
 // Define in parallelLouvianMethodApprox.cpp
+// Vertices visited by the iterations of the Approx kernel, which start with
+// percentage % of the vertices and visit more when the modularity stops increasing
+#define SampleNone     0  //No sampling: the other kernels
+#define SampleUniform  1  //Every vertex with the same probability
+#define SampleDegree   2  //Probability proportional to the degree
+#define SampleGain     3  //Only vertices that moved or next to a move, uniformly
 double parallelLouvianMethodApprox(graph *G, long *C, int nThreads, double Lower, 
-				double thresh, double *totTime, int *numItr, int percentage);
+				double thresh, double *totTime, int *numItr, int percentage, int sampling,
+				phaseStats *stats = NULL);
 
 double parallelLouvianMethodNoMap(graph *G, long *C, int nThreads, double Lower,
-				double thresh, double *totTime, int *numItr);
+				double thresh, double *totTime, int *numItr, phaseStats *stats = NULL);
 				
 double parallelLouvianMethodScale(graph *G, long *C, int nThreads, double Lower, 
-				double thresh, double *totTime, int *numItr);
+				double thresh, double *totTime, int *numItr, phaseStats *stats = NULL);
 
 // implements Granell, Arenas, et al. Fast track resistance
 // Granell, Clara, Sergio Gomez, and Alex Arenas. "Hierarchical multiresolution method to 
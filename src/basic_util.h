@@ -14,14 +14,46 @@ inline void Visit(long v, long myCommunity, short *Visited, long *Volts,
 long vertexFollowing(graph *G, long *C);
 double buildNewGraphVF(graph *Gin, graph *Gout, long *C, long numUniqueClusters);
 
+// Counter-based random numbers: a splitmix64 hash of (i, seed, stream). Values are
+// computed on the fly, so they need no storage and do not depend on the number of
+// threads or on the order in which they are requested.
+#define RandomSeed 0x2545F4914F6CDD1DULL
+inline unsigned long long hashRandom(unsigned long long i, unsigned long long seed, unsigned long long stream) {
+    unsigned long long z = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    z += (i + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+inline double hashRandomU01(unsigned long long i, unsigned long long seed, unsigned long long stream) {
+    return (double)(hashRandom(i, seed, stream) >> 11) * (1.0 / 9007199254740992.0); //53 bits in [0,1)
+}
+
+// Define in graphReordering.cpp
+#define ReorderNone       0
+#define ReorderRCM        1  //Reverse Cuthill-McKee
+#define ReorderDegree     2  //Decreasing degree
+#define ReorderCommunity  3  //Groups of label propagation
+void reorderVertices(graph *G, long *old2New, int reorder);
+void permuteGraph(graph *Gin, graph *Gout, const long *old2New);
 // Define in utilityFunctions.cpp
 double computeGiniCoefficient(long *colorSize, int numColors);
 void generateRandomNumbers(double *RandVec, long size);
 void displayGraph(graph *G);
 void duplicateGivenGraph(graph *Gin, graph *Gout);
+void freeGraph(graph *G);
+void buildGraphFromEdgeList(graph *G, long NV, long NE, edge *tmpEdgeList);
 void displayGraphEdgeList(graph *G);
 void writeEdgeListToFile(graph *G, FILE* out);
 void displayGraphCharacteristics(graph *G);
+// NUMA placement: a page is placed on the memory node of the thread that writes
+// it first. Builders that fill an edge list in another order first write it with
+// the edge-balanced schedule of the loops over vertices of the kernels.
+void firstTouchEdges(edge *edgeList, const long *edgeListPtrs, long NV);
+#define BindNone    0
+#define BindClose   1  //Thread t on the t-th allowed CPU
+#define BindSpread  2  //Threads spread evenly over the allowed CPUs
+int bindThreads(int bind, int *cpuOfThread);
 
 
 #endif
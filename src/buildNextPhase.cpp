@@ -41,6 +41,8 @@
 
 #include "defs.h"
 #include "basic_util.h"
+#include "parallel_scan.h"
+#include "parallel_backend.h"
 using namespace std;
 
 //WARNING: Will overwrite the old cluster vector
@@ -85,15 +87,13 @@ double buildNextLevelGraphOpt(graph *Gin, graph *Gout, long *C, long numUniqueCl
 #ifdef PRINT_DETAILED_STATS_
     //printf("Within buildNextLevelGraphOpt(): # of unique clusters= %ld\n",numUniqueClusters);
 #endif
-    if (nThreads < 1)
-        omp_set_num_threads(1);
-    else
-        omp_set_num_threads(nThreads);
+    ompThreadsScope threadsScope(nThreads); //Restored on return
     int nT;
 #pragma omp parallel
     {
         nT = omp_get_num_threads();
     }
+    parallelBackendScope backendScope(parallelBackend(), nT);
 #ifdef PRINT_DETAILED_STATS_
     //printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 #endif
@@ -142,8 +142,8 @@ double buildNextLevelGraphOpt(graph *Gin, graph *Gout, long *C, long numUniqueCl
 #endif
     time1 = omp_get_wtime();
     
-#pragma omp parallel for
-    for (long i=0; i<NV_in; i++) {
+    parallelForChunks(0, NV_in, [&](long begin, long end, int slot) {
+    for (long i=begin; i<end; i++) {
         long adj1 = vtxPtrIn[i];
         long adj2 = vtxPtrIn[i+1];
         map<long, double>::iterator localIterator;
@@ -172,11 +172,10 @@ double buildNextLevelGraphOpt(graph *Gin, graph *Gout, long *C, long numUniqueCl
             }//End of if
         }//End of for(j)
     }//End of for(i)
+    });
     
     //Prefix sum:
-    for(long i=0; i<NV_out; i++) {
-        vtxPtrOut[i+1] += vtxPtrOut[i];
-    }
+    parallelInclusiveScan(vtxPtrOut, NV_out+1);
     
     time2 = omp_get_wtime();
     TotTime += (time2-time1);
@@ -193,6 +192,7 @@ double buildNextLevelGraphOpt(graph *Gin, graph *Gout, long *C, long numUniqueCl
     long realEdges  = numEdges - NE_out; //Self-loops appear once, others appear twice
     edge *vtxIndOut = (edge *) malloc (numEdges * sizeof(edge));
     assert (vtxIndOut != 0);
+    firstTouchEdges(vtxIndOut, vtxPtrOut, NV_out); //Edges are added to both endpoints below
     long *Added = (long *) malloc (NV_out * sizeof(long)); //Keep track of what got added
     assert (Added != 0);
     
@@ -202,8 +202,8 @@ double buildNextLevelGraphOpt(graph *Gin, graph *Gout, long *C, long numUniqueCl
     }
     
     //Now add the edges in no particular order
-#pragma omp parallel for
-    for (long i=0; i<NV_out; i++) {
+    parallelForChunks(0, NV_out, [&](long begin, long end, int slot) {
+    for (long i=begin; i<end; i++) {
         long Where;
         map<long, double>::iterator localIterator = cluPtrIn[i]->begin();
         //Now go through the other edges:
@@ -221,6 +221,7 @@ double buildNextLevelGraphOpt(graph *Gin, graph *Gout, long *C, long numUniqueCl
             localIterator++;
         }
     }//End of for(i)
+    });
     time2 = omp_get_wtime();
     TotTime += (time2-time1);
 #ifdef PRINT_DETAILED_STATS_
@@ -326,9 +327,7 @@ void buildNextLevelGraph(graph *Gin, graph *Gout, long *C, long numUniqueCluster
     }//End of for(i)
     
     //Prefix sum:
-    for(long i=0; i<NV_out; i++) {
-        vtxPtrOut[i+1] += vtxPtrOut[i];
-    }
+    parallelInclusiveScan(vtxPtrOut, NV_out+1);
     ////printf("End Structure %ld %ld vs %ld\n",NE_out, NV_out, vtxPtrOut[NV_out]);
     assert(vtxPtrOut[NV_out] == (NE_out*2+NV_out)); //Sanity check
     
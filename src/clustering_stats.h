@@ -0,0 +1,77 @@
+#ifndef __clustering_stats__
+#define __clustering_stats__
+
+#include "defs.h"
+
+//Statistics of one iteration of a clustering kernel
+struct iterationStats {
+    int    iteration;
+    double modularity;
+    long   numMoved;       //Vertices that changed community
+    double time;           //Seconds spent in the iteration
+    double loadImbalance;  //Busiest thread over the mean in the vertex sweep, 0 if not measured
+    double idleTime;       //Seconds the threads waited for the busiest one, summed over the color classes if any
+};
+
+//Statistics of one phase of a multi-phase driver
+struct phaseStats {
+    long   phase;
+    long   numVertices;
+    long   numEdges;
+    int    numIterations;  //Iterations run by the clustering kernel
+    int    numColors;      //Zero if the phase ran without coloring
+    double timeColoring;
+    double timeClustering;
+    double timeBuilding;   //Time to build the graph for the next phase
+    long   scratchBytes;   //Scratch memory allocated by the clustering kernel
+    std::vector<iterationStats> iterations;
+};
+
+//One entry per phase, in the order the phases ran
+typedef std::vector<phaseStats> clusteringStats;
+
+inline void initPhaseStats(phaseStats *stats, long phase, graph *G) {
+    stats->phase          = phase;
+    stats->numVertices    = G->numVertices;
+    stats->numEdges       = G->numEdges;
+    stats->numIterations  = 0;
+    stats->numColors      = 0;
+    stats->timeColoring   = 0;
+    stats->timeClustering = 0;
+    stats->timeBuilding   = 0;
+    stats->scratchBytes   = 0;
+    stats->iterations.clear();
+}
+
+//Kernels call these with stats == NULL when no statistics are requested
+inline void recordIteration(phaseStats *stats, int iteration, double modularity, long numMoved, double time) {
+    if (stats == NULL)
+        return;
+    iterationStats itr;
+    itr.iteration  = iteration;
+    itr.modularity = modularity;
+    itr.numMoved   = numMoved;
+    itr.time       = time;
+    itr.loadImbalance = 0;
+    itr.idleTime   = 0;
+    stats->iterations.push_back(itr);
+}
+
+//Load imbalance of the last recorded iteration
+inline void recordLoadImbalance(phaseStats *stats, double imbalance) {
+    if ((stats != NULL) && !stats->iterations.empty())
+        stats->iterations.back().loadImbalance = imbalance;
+}
+
+//Thread idle time of the last recorded iteration
+inline void recordIdleTime(phaseStats *stats, double idleTime) {
+    if ((stats != NULL) && !stats->iterations.empty())
+        stats->iterations.back().idleTime = idleTime;
+}
+
+inline void recordScratchBytes(phaseStats *stats, long bytes) {
+    if ((stats != NULL) && (bytes > stats->scratchBytes))
+        stats->scratchBytes = bytes;
+}
+
+#endif
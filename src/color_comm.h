@@ -5,12 +5,13 @@
 #include "coloring.h"
 
 double runMultiPhaseColoring(graph *G, long *C_orig, int coloring, int numColors, int replaceMap, long minGraphSize,
-            double threshold, double C_threshold, int numThreads, int threadsOpt);
+            double threshold, double C_threshold, int numThreads, int threadsOpt, int incrementalColoring,
+            clusteringStats *stats = NULL);
 
 double algoLouvainWithDistOneColoring(graph* G, long *C, int nThreads, int* color,
-			int numColor, double Lower, double thresh, double *totTime, int *numItr);
+			int numColor, double Lower, double thresh, double *totTime, int *numItr, phaseStats *stats = NULL);
 
 double algoLouvainWithDistOneColoringNoMap(graph* G, long *C, int nThreads, int* color,
-			int numColor, double Lower, double thresh, double *totTime, int *numItr);
+			int numColor, double Lower, double thresh, double *totTime, int *numItr, phaseStats *stats = NULL);
 
 #endif
@@ -7,6 +7,10 @@
 // In coloringDistanceOne.cpp
 int algoDistanceOneVertexColoringOpt(graph *G, int *vtxColor, int nThreads, double *totTime);
 int algoDistanceOneVertexColoring(graph *G, int *vtxColor, int nThreads, double *totTime);
+int algoDistanceOneVertexRecoloring(graph *G, int *vtxColor, int nThreads, double *totTime);
+
+// In coloringDegreeOrdered.cpp
+int algoDistanceOneVertexColoringLDF(graph *G, int *vtxColor, int nThreads, double *totTime);
 
 // In ColoringMultiHasMaxMin.cpp
 int algoColoringMultiHashMaxMin(graph *G, int *vtxColor, int nThreads, double *totTime, int nHash, int nItrs);
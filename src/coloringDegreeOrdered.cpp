@@ -0,0 +1,141 @@
+#include "defs.h"
+#include "parallel_backend.h"
+#include "coloring.h"
+
+//////////////////////////////////////////////////////////////////////////////////////
+///////////////////  DISTANCE ONE COLORING: LARGEST DEGREE FIRST  ////////////////////
+//////////////////////////////////////////////////////////////////////////////////////
+//Jones-Plassmann coloring with largest-degree-first priorities: a vertex is
+//colored as soon as all of its neighbors with a higher priority have been colored,
+//and it takes the smallest color not used by them. Each vertex keeps a count of
+//its uncolored higher-priority neighbors; vertices whose count drops to zero form
+//the frontier of the next round. Vertices in a frontier are independent, so no
+//conflicts arise and the result does not depend on the number of threads.
+//Ties in degree are broken with hashed vertex priorities, and then with vertex ids.
+//Return the number of colors used (zero is a valid color)
+static inline bool higherPriority(long w, long v, long *verPtr) {
+  long degW = verPtr[w+1] - verPtr[w];
+  long degV = verPtr[v+1] - verPtr[v];
+  if (degW != degV)
+    return (degW > degV);
+  unsigned long long prW = vertexPriority(w);
+  unsigned long long prV = vertexPriority(v);
+  if (prW != prV)
+    return (prW > prV);
+  return (w > v);
+}
+
+int algoDistanceOneVertexColoringLDF(graph *G, int *vtxColor, int nThreads, double *totTime)
+{
+#ifdef PRINT_DETAILED_STATS_
+  //printf("Within algoDistanceOneVertexColoringLDF()\n");
+#endif
+
+  ompThreadsScope threadsScope(nThreads); //Restored on return
+
+  double time1=0, totalTime=0;
+  //Get the iterators for the graph:
+  long NVer    = G->numVertices;
+  long *verPtr = G->edgeListPtrs;   //Vertex Pointer: pointers to endV
+  edge *verInd = G->edgeList;       //Vertex Index: destination id of an edge (src -> dest)
+
+  time1 = omp_get_wtime();
+  //Number of uncolored neighbors with a higher priority
+  long *waitCount = (long *) malloc (NVer * sizeof(long)); assert(waitCount != 0);
+  //Frontiers: read from one, write into another, swap at the end of a round
+  long *Q    = (long *) malloc (NVer * sizeof(long)); assert(Q != 0);
+  long *Qtmp = (long *) malloc (NVer * sizeof(long)); assert(Qtmp != 0);
+  long *Qswap;
+  long QTail = 0, QtmpTail = 0;
+  long maxDegree = 0;
+
+#pragma omp parallel for reduction(max: maxDegree)
+  for (long v=0; v<NVer; v++) {
+    long count = 0;
+    for (long k = verPtr[v]; k < verPtr[v+1]; k++) {
+      long w = verInd[k].tail;
+      if ( (w != v) && higherPriority(w, v, verPtr) )
+        count++;
+    }
+    waitCount[v] = count;
+    vtxColor[v] = -1;
+    Qtmp[v] = -1; //Empty queue
+    if (count == 0) { //Local maximum: can be colored right away
+      long whereInQ = __sync_fetch_and_add(&QTail, 1);
+      Q[whereInQ] = v;
+    }
+    long de = verPtr[v+1] - verPtr[v];
+    if (de > maxDegree)
+      maxDegree = de;
+  }
+
+  int nLoops = 0; //Number of rounds
+  while (QTail > 0) {
+#pragma omp parallel
+    {
+      //Mark array indexed by color; a color is forbidden for v if Mark[color] == v
+      long *Mark = (long *) malloc ((maxDegree+2) * sizeof(long)); assert(Mark != 0);
+      for (long c=0; c<maxDegree+2; c++)
+        Mark[c] = -1;
+      //Color the frontier with the smallest available color
+#pragma omp for
+      for (long Qi=0; Qi<QTail; Qi++) {
+        long v = Q[Qi];
+        for (long k = verPtr[v]; k < verPtr[v+1]; k++) {
+          int adjColor = vtxColor[verInd[k].tail];
+          if (adjColor >= 0)
+            Mark[adjColor] = v;
+        }
+        int myColor = 0;
+        while (Mark[myColor] == v)
+          myColor++;
+        vtxColor[v] = myColor;
+      }//End of for(Qi) -- implicit barrier
+      //Release the lower-priority neighbors of the frontier
+#pragma omp for
+      for (long Qi=0; Qi<QTail; Qi++) {
+        long v = Q[Qi];
+        for (long k = verPtr[v]; k < verPtr[v+1]; k++) {
+          long w = verInd[k].tail;
+          if ( (w == v) || (vtxColor[w] >= 0) )
+            continue;
+          if (__sync_sub_and_fetch(&waitCount[w], 1) == 0) {
+            long whereInQ = __sync_fetch_and_add(&QtmpTail, 1);
+            Qtmp[whereInQ] = w;
+          }
+        }
+      }//End of for(Qi)
+      free(Mark);
+    }//End of parallel region
+    nLoops++;
+
+    //Swap the two queues:
+    Qswap = Q;
+    Q = Qtmp;
+    Qtmp = Qswap;
+    QTail = QtmpTail;
+    QtmpTail = 0;
+  }//End of while()
+  totalTime = omp_get_wtime() - time1;
+
+  //Check the number of colors used
+  int nColors = -1;
+#pragma omp parallel for reduction(max: nColors)
+  for (long v=0; v < NVer; v++ )
+    if (vtxColor[v] > nColors) nColors = vtxColor[v];
+#ifdef PRINT_DETAILED_STATS_
+  //printf("***********************************************\n");
+  //printf("Total number of colors used: %d \n", nColors);
+  //printf("Number of rounds           : %d \n", nLoops);
+  //printf("Total Time                 : %lf sec\n", totalTime);
+  //printf("***********************************************\n");
+#endif
+  *totTime = totalTime;
+
+  //Clean Up:
+  free(Q);
+  free(Qtmp);
+  free(waitCount);
+
+  return nColors; //Return the number of colors used
+}//End of algoDistanceOneVertexColoringLDF()
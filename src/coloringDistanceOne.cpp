@@ -41,6 +41,26 @@
 
 #include "defs.h"
 #include "coloring.h"
+#include "parallel_backend.h"
+#include "parallel_scan.h"
+#include "utilityClusteringFunctions.h"
+
+//Ranges of about the same work (degree + 1) over the queued vertices Q[0..QTail), for
+//parallelForRanges(): range t is Q[bounds[t]..bounds[t+1]). A vertex is colored by one
+//thread, so a hub stays in a single range. work holds QTail+1 entries.
+static void queueRanges(graph *G, const long *Q, long QTail, int nT, long *work, long *bounds)
+{
+  long *verPtr = G->edgeListPtrs;
+  work[0] = 0;
+	#pragma omp parallel for
+  for (long Qi=0; Qi<QTail; Qi++)
+    work[Qi+1] = verPtr[Q[Qi]+1] - verPtr[Q[Qi]] + 1;
+  parallelInclusiveScan(work, QTail+1);
+  bounds[0]  = 0;
+  bounds[nT] = QTail;
+  for (int t=1; t<nT; t++) //First position with at least 1/nT of the work before it, per range
+    bounds[t] = lower_bound(work + bounds[t-1], work + QTail + 1, (work[QTail] * t) / nT) - work;
+}//End of queueRanges()
 
 
 //////////////////////////////////////////////////////////////////////////////////////
@@ -53,16 +73,14 @@ int algoDistanceOneVertexColoringOpt(graph *G, int *vtxColor, int nThreads, doub
   //printf("Within algoDistanceOneVertexColoringOpt()\n");
 #endif
 
-  if (nThreads < 1)
-		omp_set_num_threads(1); //default to one thread
-  else
-		omp_set_num_threads(nThreads);
+  ompThreadsScope threadsScope(nThreads); //Restored on return
   int nT;
 
 	#pragma omp parallel
   {
 		nT = omp_get_num_threads();
   }
+  parallelBackendScope backendScope(parallelBackend(), nT);
 
 #ifdef PRINT_DETAILED_STATS_
   //printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
@@ -79,11 +97,6 @@ int algoDistanceOneVertexColoringOpt(graph *G, int *vtxColor, int nThreads, doub
   //printf("Vertices: %ld  Edges: %ld\n", NVer, NEdge);
 #endif
 
-  //Build a vector of random numbers
-  double *randValues = (double*) malloc (NVer * sizeof(double));
-  assert(randValues != 0);
-  generateRandomNumbers(randValues, NVer);
-
   long *Q    = (long *) malloc (NVer * sizeof(long)); assert(Q != 0);
   long *Qtmp = (long *) malloc (NVer * sizeof(long)); assert(Qtmp != 0);
   long *Qswap;    
@@ -94,6 +107,13 @@ int algoDistanceOneVertexColoringOpt(graph *G, int *vtxColor, int nThreads, doub
   long QTail=0;    //Tail of the queue 
   long QtmpTail=0; //Tail of the queue (implicitly will represent the size)
   long realMaxDegree = 0;
+  //Each round splits the queue between the threads by edges, not vertices
+  long *work   = (long *) malloc ((NVer+1) * sizeof(long)); assert(work != 0);
+  long *bounds = (long *) malloc ((nT+1) * sizeof(long)); assert(bounds != 0);
+  auto range = [&](int t, long *begin, long *end) {
+    *begin = bounds[t];
+    *end   = bounds[t+1];
+  };
 	
 	#pragma omp parallel for
   for (long i=0; i<NVer; i++) {
@@ -134,8 +154,9 @@ int algoDistanceOneVertexColoringOpt(graph *G, int *vtxColor, int nThreads, doub
 #endif
 
     time1 = omp_get_wtime();
-		#pragma omp parallel for
-    for (long Qi=0; Qi<QTail; Qi++) {
+		queueRanges(G, Q, QTail, nT, work, bounds);
+		parallelForRanges(nT, 0, QTail, range, [&](long begin, long end, int slot) {
+    for (long Qi=begin; Qi<end; Qi++) {
       long v = Q[Qi]; //Q.pop_front();
 			int maxColor = 0;
 			BitVector mark(MaxDegree, false);
@@ -148,6 +169,7 @@ int algoDistanceOneVertexColoringOpt(graph *G, int *vtxColor, int nThreads, doub
 			}     
 			vtxColor[v] = myColor; //Color the vertex
 		} //End of outer for loop: for each vertex
+		});
 		
 		time1  = omp_get_wtime() - time1;
 		totalTime += time1;
@@ -163,11 +185,12 @@ int algoDistanceOneVertexColoringOpt(graph *G, int *vtxColor, int nThreads, doub
     //two conflicting vertices, based on their random values 
     time2 = omp_get_wtime();
 		
-		#pragma omp parallel for
-		for (long Qi=0; Qi<QTail; Qi++) {
+		parallelForRanges(nT, 0, QTail, range, [&](long begin, long end, int slot) {
+		for (long Qi=begin; Qi<end; Qi++) {
 			long v = Q[Qi]; //Q.pop_front();
-			distanceOneConfResolution(G, v, vtxColor, randValues, &QtmpTail, Qtmp, freq, 0);
+			distanceOneConfResolution(G, v, vtxColor, &QtmpTail, Qtmp, freq, 0);
 		} //End of outer for loop: for each vertex
+		});
   
 		time2  = omp_get_wtime() - time2;
 		totalTime += time2;    
@@ -227,12 +250,142 @@ int algoDistanceOneVertexColoringOpt(graph *G, int *vtxColor, int nThreads, doub
   //Clean Up:
   free(Q);
   free(Qtmp);
-  free(randValues);
+  free(work);
+  free(bounds);
   
   return nColors; //Return the number of colors used
 }
 
 
+//////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////  DISTANCE ONE RECOLORING    ///////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////
+//Smallest color not used by the neighbors of v
+static inline int smallestAvailableColor(graph *G, long v, int *vtxColor)
+{
+	BitVector mark(MaxDegree, false);
+	int maxColor = distanceOneMarkArray(mark,G,v,vtxColor);
+	int myColor;
+	for (myColor=0; myColor<=maxColor; myColor++) {
+		if ( mark[myColor] == false )
+			break;
+	}
+	return myColor;
+}
+
+//Repair a seeded coloring: vtxColor holds a (possibly improper) coloring, for example
+//inherited from the previous phase, with -1 for vertices without a seed. Only the
+//uncolored vertices and the losers of the conflicts in the seed are recolored, followed
+//by the same detect conflicts / recolor rounds as algoDistanceOneVertexColoringOpt.
+//Return the number of colors used (zero is a valid color)
+int algoDistanceOneVertexRecoloring(graph *G, int *vtxColor, int nThreads, double *totTime)
+{
+#ifdef PRINT_DETAILED_STATS_
+  //printf("Within algoDistanceOneVertexRecoloring()\n");
+#endif
+
+  ompThreadsScope threadsScope(nThreads); //Restored on return
+  int nT;
+
+	#pragma omp parallel
+  {
+		nT = omp_get_num_threads();
+  }
+  parallelBackendScope backendScope(parallelBackend(), nT);
+
+  double time1=0, totalTime=0;
+  long NVer    = G->numVertices;
+
+  long *Q    = (long *) malloc (NVer * sizeof(long)); assert(Q != 0);
+  long *Qtmp = (long *) malloc (NVer * sizeof(long)); assert(Qtmp != 0);
+  long *Qswap;
+  long QTail=0;    //Tail of the queue
+  long QtmpTail=0; //Tail of the queue (implicitly will represent the size)
+  ColorVector freq(MaxDegree,0);
+  //The passes split the vertices, then the queues, between the threads by edges
+  vertexSchedule sched;
+  buildVertexSchedule(G->edgeListPtrs, NVer, nT, false, &sched);
+  long *work   = (long *) malloc ((NVer+1) * sizeof(long)); assert(work != 0);
+  long *bounds = sched.bounds; //Vertex ranges of the seed pass, then queue ranges
+  auto range = [&](int t, long *begin, long *end) {
+    *begin = bounds[t];
+    *end   = bounds[t+1];
+  };
+
+  time1 = omp_get_wtime();
+
+  //Seed pass: a vertex keeps its seeded color unless it loses a conflict on it;
+  //uncolored vertices and losers are queued and recolored right away. Colors kept
+  //in this pass never change, so only the queued vertices can be in conflict.
+	parallelForRanges(nT, 0, NVer, range, [&](long begin, long end, int slot) {
+  for (long v=begin; v<end; v++) {
+    Qtmp[v] = -1; //Empty queue
+    if (vtxColor[v] >= 0) {
+      distanceOneConfResolution(G, v, vtxColor, &QTail, Q, freq, 0);
+    } else {
+      long whereInQ = __sync_fetch_and_add(&QTail, 1);
+      Q[whereInQ] = v;
+    }
+    if (vtxColor[v] < 0)
+      vtxColor[v] = smallestAvailableColor(G, v, vtxColor);
+  }
+	});
+  long nConflicts = QTail; //Number of vertices recolored
+  int nLoops = 0;          //Number of rounds of conflict resolution
+
+  while (QTail > 0) {
+    //Detect the conflicts among the recolored vertices:
+		queueRanges(G, Q, QTail, nT, work, bounds);
+		parallelForRanges(nT, 0, QTail, range, [&](long begin, long end, int slot) {
+		for (long Qi=begin; Qi<end; Qi++) {
+			distanceOneConfResolution(G, Q[Qi], vtxColor, &QtmpTail, Qtmp, freq, 0);
+		} //End of outer for loop: for each vertex
+		});
+    //Recolor the losers in parallel - do not worry about conflicts
+		queueRanges(G, Qtmp, QtmpTail, nT, work, bounds);
+		parallelForRanges(nT, 0, QtmpTail, range, [&](long begin, long end, int slot) {
+    for (long Qi=begin; Qi<end; Qi++) {
+      long v = Qtmp[Qi];
+			vtxColor[v] = smallestAvailableColor(G, v, vtxColor);
+		} //End of outer for loop: for each vertex
+		});
+		nConflicts += QtmpTail;
+		nLoops++;
+
+    //Swap the two queues:
+    Qswap = Q;
+    Q = Qtmp; //Q now points to the second vector
+    Qtmp = Qswap;
+    QTail = QtmpTail; //Number of elements
+    QtmpTail = 0; //Symbolic emptying of the second queue
+  }//End of while()
+  totalTime = omp_get_wtime() - time1;
+
+  //Check the number of colors used
+  int nColors = -1;
+	#pragma omp parallel for reduction(max: nColors)
+  for (long v=0; v < NVer; v++ )
+    if (vtxColor[v] > nColors) nColors = vtxColor[v];
+#ifdef PRINT_DETAILED_STATS_
+  //printf("***********************************************\n");
+  //printf("Total number of colors used: %d \n", nColors);
+  //printf("Number of vertices recolored: %ld \n", nConflicts);
+  //printf("Number of rounds           : %d \n", nLoops);
+  //printf("Total Time                 : %lf sec\n", totalTime);
+  //printf("***********************************************\n");
+#endif
+  *totTime = totalTime;
+
+  //Clean Up:
+  free(Q);
+  free(Qtmp);
+  free(work);
+  freeVertexSchedule(&sched);
+
+  return nColors; //Return the number of colors used
+}//End of algoDistanceOneVertexRecoloring()
+
+
 //////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////  DISTANCE ONE COLORING      ///////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////
@@ -240,10 +393,7 @@ int algoDistanceOneVertexColoringOpt(graph *G, int *vtxColor, int nThreads, doub
 int algoDistanceOneVertexColoring(graph *G, int *vtxColor, int nThreads, double *totTime)
 {
 	//printf("Within algoDistanceOneVertexColoring()\n");
-	if (nThreads < 1)
-		omp_set_num_threads(1); //default to one thread
-	else
-		omp_set_num_threads(nThreads);
+	ompThreadsScope threadsScope(nThreads); //Restored on return
 	int nT;
 #pragma omp parallel
 	{
@@ -264,14 +414,6 @@ int algoDistanceOneVertexColoring(graph *G, int *vtxColor, int nThreads, double
 
   //const int MaxDegree = 4096; //Increase if number of colors is larger    
 
-  //Build a vector of random numbers
-  double *randValues = (double*) malloc (NVer * sizeof(double));
-  if( randValues == NULL ) {
-    //printf("Not enough memory to allocate for random numbers \n");
-    exit(1);
-  }
-  generateRandomNumbers(randValues, NVer);
-
   //The Queue Data Structure for the storing the vertices 
   //   the need to be colored/recolored
   //Have two queues - read from one, write into another
@@ -367,8 +509,8 @@ int algoDistanceOneVertexColoring(graph *G, int *vtxColor, int nThreads, double
 	//continue;
 	if ( vtxColor[v] == vtxColor[verInd[k].tail] ) {
 	  //Q.push_back(v or w)
-	  if ( (randValues[v] < randValues[verInd[k].tail]) || 
-	       ((randValues[v] == randValues[verInd[k].tail])&&(v < verInd[k].tail)) ) {
+	  if ( (vertexPriority(v) < vertexPriority(verInd[k].tail)) || 
+	       ((vertexPriority(v) == vertexPriority(verInd[k].tail))&&(v < verInd[k].tail)) ) {
 	    long whereInQ = __sync_fetch_and_add(&QtmpTail, 1);
 	    Qtmp[whereInQ] = v;//Add to the queue
 	    vtxColor[v] = -1;  //Will prevent v from being in conflict in another pairing
@@ -431,7 +573,6 @@ int algoDistanceOneVertexColoring(graph *G, int *vtxColor, int nThreads, double
   free(Q);
   free(Qtmp);
   free(Mark); 
-  free(randValues);
   
   return nColors; //Return the number of colors used
 }
@@ -40,6 +40,7 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "coloring.h"
 #include "stdlib.h"
 #include "time.h"
@@ -49,24 +50,13 @@
 //////////////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////
 
-void generateRandomNumbers2(double* randValues, long NVer)
-{
-    for(int v = 0; v<NVer; v++)
-    {
-        randValues[v] = (double)rand();
-    }
-}
-
 int algoColoringMultiHashMaxMin(graph *G, int *vtxColor, int nThreads, double *totTime, int nHash, int nItrs)
 {
 #ifdef PRINT_DETAILED_STATS_
-    std::cout << "Within algoColoringMultiHashMaxMin(nHash= " << nHash << " -- nItrs= " << nItrs << ")\n";
+    LOG_DEBUG("Within algoColoringMultiHashMaxMin(nHash= %d -- nItrs= %d)\n", nHash, nItrs);
 #endif
     
-    if (nThreads < 1)
-        omp_set_num_threads(1); //default to one thread
-    else
-        omp_set_num_threads(nThreads);
+    ompThreadsScope threadsScope(nThreads); //Restored on return
     int nT;
     
 #pragma omp parallel
@@ -75,7 +65,7 @@ int algoColoringMultiHashMaxMin(graph *G, int *vtxColor, int nThreads, double *t
     }
     
 #ifdef PRINT_DETAILED_STATS_
-    printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
+    LOG_DEBUG("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 #endif
     assert(nItrs > 0); assert(nHash > 0);
     double time1=0, time2=0, totalTime=0;
@@ -88,35 +78,20 @@ int algoColoringMultiHashMaxMin(graph *G, int *vtxColor, int nThreads, double *t
     int maxColor = (2 * nHash * nItrs); //Two colors for each hash per iteration; zero is a valid color
     int totalColored = 0;
 #ifdef PRINT_DETAILED_STATS_
-    printf("Vertices: %ld  Edges: %ld   Max color index: %d\n\n\n", NVer, NEdge, maxColor);
+    LOG_DEBUG("Vertices: %ld  Edges: %ld   Max color index: %d\n\n\n", NVer, NEdge, maxColor);
 #endif
     
-    //Build a vector of random numbers:
-    //Note: Cheating a little bit now -- need to fix this with a hash function
-    /*
-     double *randValues = (double*) malloc (NVer * sizeof(double));
-     assert(randValues != 0); */
-    time1 = omp_get_wtime();
-    double **randValuesPtr = (double**) malloc(nHash * sizeof(double*));
-    for(int i=0; i < nHash; i++)
-    {
-        randValuesPtr[i] = (double*) malloc (NVer * sizeof(double));
-        generateRandomNumbers2(randValuesPtr[i], NVer);
-    }
-    time2 = omp_get_wtime();
-    totalTime = time2-time1;
-#ifdef PRINT_DETAILED_STATS_
-    printf("Time to generate random numbers: %lf\n", time2-time1);
-#endif
+    //The random value of a vertex for a given hash is computed on the fly with
+    //hashRandom(v, RandomSeed, ihash): no per-hash arrays need to be stored
     //Color all the vertices to a maximum number (means that the vertex did not get colored)
 #pragma omp parallel for
     for (long v=0; v<NVer; v++) {
         vtxColor[v] = maxColor; //Set the color to maximum
     }
     int iterFreq = 0;
-    printf("--------------------------------------------------------------\n");
-    printf("Itr \t This iteration \t\t Total colored\n");
-    printf("--------------------------------------------------------------\n");
+    LOG_DEBUG("--------------------------------------------------------------\n");
+    LOG_DEBUG("Itr \t This iteration \t\t Total colored\n");
+    LOG_DEBUG("--------------------------------------------------------------\n");
     //Loop through the iterations:
     for (int itr=0; itr<nItrs; itr++) {
         //Iterate for the number of hashes
@@ -134,16 +109,18 @@ int algoColoringMultiHashMaxMin(graph *G, int *vtxColor, int nThreads, double *t
                 long adj2 = verPtr[v+1];
                 //Browse the adjacency set of vertex v
                 bool isMax = true, isMin = true;
+                unsigned long long myHash = hashRandom(v, RandomSeed, ihash);
                 for(long k = adj1; k < adj2; k++ ) {
                     if ( v == verInd[k].tail ) //Self-loops
                         continue;
                     //if(vtxColor[verInd[k].tail] < maxColor)
                     if(vtxColor[verInd[k].tail] < currentColor) //Colored in previous iterations
                         continue; //It has already been colored -- ignore this neighbor
-                    if ( randValuesPtr[ihash][v] <= randValuesPtr[ihash][verInd[k].tail] ) {
+                    unsigned long long adjHash = hashRandom(verInd[k].tail, RandomSeed, ihash);
+                    if ( myHash <= adjHash ) {
                         isMax = false;
                     }
-                    if ( randValuesPtr[ihash][v] >= randValuesPtr[ihash][verInd[k].tail] ) {
+                    if ( myHash >= adjHash ) {
                         isMin = false;
                     }
                     //Corner case: if all neighbors have been colored,
@@ -162,11 +139,11 @@ int algoColoringMultiHashMaxMin(graph *G, int *vtxColor, int nThreads, double *t
         }//End of for(ihash)
         totalColored += iterFreq;
         time2 = omp_get_wtime();
-        totalTime = time2-time1;
-        printf("%d \t %d (%3.2lf%%) \t\t\t %d (%3.2lf%%)\n", itr, iterFreq, (double)iterFreq/NVer*100, totalColored, (double)totalColored/NVer*100);
+        totalTime += time2-time1;
+        LOG_DEBUG("%d \t %d (%3.2lf%%) \t\t\t %d (%3.2lf%%)\n", itr, iterFreq, (double)iterFreq/NVer*100, totalColored, (double)totalColored/NVer*100);
         if(iterFreq == 0) {
             if(totalColored == NVer) {
-                printf("All vertices got colored in a smaller number\n");
+                LOG_DEBUG("All vertices got colored in a smaller number\n");
                 maxColor = (2*(itr-1)*nHash) + 2*nHash + 1;
                 break;
             }
@@ -174,7 +151,7 @@ int algoColoringMultiHashMaxMin(graph *G, int *vtxColor, int nThreads, double *t
             iterFreq = 0; //reset the counter
         }
     } //End of for(itr)
-    printf("--------------------------------------------------------------\n");
+    LOG_DEBUG("--------------------------------------------------------------\n");
     
     //Verify Results and Cleanup
     long myConflicts = 0;
@@ -199,28 +176,18 @@ int algoColoringMultiHashMaxMin(graph *G, int *vtxColor, int nThreads, double *t
     myConflicts = myConflicts / 2; //Have counted each conflict twice
     
     if (myConflicts > 0)
-        printf("Check - WARNING: Number of conflicts detected after resolution: %d \n\n", myConflicts);
+        LOG_WARN("Check - WARNING: Number of conflicts detected after resolution: %d \n\n", myConflicts);
     else
-        printf("Check - SUCCESS: No conflicts exist\n\n");
+        LOG_DEBUG("Check - SUCCESS: No conflicts exist\n\n");
 #ifdef PRINT_DETAILED_STATS_
-    printf("***********************************************\n");
-    printf("Number of colors used        : %d \n", maxColor);
-    printf("Number of uncolored vertices : %d \n", unColored);
-    printf("Total Time                   : %3.3lf sec\n", totalTime);
-    printf("***********************************************\n");
+    LOG_DEBUG("***********************************************\n");
+    LOG_DEBUG("Number of colors used        : %d \n", maxColor);
+    LOG_DEBUG("Number of uncolored vertices : %d \n", unColored);
+    LOG_DEBUG("Total Time                   : %3.3lf sec\n", totalTime);
+    LOG_DEBUG("***********************************************\n");
 #endif
     *totTime = totalTime;
     
-    //Cleanup:
-    for(int i = 0; i < nHash; i++)
-    {
-        //	for(int j =0; j < NVer; j++)
-        //		printf("%lf",randValuesPtr[i][j]);
-        if (randValuesPtr[i] != 0)
-            free(randValuesPtr[i]);
-    }
-    if (randValuesPtr != 0)
-        free(randValuesPtr);
     return maxColor; //Return the number of colors used (maxColor is also a valid color)
     
 }//End of algoColoringMultiHashMaxMin()
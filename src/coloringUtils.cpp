@@ -37,7 +37,7 @@ void computeBinSizes(ColorVector &binSizes, int* colors, long nv, int numColors)
 			}
 		}
 	}
-	delete bigHolder;
+	delete[] bigHolder;
 }
 
 // Loop to mark the used colors
@@ -55,7 +55,7 @@ int distanceOneMarkArray(BitVector &mark, graph *G, long v, int *vtxColor)
 		adjColor = vtxColor[verInd[k].tail];
 		if (adjColor >= 0) {
 			if (adjColor >= MaxDegree) {
-				std::cerr << "Maximum number of colors exceeded: " << adjColor << " Increase the MaxDegree"<<std::endl;
+				LOG_ERROR("Maximum number of colors exceeded: %d Increase the MaxDegree\n", adjColor);
 				exit(EXIT_FAILURE);
 			}
 			mark[adjColor] = true;
@@ -67,20 +67,22 @@ int distanceOneMarkArray(BitVector &mark, graph *G, long v, int *vtxColor)
 }
 
 
-void distanceOneConfResolution(graph* G, long v, int* vtxColor, double* randValues, long* QtmpTail, long* Qtmp, ColorVector& freq, int type)
+void distanceOneConfResolution(graph* G, long v, int* vtxColor, long* QtmpTail, long* Qtmp, ColorVector& freq, int type)
 {
 	long *verPtr = G->edgeListPtrs;   //Vertex Pointer: pointers to endV
   edge *verInd = G->edgeList;       //Vertex Index: destination id of an edge (src -> dest)
 	int maxColor = -1, adjColor = -1;
 	long adj1 = verPtr[v];
 	long adj2 = verPtr[v+1];
+	unsigned long long myPriority = vertexPriority(v);
 	
 	//Browse the adjacency set of vertex v
 	for(long k = adj1; k < adj2; k++ ) {
 		if ( v == verInd[k].tail ) //Self-loops
 			continue;
 		if ( vtxColor[v] == vtxColor[verInd[k].tail] ) {
-			if ( (randValues[v] < randValues[verInd[k].tail]) || ((randValues[v] == randValues[verInd[k].tail])&&(v < verInd[k].tail)) ) {
+			unsigned long long wPriority = vertexPriority(verInd[k].tail);
+			if ( (myPriority < wPriority) || ((myPriority == wPriority)&&(v < verInd[k].tail)) ) {
 				long whereInQ = __sync_fetch_and_add(QtmpTail, 1);
 				Qtmp[whereInQ] = v;//Add to the queue
 				if(type!= 0 &&  vtxColor[v] != -1 )
@@ -133,12 +135,12 @@ void distanceOneChecked(graph* G, long nv ,int* colors)
         long adj2 = verPtr[ci+1];
 		for (long k = adj1; k < adj2; k++) {
 			if(ci != verInd[k].tail && colors[ci] == colors[verInd[k].tail]){
-				std::cout<<"Fail"<<std::endl;
+				LOG_ERROR("Fail\n");
 				exit(1);
 			}
 		}
 	}
-	std::cout<<"Success" <<std::endl;
+	LOG_DEBUG("Success\n");
 	return;
 }
 
@@ -13,12 +13,12 @@
 #include <sstream>
 #include <vector>
 #include <fstream>
-#include "RngStream.h"
 //##include <timer.h>
 #include <ctime>
 #include <cstdlib>
 #include <omp.h>
 #include "defs.h"
+#include "basic_util.h"
 
 
 
@@ -39,7 +39,9 @@ typedef int ColorElem;
 
 int distanceOneMarkArray(BitVector &mark, graph *G, long v, int *vtxColor);
 void computeBinSizes(ColorVector &binSizes, int* colors, long nv, int numColors);
-void distanceOneConfResolution(graph* G, long v, int* vtxColor, double* randValues, long* QtmpTail, long* Qtmp, ColorVector& freq, int type);
+//Priority of vertex v for breaking conflicts (larger wins; ties are broken by vertex id)
+inline unsigned long long vertexPriority(long v) { return hashRandom(v, RandomSeed, 0); }
+void distanceOneConfResolution(graph* G, long v, int* vtxColor, long* QtmpTail, long* Qtmp, ColorVector& freq, int type);
 void distanceOneChecked(graph* G, long nv ,int* colors);
 void buildColorsIndex(int* colors, const int numColors, const long nv, ColorVector& colorPtr,  ColorVector& colorIndex, ColorVector& binSizes);
 
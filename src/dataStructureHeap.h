@@ -63,4 +63,175 @@ void heapInitializeToN(heap *myHeap, long n); /* Initialize to n */
 void heapAdd(heap *, term);
 void heapRemoveMin(heap *);
 
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+
+/* Indexed priority queues of the ids 0..n-1. Unlike heap, they know where every
+   id is, so a key can be lowered in place (decrease-key) instead of adding the
+   id again. Ties are broken by id: the order of removal is deterministic. */
+
+/* d-ary min-heap: D children per node. The entries are 64-byte aligned and shifted
+   so that the children of a node start a cache line: with D=4 and 16-byte entries,
+   a sift-down reads one line per level, on a tree half as deep as a binary one. */
+template <typename Key, int D = 4>
+class dAryHeap {
+public:
+    explicit dAryHeap(long n) : num(0) {
+        void *mem = NULL;
+        int err = posix_memalign(&mem, 64, (n + D) * sizeof(entry));
+        assert(err == 0); (void) err;
+        base = (entry *) mem;
+        entries = base + (D - 1); //Children of i at D*i+1..D*i+D: aligned groups
+        pos = (long *) malloc ((n + 1) * sizeof(long)); assert(pos != 0); //Not NULL for n=0
+        memset(pos, -1, n * sizeof(long));
+    }
+    ~dAryHeap() { free(base); free(pos); }
+
+    long size() const { return num; }
+    bool empty() const { return num == 0; }
+    bool contains(long id) const { return pos[id] >= 0; }
+    Key key(long id) const { return entries[pos[id]].key; }
+    long top() const { return entries[0].id; }
+    Key topKey() const { return entries[0].key; }
+
+    void push(long id, Key key) {
+        assert(pos[id] < 0);
+        entries[num].key = key;
+        entries[num].id = id;
+        pos[id] = num;
+        siftUp(num++);
+    }
+    void pop() {
+        pos[entries[0].id] = -1;
+        if (--num > 0) {
+            entries[0] = entries[num];
+            pos[entries[0].id] = 0;
+            siftDown(0);
+        }
+    }
+    //New key no larger than the current one
+    void decreaseKey(long id, Key key) {
+        long i = pos[id];
+        assert((i >= 0) && !(entries[i].key < key));
+        entries[i].key = key;
+        siftUp(i);
+    }
+
+private:
+    typedef struct { Key key; long id; } entry;
+    entry *base, *entries;
+    long *pos;
+    long num;
+
+    static bool before(const entry &a, const entry &b) {
+        return (a.key < b.key) || (!(b.key < a.key) && (a.id < b.id));
+    }
+    void siftUp(long i) {
+        entry e = entries[i];
+        while (i > 0) {
+            long parent = (i - 1) / D;
+            if (!before(e, entries[parent]))
+                break;
+            entries[i] = entries[parent];
+            pos[entries[i].id] = i;
+            i = parent;
+        }
+        entries[i] = e;
+        pos[e.id] = i;
+    }
+    void siftDown(long i) {
+        entry e = entries[i];
+        while (true) {
+            long first = D * i + 1;
+            if (first >= num)
+                break;
+            long last = (first + D < num) ? first + D : num;
+            long best = first;
+            for (long c=first+1; c<last; c++)
+                if (before(entries[c], entries[best]))
+                    best = c;
+            if (!before(entries[best], e))
+                break;
+            entries[i] = entries[best];
+            pos[entries[i].id] = i;
+            i = best;
+        }
+        entries[i] = e;
+        pos[e.id] = i;
+    }
+};//End of dAryHeap
+
+/* Bucket queue for small integer keys 0..maxKey, such as degrees: one doubly
+   linked list per key. push(), pop() and changeKey() take constant time, plus
+   the scan of empty buckets by pop() from the smallest key pushed since. Ids
+   of a bucket come out in the order they went in. */
+class bucketQueue {
+public:
+    bucketQueue(long n, long maxKey) : numKeys(maxKey + 1), num(0), minKey(maxKey + 1) {
+        head  = (long *) malloc (numKeys * sizeof(long)); assert(head != 0);
+        tail  = (long *) malloc (numKeys * sizeof(long)); assert(tail != 0);
+        next  = (long *) malloc ((n + 1) * sizeof(long)); assert(next != 0);
+        prev  = (long *) malloc ((n + 1) * sizeof(long)); assert(prev != 0);
+        keyOf = (long *) malloc ((n + 1) * sizeof(long)); assert(keyOf != 0);
+        memset(head, -1, numKeys * sizeof(long));
+        memset(tail, -1, numKeys * sizeof(long));
+        memset(keyOf, -1, n * sizeof(long));
+    }
+    ~bucketQueue() { free(head); free(tail); free(next); free(prev); free(keyOf); }
+
+    long size() const { return num; }
+    bool empty() const { return num == 0; }
+    bool contains(long id) const { return keyOf[id] >= 0; }
+    long key(long id) const { return keyOf[id]; }
+    //Smallest key, and the first id with that key; the queue must not be empty
+    long topKey() { skipEmpty(); return minKey; }
+    long top() { skipEmpty(); return head[minKey]; }
+
+    void push(long id, long key) {
+        assert((keyOf[id] < 0) && (key >= 0) && (key < numKeys));
+        link(id, key);
+        num++;
+    }
+    void pop() { remove(top()); }
+    void remove(long id) {
+        unlink(id);
+        keyOf[id] = -1;
+        num--;
+    }
+    //Move id to the end of the bucket of key, smaller or larger
+    void changeKey(long id, long key) {
+        assert((keyOf[id] >= 0) && (key >= 0) && (key < numKeys));
+        unlink(id);
+        link(id, key);
+    }
+
+private:
+    long *head, *tail, *next, *prev, *keyOf;
+    long numKeys, num, minKey;
+
+    void skipEmpty() {
+        assert(num > 0);
+        while (head[minKey] < 0)
+            minKey++;
+    }
+    void link(long id, long key) {
+        keyOf[id] = key;
+        next[id] = -1;
+        prev[id] = tail[key];
+        if (tail[key] >= 0)
+            next[tail[key]] = id;
+        else
+            head[key] = id;
+        tail[key] = id;
+        if (key < minKey)
+            minKey = key;
+    }
+    void unlink(long id) {
+        long key = keyOf[id];
+        if (prev[id] >= 0) next[prev[id]] = next[id]; else head[key] = next[id];
+        if (next[id] >= 0) prev[next[id]] = prev[id]; else tail[key] = prev[id];
+    }
+};//End of bucketQueue
+
 #endif
@@ -56,6 +56,7 @@
 #include <map>
 #include <vector>
 #include <unistd.h> //For getopts()
+#include "logging.h"
 
 #define MilanRealMax HUGE_VAL       // +INFINITY
 #define MilanRealMin -MilanRealMax  // -INFINITY
@@ -132,6 +133,5 @@ struct clustering_parameters
 
 //Reverse Cuthill-McKee Algorithm
 void algoReverseCuthillMcKee( graph *G, long *pOrder, int nThreads );
-void algoReverseCuthillMcKeeStrict( graph *G, long *pOrder, int nThreads );
 
 #endif
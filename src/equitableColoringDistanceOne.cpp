@@ -43,6 +43,7 @@
 
 #include "defs.h"
 #include "coloring.h"
+#include "parallel_scan.h"
 //Compute the size of each color class
 //Return: pointer to a vector that stores the size of each color class
 void buildColorSize(long NVer, int *vtxColor, int numColors, long *colorSize) {
@@ -62,26 +63,26 @@ void computeVariance(long NVer, int numColors, long *colorSize) {
   long max = 0;    //Initialize to zero
   long min = NVer; //Initialize to some large number
   
-    printf("ci= ");
+    LOG_DEBUG("ci= ");
 //#pragma omp parallel for reduction(+:variance), reduction(max:max), reduction(min:min)
   for(long ci=0; ci<numColors; ci++) {
-      printf("%ld, ", ci);
+      LOG_DEBUG("%ld, ", ci);
     variance  += (avg - (double)colorSize[ci])*(avg - (double)colorSize[ci]);
     if(colorSize[ci] > max)
       max = colorSize[ci];
     if(colorSize[ci] < min)
       min = colorSize[ci];
   }
-    printf("\n");
+    LOG_DEBUG("\n");
   variance = variance / (double)numColors;
-  printf("==========================================\n");
-  printf("Characteristics of color class sizes:     \n");
-  printf("==========================================\n");
-  printf("MinSize  : %ld \n", min);  
-  printf("MaxSize  : %ld \n", max);
-  printf("Mean     : %g  \n", (double)NVer / (double)numColors);
-  printf("Varaince : %g  \n", variance);
-  printf("==========================================\n");
+  LOG_DEBUG("==========================================\n");
+  LOG_DEBUG("Characteristics of color class sizes:     \n");
+  LOG_DEBUG("==========================================\n");
+  LOG_DEBUG("MinSize  : %ld \n", min);  
+  LOG_DEBUG("MaxSize  : %ld \n", max);
+  LOG_DEBUG("Mean     : %g  \n", (double)NVer / (double)numColors);
+  LOG_DEBUG("Varaince : %g  \n", variance);
+  LOG_DEBUG("==========================================\n");
   
 }//End of calVariance()
 
@@ -90,7 +91,7 @@ void computeVariance(long NVer, int numColors, long *colorSize) {
 void equitableDistanceOneColorBased(graph *G, int *vtxColor, int numColors, long *colorSize, 
 				    int nThreads, double *totTime, int type) {
 
-  printf("Within equitableColorBasedFirstFit(numColors=%d -- nT = %d)\n", numColors, nThreads);
+  LOG_DEBUG("Within equitableColorBasedFirstFit(numColors=%d -- nT = %d)\n", numColors, nThreads);
   /*
   if (nThreads < 1)
     omp_set_num_threads(1); //default to one thread
@@ -102,7 +103,7 @@ void equitableDistanceOneColorBased(graph *G, int *vtxColor, int numColors, long
   {
     nT = omp_get_num_threads();
   }
-  printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
+  LOG_DEBUG("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 
   double time1=0, time2=0, totalTime=0;
   //Get the iterators for the graph:
@@ -111,7 +112,7 @@ void equitableDistanceOneColorBased(graph *G, int *vtxColor, int numColors, long
   long *verPtr = G->edgeListPtrs;   //Vertex Pointer: pointers to endV
   edge *verInd = G->edgeList;       //Vertex Index: destination id of an edge (src -> dest)
 #ifdef PRINT_DETAILED_STATS_
-  printf("Vertices: %ld  Edges: %ld  Num Colors= %ld\n", NVer, NEdge, numColors);
+  LOG_DEBUG("Vertices: %ld  Edges: %ld  Num Colors= %ld\n", NVer, NEdge, numColors);
 #endif
 
   //STEP-1: Create a CSR-like data structure for vertex-colors
@@ -119,21 +120,21 @@ void equitableDistanceOneColorBased(graph *G, int *vtxColor, int numColors, long
  
   long *colorIndex = (long *) malloc (NVer * sizeof(long)); assert(colorIndex != 0);
   long *colorAdded = (long *) malloc (numColors * sizeof(long)); assert(colorAdded != 0);
-  printf("Reached here...1\n");  
+  LOG_DEBUG("Reached here...1\n");  
 
 #pragma omp parallel for
   for(long i = 0; i < numColors; i++) {	
     colorAdded[i] = 0;
   }
 
-  printf("Reached here...2\n"); 
+  LOG_DEBUG("Reached here...2\n"); 
 
  long *colorPtr = (long *) malloc ((numColors+1) * sizeof(long)); assert(colorPtr != 0);
 #pragma omp parallel for
   for(long i = 0; i <= numColors; i++) {	
     colorPtr[i] = 0;
   }
-  printf("\nReached here... 0.5\n"); 
+  LOG_DEBUG("\nReached here... 0.5\n"); 
 
 
 
@@ -142,12 +143,10 @@ void equitableDistanceOneColorBased(graph *G, int *vtxColor, int numColors, long
   for(long i = 0; i < NVer; i++) {
     __sync_fetch_and_add(&colorPtr[(long)vtxColor[i]+1],1);
   }
-  printf("Reached here...2.5\n"); 
+  LOG_DEBUG("Reached here...2.5\n"); 
   //Prefix sum:
-  for(long i=0; i<numColors; i++) {
-    colorPtr[i+1] += colorPtr[i];
-  }	
-  printf("Reached here...3\n");  
+  parallelInclusiveScan(colorPtr, numColors+1);
+  LOG_DEBUG("Reached here...3\n");  
 
   //Group vertices with the same color in particular order
 //#pragma omp parallel for
@@ -158,12 +157,12 @@ void equitableDistanceOneColorBased(graph *G, int *vtxColor, int numColors, long
   }
   time2 = omp_get_wtime();
   totalTime += time2 - time1;
-  printf("Time to initialize: %3.3lf\n", time2-time1);
+  LOG_DEBUG("Time to initialize: %3.3lf\n", time2-time1);
   
   //long avgColorSize = (long)ceil( (double)NVer/(double)numColor );
   long avgColorSize = (NVer + numColors - 1) / numColors;
   
-  printf("Reached here...3\n");  
+  LOG_DEBUG("Reached here...3\n");  
 
   //STEP-2: Start moving the vertices from one color bin to another
   time1 = omp_get_wtime();
@@ -218,8 +217,8 @@ void equitableDistanceOneColorBased(graph *G, int *vtxColor, int numColors, long
   time2  = omp_get_wtime();
   totalTime += time2 - time1;
 #ifdef PRINT_DETAILED_STATS_
-  printf("Time taken for re-coloring:  %lf sec.\n", time2-time1);
-  printf("Total Time for re-coloring:  %lf sec.\n", totalTime);
+  LOG_DEBUG("Time taken for re-coloring:  %lf sec.\n", time2-time1);
+  LOG_DEBUG("Total Time for re-coloring:  %lf sec.\n", totalTime);
 #endif
   
   *totTime = totalTime;
@@ -245,9 +244,9 @@ void equitableDistanceOneColorBased(graph *G, int *vtxColor, int numColors, long
   }//End of outer for loop: for each vertex
   myConflicts = myConflicts / 2; //Have counted each conflict twice
   if (myConflicts > 0)
-    printf("Check - WARNING: Number of conflicts detected after resolution: %d \n\n", myConflicts);
+    LOG_WARN("Check - WARNING: Number of conflicts detected after resolution: %d \n\n", myConflicts);
   else
-    printf("Check - SUCCESS: No conflicts exist\n\n");
+    LOG_DEBUG("Check - SUCCESS: No conflicts exist\n\n");
   
 }//End of colorBasedEquitable()
 	
@@ -20,7 +20,10 @@ double buildAndLockLocalMapCounter(long v, mapElement* clusterLocalMap, long* vt
 
 
 	// Has to be one over to act like array.end()
-	std::sort(&vtxInd[adj1],&vtxInd[adj2],byVertexId);
+	// Sorted lists, such as those of a graph sorted once before repeated
+	// clusterings, are left untouched
+	if(!std::is_sorted(&vtxInd[adj1],&vtxInd[adj2],byVertexId))
+		std::sort(&vtxInd[adj1],&vtxInd[adj2],byVertexId);
 
 	/*********** Calculate eii ***************/
 	// Lock all neighbors to make sure no move is performed // This Lock is to protect Data: Allow to have error
@@ -28,6 +31,8 @@ double buildAndLockLocalMapCounter(long v, mapElement* clusterLocalMap, long* vt
    // long nn = adj2-adj1;
    // long fracFree = (nn*freedom/10);
    // if( rand()%nn >= fracFree)
+		if((j > adj1) && (vtxInd[j].tail == vtxInd[j-1].tail))
+			continue; //Parallel edge: the lock is already held (locks are not reentrant)
   		omp_set_lock(&vlocks[vtxInd[j].tail]);
 	}
 	
@@ -131,6 +136,8 @@ void maxAndFree(long v, mapElement* clusterLocalMap, long* vtxPtr, edge* vtxInd,
 	/*********** Calculate eii ***************/
 	// unLock all neighbors vertex
 	for(long j=adj1; j<adj2; j++){
+		if((j > adj1) && (vtxInd[j].tail == vtxInd[j-1].tail))
+			continue; //Parallel edge: released already
 		omp_unset_lock(&vlocks[vtxInd[j].tail]);
 	}
 
@@ -0,0 +1,435 @@
+#include "defs.h"
+#include "input_output.h"
+#include "basic_util.h"
+#include "parallel_scan.h"
+#include <algorithm>
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////////////
+////////////////////  SYNTHETIC GRAPHS WITH PLANTED COMMUNITIES  /////////////////////
+//////////////////////////////////////////////////////////////////////////////////////
+//All random numbers come from hashRandom() indexed by the vertex, edge or community
+//they belong to, so a generated graph depends only on its parameters and the seed,
+//not on the number of threads. The generators fill G through buildGraphFromEdgeList()
+//and, if C is not NULL, write the planted community of every vertex into C.
+//They return the number of planted communities, or -1 if the parameters are invalid.
+
+//Streams of hashRandom(), one per use
+#define StreamCommunity  1
+#define StreamDegree     2
+#define StreamPermute    3
+#define StreamEdge       16  //Edge draws use StreamEdge + 2*attempt + endpoint
+#define StreamCenter     4
+#define StreamPoint      5
+#define StreamComponent  6
+#define StreamProjection 7
+
+#define MaxAttempts      16  //Redraws of an endpoint before falling back to a fixed choice
+
+//Uniform integer in [0, n)
+static inline long uniformLong(unsigned long long i, unsigned long long seed, unsigned long long stream, long n) {
+  long r = (long) (hashRandomU01(i, seed, stream) * (double) n);
+  return (r < n) ? r : n - 1;
+}
+
+//Standard normal variate (Box-Muller)
+static inline double normalRandom(unsigned long long i, unsigned long long seed, unsigned long long stream) {
+  double u1 = 1.0 - hashRandomU01(2*i, seed, stream); //In (0,1]
+  double u2 = hashRandomU01(2*i + 1, seed, stream);
+  return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+//Bijective shuffle of [0, NV): a four-round Feistel network on the smallest
+//even number of bits that covers NV, with cycle-walking for values >= NV.
+//Used to scatter the planted communities, which are generated as contiguous blocks.
+static inline long permuteVertex(long v, long NV, unsigned long long seed) {
+  int halfBits = 1;
+  while ((1L << (2*halfBits)) < NV)
+    halfBits++;
+  unsigned long long mask = (1ULL << halfBits) - 1;
+  unsigned long long x = (unsigned long long) v;
+  do {
+    unsigned long long L = x >> halfBits, R = x & mask;
+    for (int round=0; round<4; round++) {
+      unsigned long long F = hashRandom(R, seed, StreamPermute + 64*round) & mask;
+      unsigned long long T = L ^ F;
+      L = R;
+      R = T;
+    }
+    x = (L << halfBits) | R;
+  } while (x >= (unsigned long long) NV);
+  return (long) x;
+}
+
+//Relabel the edges and the ground truth with permuteVertex(), then build G
+static void buildPermutedGraph(graph *G, long *C, long NV, long NE, edge *tmpEdgeList,
+                               long *community, unsigned long long seed) {
+#pragma omp parallel for
+  for (long i=0; i<NE; i++) {
+    tmpEdgeList[i].head = permuteVertex(tmpEdgeList[i].head, NV, seed);
+    tmpEdgeList[i].tail = permuteVertex(tmpEdgeList[i].tail, NV, seed);
+  }
+  if (C != NULL) {
+#pragma omp parallel for
+    for (long v=0; v<NV; v++)
+      C[permuteVertex(v, NV, seed)] = community[v];
+  }
+  buildGraphFromEdgeList(G, NV, NE, tmpEdgeList);
+}//End of buildPermutedGraph()
+
+//Planted partition (stochastic block model with two edge probabilities):
+//numCommunities blocks of (almost) equal size, NV*avgDegree/2 edges. Each edge
+//picks a uniform endpoint u; with probability 1-mu the other endpoint is uniform
+//within the block of u, otherwise uniform over the vertices outside it.
+//Parallel edges are possible; self-loops are not.
+long generatePlantedPartition(graph *G, long *C, long NV, long numCommunities, double avgDegree,
+                              double mu, unsigned long long seed) {
+  if ((NV < 2) || (numCommunities < 1) || (NV < 2*numCommunities) || (avgDegree <= 0) ||
+      (mu < 0) || (mu > 1) || ((numCommunities == 1) && (mu > 0))) {
+    LOG_ERROR("generatePlantedPartition(): invalid parameters\n");
+    return -1;
+  }
+  long k  = numCommunities;
+  long NE = (long) (NV * avgDegree / 2);
+  LOG_INFO("Planted partition: |V|= %ld, |E|= %ld, %ld communities, mu= %g\n", NV, NE, k, mu);
+
+  edge *tmpEdgeList = (edge *) malloc (NE * sizeof(edge)); assert(tmpEdgeList != 0);
+#pragma omp parallel for
+  for (long e=0; e<NE; e++) {
+    long u = uniformLong(e, seed, StreamEdge, NV);
+    long c = ((u+1)*k - 1) / NV;  //Block c spans [c*NV/k, (c+1)*NV/k)
+    long start = c*NV/k;
+    long size  = (c+1)*NV/k - start;
+    long v;
+    if (hashRandomU01(e, seed, StreamCommunity) >= mu) {
+      v = start + uniformLong(e, seed, StreamEdge + 1, size - 1);
+      if (v >= u)
+        v++;  //Skip u itself
+    } else {
+      v = uniformLong(e, seed, StreamEdge + 1, NV - size);
+      if (v >= start)
+        v += size;  //Skip the block of u
+    }
+    tmpEdgeList[e].head   = u;
+    tmpEdgeList[e].tail   = v;
+    tmpEdgeList[e].weight = 1.0;
+  }
+
+  long *community = (long *) malloc (NV * sizeof(long)); assert(community != 0);
+#pragma omp parallel for
+  for (long v=0; v<NV; v++)
+    community[v] = ((v+1)*k - 1) / NV;
+  buildPermutedGraph(G, C, NV, NE, tmpEdgeList, community, seed);
+
+  free(tmpEdgeList);
+  free(community);
+  return k;
+}//End of generatePlantedPartition()
+
+//Mean of a continuous power law x^-tau truncated to [a, b]
+static double powerLawMean(double a, double b, double tau) {
+  if (fabs(tau - 1) < 1e-9)
+    return (b - a) / log(b / a);
+  if (fabs(tau - 2) < 1e-9)
+    return log(b / a) / (1/a - 1/b);
+  return ((1 - tau) / (2 - tau)) * (pow(b, 2 - tau) - pow(a, 2 - tau)) / (pow(b, 1 - tau) - pow(a, 1 - tau));
+}
+
+//Inverse transform sample of a power law x^-tau truncated to [a, b]
+static double powerLawSample(double u, double a, double b, double tau) {
+  if (fabs(tau - 1) < 1e-9)
+    return a * pow(b / a, u);
+  double lo = pow(a, 1 - tau), hi = pow(b, 1 - tau);
+  return pow(lo + u * (hi - lo), 1 / (1 - tau));
+}
+
+//Vertex with stub r, given the stub prefix sums P over the vertices [first, last)
+static inline long findStub(long *P, long first, long last, long r) {
+  return (long) (std::upper_bound(P + first, P + last + 1, r) - P) - 1;
+}
+
+//LFR-like benchmark: power-law degrees (exponent tauDegree, mean avgDegree, at most
+//maxDegree) and power-law community sizes (exponent tauCommunity, within
+//[minCommunity, maxCommunity]). A fraction mu of the stubs of every vertex is external.
+//Unlike the original LFR construction, stubs are joined Chung-Lu style: each edge
+//picks its endpoints with probability proportional to their internal (or external)
+//degree, so degrees hold in expectation and parallel edges are possible. Internal
+//degrees are capped at the community size minus one, the excess becomes external.
+long generateLFR(graph *G, long *C, long NV, double avgDegree, long maxDegree, double mu,
+                 double tauDegree, double tauCommunity, long minCommunity, long maxCommunity,
+                 unsigned long long seed) {
+  if ((NV < 2) || (avgDegree < 1) || (maxDegree < avgDegree) || (mu < 0) || (mu > 1) ||
+      (tauDegree <= 0) || (tauCommunity <= 0) || (minCommunity < 2) || (maxCommunity < minCommunity) ||
+      (maxCommunity > NV)) {
+    LOG_ERROR("generateLFR(): invalid parameters\n");
+    return -1;
+  }
+  //Minimum degree that gives the requested mean: the mean grows with the minimum
+  double lo = 1, hi = (double) maxDegree;
+  if (powerLawMean(lo, hi, tauDegree) > avgDegree) {
+    LOG_ERROR("generateLFR(): average degree %g is too small for exponent %g and maximum degree %ld\n",
+              avgDegree, tauDegree, maxDegree);
+    return -1;
+  }
+  for (int i=0; i<100; i++) {
+    double mid = 0.5 * (lo + hi);
+    if (powerLawMean(mid, (double) maxDegree, tauDegree) < avgDegree)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  double minDegree = lo;
+
+  //Community sizes: sequential draws until the vertices are covered; a remainder
+  //smaller than minCommunity is added to the last community
+  vector<long> commPtr;
+  commPtr.push_back(0);
+  long covered = 0;
+  for (long c=0; covered < NV; c++) {
+    long size = (long) (powerLawSample(hashRandomU01(c, seed, StreamCommunity), (double) minCommunity,
+                                       (double) maxCommunity + 1, tauCommunity));
+    size = min(max(size, minCommunity), maxCommunity);
+    if (NV - covered - size < minCommunity)
+      size = NV - covered;
+    covered += size;
+    commPtr.push_back(covered);
+  }
+  long numCommunities = (long) commPtr.size() - 1;
+
+  long *community = (long *) malloc (NV * sizeof(long)); assert(community != 0);
+  long *Pin  = (long *) malloc ((NV+1) * sizeof(long)); assert(Pin != 0);  //Internal stubs
+  long *Pext = (long *) malloc ((NV+1) * sizeof(long)); assert(Pext != 0); //External stubs
+#pragma omp parallel for schedule(dynamic, 64)
+  for (long c=0; c<numCommunities; c++) {
+    long size = commPtr[c+1] - commPtr[c];
+    for (long v=commPtr[c]; v<commPtr[c+1]; v++) {
+      long degree = (long) (powerLawSample(hashRandomU01(v, seed, StreamDegree), minDegree,
+                                           (double) maxDegree, tauDegree) + 0.5);
+      long internal = min((long) ((1 - mu) * degree + 0.5), size - 1);
+      community[v] = c;
+      Pin[v+1]  = internal;
+      Pext[v+1] = degree - internal;
+    }
+  }
+  Pin[0] = 0;
+  Pext[0] = 0;
+  parallelInclusiveScan(Pin, NV+1);  //Prefix sums
+  parallelInclusiveScan(Pext, NV+1);
+
+  //Internal edges: half the internal stubs of every community
+  long *edgePtr = (long *) malloc ((numCommunities+1) * sizeof(long)); assert(edgePtr != 0);
+  edgePtr[0] = 0;
+  for (long c=0; c<numCommunities; c++)
+    edgePtr[c+1] = edgePtr[c] + (Pin[commPtr[c+1]] - Pin[commPtr[c]]) / 2;
+  long NEin  = edgePtr[numCommunities];
+  long NEext = Pext[NV] / 2;
+  long NE    = NEin + NEext;
+  LOG_INFO("LFR: |V|= %ld, |E|= %ld (%ld internal), %ld communities, min degree= %g\n",
+           NV, NE, NEin, numCommunities, minDegree);
+
+  edge *tmpEdgeList = (edge *) malloc (NE * sizeof(edge)); assert(tmpEdgeList != 0);
+#pragma omp parallel for
+  for (long e=0; e<NEin; e++) {
+    long c = (long) (std::upper_bound(edgePtr, edgePtr + numCommunities + 1, e) - edgePtr) - 1;
+    long first = commPtr[c], last = commPtr[c+1];
+    long stubs = Pin[last] - Pin[first];
+    long u = findStub(Pin, first, last, Pin[first] + uniformLong(e, seed, StreamEdge, stubs));
+    long v = u;
+    for (int a=0; (a<MaxAttempts) && (v == u); a++)
+      v = findStub(Pin, first, last, Pin[first] + uniformLong(e, seed, StreamEdge + 2*a + 1, stubs));
+    if (v == u)
+      v = first + (u - first + 1) % (last - first);
+    tmpEdgeList[e].head   = u;
+    tmpEdgeList[e].tail   = v;
+    tmpEdgeList[e].weight = 1.0;
+  }
+#pragma omp parallel for
+  for (long e=0; e<NEext; e++) {
+    long id = NEin + e;
+    long u = findStub(Pext, 0, NV, uniformLong(id, seed, StreamEdge, Pext[NV]));
+    long v = u;
+    for (int a=0; (a<MaxAttempts) && (community[v] == community[u]); a++)
+      v = findStub(Pext, 0, NV, uniformLong(id, seed, StreamEdge + 2*a + 1, Pext[NV]));
+    if (v == u)
+      v = (u + 1) % NV;
+    tmpEdgeList[id].head   = u;
+    tmpEdgeList[id].tail   = v;
+    tmpEdgeList[id].weight = 1.0;
+  }
+  buildPermutedGraph(G, C, NV, NE, tmpEdgeList, community, seed);
+
+  free(tmpEdgeList);
+  free(edgePtr);
+  free(Pin);
+  free(Pext);
+  free(community);
+  return numCommunities;
+}//End of generateLFR()
+
+//Sort keys with one chunk per thread, then merge pairs of chunks in rounds
+static void parallelSortKeys(vector< pair<float,long> > &keys) {
+  long N = (long) keys.size();
+  int nT = omp_get_max_threads();
+  vector<long> bounds(nT + 1);
+  for (int t=0; t<=nT; t++)
+    bounds[t] = (N * t) / nT;
+#pragma omp parallel for
+  for (int t=0; t<nT; t++)
+    std::sort(keys.begin() + bounds[t], keys.begin() + bounds[t+1]);
+  for (int width=1; width<nT; width*=2) {
+#pragma omp parallel for
+    for (int t=0; t<nT; t+=2*width) {
+      if (t + width < nT)
+        std::inplace_merge(keys.begin() + bounds[t], keys.begin() + bounds[t+width],
+                           keys.begin() + bounds[min(t + 2*width, nT)]);
+    }
+  }
+}//End of parallelSortKeys()
+
+//Number of random projections, and candidates on each side per projection (times k)
+#define KnnProjections 8
+#define KnnWindow      2
+
+//kNN graph of a Gaussian mixture: numComponents centers drawn from N(0, separation^2 I)
+//in dim dimensions, every point is its component's center plus N(0, I) noise.
+//The k nearest neighbors are approximate: points are sorted along KnnProjections
+//random directions and every point keeps the k closest among its KnnWindow*k
+//neighbors on each side in each order. Every kNN pair becomes one edge of weight one.
+long generateGaussianMixtureKNN(graph *G, long *C, long NV, int dim, long numComponents,
+                                double separation, int k, unsigned long long seed) {
+  if ((NV < 2) || (dim < 1) || (numComponents < 1) || (separation < 0) || (k < 1) || (k >= NV)) {
+    LOG_ERROR("generateGaussianMixtureKNN(): invalid parameters\n");
+    return -1;
+  }
+  LOG_INFO("Gaussian mixture kNN: |V|= %ld, %ld components in %d dimensions, k= %d\n",
+           NV, numComponents, dim, k);
+
+  long *component = (long *) malloc (NV * sizeof(long)); assert(component != 0);
+  float *points = (float *) malloc (NV * dim * sizeof(float)); assert(points != 0);
+#pragma omp parallel for
+  for (long v=0; v<NV; v++) {
+    long c = uniformLong(v, seed, StreamComponent, numComponents);
+    component[v] = c;
+    for (int d=0; d<dim; d++)
+      points[v*dim + d] = (float) (separation * normalRandom(c*dim + d, seed, StreamCenter) +
+                                   normalRandom(v*dim + d, seed, StreamPoint));
+  }
+
+  //Candidate lists, sorted by distance; -1 marks an empty slot
+  long *nbr = (long *) malloc (NV * k * sizeof(long)); assert(nbr != 0);
+  float *dist = (float *) malloc (NV * k * sizeof(float)); assert(dist != 0);
+#pragma omp parallel for
+  for (long i=0; i<NV*k; i++) {
+    nbr[i] = -1;
+    dist[i] = HUGE_VALF;
+  }
+
+  vector< pair<float,long> > order(NV);
+  vector<double> direction(dim);
+  long window = (long) KnnWindow * k;
+  for (int p=0; p<KnnProjections; p++) {
+    for (int d=0; d<dim; d++)
+      direction[d] = normalRandom(p*dim + d, seed, StreamProjection);
+#pragma omp parallel for
+    for (long v=0; v<NV; v++) {
+      double key = 0;
+      for (int d=0; d<dim; d++)
+        key += direction[d] * points[v*dim + d];
+      order[v] = make_pair((float) key, v);
+    }
+    parallelSortKeys(order);
+    //Every point only updates its own list
+#pragma omp parallel for
+    for (long i=0; i<NV; i++) {
+      long v = order[i].second;
+      long *myNbr = nbr + v*k;
+      float *myDist = dist + v*k;
+      for (long j=max(0L, i-window); j<=min(NV-1, i+window); j++) {
+        long u = order[j].second;
+        if (u == v)
+          continue;
+        float d2 = 0;
+        for (int d=0; d<dim; d++) {
+          float diff = points[v*dim + d] - points[u*dim + d];
+          d2 += diff * diff;
+        }
+        if (d2 >= myDist[k-1])
+          continue;
+        bool present = false;
+        for (int s=0; (s<k) && (myNbr[s] >= 0); s++)
+          if (myNbr[s] == u) { present = true; break; }
+        if (present)
+          continue;
+        int s = k - 1;  //Insertion into the sorted list
+        while ((s > 0) && (myDist[s-1] > d2)) {
+          myDist[s] = myDist[s-1];
+          myNbr[s] = myNbr[s-1];
+          s--;
+        }
+        myDist[s] = d2;
+        myNbr[s] = u;
+      }
+    }
+  }
+  free(points);
+
+  //One edge per pair: a mutual pair is emitted by its smaller endpoint only
+  long *edgePtr = (long *) malloc ((NV+1) * sizeof(long)); assert(edgePtr != 0);
+  edgePtr[0] = 0;
+#pragma omp parallel for
+  for (long v=0; v<NV; v++) {
+    long count = 0;
+    for (int s=0; s<k; s++) {
+      long u = nbr[v*k + s];
+      if (u < 0)
+        continue;
+      if (u > v) {
+        count++;
+        continue;
+      }
+      bool mutual = false;
+      for (int t=0; t<k; t++)
+        if (nbr[u*k + t] == v) { mutual = true; break; }
+      if (!mutual)
+        count++;
+    }
+    edgePtr[v+1] = count;
+  }
+  parallelInclusiveScan(edgePtr, NV+1);
+  long NE = edgePtr[NV];
+  edge *tmpEdgeList = (edge *) malloc (NE * sizeof(edge)); assert(tmpEdgeList != 0);
+#pragma omp parallel for
+  for (long v=0; v<NV; v++) {
+    long where = edgePtr[v];
+    for (int s=0; s<k; s++) {
+      long u = nbr[v*k + s];
+      if (u < 0)
+        continue;
+      bool mutual = false;
+      if (u < v) {
+        for (int t=0; t<k; t++)
+          if (nbr[u*k + t] == v) { mutual = true; break; }
+      }
+      if (mutual)
+        continue;
+      tmpEdgeList[where].head   = v;
+      tmpEdgeList[where].tail   = u;
+      tmpEdgeList[where].weight = 1.0;
+      where++;
+    }
+  }
+  free(nbr);
+  free(dist);
+  free(edgePtr);
+
+  buildGraphFromEdgeList(G, NV, NE, tmpEdgeList);
+  if (C != NULL) {
+#pragma omp parallel for
+    for (long v=0; v<NV; v++)
+      C[v] = component[v];
+  }
+  free(tmpEdgeList);
+  free(component);
+  return numComponents;
+}//End of generateGaussianMixtureKNN()
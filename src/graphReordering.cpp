@@ -0,0 +1,182 @@
+#include "defs.h"
+#include "basic_util.h"
+#include "parallel_sort.h"
+#include "parallel_scan.h"
+#include <algorithm>
+
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////  LOCALITY-IMPROVING VERTEX ORDERS  ////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////
+//Graphs built from kNN searches list the vertices in input (cell) order, so the
+//neighbors of a vertex, and the community data the kernels look up for them, are
+//scattered over memory. A reordering numbers the vertices so that neighbors get
+//close numbers. The orders computed here are old2New maps: old2New[v] is the new
+//number of vertex v. They do not depend on the number of threads, except for RCM.
+
+//Rounds of label propagation for the community order, at most: it stops when
+//fewer than one vertex in LabelStopFraction changes label in a round
+#define LabelRounds        20
+#define LabelStopFraction  1000
+
+//Hub sorting: vertices by decreasing degree, ties by vertex number, so that the
+//data of the vertices most often looked up share cache lines
+static void degreeOrder(graph *G, long *old2New) {
+  long NV = G->numVertices;
+  long *vtxPtr = G->edgeListPtrs;
+  long *order = (long *) malloc (NV * sizeof(long)); assert(order != 0);
+#pragma omp parallel for
+  for (long i=0; i<NV; i++)
+    order[i] = i;
+  parallelSort(order, NV, [=](long a, long b) {
+      long da = vtxPtr[a+1] - vtxPtr[a], db = vtxPtr[b+1] - vtxPtr[b];
+      return (da > db) || ((da == db) && (a < b));
+    });
+#pragma omp parallel for
+  for (long i=0; i<NV; i++)
+    old2New[order[i]] = i;
+  free(order);
+}//End of degreeOrder()
+
+//Label propagation: in every round each vertex takes the label with the largest
+//total edge weight among its neighbors, ties to the smallest label. Every round
+//updates a random half of the vertices from the labels of the previous round, so
+//the result does not depend on the number of threads and labels cannot swap back
+//and forth between the two sides of an edge.
+static void propagateLabels(graph *G, long *label, int numRounds) {
+  long NV = G->numVertices;
+  long *vtxPtr = G->edgeListPtrs;
+  edge *vtxInd = G->edgeList;
+  long *curr = label;
+  long *next = (long *) malloc (NV * sizeof(long)); assert(next != 0);
+#pragma omp parallel for
+  for (long i=0; i<NV; i++)
+    curr[i] = i;
+  for (int r=0; r<numRounds; r++) {
+    long numChanged = 0;
+#pragma omp parallel reduction(+: numChanged)
+    {
+      vector< pair<long, double> > around;
+#pragma omp for schedule(guided)
+      for (long i=0; i<NV; i++) {
+        next[i] = curr[i];
+        if ((vtxPtr[i] == vtxPtr[i+1]) || (hashRandom(i, RandomSeed, r) & 1))
+          continue;
+        around.clear();
+        for (long k=vtxPtr[i]; k<vtxPtr[i+1]; k++)
+          around.push_back(make_pair(curr[vtxInd[k].tail], vtxInd[k].weight));
+        sort(around.begin(), around.end());
+        long best = curr[i];
+        double bestWeight = -1;
+        for (size_t k=0; k<around.size(); ) {
+          size_t m = k;
+          double w = 0;
+          for (; (m < around.size()) && (around[m].first == around[k].first); m++)
+            w += around[m].second;
+          if (w > bestWeight) { //Labels are visited in increasing order
+            best = around[k].first;
+            bestWeight = w;
+          }
+          k = m;
+        }
+        if (best != curr[i]) {
+          next[i] = best;
+          numChanged++;
+        }
+      }
+    }
+    swap(curr, next);
+    LOG_DEBUG("Label propagation round %d: %ld vertices changed label\n", r, numChanged);
+    if (numChanged <= NV / LabelStopFraction)
+      break;
+  }
+  if (curr != label) { //The last round wrote the scratch array
+#pragma omp parallel for
+    for (long i=0; i<NV; i++)
+      label[i] = curr[i];
+    next = curr;
+  }
+  free(next);
+}//End of propagateLabels()
+
+//Rabbit-order-like community order: vertices grouped by the communities of a few
+//rounds of label propagation, the groups in order of their label (a vertex of the
+//group) and the vertices of a group in their input order
+static void communityOrder(graph *G, long *old2New) {
+  long NV = G->numVertices;
+  long *label = (long *) malloc (NV * sizeof(long)); assert(label != 0);
+  propagateLabels(G, label, LabelRounds);
+  long *order = (long *) malloc (NV * sizeof(long)); assert(order != 0);
+#pragma omp parallel for
+  for (long i=0; i<NV; i++)
+    order[i] = i;
+  parallelSort(order, NV, [=](long a, long b) {
+      return (label[a] < label[b]) || ((label[a] == label[b]) && (a < b));
+    });
+#pragma omp parallel for
+  for (long i=0; i<NV; i++)
+    old2New[order[i]] = i;
+  free(order);
+  free(label);
+}//End of communityOrder()
+
+//Compute the vertex order reorder (ReorderRCM, ReorderDegree or ReorderCommunity)
+//of G into old2New
+void reorderVertices(graph *G, long *old2New, int reorder) {
+  double time1 = omp_get_wtime();
+  switch (reorder) {
+    case ReorderRCM:
+      algoReverseCuthillMcKee(G, old2New, omp_get_max_threads());
+      break;
+    case ReorderDegree:
+      degreeOrder(G, old2New);
+      break;
+    case ReorderCommunity:
+      communityOrder(G, old2New);
+      break;
+    default: //Identity
+#pragma omp parallel for
+      for (long i=0; i<G->numVertices; i++)
+        old2New[i] = i;
+      break;
+  }
+  LOG_INFO("Vertex order %d computed. Time= %lf\n", reorder, omp_get_wtime() - time1);
+}//End of reorderVertices()
+
+//Build in Gout the graph Gin with vertex v renumbered old2New[v]. The adjacency
+//of every vertex is sorted by neighbor, so the kernels scan the community data
+//of the neighbors in increasing order of address.
+void permuteGraph(graph *Gin, graph *Gout, const long *old2New) {
+  double time1 = omp_get_wtime();
+  long NV = Gin->numVertices;
+  long *vtxPtrIn = Gin->edgeListPtrs;
+  edge *vtxIndIn = Gin->edgeList;
+  long numEntries = vtxPtrIn[NV];
+  long *vtxPtrOut = (long *) malloc ((NV+1) * sizeof(long)); assert(vtxPtrOut != 0);
+  edge *vtxIndOut = (edge *) malloc (numEntries * sizeof(edge)); assert(vtxIndOut != 0);
+  vtxPtrOut[0] = 0;
+#pragma omp parallel for
+  for (long i=0; i<NV; i++)
+    vtxPtrOut[old2New[i]+1] = vtxPtrIn[i+1] - vtxPtrIn[i];
+  parallelInclusiveScan(vtxPtrOut, NV+1); //Prefix sum
+  firstTouchEdges(vtxIndOut, vtxPtrOut, NV); //Filled below in the input order
+#pragma omp parallel for schedule(guided)
+  for (long i=0; i<NV; i++) {
+    long v = old2New[i];
+    edge *out = vtxIndOut + vtxPtrOut[v];
+    long degree = vtxPtrIn[i+1] - vtxPtrIn[i];
+    for (long k=0; k<degree; k++) {
+      out[k].head   = v;
+      out[k].tail   = old2New[vtxIndIn[vtxPtrIn[i] + k].tail];
+      out[k].weight = vtxIndIn[vtxPtrIn[i] + k].weight;
+    }
+    stable_sort(out, out + degree, [](const edge &a, const edge &b) { return a.tail < b.tail; });
+  }
+  Gout->numVertices  = NV;
+  Gout->sVertices    = Gin->sVertices;
+  Gout->numEdges     = Gin->numEdges;
+  Gout->edgeListPtrs = vtxPtrOut;
+  Gout->edgeList     = vtxIndOut;
+  LOG_INFO("Graph reordered. Time= %lf\n", omp_get_wtime() - time1);
+}//End of permuteGraph()
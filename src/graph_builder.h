@@ -0,0 +1,118 @@
+#ifndef __GRAPH_BUILDER__
+#define __GRAPH_BUILDER__
+#include "defs.h"
+
+//Two-pass construction of a graph in CSR form from edges stored once, read in
+//blocks from a source that can be read more than once: an edge array, a links
+//matrix, the chunks of a text file. The first pass counts, the second writes
+//every edge twice straight into the CSR, so the edges are never copied as a
+//whole. Entries are staged in buckets of consecutive vertices and every bucket
+//is then sorted by vertex within its own range of the edge list: neither pass
+//needs atomics and the random accesses stay within one bucket. Blocks are
+//assigned to threads in contiguous ranges, so the adjacency of a vertex lists
+//its edges in block order, whatever the number of threads.
+//  readBlock(b, out): replace the contents of out with the edges of block b
+//  allocate(NV, numEntries, &edgeListPtrs, &edgeList): storage for NV+1 edge
+//  pointers and numEntries edges, in memory (allocateGraphMemory()) or in a file
+
+//Edges per block when building from an edge list
+#define BuildBlockEdges  (1L << 16)
+
+typedef struct {
+  int  shift;         //Buckets of 2^shift consecutive vertices
+  long numBuckets;
+  long numParts;      //Contiguous ranges of blocks, one per thread
+  long *partPos;      //[p*numBuckets + b]: next entry of part p in bucket b
+  long *bucketStart;  //numBuckets+1 positions in the edge list
+} edgeBuckets;
+
+void initEdgeBuckets(edgeBuckets *eb, long NV, long expectedEdges);
+long startEdgeBuckets(edgeBuckets *eb);
+void firstTouchEdgeBuckets(edgeBuckets *eb, long NV, long *edgeListPtrs, edge *edgeList);
+void sortEdgeBuckets(edgeBuckets *eb, long NV, long *edgeListPtrs, edge *edgeList);
+bool allocateGraphMemory(long NV, long numEntries, long **edgeListPtrs, edge **edgeList);
+
+template <typename F>
+void countEdgeBlocks(edgeBuckets *eb, long numBlocks, F readBlock) {
+#pragma omp parallel
+  {
+    std::vector<edge> block;
+#pragma omp for schedule(static, 1)
+    for (long p = 0; p < eb->numParts; p++) {
+      long *myPos = eb->partPos + p * eb->numBuckets;
+      for (long b = 0; b < eb->numBuckets; b++)
+        myPos[b] = 0;
+      for (long k = (numBlocks * p) / eb->numParts; k < (numBlocks * (p+1)) / eb->numParts; k++) {
+        readBlock(k, block);
+        for (size_t i = 0; i < block.size(); i++) {
+          myPos[block[i].head >> eb->shift]++;
+          myPos[block[i].tail >> eb->shift]++;
+        }
+      }
+    }
+  }
+}//End of countEdgeBlocks()
+
+template <typename F>
+void fillEdgeBlocks(edgeBuckets *eb, long numBlocks, F readBlock, edge *edgeList) {
+#pragma omp parallel
+  {
+    std::vector<edge> block;
+#pragma omp for schedule(static, 1)
+    for (long p = 0; p < eb->numParts; p++) {
+      long *myPos = eb->partPos + p * eb->numBuckets;
+      for (long k = (numBlocks * p) / eb->numParts; k < (numBlocks * (p+1)) / eb->numParts; k++) {
+        readBlock(k, block);
+        for (size_t i = 0; i < block.size(); i++) {
+          long head      = block[i].head;
+          long tail      = block[i].tail;
+          double weight  = block[i].weight;
+          long Where = myPos[head >> eb->shift]++;
+          edgeList[Where].head = head;
+          edgeList[Where].tail = tail;
+          edgeList[Where].weight = weight;
+          //Now add the counter-edge:
+          Where = myPos[tail >> eb->shift]++;
+          edgeList[Where].head = tail;
+          edgeList[Where].tail = head;
+          edgeList[Where].weight = weight;
+        }
+      }
+    }
+  }
+}//End of fillEdgeBlocks()
+
+//Build G from the edges of numBlocks blocks; expectedEdges only sizes the buckets.
+//Return: false if allocate fails
+template <typename F, typename A>
+bool buildGraphFromEdgeBlocks(graph *G, long NV, long expectedEdges, long numBlocks, F readBlock,
+                              A allocate) {
+  edgeBuckets eb;
+  initEdgeBuckets(&eb, NV, expectedEdges);
+  countEdgeBlocks(&eb, numBlocks, readBlock);
+  long numEntries = startEdgeBuckets(&eb);
+  long *edgeListPtr;
+  edge *edgeList;
+  if (!allocate(NV, numEntries, &edgeListPtr, &edgeList)) {
+    free(eb.partPos);
+    free(eb.bucketStart);
+    return false;
+  }
+  firstTouchEdgeBuckets(&eb, NV, edgeListPtr, edgeList);
+  fillEdgeBlocks(&eb, numBlocks, readBlock, edgeList);
+  sortEdgeBuckets(&eb, NV, edgeListPtr, edgeList);
+
+  G->sVertices    = NV;
+  G->numVertices  = NV;
+  G->numEdges     = numEntries / 2;
+  G->edgeListPtrs = edgeListPtr;
+  G->edgeList     = edgeList;
+  return true;
+}//End of buildGraphFromEdgeBlocks()
+
+template <typename F>
+bool buildGraphFromEdgeBlocks(graph *G, long NV, long expectedEdges, long numBlocks, F readBlock) {
+  return buildGraphFromEdgeBlocks(G, NV, expectedEdges, numBlocks, readBlock, allocateGraphMemory);
+}
+
+#endif
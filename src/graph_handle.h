@@ -0,0 +1,41 @@
+#ifndef __GRAPH_HANDLE__
+#define __GRAPH_HANDLE__
+#include "defs.h"
+#include "basic_util.h"
+#include "input_output.h"
+
+//Owner of the input graph of a clustering: a graph allocated with malloc(), or
+//one opened from a FastPG CSR file through file(). The graph is freed, or the
+//file closed, when the handle goes out of scope, also when an error unwinds the
+//stack (Rcpp::stop(), R interrupts). The clustering drivers never free their
+//input graph, so a handle covers every exit of the R entry points.
+class graphHandle {
+public:
+  graphHandle() {
+    G = (graph *) malloc (sizeof(graph)); assert(G != 0);
+    G->numVertices  = 0;
+    G->sVertices    = 0;
+    G->numEdges     = 0;
+    G->edgeListPtrs = NULL;
+    G->edgeList     = NULL;
+    csr.base        = NULL;
+    csr.vertexIds   = NULL;
+  }
+  ~graphHandle() {
+    if (csr.base != NULL)
+      closeGraphCSR(G, &csr); //Leaves the graph arrays NULL
+    freeGraph(G);
+  }
+  graph* get() const { return G; }
+  graph* operator->() const { return G; }
+  //For openGraphCSR(): the handle then closes the file
+  csrFile* file() { return &csr; }
+
+private:
+  graph *G;
+  csrFile csr;
+  graphHandle(const graphHandle &) = delete;
+  graphHandle& operator=(const graphHandle &) = delete;
+};
+
+#endif
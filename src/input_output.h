@@ -5,23 +5,42 @@
 long removeEdges(long NV, long NE, edge *edgeList); //Remove duplicates
 void SortEdgesUndirected(long NV, long NE, edge *list1, edge *list2, long *ptrs);
 
-void loadMetisFileFormat(graph *G, const char* filename); //Metis (DIMACS#10)
+bool loadMetisFileFormat(graph *G, const char* filename); //Metis (DIMACS#10)
 bool parse_MatrixMarket(graph * G, char *fileName); //Matrix-Market
 void parse_MatrixMarket_Sym_AsGraph(graph * G, char *fileName);
 
 void parse_DirectedEdgeList(dGraph * G, char *fileName); //Directed graph
 void parse_UndirectedEdgeListWeighted(graph * G, char *fileName); // for John F's graphs
 void parse_UndirectedEdgeList(graph * G, char *fileName);
-void parse_EdgeListBinaryNew(graph * G, char *fileName);
+bool parse_EdgeListBinaryNew(graph * G, char *fileName); //Binary CSR
 void parse_PajekFormatUndirected(graph* G, char* fileName);
-void parse_PajekFormat(graph* G, char* fileName);
+bool parse_PajekFormat(graph* G, char* fileName); //Pajek, each edge once
 void parse_Dimacs9FormatDirectedNewD(graph* G, char* fileName);
-void parse_SNAP(graph * G, char *fileName);
+bool parse_SNAP(graph * G, char *fileName);
+long setIngestMemoryLimit(long bytes); //Text parsers: above it, edges are parsed in every pass
 void parse_SNAP_GroundTruthCommunities(char *fileVertexMap, char *fileGroundTruth);
 void parse_UndirectedEdgeListFromJason(graph * G, char *fileName); //Data from Jason
 void parse_UndirectedEdgeListDarpaHive(graph * G, char *fileName); //DARPA-HIVE Challenge
 
-void writeGraphBinaryFormatNew(graph* G, char *filename, long weighted);
+bool writeGraphBinaryFormatNew(graph* G, char *filename, long weighted);
+
+//FastPG CSR files (loadCSRFileFormat.cpp): a versioned binary CSR that is memory
+//mapped and, for edge records on 64-bit systems, used as a graph without copying
+typedef struct {
+    char   *base;       //Mapping (or in-memory copy) of the file
+    size_t length;
+    bool   mapped;      //base is a mapping, not a copy
+    bool   inPlace;     //The graph arrays point into base
+    long   *vertexIds;  //Original vertex ids, NULL if the file has none
+    bool   ownsIds;
+} csrFile;
+bool writeGraphCSR(graph *G, const char *fileName, int indexBytes, const long *vertexIds);
+bool openGraphCSR(graph *G, const char *fileName, csrFile *file);
+void closeGraphCSR(graph *G, csrFile *file);
+bool createGraphCSR(const char *fileName, long NV, long numEntries, csrFile *file,
+                    long **edgeListPtrs, edge **edgeList);
+bool finishGraphCSR(csrFile *file);
+bool ingestSNAPToCSR(const char *fileName, const char *csrFileName);
 void writeGraphMetisSimpleFormat(graph* G, char *filename);
 void writeGraphMatrixMarketFormatSymmetric(graph* G, char *filename);
 
@@ -34,6 +53,15 @@ void writeGraphMatrixMarketFormatBipartiteReordered(graph* G, char *filename, lo
 void parse_EdgeListCompressedHDF5(graph * G, char *fileName);
 void parse_EdgeListCompressedHDF5NoDuplicates(graph * G, char *fileName);
 
+//Synthetic graphs with planted communities (graphGenerators.cpp)
+long generatePlantedPartition(graph *G, long *C, long NV, long numCommunities, double avgDegree,
+                              double mu, unsigned long long seed);
+long generateLFR(graph *G, long *C, long NV, double avgDegree, long maxDegree, double mu,
+                 double tauDegree, double tauCommunity, long minCommunity, long maxCommunity,
+                 unsigned long long seed);
+long generateGaussianMixtureKNN(graph *G, long *C, long NV, int dim, long numComponents,
+                                double separation, int k, unsigned long long seed);
+
 using namespace std;
 
 #endif
@@ -0,0 +1,105 @@
+#include "defs.h"
+#include "input_output.h"
+
+#define BinaryChunkSize 65536L
+
+//Binary CSR format: NV, NE and a weighted flag (three longs), followed by the
+//NV+1 edge pointers and the 2*NE edges. Weighted graphs store (tail, weight)
+//pairs, unweighted graphs only the tails. Each edge is stored twice, as in graph.
+
+//Return: false if the file cannot be written
+bool writeGraphBinaryFormatNew(graph* G, char *filename, long weighted) {
+  long NV = G->numVertices;
+  long NE = G->numEdges;
+  long *vtxPtr = G->edgeListPtrs;
+  edge *vtxInd = G->edgeList;
+  FILE *fout = fopen(filename, "wb");
+  if (fout == NULL) {
+    LOG_ERROR("writeGraphBinaryFormatNew(): could not open the file %s\n", filename);
+    return false;
+  }
+  bool ok = (fwrite(&NV, sizeof(long), 1, fout) == 1);
+  ok = ok && (fwrite(&NE, sizeof(long), 1, fout) == 1);
+  ok = ok && (fwrite(&weighted, sizeof(long), 1, fout) == 1);
+  ok = ok && (fwrite(vtxPtr, sizeof(long), NV+1, fout) == (size_t) (NV+1));
+  //Write the edges through a buffer of BinaryChunkSize records
+  long recSize = weighted ? (sizeof(long) + sizeof(double)) : sizeof(long);
+  char *buffer = (char *) malloc(BinaryChunkSize * recSize); assert(buffer != NULL);
+  for (long start=0; ok && (start<vtxPtr[NV]); start += BinaryChunkSize) {
+    long count = min(BinaryChunkSize, vtxPtr[NV] - start);
+    for (long i=0; i<count; i++) {
+      memcpy(buffer + i*recSize, &vtxInd[start+i].tail, sizeof(long));
+      if (weighted)
+        memcpy(buffer + i*recSize + sizeof(long), &vtxInd[start+i].weight, sizeof(double));
+    }
+    ok = (fwrite(buffer, recSize, count, fout) == (size_t) count);
+  }
+  free(buffer);
+  fclose(fout);
+  if (!ok)
+    LOG_ERROR("writeGraphBinaryFormatNew(): could not write the file %s\n", filename);
+  return ok;
+}//End of writeGraphBinaryFormatNew()
+
+//Return: false if the file cannot be read or is truncated
+bool parse_EdgeListBinaryNew(graph * G, char *fileName) {
+  double time1 = omp_get_wtime();
+  FILE *fin = fopen(fileName, "rb");
+  if (fin == NULL) {
+    LOG_ERROR("parse_EdgeListBinaryNew(): could not open the file %s\n", fileName);
+    return false;
+  }
+  long NV = 0, NE = 0, weighted = 0;
+  bool ok = (fread(&NV, sizeof(long), 1, fin) == 1);
+  ok = ok && (fread(&NE, sizeof(long), 1, fin) == 1);
+  ok = ok && (fread(&weighted, sizeof(long), 1, fin) == 1);
+  ok = ok && (NV >= 0) && (NE >= 0);
+  if (!ok) {
+    LOG_ERROR("parse_EdgeListBinaryNew(): invalid header in %s\n", fileName);
+    fclose(fin);
+    return false;
+  }
+  long *edgeListPtr = (long *) malloc((NV+1) * sizeof(long)); assert(edgeListPtr != NULL);
+  ok = (fread(edgeListPtr, sizeof(long), NV+1, fin) == (size_t) (NV+1));
+  ok = ok && (edgeListPtr[0] == 0) && (edgeListPtr[NV] <= 2*NE);
+  for (long i=0; ok && (i<NV); i++)
+    ok = (edgeListPtr[i] <= edgeListPtr[i+1]);
+  edge *edgeList = (edge *) malloc(2*NE * sizeof(edge)); assert(edgeList != NULL);
+  //Read the records into the front of edgeList and expand them in place, from
+  //the last one backwards (a record is never larger than an edge)
+  long numRecords = ok ? edgeListPtr[NV] : 0;
+  long recSize = weighted ? (sizeof(long) + sizeof(double)) : sizeof(long);
+  char *raw = (char *) edgeList;
+  ok = ok && (fread(raw, recSize, numRecords, fin) == (size_t) numRecords);
+  fclose(fin);
+  for (long j=numRecords-1; ok && (j>=0); j--) {
+    long tail;
+    double weight = 1.0;
+    memcpy(&tail, raw + j*recSize, sizeof(long));
+    if (weighted)
+      memcpy(&weight, raw + j*recSize + sizeof(long), sizeof(double));
+    edgeList[j].tail = tail;
+    edgeList[j].weight = weight;
+    ok = (tail >= 0) && (tail < NV);
+  }
+  if (ok) {
+#pragma omp parallel for
+    for (long i=0; i<NV; i++) {
+      for (long j=edgeListPtr[i]; j<edgeListPtr[i+1]; j++)
+        edgeList[j].head = i;
+    }
+  }
+  if (!ok) {
+    LOG_ERROR("parse_EdgeListBinaryNew(): %s is truncated or corrupt\n", fileName);
+    free(edgeListPtr);
+    free(edgeList);
+    return false;
+  }
+  G->sVertices    = NV;
+  G->numVertices  = NV;
+  G->numEdges     = NE;
+  G->edgeListPtrs = edgeListPtr;
+  G->edgeList     = edgeList;
+  LOG_INFO("Done reading from file: NV= %ld NE= %ld. Time= %lf\n", NV, NE, omp_get_wtime()-time1);
+  return true;
+}//End of parse_EdgeListBinaryNew()
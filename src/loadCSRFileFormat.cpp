@@ -0,0 +1,377 @@
+#include "defs.h"
+#include "input_output.h"
+#include "text_parser.h"
+#include <stdint.h>
+#include <fcntl.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+//FastPG CSR format, version 1. All integers are little-endian, every section
+//starts at a multiple of CSRAlignment bytes from the start of the file:
+//  header     csrFileHeader below
+//  offsets    NV+1 int64 edge pointers, as in graph.edgeListPtrs
+//  adjacency  either edgeListPtrs[NV] edge records {int64 head, int64 tail,
+//             float64 weight} (CSR_EDGE_RECORDS), which is the layout of graph.edgeList
+//             on 64-bit systems, or edgeListPtrs[NV] int32/int64 tails
+//  weights    edgeListPtrs[NV] float64 weights, only for weighted tails
+//  vertexIds  NV int64 original vertex ids, optional
+//Edge records are used in place from a private mapping of the file; tails are
+//smaller on disk but have to be expanded into a graph.edgeList when loaded.
+
+#define CSRMagic      "FPGCSR01"
+#define CSRVersion    1
+#define CSRAlignment  64
+#define CSRChunkSize  65536L
+
+#define CSR_EDGE_RECORDS  1  //Adjacency holds edge records
+#define CSR_WEIGHTED      2  //Weights section present (tails only)
+#define CSR_VERTEX_IDS    4  //Vertex id section present
+
+typedef struct {
+  char     magic[8];
+  uint32_t version;
+  uint32_t flags;
+  uint32_t indexBytes;    //Size of a tail: 4 or 8, 24 for edge records
+  uint32_t byteOrder;     //0x01020304 as written
+  int64_t  numVertices;
+  int64_t  numEdges;      //graph.numEdges
+  int64_t  numEntries;    //Adjacency entries: edgeListPtrs[NV]
+  uint64_t offsetsPos;    //Byte positions of the sections, zero if absent
+  uint64_t adjacencyPos;
+  uint64_t weightsPos;
+  uint64_t vertexIdsPos;
+  uint64_t fileSize;
+  uint64_t reserved[3];
+} csrFileHeader;          //128 bytes
+
+static inline uint64_t alignSection(uint64_t pos) {
+  return (pos + CSRAlignment - 1) / CSRAlignment * CSRAlignment;
+}
+
+//Edge records can be used in place when graph.edge has their layout
+static inline bool nativeEdgeLayout() {
+  return (sizeof(long) == 8) && (sizeof(edge) == 24);
+}
+
+//Write count values of type T converted from src(i), through a buffer
+template <typename T, typename F>
+static bool writeConverted(FILE *fout, long count, F src) {
+  T *buffer = (T *) malloc(CSRChunkSize * sizeof(T)); assert(buffer != NULL);
+  bool ok = true;
+  for (long start=0; ok && (start<count); start += CSRChunkSize) {
+    long n = min(CSRChunkSize, count - start);
+    for (long i=0; i<n; i++)
+      buffer[i] = (T) src(start + i);
+    ok = (fwrite(buffer, sizeof(T), n, fout) == (size_t) n);
+  }
+  free(buffer);
+  return ok;
+}
+
+static bool writePadding(FILE *fout, uint64_t from, uint64_t to) {
+  char zeros[CSRAlignment] = {0};
+  return (to == from) || (fwrite(zeros, 1, to - from, fout) == (size_t) (to - from));
+}
+
+//Write G in the FastPG CSR format. indexBytes is 0 for edge records, or 4 or 8
+//for tails of that size. vertexIds (NV values) may be NULL.
+//Return: false if the file cannot be written or 32-bit tails cannot hold NV
+bool writeGraphCSR(graph *G, const char *fileName, int indexBytes, const long *vertexIds) {
+  long NV = G->numVertices;
+  long *vtxPtr = G->edgeListPtrs;
+  edge *vtxInd = G->edgeList;
+  long numEntries = vtxPtr[NV];
+  if ((indexBytes != 0) && (indexBytes != 4) && (indexBytes != 8)) {
+    LOG_ERROR("writeGraphCSR(): index size must be 0, 4 or 8 bytes\n");
+    return false;
+  }
+  if ((indexBytes == 4) && (NV > INT32_MAX)) {
+    LOG_ERROR("writeGraphCSR(): %ld vertices do not fit 32-bit indices\n", NV);
+    return false;
+  }
+  bool weighted = false;
+  if (indexBytes != 0) {
+#pragma omp parallel for reduction(||: weighted)
+    for (long i=0; i<numEntries; i++)
+      weighted = weighted || (vtxInd[i].weight != 1.0);
+  }
+
+  csrFileHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, CSRMagic, 8);
+  h.version      = CSRVersion;
+  h.flags        = ((indexBytes == 0) ? CSR_EDGE_RECORDS : 0) | (weighted ? CSR_WEIGHTED : 0) |
+                   ((vertexIds != NULL) ? CSR_VERTEX_IDS : 0);
+  h.indexBytes   = (indexBytes == 0) ? 24 : indexBytes;
+  h.byteOrder    = 0x01020304;
+  h.numVertices  = NV;
+  h.numEdges     = G->numEdges;
+  h.numEntries   = numEntries;
+  h.offsetsPos   = alignSection(sizeof(csrFileHeader));
+  h.adjacencyPos = alignSection(h.offsetsPos + (NV+1) * sizeof(int64_t));
+  uint64_t pos   = alignSection(h.adjacencyPos + numEntries * (uint64_t) h.indexBytes);
+  if (weighted) {
+    h.weightsPos = pos;
+    pos = alignSection(pos + numEntries * sizeof(double));
+  }
+  if (vertexIds != NULL) {
+    h.vertexIdsPos = pos;
+    pos = alignSection(pos + NV * sizeof(int64_t));
+  }
+  h.fileSize = pos;
+
+  FILE *fout = fopen(fileName, "wb");
+  if (fout == NULL) {
+    LOG_ERROR("writeGraphCSR(): could not open the file %s\n", fileName);
+    return false;
+  }
+  bool ok = (fwrite(&h, sizeof(h), 1, fout) == 1);
+  ok = ok && writePadding(fout, sizeof(h), h.offsetsPos);
+  ok = ok && writeConverted<int64_t>(fout, NV+1, [&](long i) { return vtxPtr[i]; });
+  ok = ok && writePadding(fout, h.offsetsPos + (NV+1) * sizeof(int64_t), h.adjacencyPos);
+  if (indexBytes == 0) {
+    if (nativeEdgeLayout()) {
+      ok = ok && (fwrite(vtxInd, sizeof(edge), numEntries, fout) == (size_t) numEntries);
+    } else {
+      for (long i=0; ok && (i<numEntries); i++) {
+        int64_t ends[2] = {vtxInd[i].head, vtxInd[i].tail};
+        ok = (fwrite(ends, sizeof(int64_t), 2, fout) == 2) &&
+             (fwrite(&vtxInd[i].weight, sizeof(double), 1, fout) == 1);
+      }
+    }
+  } else if (indexBytes == 4) {
+    ok = ok && writeConverted<int32_t>(fout, numEntries, [&](long i) { return vtxInd[i].tail; });
+  } else {
+    ok = ok && writeConverted<int64_t>(fout, numEntries, [&](long i) { return vtxInd[i].tail; });
+  }
+  pos = h.adjacencyPos + numEntries * (uint64_t) h.indexBytes;
+  if (weighted) {
+    ok = ok && writePadding(fout, pos, h.weightsPos);
+    ok = ok && writeConverted<double>(fout, numEntries, [&](long i) { return vtxInd[i].weight; });
+    pos = h.weightsPos + numEntries * sizeof(double);
+  }
+  if (vertexIds != NULL) {
+    ok = ok && writePadding(fout, pos, h.vertexIdsPos);
+    ok = ok && writeConverted<int64_t>(fout, NV, [&](long i) { return vertexIds[i]; });
+    pos = h.vertexIdsPos + NV * sizeof(int64_t);
+  }
+  ok = ok && writePadding(fout, pos, h.fileSize);
+  ok = (fclose(fout) == 0) && ok;
+  if (!ok)
+    LOG_ERROR("writeGraphCSR(): could not write the file %s\n", fileName);
+  return ok;
+}//End of writeGraphCSR()
+
+//Create a FastPG CSR file of edge records for NV vertices and numEntries edge
+//entries, mapped shared so that *edgeListPtrs and *edgeList, once filled, are the
+//contents of the file. The space is reserved up front. Call finishGraphCSR(file)
+//to write the file back. This is the allocate step of buildGraphFromEdgeBlocks()
+//for graphs that are built straight to disk.
+//Return: false if the file cannot be created, or mmap or the edge layout is not
+//available
+bool createGraphCSR(const char *fileName, long NV, long numEntries, csrFile *file,
+                    long **edgeListPtrs, edge **edgeList) {
+#ifdef _WIN32
+  LOG_ERROR("createGraphCSR(): not available on this platform\n");
+  return false;
+#else
+  if (!nativeEdgeLayout()) {
+    LOG_ERROR("createGraphCSR(): edge records need 64-bit integers\n");
+    return false;
+  }
+  csrFileHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, CSRMagic, 8);
+  h.version      = CSRVersion;
+  h.flags        = CSR_EDGE_RECORDS;
+  h.indexBytes   = 24;
+  h.byteOrder    = 0x01020304;
+  h.numVertices  = NV;
+  h.numEdges     = numEntries / 2;
+  h.numEntries   = numEntries;
+  h.offsetsPos   = alignSection(sizeof(csrFileHeader));
+  h.adjacencyPos = alignSection(h.offsetsPos + (NV+1) * sizeof(int64_t));
+  h.fileSize     = alignSection(h.adjacencyPos + numEntries * (uint64_t) h.indexBytes);
+
+  int fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_ERROR("createGraphCSR(): could not create the file %s\n", fileName);
+    return false;
+  }
+  //Reserve the blocks: running out of space while the mapping is written would
+  //raise SIGBUS instead of an error
+  void *addr = MAP_FAILED;
+  if (posix_fallocate(fd, 0, (off_t) h.fileSize) == 0)
+    addr = mmap(NULL, h.fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    LOG_ERROR("createGraphCSR(): could not allocate %lu bytes for the file %s\n",
+              (unsigned long) h.fileSize, fileName);
+    return false;
+  }
+  char *base = (char *) addr;
+  memcpy(base, &h, sizeof(h));
+  file->base      = base;
+  file->length    = h.fileSize;
+  file->mapped    = true;
+  file->inPlace   = true;
+  file->vertexIds = NULL;
+  file->ownsIds   = false;
+  *edgeListPtrs   = (long *) (base + h.offsetsPos);
+  *edgeList       = (edge *) (base + h.adjacencyPos);
+  return true;
+#endif
+}//End of createGraphCSR()
+
+//Write back and unmap a file from createGraphCSR()
+//Return: false if the file could not be written
+bool finishGraphCSR(csrFile *file) {
+  bool ok = true;
+#ifndef _WIN32
+  ok = (msync(file->base, file->length, MS_SYNC) == 0);
+  ok = (munmap(file->base, file->length) == 0) && ok;
+  if (!ok)
+    LOG_ERROR("finishGraphCSR(): could not write the graph file\n");
+#endif
+  file->base = NULL;
+  return ok;
+}//End of finishGraphCSR()
+
+//Check that the header describes sections that lie within the file
+static bool validCSRHeader(const csrFileHeader *h, uint64_t length) {
+  if ((memcmp(h->magic, CSRMagic, 8) != 0) || (h->version != CSRVersion) || (h->byteOrder != 0x01020304))
+    return false;
+  if ((h->numVertices < 0) || (h->numEntries < 0) || (h->fileSize > length))
+    return false;
+  bool records = (h->flags & CSR_EDGE_RECORDS) != 0;
+  if (records ? (h->indexBytes != 24) : ((h->indexBytes != 4) && (h->indexBytes != 8)))
+    return false;
+  uint64_t NV = h->numVertices, NE = h->numEntries;
+  if ((NV >= length) || (NE >= length) || (h->offsetsPos >= length) || (h->adjacencyPos >= length) ||
+      (h->weightsPos >= length) || (h->vertexIdsPos >= length))
+    return false;
+  if ((h->offsetsPos % CSRAlignment) || (h->offsetsPos + (NV+1) * 8 > length))
+    return false;
+  if ((h->adjacencyPos % CSRAlignment) || (h->adjacencyPos + NE * h->indexBytes > length))
+    return false;
+  if ((h->flags & CSR_WEIGHTED) && ((h->weightsPos % CSRAlignment) || (h->weightsPos + NE * 8 > length)))
+    return false;
+  if ((h->flags & CSR_VERTEX_IDS) && ((h->vertexIdsPos % CSRAlignment) || (h->vertexIdsPos + NV * 8 > length)))
+    return false;
+  return true;
+}
+
+//Open a FastPG CSR file as graph G. Edge records on a 64-bit system are used in
+//place, without copying; tails are expanded into a newly allocated edge list.
+//file keeps the mapping and the vertex ids (NULL if the file has none) until
+//closeGraphCSR(G, file) is called; G must not be freed in any other way.
+//Return: false if the file cannot be read or is not a valid CSR file
+bool openGraphCSR(graph *G, const char *fileName, csrFile *file) {
+  double time1 = omp_get_wtime();
+  size_t length = 0;
+  bool mapped = false;
+  char *base = mapInputFile(fileName, &length, &mapped);
+  if (base == NULL) {
+    LOG_ERROR("openGraphCSR(): could not read the file %s\n", fileName);
+    return false;
+  }
+  csrFileHeader h;
+  memset(&h, 0, sizeof(h));
+  if (length >= sizeof(h))
+    memcpy(&h, base, sizeof(h));
+  if (!validCSRHeader(&h, length)) {
+    LOG_ERROR("openGraphCSR(): %s is not a FastPG CSR file (version %d) or is truncated\n",
+              fileName, CSRVersion);
+    unmapInputFile(base, length, mapped);
+    return false;
+  }
+  long NV = (long) h.numVertices;
+  long numEntries = (long) h.numEntries;
+  const int64_t *offsets = (const int64_t *) (base + h.offsetsPos);
+  bool ok = (offsets[0] == 0) && (offsets[NV] == numEntries);
+  for (long i=0; ok && (i<NV); i++)
+    ok = (offsets[i] <= offsets[i+1]);
+  if (!ok) {
+    LOG_ERROR("openGraphCSR(): invalid edge pointers in %s\n", fileName);
+    unmapInputFile(base, length, mapped);
+    return false;
+  }
+
+  bool records = (h.flags & CSR_EDGE_RECORDS) != 0;
+  file->base        = base;
+  file->length      = length;
+  file->mapped      = mapped;
+  file->inPlace     = records && nativeEdgeLayout();
+  file->vertexIds   = NULL;
+  file->ownsIds     = false;
+  if (file->inPlace) {
+    G->edgeListPtrs = (long *) (base + h.offsetsPos);
+    G->edgeList     = (edge *) (base + h.adjacencyPos);
+  } else {
+    long *edgeListPtr = (long *) malloc((NV+1) * sizeof(long)); assert(edgeListPtr != NULL);
+    edge *edgeList = (edge *) malloc(numEntries * sizeof(edge)); assert(edgeList != NULL);
+#pragma omp parallel for
+    for (long i=0; i<=NV; i++)
+      edgeListPtr[i] = (long) offsets[i];
+    const char *adj = base + h.adjacencyPos;
+    const double *weights = (h.flags & CSR_WEIGHTED) ? (const double *) (base + h.weightsPos) : NULL;
+#pragma omp parallel for
+    for (long i=0; i<NV; i++) {
+      for (long j=edgeListPtr[i]; j<edgeListPtr[i+1]; j++) {
+        edgeList[j].head = i;
+        if (records) {
+          const int64_t *rec = (const int64_t *) (adj + j*24);
+          edgeList[j].tail = (long) rec[1];
+          memcpy(&edgeList[j].weight, rec + 2, sizeof(double));
+        } else {
+          edgeList[j].tail = (h.indexBytes == 4) ? (long) ((const int32_t *) adj)[j] : (long) ((const int64_t *) adj)[j];
+          edgeList[j].weight = (weights != NULL) ? weights[j] : 1.0;
+        }
+      }
+    }
+    G->edgeListPtrs = edgeListPtr;
+    G->edgeList     = edgeList;
+  }
+  //The kernels index with the tails: reject out of range ones
+  long badTails = 0;
+#pragma omp parallel for reduction(+: badTails)
+  for (long j=0; j<numEntries; j++)
+    badTails += ((G->edgeList[j].tail < 0) || (G->edgeList[j].tail >= NV)) ? 1 : 0;
+  if (badTails > 0) {
+    LOG_ERROR("openGraphCSR(): %ld edges of %s point outside the graph\n", badTails, fileName);
+    closeGraphCSR(G, file);
+    return false;
+  }
+  if (h.flags & CSR_VERTEX_IDS) {
+    if (sizeof(long) == sizeof(int64_t)) {
+      file->vertexIds = (long *) (base + h.vertexIdsPos);
+    } else {
+      const int64_t *ids = (const int64_t *) (base + h.vertexIdsPos);
+      file->vertexIds = (long *) malloc(NV * sizeof(long)); assert(file->vertexIds != NULL);
+      for (long i=0; i<NV; i++)
+        file->vertexIds[i] = (long) ids[i];
+      file->ownsIds = true;
+    }
+  }
+  G->sVertices    = NV;
+  G->numVertices  = NV;
+  G->numEdges     = (long) h.numEdges;
+  LOG_INFO("Opened %s: NV= %ld NE= %ld, %s. Time= %lf\n", fileName, NV, G->numEdges,
+           file->inPlace ? "edges used in place" : "edges expanded", omp_get_wtime()-time1);
+  return true;
+}//End of openGraphCSR()
+
+void closeGraphCSR(graph *G, csrFile *file) {
+  if (!file->inPlace) {
+    free(G->edgeListPtrs);
+    free(G->edgeList);
+  }
+  if (file->ownsIds)
+    free(file->vertexIds);
+  unmapInputFile(file->base, file->length, file->mapped);
+  G->edgeListPtrs = NULL;
+  G->edgeList     = NULL;
+  file->base      = NULL;
+  file->vertexIds = NULL;
+}//End of closeGraphCSR()
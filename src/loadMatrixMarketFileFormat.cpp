@@ -0,0 +1,121 @@
+#include "defs.h"
+#include "input_output.h"
+#include "basic_util.h"
+#include "text_parser.h"
+
+//Case-insensitive comparison of the banner word at *p with word
+static bool bannerWord(const char **p, const char *end, const char *word) {
+  const char *q = skipBlanks(*p, end);
+  size_t n = strlen(word);
+  if ((size_t) (end - q) < n)
+    return false;
+  for (size_t i=0; i<n; i++)
+    if (tolower((unsigned char) q[i]) != word[i])
+      return false;
+  if ((q + n < end) && !isFieldSeparator(q[n]))
+    return false;
+  *p = q + n;
+  return true;
+}
+
+//Parse a Matrix Market coordinate file as a graph: "%%MatrixMarket matrix
+//coordinate real|integer|pattern general|symmetric", '%' comment lines, a size
+//line "N N nnz", and one entry "i j [v]" per line with one-based indices. Every
+//off-diagonal entry becomes an edge between vertices i-1 and j-1; diagonal entries
+//are ignored. Symmetric files store each edge once. A general matrix A is read
+//as the graph of (A + A^T)/2: the weight of every entry is halved, so a symmetric
+//matrix gives the same graph stored either way. Pattern entries weigh one.
+//The entries are parsed in parallel from a memory mapping of the file.
+//Return: false if the file cannot be read, is not a square coordinate matrix, or
+//an entry cannot be parsed
+bool parse_MatrixMarket(graph * G, char *fileName) {
+  LOG_INFO("Parsing a Matrix Market file as a general graph...\n");
+  double time1 = omp_get_wtime();
+  size_t length = 0;
+  bool mapped = false;
+  char *base = mapInputFile(fileName, &length, &mapped);
+  if (base == NULL) {
+    LOG_ERROR("Within Function: parse_MatrixMarket(): could not open the file %s\n", fileName);
+    return false;
+  }
+  const char *end = base + length;
+
+  //Banner
+  const char *p = base;
+  const char *lineEnd = endOfLine(p, end);
+  bool pattern = false, symmetric = false;
+  bool ok = bannerWord(&p, lineEnd, "%%matrixmarket") && bannerWord(&p, lineEnd, "matrix") &&
+            bannerWord(&p, lineEnd, "coordinate");
+  if (ok) {
+    if (bannerWord(&p, lineEnd, "pattern"))
+      pattern = true;
+    else
+      ok = bannerWord(&p, lineEnd, "real") || bannerWord(&p, lineEnd, "integer");
+  }
+  if (ok) {
+    if (bannerWord(&p, lineEnd, "symmetric"))
+      symmetric = true;
+    else
+      ok = bannerWord(&p, lineEnd, "general");
+  }
+  if (!ok) {
+    LOG_ERROR("parse_MatrixMarket(): %s is not a real, integer or pattern coordinate matrix, "
+              "general or symmetric\n", fileName);
+    unmapInputFile(base, length, mapped);
+    return false;
+  }
+
+  //Size line, after comments
+  long numLines = 1;
+  p = (lineEnd < end) ? lineEnd + 1 : end;
+  while ((p < end) && atLineEnd(p, endOfLine(p, end), "%")) {
+    p = endOfLine(p, end);
+    p = (p < end) ? p + 1 : end;
+    numLines++;
+  }
+  long NR = 0, NC = 0, NNZ = 0;
+  lineEnd = endOfLine(p, end);
+  if (!scanLong(&p, lineEnd, &NR) || !scanLong(&p, lineEnd, &NC) || !scanLong(&p, lineEnd, &NNZ) ||
+      (NR != NC) || (NR < 0) || (NNZ < 0)) {
+    LOG_ERROR("parse_MatrixMarket(): %s does not have the size line of a square matrix\n", fileName);
+    unmapInputFile(base, length, mapped);
+    return false;
+  }
+  numLines++;
+  long NV = NR;
+  LOG_INFO("|V|= %ld, entries= %ld, %s, %s\n", NV, NNZ, pattern ? "pattern" : "weighted",
+           symmetric ? "symmetric" : "general");
+
+  double scale = symmetric ? 1.0 : 0.5;
+  const char *entries = (lineEnd < end) ? lineEnd + 1 : end;
+  textChunks chunks;
+  splitTextLines(entries, end, &chunks);
+  bool built;
+  long badLine = buildGraphFromTextChunks(G, NV, &chunks, [=](const char *q, const char *qEnd, edge *e) -> int {
+      if (atLineEnd(q, qEnd, "%"))
+        return 0;
+      long i, j;
+      double wt = 1.0;
+      if (!scanLong(&q, qEnd, &i) || !scanLong(&q, qEnd, &j) || (i < 1) || (i > NV) || (j < 1) || (j > NV))
+        return -1;
+      if (!pattern && !scanDouble(&q, qEnd, &wt))
+        return -1;
+      if (i == j)
+        return 0; //Self loops are ignored
+      e->head   = i-1;
+      e->tail   = j-1;
+      e->weight = wt * scale;
+      return 1;
+    }, allocateGraphMemory, &built);
+  freeTextChunks(&chunks);
+  unmapInputFile(base, length, mapped);
+  if (badLine >= 0) {
+    LOG_ERROR("parse_MatrixMarket(): cannot parse line %ld of %s\n", numLines + badLine, fileName);
+    return false;
+  }
+  if (G->numEdges > NNZ)
+    LOG_WARN("parse_MatrixMarket(): %s has %ld entries, more than the %ld declared\n", fileName,
+             G->numEdges, NNZ);
+  LOG_INFO("Done reading from file: NE= %ld. Time= %lf\n", G->numEdges, omp_get_wtime() - time1);
+  return built;
+}//End of parse_MatrixMarket()
@@ -0,0 +1,186 @@
+#include "defs.h"
+#include "input_output.h"
+#include "basic_util.h"
+#include "parallel_scan.h"
+#include "text_parser.h"
+
+//Vertex lines per chunk, and the first line of the chunk in the file
+typedef struct {
+  long firstVertex;
+  long firstLine;
+} metisChunk;
+
+//Parse one vertex line: skip the vertex size and weights, then call visit(u, w)
+//for every neighbor u (zero-based) with edge weight w.
+//Return: false if the line cannot be parsed or a neighbor is out of range
+template <typename F>
+static inline bool parseMetisLine(const char *p, const char *end, int numSkip, bool edgeWeights,
+                                  long NV, F visit) {
+  for (int k=0; k<numSkip; k++) {
+    double skipped;
+    if (!scanDouble(&p, end, &skipped))
+      return false;
+  }
+  while (!atLineEnd(p, end, NULL)) {
+    long u;
+    double w = 1.0;
+    if (!scanLong(&p, end, &u) || (u < 1) || (u > NV))
+      return false;
+    if (edgeWeights && !scanDouble(&p, end, &w))
+      return false;
+    visit(u-1, w);
+  }
+  return true;
+}
+
+//Parse a METIS (DIMACS#10) graph: '%' comment lines, a header "NV NE [fmt [ncon]]",
+//then one line per vertex listing its one-based neighbors. fmt is up to three
+//digits: vertex sizes, vertex weights (ncon of them, default 1) and edge weights;
+//vertex sizes and weights are skipped. Every edge appears in the lines of both of
+//its ends, which is the layout of graph.edgeList, so the CSR is built directly:
+//one pass counts the vertex lines of every chunk, one counts the degrees, and one
+//fills the edges. Edges are taken as listed, without checking symmetry.
+//Return: false if the file cannot be read or parsed
+bool loadMetisFileFormat(graph *G, const char* filename) {
+  LOG_INFO("Parsing a METIS formatted file as a general graph...\n");
+  double time1 = omp_get_wtime();
+  size_t length = 0;
+  bool mapped = false;
+  char *base = mapInputFile(filename, &length, &mapped);
+  if (base == NULL) {
+    LOG_ERROR("Within Function: loadMetisFileFormat(): could not open the file %s\n", filename);
+    return false;
+  }
+  const char *end = base + length;
+
+  //Header, after comments
+  const char *p = base;
+  long headerLines = 1;
+  while ((p < end) && (*p == '%')) {
+    p = endOfLine(p, end);
+    p = (p < end) ? p + 1 : end;
+    headerLines++;
+  }
+  const char *lineEnd = endOfLine(p, end);
+  long NV = 0, NE = 0, fmt = 0, ncon = 1;
+  bool ok = scanLong(&p, lineEnd, &NV) && scanLong(&p, lineEnd, &NE) && (NV >= 0) && (NE >= 0);
+  if (ok && scanLong(&p, lineEnd, &fmt))
+    ok = (fmt >= 0) && (fmt <= 111) && (fmt % 10 <= 1) && ((fmt / 10) % 10 <= 1) &&
+         (!scanLong(&p, lineEnd, &ncon) || (ncon >= 1));
+  if (!ok) {
+    LOG_ERROR("loadMetisFileFormat(): %s does not start with a METIS header\n", filename);
+    unmapInputFile(base, length, mapped);
+    return false;
+  }
+  bool edgeWeights = (fmt % 10) == 1;
+  int numSkip = (int) ((fmt / 100) + (((fmt / 10) % 10) ? ncon : 0));
+  LOG_INFO("|V|= %ld, |E|= %ld, fmt= %03ld\n", NV, NE, fmt);
+
+  const char *vertexLines = (lineEnd < end) ? lineEnd + 1 : end;
+  long numChunks = numTextChunks(vertexLines, end);
+  const char **starts = (const char **) malloc ((numChunks+1) * sizeof(const char *)); assert(starts != 0);
+  splitTextChunks(vertexLines, end, numChunks, starts);
+  metisChunk *chunk = (metisChunk *) malloc ((numChunks+1) * sizeof(metisChunk)); assert(chunk != 0);
+
+  //Vertex lines (all but comments) of every chunk
+  chunk[0].firstVertex = 0;
+  chunk[0].firstLine = headerLines + 1;
+#pragma omp parallel for schedule(dynamic)
+  for (long c=0; c<numChunks; c++) {
+    long numVertexLines = 0, numLines = 0;
+    for (const char *q = starts[c]; q < starts[c+1]; numLines++) {
+      if (*q != '%')
+        numVertexLines++;
+      q = endOfLine(q, starts[c+1]) + 1;
+    }
+    chunk[c+1].firstVertex = numVertexLines;
+    chunk[c+1].firstLine = numLines;
+  }
+  for (long c=0; c<numChunks; c++) {
+    chunk[c+1].firstVertex += chunk[c].firstVertex;
+    chunk[c+1].firstLine += chunk[c].firstLine;
+  }
+
+  long *edgeListPtr = (long *) malloc ((NV+1) * sizeof(long)); assert(edgeListPtr != 0);
+#pragma omp parallel for
+  for (long i=0; i<=NV; i++)
+    edgeListPtr[i] = 0; //For first touch purposes
+
+  //Degrees; lines past the last vertex must be empty
+  long badLine = -1;
+#pragma omp parallel for schedule(dynamic)
+  for (long c=0; c<numChunks; c++) {
+    long v = chunk[c].firstVertex, line = chunk[c].firstLine;
+    for (const char *q = starts[c]; q < starts[c+1]; line++) {
+      const char *qEnd = endOfLine(q, starts[c+1]);
+      if (*q != '%') {
+        long degree = 0;
+        bool valid = (v < NV) ? parseMetisLine(q, qEnd, numSkip, edgeWeights, NV,
+                                               [&](long, double) { degree++; })
+                              : atLineEnd(q, qEnd, NULL);
+        if (!valid) {
+#pragma omp critical
+          {
+            if ((badLine < 0) || (line < badLine))
+              badLine = line;
+          }
+          break;
+        }
+        if (v < NV)
+          edgeListPtr[v+1] = degree;
+        v++;
+      }
+      q = qEnd + 1;
+    }
+  }
+  ok = (badLine < 0) && (chunk[numChunks].firstVertex >= NV);
+  if (badLine >= 0)
+    LOG_ERROR("loadMetisFileFormat(): cannot parse line %ld of %s\n", badLine, filename);
+  else if (!ok)
+    LOG_ERROR("loadMetisFileFormat(): %s has %ld vertex lines, fewer than %ld\n", filename,
+              chunk[numChunks].firstVertex, NV);
+  if (!ok) {
+    free(edgeListPtr);
+    free(chunk);
+    free(starts);
+    unmapInputFile(base, length, mapped);
+    return false;
+  }
+  parallelInclusiveScan(edgeListPtr, NV+1); //Prefix Sum
+  long numEntries = edgeListPtr[NV];
+  if (numEntries != 2*NE)
+    LOG_WARN("loadMetisFileFormat(): %s lists %ld neighbors, not twice the %ld edges declared\n",
+             filename, numEntries, NE);
+
+  //Fill the edges in place
+  edge *edgeList = (edge *) malloc ((numEntries+1) * sizeof(edge)); assert(edgeList != 0);
+#pragma omp parallel for schedule(dynamic)
+  for (long c=0; c<numChunks; c++) {
+    long v = chunk[c].firstVertex;
+    for (const char *q = starts[c]; (q < starts[c+1]) && (v < NV); ) {
+      const char *qEnd = endOfLine(q, starts[c+1]);
+      if (*q != '%') {
+        long where = edgeListPtr[v];
+        parseMetisLine(q, qEnd, numSkip, edgeWeights, NV, [&](long u, double w) {
+            edgeList[where].head   = v;
+            edgeList[where].tail   = u;
+            edgeList[where].weight = w;
+            where++;
+          });
+        v++;
+      }
+      q = qEnd + 1;
+    }
+  }
+  free(chunk);
+  free(starts);
+  unmapInputFile(base, length, mapped);
+
+  G->sVertices    = NV;
+  G->numVertices  = NV;
+  G->numEdges     = numEntries / 2;
+  G->edgeListPtrs = edgeListPtr;
+  G->edgeList     = edgeList;
+  LOG_INFO("Done reading from file: NE= %ld. Time= %lf\n", G->numEdges, omp_get_wtime() - time1);
+  return true;
+}//End of loadMetisFileFormat()
@@ -0,0 +1,95 @@
+#include "defs.h"
+#include "input_output.h"
+#include "basic_util.h"
+#include "text_parser.h"
+
+//Case-insensitive test for a section header "*word" at the start of [p, end)
+static bool pajekSection(const char *p, const char *end, const char *word) {
+  size_t n = strlen(word);
+  if ((size_t) (end - p) < n + 1 || (*p != '*'))
+    return false;
+  for (size_t i=0; i<n; i++)
+    if (tolower((unsigned char) p[i+1]) != word[i])
+      return false;
+  return (p + n + 1 == end) || isFieldSeparator(p[n+1]);
+}
+
+//Parse a Pajek network with every edge stored once: "*Vertices N", N optional
+//vertex lines (labels are ignored), then "*Edges" and/or "*Arcs" sections of
+//"u v [w]" lines with one-based vertex numbers. Arcs are read as undirected
+//edges. Lines starting with '%' are comments. The edge sections are parsed in
+//parallel from a memory mapping of the file.
+//Return: false if the file cannot be read or parsed
+bool parse_PajekFormat(graph* G, char* fileName) {
+  LOG_INFO("Parsing a Pajek file as a general graph...\n");
+  double time1 = omp_get_wtime();
+  size_t length = 0;
+  bool mapped = false;
+  char *base = mapInputFile(fileName, &length, &mapped);
+  if (base == NULL) {
+    LOG_ERROR("Within Function: parse_PajekFormat(): could not open the file %s\n", fileName);
+    return false;
+  }
+  const char *end = base + length;
+
+  //"*Vertices N", after comments
+  const char *p = base;
+  long numLines = 1;
+  while ((p < end) && atLineEnd(p, endOfLine(p, end), "%")) {
+    p = endOfLine(p, end);
+    p = (p < end) ? p + 1 : end;
+    numLines++;
+  }
+  const char *lineEnd = endOfLine(p, end);
+  long NV = 0;
+  const char *q = p;
+  bool ok = pajekSection(p, lineEnd, "vertices");
+  if (ok) {
+    q += strlen("*vertices");
+    ok = scanLong(&q, lineEnd, &NV) && (NV >= 0);
+  }
+  if (!ok) {
+    LOG_ERROR("parse_PajekFormat(): %s does not start with \"*Vertices N\"\n", fileName);
+    unmapInputFile(base, length, mapped);
+    return false;
+  }
+  //Skip the vertex lines: the edges start at the next section header
+  p = (lineEnd < end) ? lineEnd + 1 : end;
+  while ((p < end) && (*p != '*')) {
+    p = endOfLine(p, end);
+    p = (p < end) ? p + 1 : end;
+    numLines++;
+  }
+  LOG_INFO("|V|= %ld\n", NV);
+
+  textChunks chunks;
+  splitTextLines(p, end, &chunks);
+  bool built;
+  long badLine = buildGraphFromTextChunks(G, NV, &chunks, [=](const char *r, const char *rEnd, edge *e) -> int {
+      if (*r == '*') //Only edge sections may follow
+        return (pajekSection(r, rEnd, "edges") || pajekSection(r, rEnd, "arcs")) ? 0 : -1;
+      if (atLineEnd(r, rEnd, "%"))
+        return 0;
+      long Si, Ti;
+      double wt;
+      if (!scanLong(&r, rEnd, &Si) || !scanLong(&r, rEnd, &Ti) || (Si < 1) || (Si > NV) ||
+          (Ti < 1) || (Ti > NV))
+        return -1;
+      if (atLineEnd(r, rEnd, "%"))
+        wt = 1.0; //Default weight of one
+      else if (!scanDouble(&r, rEnd, &wt))
+        return -1;
+      e->head   = Si-1;
+      e->tail   = Ti-1;
+      e->weight = wt;
+      return 1;
+    }, allocateGraphMemory, &built);
+  freeTextChunks(&chunks);
+  unmapInputFile(base, length, mapped);
+  if (badLine >= 0) {
+    LOG_ERROR("parse_PajekFormat(): cannot parse line %ld of %s\n", numLines + badLine, fileName);
+    return false;
+  }
+  LOG_INFO("Done reading from file: NE= %ld. Time= %lf\n", G->numEdges, omp_get_wtime() - time1);
+  return built;
+}//End of parse_PajekFormat()
@@ -0,0 +1,257 @@
+#include "defs.h"
+#include "input_output.h"
+#include "basic_util.h"
+#include "text_parser.h"
+#include "parallel_sort.h"
+#include "parallel_scan.h"
+#include <algorithm>
+#include <climits>
+
+//Vertex ids are mapped through a table indexed by id when they span at most
+//this many ids per edge endpoint (plus a constant) and the table fits in the
+//ingest memory limit; the distinct ids are sorted otherwise
+#define DenseIdsPerEndpoint  2
+#define DenseIdsMinimum      (1L << 20)
+//Every range of sparse ids costs a pass over the file: past this many, the ids
+//of a range are allowed to exceed the ingest memory limit
+#define MaxIdRanges          64
+
+//Renumbering of the vertex ids, contiguously from zero in increasing order of id
+typedef struct {
+  long minId;
+  long *newId;   //Dense ids: newId[id - minId], NULL otherwise
+  long *ids;     //Sparse ids: the distinct ids, sorted
+  long numIds;
+} snapVertexMap;
+
+static inline unsigned long idOffset(long id, long minId) {
+  return (unsigned long) id - (unsigned long) minId;
+}
+
+static inline long mapVertexId(const snapVertexMap *m, long id) {
+  if (m->newId != NULL)
+    return m->newId[idOffset(id, m->minId)];
+  return (long) (std::lower_bound(m->ids, m->ids + m->numIds, id) - m->ids);
+}
+
+//Number the ids of the NE edges that readBlock returns, all in [minId, maxId].
+//Dense ids are marked in a table and numbered by a prefix sum. Sparse ids are
+//collected and sorted one range of ids at a time, with as many ranges as it
+//takes for the ids of a range to fit in the ingest memory limit.
+template <typename F>
+static void buildVertexMap(snapVertexMap *m, long minId, long maxId, long NE, long numBlocks, F readBlock) {
+  m->minId  = minId;
+  m->newId  = NULL;
+  m->ids    = NULL;
+  m->numIds = 0;
+  if (NE == 0)
+    return;
+  unsigned long span = idOffset(maxId, minId) + 1;
+  double limit = (double) ingestMemoryLimit();
+  if ((span <= (unsigned long) (DenseIdsPerEndpoint * 2 * NE + DenseIdsMinimum)) &&
+      ((double) span * sizeof(long) <= limit)) {
+    long *newId = (long *) malloc (span * sizeof(long)); assert(newId != 0);
+#pragma omp parallel for
+    for (long i=0; i<(long) span; i++)
+      newId[i] = 0;
+#pragma omp parallel
+    {
+      vector<edge> block;
+#pragma omp for schedule(dynamic)
+      for (long k=0; k<numBlocks; k++) {
+        readBlock(k, block);
+        for (size_t i=0; i<block.size(); i++) {
+          newId[idOffset(block[i].head, minId)] = 1; //Every thread writes the same value
+          newId[idOffset(block[i].tail, minId)] = 1;
+        }
+      }
+    }
+    long numIds = parallelExclusiveScan(newId, (long) span);
+    m->newId  = newId;
+    m->numIds = numIds;
+    return;
+  }
+
+  long numRanges = min((long) MaxIdRanges, max(1L, (long) ceil(2.0 * NE * sizeof(long) / limit)));
+  if (numRanges > 1)
+    LOG_INFO("Sorting the vertex ids in %ld ranges\n", numRanges);
+  unsigned long width = span / numRanges + 1;
+  vector<long> ids;
+  for (long r=0; r<numRanges; r++) {
+    vector<long> rangeIds;
+#pragma omp parallel
+    {
+      vector<edge> block;
+      vector<long> myIds;
+#pragma omp for schedule(dynamic) nowait
+      for (long k=0; k<numBlocks; k++) {
+        readBlock(k, block);
+        for (size_t i=0; i<block.size(); i++) {
+          if (idOffset(block[i].head, minId) / width == (unsigned long) r)
+            myIds.push_back(block[i].head);
+          if (idOffset(block[i].tail, minId) / width == (unsigned long) r)
+            myIds.push_back(block[i].tail);
+        }
+      }
+      std::sort(myIds.begin(), myIds.end());
+      myIds.erase(std::unique(myIds.begin(), myIds.end()), myIds.end());
+#pragma omp critical
+      rangeIds.insert(rangeIds.end(), myIds.begin(), myIds.end());
+    }
+    parallelSort(rangeIds.data(), (long) rangeIds.size());
+    ids.insert(ids.end(), rangeIds.begin(), std::unique(rangeIds.begin(), rangeIds.end()));
+  }
+  m->numIds = (long) ids.size();
+  m->ids = (long *) malloc ((m->numIds + 1) * sizeof(long)); assert(m->ids != 0);
+  std::copy(ids.begin(), ids.end(), m->ids);
+}//End of buildVertexMap()
+
+static int parseSNAPLine(const char *p, const char *end, edge *e) {
+  if (atLineEnd(p, end, "#%"))
+    return 0; //Comment or empty line
+  long Si, Ti;
+  double wt;
+  if (!scanLong(&p, end, &Si) || !scanLong(&p, end, &Ti))
+    return -1;
+  if (atLineEnd(p, end, "#%"))
+    wt = 1.0; //Default weight of one
+  else if (!scanDouble(&p, end, &wt))
+    return -1;
+  e->head   = Si;
+  e->tail   = Ti;
+  e->weight = wt;
+  return 1;
+}//End of parseSNAPLine()
+
+//Build G from the SNAP file mapped at [base, base+length), with allocate as for
+//buildGraphFromEdgeBlocks(). If a temporary edge list fits in the ingest memory
+//limit, the file is parsed once into it. Otherwise the file is parsed again by
+//every pass: one for the range of the ids, one or more to number them and the
+//two of the graph builder, so that only the graph and the numbering are held.
+template <typename A>
+static bool loadSNAP(graph *G, const char *fileName, const char *base, size_t length, A allocate) {
+  double time1 = omp_get_wtime();
+  textChunks chunks;
+  splitTextLines(base, base + length, &chunks);
+  long numLines = chunks.firstLine[chunks.numChunks];
+  bool inMemory = ((double) numLines * sizeof(edge) <= (double) ingestMemoryLimit());
+
+  edge *tmpEdgeList = NULL; //Every edge stored ONCE
+  long NE = 0, numBlocks, badLine = -1;
+  long minId = 0, maxId = -1;
+  if (inMemory) {
+    NE = parseEdgeLines(&chunks, parseSNAPLine, &tmpEdgeList, &badLine);
+    numBlocks = (NE + BuildBlockEdges - 1) / BuildBlockEdges;
+    if (NE > 0)
+      minId = maxId = tmpEdgeList[0].head;
+#pragma omp parallel for reduction(min: minId) reduction(max: maxId)
+    for (long i=0; i<NE; i++) {
+      minId = min(minId, min(tmpEdgeList[i].head, tmpEdgeList[i].tail));
+      maxId = max(maxId, max(tmpEdgeList[i].head, tmpEdgeList[i].tail));
+    }
+  } else {
+    LOG_INFO("Edges do not fit the ingest memory limit: parsing the file in every pass\n");
+    numBlocks = chunks.numChunks;
+    minId = LONG_MAX;
+    maxId = LONG_MIN;
+#pragma omp parallel for schedule(dynamic) reduction(min: minId) reduction(max: maxId) reduction(+: NE)
+    for (long c=0; c<numBlocks; c++) {
+      long bad = parseChunkLines(&chunks, c, parseSNAPLine, [&](const edge &e) {
+          minId = min(minId, min(e.head, e.tail));
+          maxId = max(maxId, max(e.head, e.tail));
+          NE++;
+        });
+      if (bad >= 0) {
+#pragma omp critical
+        {
+          if ((badLine < 0) || (bad < badLine))
+            badLine = bad;
+        }
+      }
+    }
+  }
+  if (badLine >= 0) {
+    LOG_ERROR("parse_SNAP(): cannot parse line %ld of %s\n", badLine, fileName);
+    freeTextChunks(&chunks);
+    return false;
+  }
+  double time2 = omp_get_wtime();
+  LOG_INFO("Done reading from file: NE= %ld. Time= %lf\n", NE, time2-time1);
+
+  //The edges of block k with their original ids: from the temporary edge list,
+  //or parsed from chunk k of the file
+  auto readRawBlock = [&](long k, vector<edge> &block) {
+    if (inMemory) {
+      long first = k * BuildBlockEdges;
+      block.assign(tmpEdgeList + first, tmpEdgeList + min(first + BuildBlockEdges, NE));
+    } else {
+      block.clear();
+      parseChunkLines(&chunks, k, parseSNAPLine, [&](const edge &e) { block.push_back(e); });
+    }
+  };
+  snapVertexMap m;
+  buildVertexMap(&m, minId, maxId, NE, numBlocks, readRawBlock);
+  LOG_INFO("Number of unique vertices: %ld \n", m.numIds);
+
+  bool built = buildGraphFromEdgeBlocks(G, m.numIds, NE, numBlocks, [&](long k, vector<edge> &block) {
+      readRawBlock(k, block);
+      for (size_t i=0; i<block.size(); i++) {
+        block[i].head = mapVertexId(&m, block[i].head);
+        block[i].tail = mapVertexId(&m, block[i].tail);
+      }
+    }, allocate);
+  free(m.newId);
+  free(m.ids);
+  free(tmpEdgeList);
+  freeTextChunks(&chunks);
+  LOG_INFO("Graph built. Time= %lf\n", omp_get_wtime() - time2);
+  return built;
+}//End of loadSNAP()
+
+//Parse a SNAP formatted edge list: one edge "u v [w]" per line, fields separated
+//by blanks, tabs or commas, lines starting with '#' or '%' are comments. Edges
+//are assumed to be stored once; vertex ids are renumbered contiguously from zero
+//in increasing order of id, so ids 0..n-1 or 1..n keep their order. A missing
+//weight defaults to one. The file is memory mapped and parsed in parallel.
+//Return: false if the file cannot be read or parsed
+bool parse_SNAP(graph * G, char *fileName) {
+  LOG_INFO("Parsing a SNAP formatted file as a general graph...\n");
+  size_t length = 0;
+  bool mapped = false;
+  char *base = mapInputFile(fileName, &length, &mapped);
+  if (base == NULL) {
+    LOG_ERROR("Within Function: parse_SNAP(): could not open the file %s\n", fileName);
+    return false;
+  }
+  bool ok = loadSNAP(G, fileName, base, length, allocateGraphMemory);
+  unmapInputFile(base, length, mapped);
+  return ok;
+}//End of parse_SNAP()
+
+//Convert a SNAP formatted edge list (as for parse_SNAP()) to a FastPG CSR file.
+//The graph is built in a shared mapping of csrFileName, so its pages are written
+//back to the file rather than held in memory. Open the result with openGraphCSR().
+//Return: false if a file cannot be read or written, or the edge list cannot be parsed
+bool ingestSNAPToCSR(const char *fileName, const char *csrFileName) {
+  LOG_INFO("Converting a SNAP formatted file to a FastPG CSR file...\n");
+  size_t length = 0;
+  bool mapped = false;
+  char *base = mapInputFile(fileName, &length, &mapped);
+  if (base == NULL) {
+    LOG_ERROR("Within Function: ingestSNAPToCSR(): could not open the file %s\n", fileName);
+    return false;
+  }
+  csrFile out;
+  out.base = NULL;
+  graph G;
+  bool ok = loadSNAP(&G, fileName, base, length,
+    [&](long NV, long numEntries, long **edgeListPtrs, edge **edgeList) {
+      return createGraphCSR(csrFileName, NV, numEntries, &out, edgeListPtrs, edgeList);
+    });
+  unmapInputFile(base, length, mapped);
+  if (out.base != NULL)
+    ok = finishGraphCSR(&out) && ok;
+  if (!ok)
+    remove(csrFileName);
+  return ok;
+}//End of ingestSNAPToCSR()
@@ -0,0 +1,74 @@
+#include "defs.h"
+#include <stdarg.h>
+#include <string>
+#include <thread>
+#include <mutex>
+#ifndef FASTPG_STANDALONE
+#include <R_ext/Print.h>
+#endif
+
+#define LogBufferSize 1024
+
+int logLevel = LOG_LEVEL_DEFAULT;
+
+//Messages issued inside parallel regions or from other threads, printed later
+//from serial code on the main thread
+static std::vector<std::pair<int, std::string> > pendingMessages;
+static std::mutex pendingLock;
+//The thread that loaded the library, the R thread; setLogLevel() records it again
+static std::thread::id mainThread = std::this_thread::get_id();
+
+//OpenMP teams and TBB workers must not print: the R API is for the main thread
+//only, and omp_in_parallel() is false on TBB workers
+static bool canEmit() {
+  return (std::this_thread::get_id() == mainThread) && !omp_in_parallel();
+}
+
+//Only called when canEmit()
+static void emitMessage(int level, const char *message) {
+#ifdef FASTPG_STANDALONE
+  fputs(message, (level <= LOG_LEVEL_WARN) ? stderr : stdout);
+#else
+  if (level <= LOG_LEVEL_WARN)
+    REprintf("%s", message);
+  else
+    Rprintf("%s", message);
+#endif
+}
+
+int setLogLevel(int level) {
+  int previous = logLevel;
+  mainThread = std::this_thread::get_id(); //Called from R
+  if (level < LOG_LEVEL_SILENT)
+    level = LOG_LEVEL_SILENT;
+  if (level > LOG_LEVEL_DEBUG)
+    level = LOG_LEVEL_DEBUG;
+  logLevel = level;
+  return previous;
+}
+
+void logMessage(int level, const char *format, ...) {
+  if (level > logLevel)
+    return;
+  char buffer[LogBufferSize];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buffer, LogBufferSize, format, args);
+  va_end(args);
+  if (!canEmit()) {
+    std::lock_guard<std::mutex> guard(pendingLock);
+    pendingMessages.push_back(std::make_pair(level, std::string(buffer)));
+    return;
+  }
+  logFlush(); //Keep the messages in order
+  emitMessage(level, buffer);
+}//End of logMessage()
+
+void logFlush() {
+  if (!canEmit())
+    return;
+  std::lock_guard<std::mutex> guard(pendingLock); //Workers may still be queuing
+  for (size_t i = 0; i < pendingMessages.size(); i++)
+    emitMessage(pendingMessages[i].first, pendingMessages[i].second.c_str());
+  pendingMessages.clear();
+}//End of logFlush()
@@ -0,0 +1,36 @@
+#ifndef __logging__
+#define __logging__
+
+//Verbosity levels: a message is printed if its level is at most the current level
+#define LOG_LEVEL_SILENT 0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3   //Phase-level progress and summaries
+#define LOG_LEVEL_DEBUG  4   //Kernel internals: per-iteration tables, timings
+
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_WARN
+
+extern int logLevel; //Current verbosity; change it with setLogLevel()
+
+//Set the verbosity and return the previous one
+int setLogLevel(int level);
+//Format and print a message (printf syntax). Messages issued inside an OpenMP
+//parallel region or from a thread other than the main (R) thread, such as a TBB
+//worker, are queued and printed by the next call from serial code on the main thread.
+void logMessage(int level, const char *format, ...);
+//Print the queued messages; a no-op inside a parallel region or on another thread
+void logFlush();
+
+//Compiling with -DFASTPG_NO_LOGGING removes all logging calls
+#ifdef FASTPG_NO_LOGGING
+#define LOG_AT(level, ...) ((void) 0)
+#else
+#define LOG_AT(level, ...) do { if ((level) <= logLevel) logMessage((level), __VA_ARGS__); } while (0)
+#endif
+
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LOG_LEVEL_WARN,  __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LOG_LEVEL_INFO,  __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+#endif
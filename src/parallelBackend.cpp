@@ -0,0 +1,59 @@
+#include "defs.h"
+#include "parallel_backend.h"
+
+static int currentBackend = BackendOpenMP;
+static int currentThreads = 0; //0 outside of scopes
+
+bool parallelBackendAvailable(int backend) {
+#ifdef FASTPG_USE_TBB
+  return (backend == BackendOpenMP) || (backend == BackendTBB);
+#else
+  return (backend == BackendOpenMP);
+#endif
+}//End of parallelBackendAvailable()
+
+parallelBackendScope::parallelBackendScope(int backend, int nThreads) {
+  prevBackend = currentBackend;
+  prevThreads = currentThreads;
+  if (!parallelBackendAvailable(backend)) {
+    LOG_WARN("Backend %d is not available in this build, using OpenMP\n", backend);
+    backend = BackendOpenMP;
+  }
+  currentBackend = backend;
+  currentThreads = (nThreads < 1) ? 1 : nThreads;
+}
+
+parallelBackendScope::~parallelBackendScope() {
+  currentBackend = prevBackend;
+  currentThreads = prevThreads;
+}
+
+int parallelBackend() {
+  return currentBackend;
+}
+
+int backendThreads() {
+  return (currentThreads > 0) ? currentThreads : omp_get_max_threads();
+}
+
+#ifdef FASTPG_USE_TBB
+//Kept between scopes and rebuilt when the number of threads changes. The
+//worker threads belong to TBB, which shares them between all the arenas of the
+//process.
+static tbb::task_arena *arena = NULL;
+static int arenaThreads = 0;
+
+tbb::task_arena* backendArena() {
+  //TBB has no more workers than CPUs available to the process
+  int nT = std::min(backendThreads(), tbb::this_task_arena::max_concurrency());
+  if ((arena != NULL) && (arenaThreads != nT)) {
+    delete arena;
+    arena = NULL;
+  }
+  if (arena == NULL) {
+    arena = new tbb::task_arena(nT);
+    arenaThreads = nT;
+  }
+  return arena;
+}//End of backendArena()
+#endif
@@ -40,6 +40,7 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "utilityClusteringFunctions.h"
 #include "basic_comm.h"
 using namespace std;
@@ -48,19 +49,16 @@ double parallelDirectedLouvianMethod(dGraph *dG, long *C, int nThreads, double L
                              double thresh, double *totTime, int *numItr) {
 
 #ifdef PRINT_DETAILED_STATS_
-    printf("Within parallelLouvianMethod()\n");
+    LOG_DEBUG("Within parallelLouvianMethod()\n");
 #endif
-    if (nThreads < 1)
-        omp_set_num_threads(1);
-    else
-        omp_set_num_threads(nThreads);
+    ompThreadsScope threadsScope(nThreads); //Restored on return
     int nT;
 #pragma omp parallel
     {
         nT = omp_get_num_threads();
     }
 #ifdef PRINT_DETAILED_STATS_
-    printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
+    LOG_DEBUG("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 #endif
     
     
@@ -124,17 +122,17 @@ double parallelDirectedLouvianMethod(dGraph *dG, long *C, int nThreads, double L
     initCommAss(pastCommAss, currCommAss, NV);
     
     time2 = omp_get_wtime();
-    printf("Time to initialize: %3.3lf\n", time2-time1);
+    LOG_DEBUG("Time to initialize: %3.3lf\n", time2-time1);
     
 #ifdef PRINT_DETAILED_STATS_
-    printf("========================================================================================================\n");
-    printf("Itr      E_xx            A_x2           Curr-Mod         Time-1(s)       Time-2(s)        T/Itr(s)\n");
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Itr      E_xx            A_x2           Curr-Mod         Time-1(s)       Time-2(s)        T/Itr(s)\n");
+    LOG_DEBUG("========================================================================================================\n");
 #endif
 #ifdef PRINT_TERSE_STATS_
-    printf("=====================================================\n");
-    printf("Itr      Curr-Mod         T/Itr(s)      T-Cumulative\n");
-    printf("=====================================================\n");
+    LOG_DEBUG("=====================================================\n");
+    LOG_DEBUG("Itr      Curr-Mod         T/Itr(s)      T-Cumulative\n");
+    LOG_DEBUG("=====================================================\n");
 #endif
     //Start maximizing modularity
     while(true) {
@@ -208,10 +206,10 @@ reduction(+:e_xx) reduction(+:a2_x)
         totItr = (time2-time1) + (time4-time3);
         total += totItr;
 #ifdef PRINT_DETAILED_STATS_
-        printf("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr );
+        LOG_DEBUG("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr );
 #endif
 #ifdef PRINT_TERSE_STATS_
-        printf("%d \t %lf \t %3.3lf  \t %3.3lf\n",numItrs, currMod, totItr, total);
+        LOG_DEBUG("%d \t %lf \t %3.3lf  \t %3.3lf\n",numItrs, currMod, totItr, total);
 #endif
         
         //Break if modularity gain is not sufficient
@@ -241,14 +239,14 @@ reduction(+:e_xx) reduction(+:a2_x)
     *numItr  = numItrs;
     
 #ifdef PRINT_DETAILED_STATS_
-    printf("========================================================================================================\n");
-    printf("Total time for %d iterations is: %lf\n",numItrs, total);
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);
+    LOG_DEBUG("========================================================================================================\n");
 #endif
 #ifdef PRINT_TERSE_STATS_
-    printf("========================================================================================================\n");
-    printf("Total time for %d iterations is: %lf\n",numItrs, total);  
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);  
+    LOG_DEBUG("========================================================================================================\n");
 #endif
     
     //Store back the community assignments in the input variable:
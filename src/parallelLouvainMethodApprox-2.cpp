@@ -40,6 +40,7 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "basic_util.h"
 #include "utilityClusteringFunctions.h"
 #include "basic_comm.h"
@@ -49,19 +50,16 @@ using namespace std;
 double parallelLouvianMethodApprox2(graph *G, long *C, int nThreads, double Lower,
                                     double thresh, double *totTime, int *numItr, int percentage) {
 #ifdef PRINT_DETAILED_STATS_
-    printf("Within parallelLouvianMethod()\n");
+    LOG_DEBUG("Within parallelLouvianMethod()\n");
 #endif
-    if (nThreads < 1)
-        omp_set_num_threads(1);
-    else
-        omp_set_num_threads(nThreads);
+    ompThreadsScope threadsScope(nThreads); //Restored on return
     int nT;
 #pragma omp parallel
     {
         nT = omp_get_num_threads();
     }
 #ifdef PRINT_DETAILED_STATS_
-    printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
+    LOG_DEBUG("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 #endif
     double time1, time2, time3, time4; //For timing purposes
     double total = 0, totItr = 0;
@@ -120,17 +118,17 @@ double parallelLouvianMethodApprox2(graph *G, long *C, int nThreads, double Lowe
     double *randValues = (double *) malloc (NV*sizeof(double)); //Array to hold random number for each vertex
     
     time2 = omp_get_wtime();
-    printf("Time to initialize: %3.3lf\n", time2-time1);
+    LOG_DEBUG("Time to initialize: %3.3lf\n", time2-time1);
     
 #ifdef PRINT_DETAILED_STATS_
-    printf("========================================================================================================\n");
-    printf("Itr      E_xx            A_x2           Curr-Mod         Time-1(s)       Time-2(s)        T/Itr(s)\n");
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Itr      E_xx            A_x2           Curr-Mod         Time-1(s)       Time-2(s)        T/Itr(s)\n");
+    LOG_DEBUG("========================================================================================================\n");
 #endif
 #ifdef PRINT_TERSE_STATS_
-    printf("=====================================================\n");
-    printf("Itr      Curr-Mod         T/Itr(s)      T-Cumulative\n");
-    printf("=====================================================\n");
+    LOG_DEBUG("=====================================================\n");
+    LOG_DEBUG("Itr      Curr-Mod         T/Itr(s)      T-Cumulative\n");
+    LOG_DEBUG("=====================================================\n");
 #endif
     
     
@@ -142,10 +140,11 @@ double parallelLouvianMethodApprox2(graph *G, long *C, int nThreads, double Lowe
         numItrs++;
         time1 = omp_get_wtime();
         /* Re-initialize datastructures */
-        generateRandomNumbers(randValues, NV); //Generate random numbers for each iteration
+        //Generate random numbers for each iteration (one stream per iteration)
         //so that the same set of vertices are not chosen for skipping computation
 #pragma omp parallel for
         for (long i=0; i<NV; i++) {
+            randValues[i] = hashRandomU01(i, RandomSeed, numItrs);
             clusterWeightInternal[i] = 0;
             cUpdate[i].degree =0;
             cUpdate[i].size =0;
@@ -215,10 +214,10 @@ reduction(+:e_xx) reduction(+:a2_x)
         totItr = (time2-time1) + (time4-time3);
         total += totItr;
 #ifdef PRINT_DETAILED_STATS_
-        printf("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr );
+        LOG_DEBUG("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr );
 #endif
 #ifdef PRINT_TERSE_STATS_
-        printf("%d \t %lf \t %3.3lf  \t %3.3lf\n",numItrs, currMod, totItr, total);
+        LOG_DEBUG("%d \t %lf \t %3.3lf  \t %3.3lf\n",numItrs, currMod, totItr, total);
 #endif
         
         //Break if modularity gain is not sufficient
@@ -248,14 +247,14 @@ reduction(+:e_xx) reduction(+:a2_x)
     *numItr  = numItrs;
     
 #ifdef PRINT_DETAILED_STATS_
-    printf("========================================================================================================\n");
-    printf("Total time for %d iterations is: %lf\n",numItrs, total);
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);
+    LOG_DEBUG("========================================================================================================\n");
 #endif  
 #ifdef PRINT_TERSE_STATS_
-    printf("========================================================================================================\n");
-    printf("Total time for %d iterations is: %lf\n",numItrs, total);  
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);  
+    LOG_DEBUG("========================================================================================================\n");
 #endif
     
     //Store back the community assignments in the input variable:
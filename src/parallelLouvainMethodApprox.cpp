@@ -40,195 +40,203 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "utilityClusteringFunctions.h"
 #include "basic_comm.h"
-#include <stdlib.h>
+#include "basic_util.h"
 using namespace std;
 
-double parallelLouvianMethodApprox(graph *G, long *C, int nThreads, double Lower, 
-				double thresh, double *totTime, int *numItr, int percentage) {
-#ifdef PRINT_DETAILED_STATS_  
-  printf("Within parallelLouvianMethod()\n");
-#endif
-  if (nThreads < 1)
-    omp_set_num_threads(1);
-  else
-    omp_set_num_threads(nThreads);
+#define ApproxPlateauRatio 0.3
+#define ApproxMaxIterations 200 //Per phase, as the FastTrackResistance kernels
+
+//Whether vertex i is visited by iteration numItrs, which samples about fraction
+//of the vertices (sampling is SampleUniform, SampleDegree or SampleGain).
+//active: i or a neighbor moved in the last iteration.
+static inline bool sampleVertex(long i, int numItrs, int sampling, double fraction,
+                                double degree, double meanDegree, bool active) {
+  if ((sampling == SampleGain) && !active)
+    return false; //Neighborhood unchanged: little to gain
+  if (fraction >= 1)
+    return true;
+  double p = fraction;
+  if (sampling == SampleDegree)
+    p = (meanDegree > 0) ? fraction * degree / meanDegree : 1;
+  return hashRandomU01(i, RandomSeed, numItrs) < p;
+}//End of sampleVertex()
+
+//The NoMap kernel, but every iteration only looks for a better community for a
+//sample of the vertices, percentage % of them at first. When the modularity
+//gain of an iteration falls below thresh, or below ApproxPlateauRatio of the
+//gain of the first iteration with the same percentage, the percentage is
+//doubled (see sampleVertex() for the samples), and the phase ends when a sweep over all the vertices gains less than thresh, as in
+//the other kernels. Gains are measured against the best modularity of the
+//phase, which sampled iterations can lower. The sample is the same for any
+//number of threads.
+//The modularity counts every vertex: e_ix is recomputed for the vertices that
+//are not visited only when they or a neighbor moved in the last iteration.
+double parallelLouvianMethodApprox(graph *G, long *C, int nThreads, double Lower,
+				double thresh, double *totTime, int *numItr, int percentage, int sampling,
+				phaseStats *stats) {
+  ompThreadsScope threadsScope(nThreads); //Restored on return
   int nT;
 #pragma omp parallel
   {
     nT = omp_get_num_threads();
   }
-#ifdef PRINT_DETAILED_STATS_
-  printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
-#endif
-  double time1, time2, time3, time4; //For timing purposes  
+  parallelBackendScope backendScope(parallelBackend(), nT); //Slots of the backend loops stay below nT
+  double time1, time2, time3, time4; //For timing purposes
   double total = 0, totItr = 0;
-  //long percentange = clustering_parameters.percentage;
+
   long    NV        = G->numVertices;
-  long    NS        = G->sVertices;      
   long    NE        = G->numEdges;
   long    *vtxPtr   = G->edgeListPtrs;
   edge    *vtxInd   = G->edgeList;
- 
+
   /* Variables for computing modularity */
-  long totalEdgeWeightTwice;
   double constantForSecondTerm;
   double prevMod=-1;
   double currMod=-1;
-  //double thresMod = 0.000001;
+  double bestMod=-1; //Best modularity of the phase, to measure gains
   double thresMod = thresh; //Input parameter
   int numItrs = 0;
-  
+  int currPercentage = (percentage < 1) ? 1 : ((percentage > 100) ? 100 : percentage);
+  double levelGain = -1; //Gain of the first iteration with the current percentage
+  bool fullSweep = false; //Visit every vertex, also those skipped by SampleGain
+
   /********************** Initialization **************************/
-  time1 = omp_get_wtime();
   //Store the degree of all vertices
   double* vDegree = (double *) malloc (NV * sizeof(double)); assert(vDegree != 0);
   //Community info. (ai and size)
   Comm *cInfo = (Comm *) malloc (NV * sizeof(Comm)); assert(cInfo != 0);
   //use for updating Community
   Comm *cUpdate = (Comm*)malloc(NV*sizeof(Comm)); assert(cUpdate != 0);
-  //use for Modularity calculation (eii)
+  //use for Modularity calculation (eii), kept between iterations
   double* clusterWeightInternal = (double*) malloc (NV*sizeof(double)); assert(clusterWeightInternal != 0);
+  //Vertices that moved, or with a neighbor that moved, in the last iteration
+  char* active = (char *) malloc (NV * sizeof(char)); assert(active != 0);
 
   sumVertexDegree(vtxInd, vtxPtr, vDegree, NV , cInfo);	// Sum up the vertex degree
-  
+
   /*** Compute the total edge weight (2m) and 1/2m ***/
   constantForSecondTerm = calConstantForSecondTerm(vDegree, NV); // 1 over sum of the degree
+  double meanDegree = (NV > 0) ? 1.0 / (constantForSecondTerm * NV) : 0;
 
-  cout<<"CHECK THIS:              "<<constantForSecondTerm<<endl;
   //Community assignments:
   //Store previous iteration's community assignment
   long* pastCommAss = (long *) malloc (NV * sizeof(long)); assert(pastCommAss != 0);
   //Store current community assignment
-  long* currCommAss = (long *) malloc (NV * sizeof(long)); assert(currCommAss != 0);  
-  //Store the target of community assignment  
+  long* currCommAss = (long *) malloc (NV * sizeof(long)); assert(currCommAss != 0);
+  //Store the target of community assignment
   long* targetCommAss = (long *) malloc (NV * sizeof(long)); assert(targetCommAss != 0);
- 
-//Vectors used in place of maps: Total size = |V|+2*|E| -- The |V| part takes care of self loop
-//  mapElement* clusterLocalMapX = (mapElement *) malloc ((NV + 2*NE) * sizeof(mapElement)); assert(clusterLocalMapX != 0);
-  //double* Counter             = (double *)     malloc ((NV + 2*NE) * sizeof(double));     assert(Counter != 0);
- 
-  //Initialize each vertex to its own cluster
-  //initCommAssOpt(pastCommAss, currCommAss, NV, clusterLocalMapX, vtxPtr, vtxInd, cInfo, constantForSecondTerm, vDegree);
-  
-  //Initialize each vertex to its own cluster
-  initCommAss(pastCommAss, currCommAss, NV); 
 
-  time2 = omp_get_wtime();
-  printf("Time to initialize: %3.3lf\n", time2-time1);
-	
-#ifdef PRINT_DETAILED_STATS_
-  printf("========================================================================================================\n");
-  printf("Itr      E_xx            A_x2           Curr-Mod         Time-1(s)       Time-2(s)        T/Itr(s)\n");
-  printf("========================================================================================================\n");
-#endif
-#ifdef PRINT_TERSE_STATS_
-  printf("=====================================================\n");
-  printf("Itr      Curr-Mod         T/Itr(s)      T-Cumulative\n");
-  printf("=====================================================\n");
-#endif
+  //Vectors used in place of maps: Total size = |V|+2*|E| -- The |V| part takes care of self loop
+  mapElement* clusterLocalMap = (mapElement *) malloc ((NV + 2*NE) * sizeof(mapElement)); assert(clusterLocalMap != 0);
 
-bool *array = (bool *) malloc(NV*sizeof(bool));
-/*
+  //Initialize each vertex to its own cluster
+  initCommAssOpt(pastCommAss, currCommAss, NV, clusterLocalMap, vtxPtr, vtxInd, cInfo, constantForSecondTerm, vDegree);
 #pragma omp parallel for
-    for (long i=0; i<NV; i++) {
-        array[i]=true;
-        
-    }*/
-int x = NV*percentage/100;
+  for (long i=0; i<NV; i++) {
+    active[i] = 1; //No e_ix yet
+  }
 
-    
   //Start maximizing modularity
+  //One range of vertices of about the same work per thread; hubs are split across the threads
+  vertexSchedule sched;
+  buildVertexSchedule(vtxPtr, NV, nT, true, &sched);
+  double* threadBusy = (double *) malloc (nT * sizeof(double)); assert(threadBusy != 0);
+  recordScratchBytes(stats, NV*(2*sizeof(double) + 2*sizeof(Comm) + 3*sizeof(long) + sizeof(char)) + (NV + 2*NE)*sizeof(mapElement));
   while(true) {
-    numItrs++;    
+    numItrs++;
     time1 = omp_get_wtime();
+    long numMoved = 0; //Vertices that change community in this iteration
+    double fraction = currPercentage / 100.0;
+    bool allVisited = (currPercentage >= 100) && ((sampling != SampleGain) || fullSweep);
     /* Re-initialize datastructures */
-    if(numItrs<3){
-        #pragma omp parallel for
-        for (long i=0; i<NV; i++) {
-            int tmp = (int)rand()%(NV);
-            if(tmp<x)
-                array[i]=true;
-            else array[i]=false;
-        }
-    }
 #pragma omp parallel for
     for (long i=0; i<NV; i++) {
-      clusterWeightInternal[i] = 0; 
       cUpdate[i].degree =0;
       cUpdate[i].size =0;
     }
-//if(numItrs==1){
 
+    //Each range of about the same work goes to one thread (OpenMP), or the
+    //threads steal pieces of the vertices (TBB); the hubs follow
+    for (int t=0; t<nT; t++)
+      threadBusy[t] = 0;
+    parallelForRanges(sched.nT, 0, NV, [&](int t, long *begin, long *end) {
+      *begin = sched.bounds[t];
+      *end   = sched.bounds[t+1];
+    }, [&](long begin, long end, int slot) {
+      double tBusy = omp_get_wtime();
+      long moved = 0;
+      for (long i=begin; i<end; i++) {
+        if (isHub(&sched, vtxPtr, i))
+          continue; //Always visited, below by all the threads
+        long adj1 = vtxPtr[i];
+        long adj2 = vtxPtr[i+1];
+        if (adj1 == adj2) {
+          targetCommAss[i] = -1;
+          clusterWeightInternal[i] = 0;
+        } else if (allVisited || sampleVertex(i, numItrs, sampling, fraction, vDegree[i], meanDegree, active[i] != 0)) {
+          //Add the current cluster of i to the local map
+          long sPosition = vtxPtr[i]+i; //Starting position of local map for i
+          long numUniqueClusters = 0;
+          clusterLocalMap[sPosition].Counter = 0;          //Initialize the counter to ZERO (no edges incident yet)
+          clusterLocalMap[sPosition].cid = currCommAss[i]; //Initialize with current community
+          numUniqueClusters++; //Added the first entry
+          //Find unique cluster ids and #of edges incident (eicj) to them
+          double selfLoop = buildLocalMapCounterNoMap(i, clusterLocalMap, vtxPtr, vtxInd, currCommAss, numUniqueClusters);
+          clusterWeightInternal[i] = clusterLocalMap[sPosition].Counter; //(e_ix)
+          //Calculate the max
+          targetCommAss[i] = maxNoMap(i, clusterLocalMap, vtxPtr, selfLoop, cInfo, vDegree[i], currCommAss[i],
+                                      constantForSecondTerm, numUniqueClusters);
+        } else {
+          targetCommAss[i] = currCommAss[i]; //Not visited: stays
+          if (active[i]) {
+            double eix = 0;
+            for (long j=adj1; j<adj2; j++) {
+              if (currCommAss[vtxInd[j].tail] == currCommAss[i])
+                eix += vtxInd[j].weight;
+            }
+            clusterWeightInternal[i] = eix; //(e_ix)
+          }
+        }
 
-    /*
-}else{
-    #pragma omp parallel for
-    for (long i=0; i<NV; i++) {
-        if(array[i])
-            array[i]=false;
-        else array[i]=true;
-        
+        //Update
+        if(targetCommAss[i] != currCommAss[i]  && targetCommAss[i] != -1) {
+          moved++;
+#pragma omp atomic update
+          cUpdate[targetCommAss[i]].degree += vDegree[i];
+#pragma omp atomic update
+          cUpdate[targetCommAss[i]].size += 1;
+#pragma omp atomic update
+          cUpdate[currCommAss[i]].degree -= vDegree[i];
+#pragma omp atomic update
+          cUpdate[currCommAss[i]].size -=1;
+        }//End of If()
+      }//End of for(i)
+      __sync_fetch_and_add(&numMoved, moved);
+      threadBusy[slot] += omp_get_wtime() - tBusy;
+    });
+    //Hubs: the adjacency of each one is split across the threads
+    for (long h=0; h<sched.numHubs; h++) {
+      long i = sched.hubs[h];
+      double ownWeight = 0;
+      targetCommAss[i] = hubBestCommunity(&sched, i, vtxPtr, vtxInd, currCommAss, cInfo, vDegree[i],
+                                          constantForSecondTerm, &ownWeight);
+      clusterWeightInternal[i] = ownWeight; //(e_ix)
+      if(targetCommAss[i] != currCommAss[i]) {
+        numMoved++;
+        cUpdate[targetCommAss[i]].degree += vDegree[i];
+        cUpdate[targetCommAss[i]].size += 1;
+        cUpdate[currCommAss[i]].degree -= vDegree[i];
+        cUpdate[currCommAss[i]].size -=1;
+      }
     }
-}*/
-#pragma omp parallel for
-    for (long i=0; i<NV; i++) {
-        bool flag = false;
-        if(currCommAss[i]==pastCommAss[i]&&numItrs>2){
-            flag=true;
-        }
-        if(array[i]){//&&!flag
-        //if(i<NV*percentage/100){
-            long adj1 = vtxPtr[i];
-	      long adj2 = vtxPtr[i+1];
-		    double selfLoop = 0;
-		  //Build a datastructure to hold the cluster structure of its neighbors      	
-		  map<long, long> clusterLocalMap; //Map each neighbor's cluster to a local number
-		  map<long, long>::iterator storedAlready;
-		  vector<double> Counter; //Number of edges in each unique cluster
-		  //Add v's current cluster:
-		  if(adj1 != adj2){	
-		clusterLocalMap[currCommAss[i]] = 0;
-		      Counter.push_back(0); //Initialize the counter to ZERO (no edges incident yet)
-		      //Find unique cluster ids and #of edges incident (eicj) to them
-		      selfLoop = buildLocalMapCounter(adj1, adj2, clusterLocalMap, Counter, vtxInd, currCommAss, i);
-		      // Update delta Q calculation
-		      clusterWeightInternal[i] += Counter[0]; //(e_ix)
-		      //Calculate the max
-		      targetCommAss[i] = max(clusterLocalMap, Counter, selfLoop, cInfo, vDegree[i], currCommAss[i], constantForSecondTerm);
-		      //assert((targetCommAss[i] >= 0)&&(targetCommAss[i] < NV));
-	      	  } else {
-			    targetCommAss[i] = -1;	
-		  } 
-		      clusterLocalMap.clear();      
-		Counter.clear();
-        
-           }else {
-                         targetCommAss[i]=currCommAss[i];//(int)rand()%(NV*percentange/100);	
-		  }
-		//Update
-		if(targetCommAss[i] != currCommAss[i]  && targetCommAss[i] != -1) {
-		  #pragma omp atomic update
-			cUpdate[targetCommAss[i]].degree += vDegree[i];
-			#pragma omp atomic update
-			cUpdate[targetCommAss[i]].size += 1;
-		  #pragma omp atomic update
-			cUpdate[currCommAss[i]].degree -= vDegree[i];
-		  #pragma omp atomic update
-			cUpdate[currCommAss[i]].size -=1;
-		  /*
-		  __sync_fetch_and_add(&cUpdate[targetCommAss[i]].size, 1);
-			__sync_fetch_and_sub(&cUpdate[currCommAss[i]].degree, vDegree[i]);
-			__sync_fetch_and_sub(&cUpdate[currCommAss[i]].size, 1);*/
-		}//End of If()      
-		
-    }//End of for(i)
     time2 = omp_get_wtime();
- 
-    time3 = omp_get_wtime();    
+
+    time3 = omp_get_wtime();
     double e_xx = 0;
-    double a2_x = 0;	
+    double a2_x = 0;
 
 #pragma omp parallel for \
   reduction(+:e_xx) reduction(+:a2_x)
@@ -241,53 +249,68 @@ int x = NV*percentage/100;
     currMod = (e_xx*(double)constantForSecondTerm) - (a2_x*(double)constantForSecondTerm*(double)constantForSecondTerm);
     totItr = (time2-time1) + (time4-time3);
     total += totItr;
-#ifdef PRINT_DETAILED_STATS_
-    printf("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr );
-#endif
-#ifdef PRINT_TERSE_STATS_
-   printf("%d \t %lf \t %3.3lf  \t %3.3lf\n",numItrs, currMod, totItr, total);
-#endif
- 
-    //Break if modularity gain is not sufficient
-    if((currMod - prevMod) < thresMod) {
+    recordIteration(stats, numItrs, currMod, numMoved, totItr);
+    recordLoadImbalance(stats, threadImbalance(threadBusy, nT));
+    recordIdleTime(stats, threadIdleTime(threadBusy, nT));
+
+    //Break if modularity gain over the best is not sufficient with all the
+    //vertices. A sample is on a plateau when its gain is not sufficient either,
+    //or less than ApproxPlateauRatio of the gain of the first iteration with the
+    //same percentage: the percentage is doubled. SampleGain then ends with one
+    //iteration over all the vertices, and goes on with samples while these gain.
+    double gain = currMod - bestMod;
+    if(allVisited && (gain < thresMod))
       break;
+    if(currPercentage < 100) {
+      if((gain < thresMod) || ((levelGain >= 0) && (gain < ApproxPlateauRatio * levelGain))) {
+        currPercentage = (2*currPercentage > 100) ? 100 : 2*currPercentage;
+        levelGain = -1;
+      } else if(levelGain < 0) {
+        levelGain = gain;
+      }
+    } else {
+      fullSweep = (gain < thresMod);
     }
-    
+
     //Else update information for the next iteration
     prevMod = currMod;
     if(prevMod < Lower)
-	prevMod = Lower;
-#pragma omp parallel for 
+      prevMod = Lower;
+    if(prevMod > bestMod)
+      bestMod = prevMod; //Never lowered by a sampled iteration that lost modularity
+#pragma omp parallel for
     for (long i=0; i<NV; i++) {
       cInfo[i].size += cUpdate[i].size;
       cInfo[i].degree += cUpdate[i].degree;
+      active[i] = 0;
     }
-    
+    //The e_ix of the vertices that moved and of their neighbors are out of date
+#pragma omp parallel for schedule(guided)
+    for (long i=0; i<NV; i++) {
+      if (targetCommAss[i] != currCommAss[i]) {
+        active[i] = 1;
+        for (long j=vtxPtr[i]; j<vtxPtr[i+1]; j++)
+          active[vtxInd[j].tail] = 1; //Same value from every writer
+      }
+    }
+
     //Do pointer swaps to reuse memory:
     long* tmp;
     tmp = pastCommAss;
     pastCommAss = currCommAss; //Previous holds the current
     currCommAss = targetCommAss; //Current holds the chosen assignment
     targetCommAss = tmp;      //Reuse the vector
-    
+
+    //Prevent infinite loops
+    if (numItrs >= ApproxMaxIterations)
+      break;
   }//End of while(true)
   *totTime = total; //Return back the total time for clustering
   *numItr  = numItrs;
 
-#ifdef PRINT_DETAILED_STATS_
-  printf("========================================================================================================\n");
-  printf("Total time for %d iterations is: %lf\n",numItrs, total);  
-  printf("========================================================================================================\n");
-#endif  
-#ifdef PRINT_TERSE_STATS_
-  printf("========================================================================================================\n");
-  printf("Total time for %d iterations is: %lf\n",numItrs, total);  
-  printf("========================================================================================================\n");
-#endif
-
   //Store back the community assignments in the input variable:
   //Note: No matter when the while loop exits, we are interested in the previous assignment
-#pragma omp parallel for 
+#pragma omp parallel for
   for (long i=0; i<NV; i++) {
     C[i] = pastCommAss[i];
   }
@@ -299,6 +322,10 @@ int x = NV*percentage/100;
   free(cInfo);
   free(cUpdate);
   free(clusterWeightInternal);
+  free(active);
+  free(threadBusy);
+  freeVertexSchedule(&sched);
+  free(clusterLocalMap);
 
   return prevMod;
-}
+}//End of parallelLouvianMethodApprox()
@@ -40,27 +40,26 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "utilityClusteringFunctions.h"
 #include "sync_comm.h"
 
 using namespace std;
 
 double parallelLouvianMethodEarlyTerminate(graph *G, long *C, int nThreads, double Lower,
-                                           double thresh, double *totTime, int *numItr) {
+                                           double thresh, double *totTime, int *numItr, phaseStats *stats) {
 #ifdef PRINT_DETAILED_STATS_
-    printf("Within parallelLouvianMethodEarlyTerminate()\n");
+    LOG_DEBUG("Within parallelLouvianMethodEarlyTerminate()\n");
 #endif
-    if (nThreads < 1)
-    omp_set_num_threads(1);
-    else
-    omp_set_num_threads(nThreads);
+    ompThreadsScope threadsScope(nThreads); //Restored on return
     int nT;
 #pragma omp parallel
     {
         nT = omp_get_num_threads();
     }
+    parallelBackendScope backendScope(parallelBackend(), nT); //Slots of the backend loops stay below nT
 #ifdef PRINT_DETAILED_STATS_
-    printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
+    LOG_DEBUG("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 #endif
     double time1, time2, time3, time4; //For timing purposes
     double total = 0, totItr = 0;
@@ -120,23 +119,29 @@ double parallelLouvianMethodEarlyTerminate(graph *G, long *C, int nThreads, doub
         verT[i] = false;
     }
     time2 = omp_get_wtime();
-    printf("Time to initialize: %3.3lf\n", time2-time1);
+    LOG_DEBUG("Time to initialize: %3.3lf\n", time2-time1);
     
 #ifdef PRINT_DETAILED_STATS_
-    printf("=====================================================================================================================\n");
-    printf("Itr      E_xx            A_x2           Curr-Mod         Time-1(s)       Time-2(s)        T/Itr(s)      #V-Terminated\n");
-    printf("=====================================================================================================================\n");
+    LOG_DEBUG("=====================================================================================================================\n");
+    LOG_DEBUG("Itr      E_xx            A_x2           Curr-Mod         Time-1(s)       Time-2(s)        T/Itr(s)      #V-Terminated\n");
+    LOG_DEBUG("=====================================================================================================================\n");
 #endif
 #ifdef PRINT_TERSE_STATS_
-    printf("=========================================================================\n");
-    printf("Itr      Curr-Mod         T/Itr(s)      T-Cumulative        #V-Terminated\n");
-    printf("=========================================================================\n");
+    LOG_DEBUG("=========================================================================\n");
+    LOG_DEBUG("Itr      Curr-Mod         T/Itr(s)      T-Cumulative        #V-Terminated\n");
+    LOG_DEBUG("=========================================================================\n");
 #endif
     //Start maximizing modularity
     long termNodes = 0;
+    //One range of vertices of about the same work per thread; hubs are split across the threads
+    vertexSchedule sched;
+    buildVertexSchedule(vtxPtr, NV, nT, true, &sched);
+    double* threadBusy = (double *) malloc (nT * sizeof(double)); assert(threadBusy != 0);
+    recordScratchBytes(stats, NV*(2*sizeof(double) + 2*sizeof(Comm) + 3*sizeof(long) + sizeof(bool)) + (NV + 2*NE)*sizeof(mapElement));
     while(true) {
         numItrs++;
         time1 = omp_get_wtime();
+        long numMoved = 0; //Vertices that change community in this iteration
         
         /* Re-initialize datastructures */
 #pragma omp parallel for
@@ -153,59 +158,94 @@ double parallelLouvianMethodEarlyTerminate(graph *G, long *C, int nThreads, doub
         //long totalEdgeTravel= 0;
         //long totalUniqueComm = 0;
         
-        //#pragma omp parallel for reduction(+:totalEdgeTravel), reduction(+:totalUniqueComm)
-#pragma omp parallel for
-        for (long i=0; i<NV; i++) {
-            if(verT[i])
-                continue; //Check if the vertex has already been terminated
-            long adj1 = vtxPtr[i];
-            long adj2 = vtxPtr[i+1];
-            long selfLoop = 0;
+        //Each range of about the same work goes to one thread (OpenMP), or the
+        //threads steal pieces of the vertices (TBB); the hubs follow
+        for (int t=0; t<nT; t++)
+            threadBusy[t] = 0;
+        parallelForRanges(sched.nT, 0, NV, [&](int t, long *begin, long *end) {
+            *begin = sched.bounds[t];
+            *end   = sched.bounds[t+1];
+        }, [&](long begin, long end, int slot) {
+            double tBusy = omp_get_wtime();
+            long moved = 0;
+            for (long i=begin; i<end; i++) {
+                if(verT[i])
+                    continue; //Check if the vertex has already been terminated
+                if (isHub(&sched, vtxPtr, i))
+                    continue; //Processed below by all the threads
+                long adj1 = vtxPtr[i];
+                long adj2 = vtxPtr[i+1];
+                long selfLoop = 0;
             
-            //totalEdgeTravel += (adj2-adj1);
-            //Build a datastructure to hold the cluster structure of its neighbors
-            //map<long, long> clusterLocalMap; //Map each neighbor's cluster to a local number
-            //map<long, long>::iterator storedAlready;
-            // vector<double> Counter; //Number of edges in each unique cluster
-            long numUniqueClusters = 0;
-            //Add v's current cluster:
-            if(adj1 != adj2){
-                //Add the current cluster of i to the local map
-                long sPosition = vtxPtr[i]+i; //Starting position of local map for i
-                clusterLocalMap[sPosition].Counter = 0;          //Initialize the counter to ZERO (no edges incident yet)
-                clusterLocalMap[sPosition].cid = currCommAss[i]; //Initialize with current community
-                numUniqueClusters++; //Added the first entry
+                //totalEdgeTravel += (adj2-adj1);
+                //Build a datastructure to hold the cluster structure of its neighbors
+                //map<long, long> clusterLocalMap; //Map each neighbor's cluster to a local number
+                //map<long, long>::iterator storedAlready;
+                // vector<double> Counter; //Number of edges in each unique cluster
+                long numUniqueClusters = 0;
+                //Add v's current cluster:
+                if(adj1 != adj2){
+                    //Add the current cluster of i to the local map
+                    long sPosition = vtxPtr[i]+i; //Starting position of local map for i
+                    clusterLocalMap[sPosition].Counter = 0;          //Initialize the counter to ZERO (no edges incident yet)
+                    clusterLocalMap[sPosition].cid = currCommAss[i]; //Initialize with current community
+                    numUniqueClusters++; //Added the first entry
                 
-                //Find unique cluster ids and #of edges incident (eicj) to them
-                selfLoop = buildLocalMapCounterNoMap(i, clusterLocalMap, vtxPtr, vtxInd, currCommAss, numUniqueClusters);
-                // Update delta Q calculation
-                clusterWeightInternal[i] += clusterLocalMap[sPosition].Counter; //(e_ix)
-                //Calculate the max
-                targetCommAss[i] = maxNoMap(i, clusterLocalMap, vtxPtr, selfLoop, cInfo, vDegree[i], currCommAss[i],
-                                            constantForSecondTerm, numUniqueClusters);
-                //assert((targetCommAss[i] >= 0)&&(targetCommAss[i] < NV));
-            } else {
-                targetCommAss[i] = -1;
-            }
-            //totalUniqueComm += numUniqueClusters;
+                    //Find unique cluster ids and #of edges incident (eicj) to them
+                    selfLoop = buildLocalMapCounterNoMap(i, clusterLocalMap, vtxPtr, vtxInd, currCommAss, numUniqueClusters);
+                    // Update delta Q calculation
+                    clusterWeightInternal[i] += clusterLocalMap[sPosition].Counter; //(e_ix)
+                    //Calculate the max
+                    targetCommAss[i] = maxNoMap(i, clusterLocalMap, vtxPtr, selfLoop, cInfo, vDegree[i], currCommAss[i],
+                                                constantForSecondTerm, numUniqueClusters);
+                    //assert((targetCommAss[i] >= 0)&&(targetCommAss[i] < NV));
+                } else {
+                    targetCommAss[i] = -1;
+                }
+                //totalUniqueComm += numUniqueClusters;
             
+                if((numItrs > 1) && (targetCommAss[i] == pastCommAss[i]) && (targetCommAss[i]==currCommAss[i]) ){
+                    verT[i] = true; //Commuity assignment has not changed
+                    __sync_fetch_and_add(&termNodes, 1); //Update the number of terminated nodes
+                }
+            
+                //Update
+                if((targetCommAss[i] != currCommAss[i])  && (targetCommAss[i] != -1)) {
+                    moved++;
+#pragma omp atomic update
+                    cUpdate[targetCommAss[i]].degree += vDegree[i];
+#pragma omp atomic update
+                    cUpdate[targetCommAss[i]].size += 1;
+#pragma omp atomic update
+                    cUpdate[currCommAss[i]].degree -= vDegree[i];
+#pragma omp atomic update
+                    cUpdate[currCommAss[i]].size -=1;
+                }//End of If()
+            }//End of for(i)
+            __sync_fetch_and_add(&numMoved, moved);
+            threadBusy[slot] += omp_get_wtime() - tBusy;
+        });
+        //Hubs: the adjacency of each one is split across the threads
+        for (long h=0; h<sched.numHubs; h++) {
+            long i = sched.hubs[h];
+            if(verT[i])
+                continue;
+            double ownWeight = 0;
+            targetCommAss[i] = hubBestCommunity(&sched, i, vtxPtr, vtxInd, currCommAss, cInfo, vDegree[i],
+                                                constantForSecondTerm, &ownWeight);
+            clusterWeightInternal[i] += ownWeight; //(e_ix)
             if((numItrs > 1) && (targetCommAss[i] == pastCommAss[i]) && (targetCommAss[i]==currCommAss[i]) ){
                 verT[i] = true; //Commuity assignment has not changed
-                __sync_fetch_and_add(&termNodes, 1); //Update the number of terminated nodes
+                termNodes++;
             }
-            
-            //Update
-            if((targetCommAss[i] != currCommAss[i])  && (targetCommAss[i] != -1)) {
-#pragma omp atomic update
+            if(targetCommAss[i] != currCommAss[i]) {
+                numMoved++;
                 cUpdate[targetCommAss[i]].degree += vDegree[i];
-#pragma omp atomic update
                 cUpdate[targetCommAss[i]].size += 1;
-#pragma omp atomic update
                 cUpdate[currCommAss[i]].degree -= vDegree[i];
-#pragma omp atomic update
                 cUpdate[currCommAss[i]].size -=1;
-            }//End of If()
-        }//End of for(i)
+            }
+        }
         time2 = omp_get_wtime();
         
         time3 = omp_get_wtime();
@@ -223,12 +263,15 @@ double parallelLouvianMethodEarlyTerminate(graph *G, long *C, int nThreads, doub
         currMod = (e_xx*(double)constantForSecondTerm) - (a2_x*(double)constantForSecondTerm*(double)constantForSecondTerm);
         totItr = (time2-time1) + (time4-time3);
         total += totItr;
+        recordIteration(stats, numItrs, currMod, numMoved, totItr);
+        recordLoadImbalance(stats, threadImbalance(threadBusy, nT));
+        recordIdleTime(stats, threadIdleTime(threadBusy, nT));
 #ifdef PRINT_DETAILED_STATS_
-        printf("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf \t %3.3lf \t %d\n", numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr, termNodes);
+        LOG_DEBUG("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf \t %3.3lf \t %d\n", numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr, termNodes);
         //printf("%d %d %d %d %d %3.5lf\n",numItrs, NV, termNodes, totalEdgeTravel, totalUniqueComm, currMod);
 #endif
 #ifdef PRINT_TERSE_STATS_
-        printf("%d \t %lf \t %3.3lf \t %3.3lf \t %d\n", numItrs, currMod, totItr, total, termNodes);
+        LOG_DEBUG("%d \t %lf \t %3.3lf \t %3.3lf \t %d\n", numItrs, currMod, totItr, total, termNodes);
 #endif
         
         //Break if modularity gain is not sufficient
@@ -258,14 +301,14 @@ double parallelLouvianMethodEarlyTerminate(graph *G, long *C, int nThreads, doub
     *numItr  = numItrs;
     
 #ifdef PRINT_DETAILED_STATS_
-    printf("========================================================================================================\n");
-    printf("Total time for %d iterations is: %lf\n",numItrs, total);
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);
+    LOG_DEBUG("========================================================================================================\n");
 #endif
 #ifdef PRINT_TERSE_STATS_
-    printf("========================================================================================================\n");
-    printf("Total time for %d iterations is: %lf\n",numItrs, total);
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);
+    LOG_DEBUG("========================================================================================================\n");
 #endif
     
     //Store back the community assignments in the input variable:
@@ -283,6 +326,9 @@ double parallelLouvianMethodEarlyTerminate(graph *G, long *C, int nThreads, doub
     free(cUpdate);
     free(clusterWeightInternal);
     free(clusterLocalMap);
+    free(verT);
+    free(threadBusy);
+    freeVertexSchedule(&sched);
     
     return prevMod;
 }
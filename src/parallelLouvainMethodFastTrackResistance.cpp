@@ -40,6 +40,7 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "utilityClusteringFunctions.h"
 #include "basic_comm.h"
 using namespace std;
@@ -47,19 +48,16 @@ using namespace std;
 double parallelLouvianMethodFastTrackResistance(graph *G, long *C, int nThreads, double Lower,
         double thresh, double *totTime, int *numItr, int phase, double* rmin, double* finMod) {
 #ifdef PRINT_DETAILED_STATS_
-    printf("Within parallelLouvianMethodFastTrackResistance()\n");
+    LOG_DEBUG("Within parallelLouvianMethodFastTrackResistance()\n");
 #endif
-    if (nThreads < 1)
-        omp_set_num_threads(1);
-    else
-        omp_set_num_threads(nThreads);
+    ompThreadsScope threadsScope(nThreads); //Restored on return
     int nT;
 #pragma omp parallel
     {
         nT = omp_get_num_threads();
     }
 #ifdef PRINT_DETAILED_STATS_
-    printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
+    LOG_DEBUG("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 #endif
     double time1, time2, time3, time4; //For timing purposes
     double total = 0, totItr = 0;
@@ -109,17 +107,17 @@ double parallelLouvianMethodFastTrackResistance(graph *G, long *C, int nThreads,
     initCommAss(pastCommAss, currCommAss, NV);
 
     time2 = omp_get_wtime();
-    printf("Time to initialize: %3.3lf\n", time2-time1);
+    LOG_DEBUG("Time to initialize: %3.3lf\n", time2-time1);
     
 #ifdef PRINT_DETAILED_STATS_
-    printf("=============================================================================================================\n");
-    printf("Itr      E_xx            A_x2           R_min       Curr-Mod        Time-1(s)       Time-2(s)        T/Itr(s)\n");
-    printf("=============================================================================================================\n");
+    LOG_DEBUG("=============================================================================================================\n");
+    LOG_DEBUG("Itr      E_xx            A_x2           R_min       Curr-Mod        Time-1(s)       Time-2(s)        T/Itr(s)\n");
+    LOG_DEBUG("=============================================================================================================\n");
 #endif
 #ifdef PRINT_TERSE_STATS_
-    printf("==============================================================\n");
-    printf("Itr      R_min      Curr-Mod    T/Itr(s)      T-Cumulative\n");
-    printf("==============================================================\n");
+    LOG_DEBUG("==============================================================\n");
+    LOG_DEBUG("Itr      R_min      Curr-Mod    T/Itr(s)      T-Cumulative\n");
+    LOG_DEBUG("==============================================================\n");
 #endif
  
     while(true)
@@ -223,10 +221,10 @@ double parallelLouvianMethodFastTrackResistance(graph *G, long *C, int nThreads,
         totItr = (time2-time1) + (time4-time3);
         total += totItr;
 #ifdef PRINT_DETAILED_STATS_
-        printf("%d \t %g \t\t %g \t %g \t %g \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, r_min, currMod, (time2-time1), (time4-time3), totItr );
+        LOG_DEBUG("%d \t %g \t\t %g \t %g \t %g \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, r_min, currMod, (time2-time1), (time4-time3), totItr );
 #endif
 #ifdef PRINT_TERSE_STATS_
-        printf("%d \t %g \t %g \t %3.3lf  \t %3.3lf\n",numItrs, r_min, currMod, totItr, total);
+        LOG_DEBUG("%d \t %g \t %g \t %3.3lf  \t %3.3lf\n",numItrs, r_min, currMod, totItr, total);
 #endif
        
         // exit criteria
@@ -261,7 +259,7 @@ double parallelLouvianMethodFastTrackResistance(graph *G, long *C, int nThreads,
 
         // prevent infinite loop
         if (numItrs > 200) {
-            printf("Exiting after 200 iterations...\n");
+            LOG_DEBUG("Exiting after 200 iterations...\n");
             break;
         }
         numItrs++;
@@ -271,14 +269,14 @@ double parallelLouvianMethodFastTrackResistance(graph *G, long *C, int nThreads,
     *numItr  = numItrs;
     
 #ifdef PRINT_DETAILED_STATS_
-    printf("========================================================================================================\n");
-    printf("Total time for %d iterations is: %lf\n",numItrs, total);
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);
+    LOG_DEBUG("========================================================================================================\n");
 #endif
 #ifdef PRINT_TERSE_STATS_
-    printf("========================================================================================================\n");
-    printf("Total time for %d iterations is: %lf\n",numItrs, total);  
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);  
+    LOG_DEBUG("========================================================================================================\n");
 #endif
     
     //Store back the community assignments in the input variable:
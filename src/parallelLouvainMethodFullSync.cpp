@@ -40,27 +40,26 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "utilityClusteringFunctions.h"
 #include "sync_comm.h"
 
 using namespace std;
 
 double parallelLouvainMethodFullSync(graph *G, long *C, int nThreads, double Lower,
-                                     double thresh, double *totTime, int *numItr,int ytype, int freedom) {
+                                     double thresh, double *totTime, int *numItr,int ytype, int freedom, phaseStats *stats) {
 #ifdef PRINT_DETAILED_STATS_
-    printf("Within parallelLouvainMethodFullSync()\n");
+    LOG_DEBUG("Within parallelLouvainMethodFullSync()\n");
 #endif
-    if (nThreads < 1)
-        omp_set_num_threads(1);
-    else
-        omp_set_num_threads(nThreads);
+    ompThreadsScope threadsScope(nThreads); //Restored on return
     int nT;
 #pragma omp parallel
     {
         nT = omp_get_num_threads();
     }
+    parallelBackendScope backendScope(parallelBackend(), nT); //Slots of the backend loops stay below nT
 #ifdef PRINT_DETAILED_STATS_
-    printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
+    LOG_DEBUG("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 #endif
     double time1, time2, time3, time4; //For timing purposes
     double total = 0, totItr = 0;
@@ -103,7 +102,7 @@ double parallelLouvainMethodFullSync(graph *G, long *C, int nThreads, double Low
     initCommAss(C, C, NV);
     
     time2 = omp_get_wtime();
-    printf("Time to initialize: %3.3lf\n", time2-time1);
+    LOG_DEBUG("Time to initialize: %3.3lf\n", time2-time1);
     
     
     // Set up locks for full sync
@@ -115,51 +114,76 @@ double parallelLouvainMethodFullSync(graph *G, long *C, int nThreads, double Low
     
     
 #ifdef PRINT_DETAILED_STATS_
-    printf("========================================================================================================\n");
-    printf("Itr      E_xx            A_x2           Curr-Mod         Time-1(s)       Time-2(s)        T/Itr(s)\n");
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Itr      E_xx            A_x2           Curr-Mod         Time-1(s)       Time-2(s)        T/Itr(s)\n");
+    LOG_DEBUG("========================================================================================================\n");
 #endif
 #ifdef PRINT_TERSE_STATS_
-    printf("=====================================================\n");
-    printf("Itr      Curr-Mod         T/Itr(s)      T-Cumulative\n");
-    printf("=====================================================\n");
+    LOG_DEBUG("=====================================================\n");
+    LOG_DEBUG("Itr      Curr-Mod         T/Itr(s)      T-Cumulative\n");
+    LOG_DEBUG("=====================================================\n");
 #endif
     //Start maximizing modularity
+    //One range of vertices of about the same work per thread. Hubs are not split:
+    //a vertex moves under the locks of its own and its neighbors' communities
+    vertexSchedule sched;
+    buildVertexSchedule(vtxPtr, NV, nT, false, &sched);
+    auto range = [&](int t, long *begin, long *end) {
+        *begin = sched.bounds[t];
+        *end   = sched.bounds[t+1];
+    };
+    double* threadBusy = (double *) malloc (nT * sizeof(double)); assert(threadBusy != 0);
+    recordScratchBytes(stats, NV*(2*sizeof(double) + sizeof(Comm) + 2*sizeof(omp_lock_t)) + (NV + 2*NE)*sizeof(mapElement));
     while(true) {
         numItrs++;
         time1 = omp_get_wtime();
+        long numMoved = 0; //Vertices that change community in this iteration
         /* Re-initialize datastructures */
         
         long totalEdgeTravel= 0;
         long totalUniqueComm = 0;
         
-#pragma omp parallel for reduction(+:totalEdgeTravel), reduction(+:totalUniqueComm)
-        for (long i=0; i<NV; i++) {
-            long adj1 = vtxPtr[i];
-            long adj2 = vtxPtr[i+1];
-            long selfLoop = 0;
-            totalEdgeTravel += (adj2-adj1);
-            long numUniqueClusters = 0;
-            //Add v's current cluster:
-            if(adj1 != adj2){
-                //Add the current cluster of i to the local map
-                long sPosition = vtxPtr[i]+i; //Starting position of local map for i
-                double eix;
-                clusterLocalMap[sPosition].Counter = 0;          //Initialize the counter to ZERO (no edges incident yet)
-                clusterLocalMap[sPosition].cid = C[i]; //Initialize with current community
-                numUniqueClusters++; //Added the first entry
+        //Each range goes to one thread (OpenMP), or the threads steal pieces of
+        //the vertices (TBB)
+        for (int t=0; t<nT; t++)
+            threadBusy[t] = 0;
+        parallelForRanges(sched.nT, 0, NV, range, [&](long begin, long end, int slot) {
+            double tBusy = omp_get_wtime();
+            long moved = 0, edgeTravel = 0, uniqueComm = 0;
+            for (long i=begin; i<end; i++) {
+                long adj1 = vtxPtr[i];
+                long adj2 = vtxPtr[i+1];
+                long selfLoop = 0;
+                edgeTravel += (adj2-adj1);
+                long numUniqueClusters = 0;
+                //Add v's current cluster:
+                if(adj1 != adj2){
+                    //Add the current cluster of i to the local map
+                    long sPosition = vtxPtr[i]+i; //Starting position of local map for i
+                    double eix;
+                    clusterLocalMap[sPosition].Counter = 0;          //Initialize the counter to ZERO (no edges incident yet)
+                    clusterLocalMap[sPosition].cid = C[i]; //Initialize with current community
+                    numUniqueClusters++; //Added the first entry
                 
-                //Find unique cluster ids and #of edges incident (eicj) to them
-                selfLoop = buildAndLockLocalMapCounter(i, clusterLocalMap, vtxPtr, vtxInd, C, numUniqueClusters, vlocks, clocks, ytype, eix, freedom);
-                // Update delta Q calculation
-                //Calculate the max
-                maxAndFree(i, clusterLocalMap, vtxPtr, vtxInd, selfLoop, cInfo, C, constantForSecondTerm, numUniqueClusters, vlocks, clocks, ytype, eix, vDegree);
-                //assert((targetCommAss[i] >= 0)&&(targetCommAss[i] < NV));
-            } else {
+                    //Find unique cluster ids and #of edges incident (eicj) to them
+                    selfLoop = buildAndLockLocalMapCounter(i, clusterLocalMap, vtxPtr, vtxInd, C, numUniqueClusters, vlocks, clocks, ytype, eix, freedom);
+                    // Update delta Q calculation
+                    //Calculate the max
+                    long prevComm = C[i];
+                    maxAndFree(i, clusterLocalMap, vtxPtr, vtxInd, selfLoop, cInfo, C, constantForSecondTerm, numUniqueClusters, vlocks, clocks, ytype, eix, vDegree);
+                    if(C[i] != prevComm)
+                        moved++;
+                    //assert((targetCommAss[i] >= 0)&&(targetCommAss[i] < NV));
+                } else {
                 
-            }
-            totalUniqueComm += numUniqueClusters;
-        }//End of for(i)
+                }
+                uniqueComm += numUniqueClusters;
+            }//End of for(i)
+            __sync_fetch_and_add(&numMoved, moved);
+            __sync_fetch_and_add(&totalEdgeTravel, edgeTravel);
+            __sync_fetch_and_add(&totalUniqueComm, uniqueComm);
+            threadBusy[slot] += omp_get_wtime() - tBusy;
+        });
         time2 = omp_get_wtime();
         
         time3 = omp_get_wtime();
@@ -172,16 +196,17 @@ double parallelLouvainMethodFullSync(graph *G, long *C, int nThreads, double Low
         for (long i =0; i<NV;i++){
             clusterWeightInternal[i] = 0;
         }
-#pragma omp parallel for  //Parallelize on each vertex
-        for (long i=0; i<NV; i++) {
-            long adj1 = vtxPtr[i];
-            long adj2 = vtxPtr[i+1];
-            for(long j=adj1; j<adj2; j++) {
-                if(C[vtxInd[j].tail] == C[i]){
-                    clusterWeightInternal[i] += vtxInd[j].weight;
+        parallelForRanges(sched.nT, 0, NV, range, [&](long begin, long end, int slot) {
+            for (long i=begin; i<end; i++) {
+                long adj1 = vtxPtr[i];
+                long adj2 = vtxPtr[i+1];
+                for(long j=adj1; j<adj2; j++) {
+                    if(C[vtxInd[j].tail] == C[i]){
+                        clusterWeightInternal[i] += vtxInd[j].weight;
+                    }
                 }
             }
-        }
+        });
 #pragma omp parallel for reduction(+:e_xx) reduction(+:a2_x)
         for (long i=0; i<NV; i++) {
             e_xx += clusterWeightInternal[i];
@@ -192,13 +217,16 @@ double parallelLouvainMethodFullSync(graph *G, long *C, int nThreads, double Low
         currMod = (e_xx*(double)constantForSecondTerm) - (a2_x*(double)constantForSecondTerm*(double)constantForSecondTerm);
         totItr = (time2-time1) + (time4-time3);
         total += totItr;
+        recordIteration(stats, numItrs, currMod, numMoved, totItr);
+        recordLoadImbalance(stats, threadImbalance(threadBusy, nT));
+        recordIdleTime(stats, threadIdleTime(threadBusy, nT));
         
 #ifdef PRINT_DETAILED_STATS_
         //printf("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr );
-        printf("%d %d %d %d %3.5lf\n",numItrs, NV, totalEdgeTravel, totalUniqueComm, currMod);
+        LOG_DEBUG("%d %d %d %d %3.5lf\n",numItrs, NV, totalEdgeTravel, totalUniqueComm, currMod);
 #endif
 #ifdef PRINT_TERSE_STATS_
-        printf("%d \t %lf \t %3.3lf  \t %3.3lf\n",numItrs, currMod, totItr, total);
+        LOG_DEBUG("%d \t %lf \t %3.3lf  \t %3.3lf\n",numItrs, currMod, totItr, total);
 #endif
         
         //Break if modularity gain is not sufficient
@@ -211,21 +239,30 @@ double parallelLouvainMethodFullSync(graph *G, long *C, int nThreads, double Low
     *numItr  = numItrs;
     
 #ifdef PRINT_DETAILED_STATS_
-    printf("========================================================================================================\n");
-    printf("Total time for %d iterations is: %lf\n",numItrs, total);  
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);  
+    LOG_DEBUG("========================================================================================================\n");
 #endif  
 #ifdef PRINT_TERSE_STATS_
-    printf("========================================================================================================\n");
-    printf("Total time for %d iterations is: %lf\n",numItrs, total);  
-    printf("========================================================================================================\n");
+    LOG_DEBUG("========================================================================================================\n");
+    LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);  
+    LOG_DEBUG("========================================================================================================\n");
 #endif
     
     //Cleanup
+#pragma omp parallel for
+    for (long i=0; i<NV; i++) {
+        omp_destroy_lock(&vlocks[i]);
+        omp_destroy_lock(&clocks[i]);
+    }
     free(vDegree);
     free(cInfo);
+    free(vlocks);
+    free(clocks);
     free(clusterWeightInternal);
     free(clusterLocalMap);
+    free(threadBusy);
+    freeVertexSchedule(&sched);
     
     return currMod;
 }
@@ -42,23 +42,22 @@
 #include "defs.h"
 #include "basic_comm.h"
 #include "utilityClusteringFunctions.h"
+#include "parallel_backend.h"
 
 using namespace std;
 
 double parallelLouvianMethodNoMap(graph *G, long *C, int nThreads, double Lower,
-                                  double thresh, double *totTime, int *numItr) {
+                                  double thresh, double *totTime, int *numItr, phaseStats *stats) {
 #ifdef PRINT_DETAILED_STATS_
     //printf("Within parallelLouvianMethodNoMap()\n");
 #endif
-    if (nThreads < 1)
-    omp_set_num_threads(1);
-    else
-    omp_set_num_threads(nThreads);
+    ompThreadsScope threadsScope(nThreads); //Restored on return
     int nT;
 #pragma omp parallel
     {
         nT = omp_get_num_threads();
     }
+    parallelBackendScope backendScope(parallelBackend(), nT); //Slots of the backend loops stay below nT
 #ifdef PRINT_DETAILED_STATS_
     //printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 #endif
@@ -126,9 +125,15 @@ double parallelLouvianMethodNoMap(graph *G, long *C, int nThreads, double Lower,
     //printf("=====================================================\n");
 #endif
     //Start maximizing modularity
+    //One range of vertices of about the same work per thread; hubs are split across the threads
+    vertexSchedule sched;
+    buildVertexSchedule(vtxPtr, NV, nT, true, &sched);
+    double* threadBusy = (double *) malloc (nT * sizeof(double)); assert(threadBusy != 0);
+    recordScratchBytes(stats, NV*(2*sizeof(double) + 2*sizeof(Comm) + 3*sizeof(long)) + (NV + 2*NE)*sizeof(mapElement));
     while(true) {
         numItrs++;
         time1 = omp_get_wtime();
+        long numMoved = 0; //Vertices that change community in this iteration
         /* Re-initialize datastructures */
 #pragma omp parallel for
         for (long i=0; i<NV; i++) {
@@ -137,56 +142,86 @@ double parallelLouvianMethodNoMap(graph *G, long *C, int nThreads, double Lower,
             cUpdate[i].size =0;
         }
         
-#pragma omp parallel for
-        for (long i=0; i<NV; i++) {
-            long adj1 = vtxPtr[i];
-            long adj2 = vtxPtr[i+1];
-            double selfLoop = 0;
-            //Build a datastructure to hold the cluster structure of its neighbors
-            //map<long, long> clusterLocalMap; //Map each neighbor's cluster to a local number
-            //map<long, long>::iterator storedAlready;
-            // vector<double> Counter; //Number of edges in each unique cluster
-            long numUniqueClusters = 0;
-            //Add v's current cluster:
-            if(adj1 != adj2){
-                //Add the current cluster of i to the local map
-                long sPosition = vtxPtr[i]+i; //Starting position of local map for i
-                clusterLocalMap[sPosition].Counter = 0;          //Initialize the counter to ZERO (no edges incident yet)
-                clusterLocalMap[sPosition].cid = currCommAss[i]; //Initialize with current community
-                numUniqueClusters++; //Added the first entry
+        //Each range of about the same work goes to one thread (OpenMP), or the
+        //threads steal pieces of the vertices (TBB); the hubs follow
+        for (int t=0; t<nT; t++)
+            threadBusy[t] = 0;
+        parallelForRanges(sched.nT, 0, NV, [&](int t, long *begin, long *end) {
+            *begin = sched.bounds[t];
+            *end   = sched.bounds[t+1];
+        }, [&](long begin, long end, int slot) {
+            double tBusy = omp_get_wtime();
+            long moved = 0;
+            for (long i=begin; i<end; i++) {
+                if (isHub(&sched, vtxPtr, i))
+                    continue; //Processed below by all the threads
+                long adj1 = vtxPtr[i];
+                long adj2 = vtxPtr[i+1];
+                double selfLoop = 0;
+                //Build a datastructure to hold the cluster structure of its neighbors
+                //map<long, long> clusterLocalMap; //Map each neighbor's cluster to a local number
+                //map<long, long>::iterator storedAlready;
+                // vector<double> Counter; //Number of edges in each unique cluster
+                long numUniqueClusters = 0;
+                //Add v's current cluster:
+                if(adj1 != adj2){
+                    //Add the current cluster of i to the local map
+                    long sPosition = vtxPtr[i]+i; //Starting position of local map for i
+                    clusterLocalMap[sPosition].Counter = 0;          //Initialize the counter to ZERO (no edges incident yet)
+                    clusterLocalMap[sPosition].cid = currCommAss[i]; //Initialize with current community
+                    numUniqueClusters++; //Added the first entry
                 
-                //Find unique cluster ids and #of edges incident (eicj) to them
-                selfLoop = buildLocalMapCounterNoMap(i, clusterLocalMap, vtxPtr, vtxInd, currCommAss, numUniqueClusters);
-                // Update delta Q calculation
-                clusterWeightInternal[i] += clusterLocalMap[sPosition].Counter; //(e_ix)
-                //Calculate the max
-                targetCommAss[i] = maxNoMap(i, clusterLocalMap, vtxPtr, selfLoop, cInfo, vDegree[i], currCommAss[i],
-                                            constantForSecondTerm, numUniqueClusters);
-                //assert((targetCommAss[i] >= 0)&&(targetCommAss[i] < NV));
-            } else {
-                targetCommAss[i] = -1;
-            }
+                    //Find unique cluster ids and #of edges incident (eicj) to them
+                    selfLoop = buildLocalMapCounterNoMap(i, clusterLocalMap, vtxPtr, vtxInd, currCommAss, numUniqueClusters);
+                    // Update delta Q calculation
+                    clusterWeightInternal[i] += clusterLocalMap[sPosition].Counter; //(e_ix)
+                    //Calculate the max
+                    targetCommAss[i] = maxNoMap(i, clusterLocalMap, vtxPtr, selfLoop, cInfo, vDegree[i], currCommAss[i],
+                                                constantForSecondTerm, numUniqueClusters);
+                    //assert((targetCommAss[i] >= 0)&&(targetCommAss[i] < NV));
+                } else {
+                    targetCommAss[i] = -1;
+                }
             
-            //Update
-            if(targetCommAss[i] != currCommAss[i]  && targetCommAss[i] != -1) {
+                //Update
+                if(targetCommAss[i] != currCommAss[i]  && targetCommAss[i] != -1) {
+                    moved++;
                 
 #pragma omp atomic update
-                cUpdate[targetCommAss[i]].degree += vDegree[i];
+                    cUpdate[targetCommAss[i]].degree += vDegree[i];
 #pragma omp atomic update
-                cUpdate[targetCommAss[i]].size += 1;
+                    cUpdate[targetCommAss[i]].size += 1;
 #pragma omp atomic update
-                cUpdate[currCommAss[i]].degree -= vDegree[i];
+                    cUpdate[currCommAss[i]].degree -= vDegree[i];
 #pragma omp atomic update
-                cUpdate[currCommAss[i]].size -=1;
+                    cUpdate[currCommAss[i]].size -=1;
                 
                 
-                /*	      __sync_fetch_and_add(&cUpdate[targetCommAss[i]].degree, vDegree[i]);
-                 __sync_fetch_and_add(&cUpdate[targetCommAss[i]].size, 1);
-                 __sync_fetch_and_sub(&cUpdate[currCommAss[i]].degree, vDegree[i]);
-                 __sync_fetch_and_sub(&cUpdate[currCommAss[i]].size, 1);*/
-            }//End of If()
-            //numClustSize = 0;
-        }//End of for(i)
+                    /*	      __sync_fetch_and_add(&cUpdate[targetCommAss[i]].degree, vDegree[i]);
+                     __sync_fetch_and_add(&cUpdate[targetCommAss[i]].size, 1);
+                     __sync_fetch_and_sub(&cUpdate[currCommAss[i]].degree, vDegree[i]);
+                     __sync_fetch_and_sub(&cUpdate[currCommAss[i]].size, 1);*/
+                }//End of If()
+                //numClustSize = 0;
+            }//End of for(i)
+            __sync_fetch_and_add(&numMoved, moved);
+            threadBusy[slot] += omp_get_wtime() - tBusy;
+        });
+        //Hubs: the adjacency of each one is split across the threads
+        for (long h=0; h<sched.numHubs; h++) {
+            long i = sched.hubs[h];
+            double ownWeight = 0;
+            targetCommAss[i] = hubBestCommunity(&sched, i, vtxPtr, vtxInd, currCommAss, cInfo, vDegree[i],
+                                                constantForSecondTerm, &ownWeight);
+            clusterWeightInternal[i] += ownWeight; //(e_ix)
+            if(targetCommAss[i] != currCommAss[i]) {
+                numMoved++;
+                cUpdate[targetCommAss[i]].degree += vDegree[i];
+                cUpdate[targetCommAss[i]].size += 1;
+                cUpdate[currCommAss[i]].degree -= vDegree[i];
+                cUpdate[currCommAss[i]].size -=1;
+            }
+        }
         time2 = omp_get_wtime();
         
         time3 = omp_get_wtime();
@@ -204,6 +239,9 @@ reduction(+:e_xx) reduction(+:a2_x)
         currMod = (e_xx*(double)constantForSecondTerm) - (a2_x*(double)constantForSecondTerm*(double)constantForSecondTerm);
         totItr = (time2-time1) + (time4-time3);
         total += totItr;
+        recordIteration(stats, numItrs, currMod, numMoved, totItr);
+        recordLoadImbalance(stats, threadImbalance(threadBusy, nT));
+        recordIdleTime(stats, threadIdleTime(threadBusy, nT));
 #ifdef PRINT_DETAILED_STATS_
         //printf("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr );
 #endif
@@ -262,6 +300,8 @@ reduction(+:e_xx) reduction(+:a2_x)
     free(cInfo);
     free(cUpdate);
     free(clusterWeightInternal);
+    free(threadBusy);
+    freeVertexSchedule(&sched);
     free(clusterLocalMap);
     
     return prevMod;
@@ -40,25 +40,24 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "utilityClusteringFunctions.h"
+#include "basic_comm.h"
 using namespace std;
 
 double parallelLouvianMethodScale(graph *G, long *C, int nThreads, double Lower, 
-				double thresh, double *totTime, int *numItr) {
+				double thresh, double *totTime, int *numItr, phaseStats *stats) {
 #ifdef PRINT_DETAILED_STATS_  
-  printf("Within parallelLouvianMethod()\n");
+  LOG_DEBUG("Within parallelLouvianMethod()\n");
 #endif
-  if (nThreads < 1)
-    omp_set_num_threads(1);
-  else
-    omp_set_num_threads(nThreads);
+  ompThreadsScope threadsScope(nThreads); //Restored on return
   int nT;
 #pragma omp parallel
   {
     nT = omp_get_num_threads();
   }
 #ifdef PRINT_DETAILED_STATS_
-  printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
+  LOG_DEBUG("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 #endif
   double time1, time2, time3, time4; //For timing purposes  
   double total = 0, totItr = 0;
@@ -101,7 +100,7 @@ double parallelLouvianMethodScale(graph *G, long *C, int nThreads, double Lower,
   /*** Compute the total edge weight (2m) and 1/2m ***/
   constantForSecondTerm = calConstantForSecondTerm(vDegree, NV); // 1 over sum of the degree
 
-  cout<<"CHECK THIS:              "<<constantForSecondTerm<<endl;
+  LOG_DEBUG("CHECK THIS:              %g\n", constantForSecondTerm);
   //Community assignments:
   //Store previous iteration's community assignment
   long* pastCommAss = (long *) malloc (NV * sizeof(long)); assert(pastCommAss != 0);
@@ -121,22 +120,24 @@ double parallelLouvianMethodScale(graph *G, long *C, int nThreads, double Lower,
   initCommAss(pastCommAss, currCommAss, NV); 
 
   time2 = omp_get_wtime();
-  printf("Time to initialize: %3.3lf\n", time2-time1);
+  LOG_DEBUG("Time to initialize: %3.3lf\n", time2-time1);
 	
 #ifdef PRINT_DETAILED_STATS_
-  printf("========================================================================================================\n");
-  printf("Itr      E_xx            A_x2           Curr-Mod         Time-1(s)       Time-2(s)        T/Itr(s)\n");
-  printf("========================================================================================================\n");
+  LOG_DEBUG("========================================================================================================\n");
+  LOG_DEBUG("Itr      E_xx            A_x2           Curr-Mod         Time-1(s)       Time-2(s)        T/Itr(s)\n");
+  LOG_DEBUG("========================================================================================================\n");
 #endif
 #ifdef PRINT_TERSE_STATS_
-  printf("=====================================================\n");
-  printf("Itr      Curr-Mod         T/Itr(s)      T-Cumulative\n");
-  printf("=====================================================\n");
+  LOG_DEBUG("=====================================================\n");
+  LOG_DEBUG("Itr      Curr-Mod         T/Itr(s)      T-Cumulative\n");
+  LOG_DEBUG("=====================================================\n");
 #endif
   //Start maximizing modularity
+  recordScratchBytes(stats, NV*(2*sizeof(double) + sizeof(Comm) + 3*sizeof(long)));
   while(true) {
     numItrs++;    
     time1 = omp_get_wtime();
+    long numMoved = 0; //Vertices that change community in this iteration
     /* Re-initialize datastructures */
 #pragma omp parallel
 {
@@ -162,7 +163,7 @@ double parallelLouvianMethodScale(graph *G, long *C, int nThreads, double Lower,
     int meT = omp_get_thread_num();
     int myMap = meT*nT;
 
-    #pragma omp for
+    #pragma omp for reduction(+:numMoved)
     for (long i=0; i<NV; i++) {
 
       long adj1 = vtxPtr[i];
@@ -189,6 +190,7 @@ double parallelLouvianMethodScale(graph *G, long *C, int nThreads, double Lower,
 
         //Update
         if(targetCommAss[i] != currCommAss[i]  && targetCommAss[i] != -1) {
+          numMoved++;
           int owner1 = currCommAss[i] / blkSize + myMap;
           int owner2 = targetCommAss[i]/ blkSize + myMap;
           
@@ -240,11 +242,12 @@ double parallelLouvianMethodScale(graph *G, long *C, int nThreads, double Lower,
     currMod = (e_xx*(double)constantForSecondTerm) - (a2_x*(double)constantForSecondTerm*(double)constantForSecondTerm);
     totItr = (time2-time1) + (time4-time3);
     total += totItr;
+    recordIteration(stats, numItrs, currMod, numMoved, totItr);
 #ifdef PRINT_DETAILED_STATS_
-    printf("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr );
+    LOG_DEBUG("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr );
 #endif
 #ifdef PRINT_TERSE_STATS_
-   printf("%d \t %lf \t %3.3lf  \t %3.3lf\n",numItrs, currMod, totItr, total);
+   LOG_DEBUG("%d \t %lf \t %3.3lf  \t %3.3lf\n",numItrs, currMod, totItr, total);
 #endif
  
     //Break if modularity gain is not sufficient
@@ -289,14 +292,14 @@ double parallelLouvianMethodScale(graph *G, long *C, int nThreads, double Lower,
   *numItr  = numItrs;
 
 #ifdef PRINT_DETAILED_STATS_
-  printf("========================================================================================================\n");
-  printf("Total time for %d iterations is: %lf\n",numItrs, total);  
-  printf("========================================================================================================\n");
+  LOG_DEBUG("========================================================================================================\n");
+  LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);  
+  LOG_DEBUG("========================================================================================================\n");
 #endif  
 #ifdef PRINT_TERSE_STATS_
-  printf("========================================================================================================\n");
-  printf("Total time for %d iterations is: %lf\n",numItrs, total);  
-  printf("========================================================================================================\n");
+  LOG_DEBUG("========================================================================================================\n");
+  LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);  
+  LOG_DEBUG("========================================================================================================\n");
 #endif
 
   //Store back the community assignments in the input variable:
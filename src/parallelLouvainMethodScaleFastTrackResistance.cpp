@@ -40,25 +40,23 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "utilityClusteringFunctions.h"
 using namespace std;
 
 double parallelLouvianMethodScaleFastTrackResistance(graph *G, long *C, int nThreads, double Lower, 
         double thresh, double *totTime, int *numItr, int phase, double* rmin, double* finMod) {
 #ifdef PRINT_DETAILED_STATS_  
-  printf("Within parallelLouvianMethodScaleFastTrackResistance()\n");
+  LOG_DEBUG("Within parallelLouvianMethodScaleFastTrackResistance()\n");
 #endif
-  if (nThreads < 1)
-    omp_set_num_threads(1);
-  else
-    omp_set_num_threads(nThreads);
+  ompThreadsScope threadsScope(nThreads); //Restored on return
   int nT;
 #pragma omp parallel
   {
     nT = omp_get_num_threads();
   }
 #ifdef PRINT_DETAILED_STATS_
-  printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
+  LOG_DEBUG("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 #endif
   double time1, time2, time3, time4; //For timing purposes  
   double total = 0, totItr = 0;
@@ -122,17 +120,17 @@ double parallelLouvianMethodScaleFastTrackResistance(graph *G, long *C, int nThr
   initCommAss(pastCommAss, currCommAss, NV); 
 
   time2 = omp_get_wtime();
-  printf("Time to initialize: %3.3lf\n", time2-time1);
+  LOG_DEBUG("Time to initialize: %3.3lf\n", time2-time1);
 	
 #ifdef PRINT_DETAILED_STATS_
-  printf("===================================================================================================================\n");
-  printf("Itr      E_xx            A_x2           Curr-Mod      Curr-Mod-AFG        Time-1(s)       Time-2(s)        T/Itr(s)\n");
-  printf("===================================================================================================================\n");
+  LOG_DEBUG("===================================================================================================================\n");
+  LOG_DEBUG("Itr      E_xx            A_x2           Curr-Mod      Curr-Mod-AFG        Time-1(s)       Time-2(s)        T/Itr(s)\n");
+  LOG_DEBUG("===================================================================================================================\n");
 #endif
 #ifdef PRINT_TERSE_STATS_
-  printf("====================================================================\n");
-  printf("Itr      Curr-Mod     Curr-Mod-AFG        T/Itr(s)      T-Cumulative\n");
-  printf("====================================================================\n");
+  LOG_DEBUG("====================================================================\n");
+  LOG_DEBUG("Itr      Curr-Mod     Curr-Mod-AFG        T/Itr(s)      T-Cumulative\n");
+  LOG_DEBUG("====================================================================\n");
 #endif
   //Start maximizing modularity
   while(true) {
@@ -278,10 +276,10 @@ double parallelLouvianMethodScaleFastTrackResistance(graph *G, long *C, int nThr
     total += totItr;
 
 #ifdef PRINT_DETAILED_STATS_
-        printf("%d \t %g \t\t %g \t %g \t %g \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, r_min, currMod, (time2-time1), (time4-time3), totItr );
+        LOG_DEBUG("%d \t %g \t\t %g \t %g \t %g \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, r_min, currMod, (time2-time1), (time4-time3), totItr );
 #endif
 #ifdef PRINT_TERSE_STATS_
-        printf("%d \t %g \t %g \t %3.3lf  \t %3.3lf\n",numItrs, r_min, currMod, totItr, total);
+        LOG_DEBUG("%d \t %g \t %g \t %3.3lf  \t %3.3lf\n",numItrs, r_min, currMod, totItr, total);
 #endif
        
         // exit criteria
@@ -338,14 +336,14 @@ double parallelLouvianMethodScaleFastTrackResistance(graph *G, long *C, int nThr
   *numItr  = numItrs;
 
 #ifdef PRINT_DETAILED_STATS_
-  printf("========================================================================================================\n");
-  printf("Total time for %d iterations is: %lf\n",numItrs, total);  
-  printf("========================================================================================================\n");
+  LOG_DEBUG("========================================================================================================\n");
+  LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);  
+  LOG_DEBUG("========================================================================================================\n");
 #endif  
 #ifdef PRINT_TERSE_STATS_
-  printf("========================================================================================================\n");
-  printf("Total time for %d iterations is: %lf\n",numItrs, total);  
-  printf("========================================================================================================\n");
+  LOG_DEBUG("========================================================================================================\n");
+  LOG_DEBUG("Total time for %d iterations is: %lf\n",numItrs, total);  
+  LOG_DEBUG("========================================================================================================\n");
 #endif
 
   //Store back the community assignments in the input variable:
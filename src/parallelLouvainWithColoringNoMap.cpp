@@ -41,23 +41,23 @@
 
 #include "defs.h"
 #include "utilityClusteringFunctions.h"
+#include "parallel_backend.h"
 #include "color_comm.h"
+#include "parallel_scan.h"
 using namespace std;
 
 double algoLouvainWithDistOneColoringNoMap(graph* G, long *C, int nThreads, int* color,
-			int numColor, double Lower, double thresh, double *totTime, int *numItr) {
+			int numColor, double Lower, double thresh, double *totTime, int *numItr, phaseStats *stats) {
 #ifdef PRINT_DETAILED_STATS_  
 	//printf("Within algoLouvainWithDistOneColoring()\n");
 #endif
-	if (nThreads < 1)
-		omp_set_num_threads(1);
-	else
-		omp_set_num_threads(nThreads);
+	ompThreadsScope threadsScope(nThreads); //Restored on return
 	int nT;
 #pragma omp parallel
 	{
 		nT = omp_get_num_threads();
 	}
+	parallelBackendScope backendScope(parallelBackend(), nT); //Slots of the backend loops stay below nT
 #ifdef PRINT_DETAILED_STATS_  
 	//printf("Actual number of threads: %d (requested: %d)\n", nT, nThreads);
 #endif
@@ -112,6 +112,17 @@ double algoLouvainWithDistOneColoringNoMap(graph* G, long *C, int nThreads, int*
 
 	clusterWeightInternal = (double*) malloc (NV*sizeof(double)); assert(clusterWeightInternal != 0);
 	
+	/*** Communities changed by the current color class: only these are updated ***/
+	char* commChanged = (char*) malloc (NV*sizeof(char)); assert(commChanged != 0);
+	long* changedList = (long*) malloc (NV*sizeof(long)); assert(changedList != 0);
+	long  numChanged  = 0;
+#pragma omp parallel for
+	for (long i=0; i<NV; i++) {
+		commChanged[i] = 0;
+		cUpdate[i].degree = 0;
+		cUpdate[i].size = 0;
+	}
+	
 	/*** Create a CSR-like datastructure for vertex-colors ***/
 	long * colorPtr = (long *) malloc ((numColor+1) * sizeof(long));
 	long * colorIndex = (long *) malloc (NV * sizeof(long));
@@ -132,9 +143,7 @@ double algoLouvainWithDistOneColoringNoMap(graph* G, long *C, int nThreads, int*
 		__sync_fetch_and_add(&colorPtr[(long)color[i]+1],1);
 	}
 	//Prefix sum:
-	for(long i=0; i<numColor; i++) {
-		colorPtr[i+1] += colorPtr[i];
-	}	
+	parallelInclusiveScan(colorPtr, numColor+1);
 	//Group vertices with the same color in particular order
 #pragma omp parallel for
 	for (long i=0; i<NV; i++) {
@@ -142,6 +151,15 @@ double algoLouvainWithDistOneColoringNoMap(graph* G, long *C, int nThreads, int*
 		long Where = colorPtr[tc] + __sync_fetch_and_add(&(colorAdded[tc]), 1);
 		colorIndex[Where] = i;
 	}
+	//Hubs are left out of the color class ranges and split across the threads
+	vertexSchedule sched;
+	buildVertexSchedule(vtxPtr, NV, nT, true, &sched);
+	//Work (edges + vertices) of the color classes, used to balance threads within a class
+	long * workPrefix = (long *) malloc ((NV+1) * sizeof(long)); assert(workPrefix != 0);
+	buildColorClassWork(colorIndex, vtxPtr, NV, &sched, workPrefix);
+	double * threadBusy = (double *) malloc (nT * sizeof(double)); assert(threadBusy != 0);
+	double idleTime = 0;      //Time threads spend waiting for others within a color class
+	long   serialClasses = 0; //Color classes too small to be worth a parallel region
 	time2 = omp_get_wtime();
 	//printf("Time to initialize: %3.3lf\n", time2-time1);
 #ifdef PRINT_DETAILED_STATS_	
@@ -154,73 +172,115 @@ double algoLouvainWithDistOneColoringNoMap(graph* G, long *C, int nThreads, int*
 	//printf("Itr      Curr-Mod         T/Itr(s)      T-Cumulative\n");
 	//printf("=====================================================\n");
 #endif
+	recordScratchBytes(stats, NV*(sizeof(double)*2 + sizeof(Comm)*2 + sizeof(long)*4 + sizeof(char)) + (numColor*2 + 1)*sizeof(long) + (NV + 2*NE)*sizeof(mapElement));
 	while(true) {
 		numItrs++;
 		
 		time1 = omp_get_wtime();
+		long numMoved = 0; //Vertices that change community in this iteration
+		double itrMaxBusy = 0, itrSumBusy = 0; //Load imbalance of the sweep
 		for( long ci = 0; ci < numColor; ci++) // Begin of color loop
 		{
-#pragma omp parallel for
-			for (long i=0; i<NV; i++) {
-				clusterWeightInternal[i] = 0; //Initialize to zero
-				cUpdate[i].degree =0;
-				cUpdate[i].size =0;
-			}
 			long coloradj1 = colorPtr[ci];
 			long coloradj2 = colorPtr[ci+1];
 			
-#pragma omp parallel for  
-			for (long K = coloradj1; K<coloradj2; K++) {
-				long i = colorIndex[K];
-				long localTarget = -1;
-				long adj1 = vtxPtr[i];
-				long adj2 = vtxPtr[i+1];
-				double selfLoop = 0;
-				//Build a datastructure to hold the cluster structure of its neighbors:      	
-				//map<long, long> clusterLocalMap; //Map each neighbor's cluster to a local number
-				//map<long, long>::iterator storedAlready;
-				//vector<double> Counter; //Number of edges to each unique cluster
-				long numUniqueClusters = 0;
-				if(adj1 != adj2) {
-					//Add the current cluster of i to the local map
-                    long sPosition = vtxPtr[i]+i; //Starting position of local map for i
-                    clusterLocalMap[sPosition].Counter = 0;          //Initialize the counter to ZERO (no edges incident yet)
-                    clusterLocalMap[sPosition].cid = currCommAss[i]; //Initialize with current community
-                    numUniqueClusters++; //Added the first entry
+			//Small color classes get fewer threads (one per ColorClassMinWork units of work),
+			//and each thread gets a contiguous range with about the same number of edges (OpenMP)
+			//or steals pieces of the class from the busy ones (TBB)
+			long classWork = workPrefix[coloradj2] - workPrefix[coloradj1];
+			int  classThreads = (int) min((long)nT, 1 + classWork/ColorClassMinWork);
+			int  classTeam = ((classThreads > 1) && (parallelBackend() == BackendTBB)) ? nT : classThreads;
+			for (int t=0; t<classTeam; t++)
+				threadBusy[t] = 0;
+			parallelForRanges(classThreads, coloradj1, coloradj2, [&](int t, long *kBegin, long *kEnd) {
+				colorClassThreadRange(workPrefix, coloradj1, coloradj2, t, classThreads, kBegin, kEnd);
+			}, [&](long kBegin, long kEnd, int slot) {
+				long moved = 0;
+				double tBusy = omp_get_wtime();
+				for (long K = kBegin; K<kEnd; K++) {
+					long i = colorIndex[K];
+					if (isHub(&sched, vtxPtr, i))
+						continue; //Processed after the class by all the threads
+					long localTarget = -1;
+					long adj1 = vtxPtr[i];
+					long adj2 = vtxPtr[i+1];
+					double selfLoop = 0;
+					//Build a datastructure to hold the cluster structure of its neighbors:      	
+					//map<long, long> clusterLocalMap; //Map each neighbor's cluster to a local number
+					//map<long, long>::iterator storedAlready;
+					//vector<double> Counter; //Number of edges to each unique cluster
+					long numUniqueClusters = 0;
+					if(adj1 != adj2) {
+						//Add the current cluster of i to the local map
+                        long sPosition = vtxPtr[i]+i; //Starting position of local map for i
+                        clusterLocalMap[sPosition].Counter = 0;          //Initialize the counter to ZERO (no edges incident yet)
+                        clusterLocalMap[sPosition].cid = currCommAss[i]; //Initialize with current community
+                        numUniqueClusters++; //Added the first entry
                     
-					//Find unique cluster ids and #of edges incident (eicj) to them
-					selfLoop = buildLocalMapCounterNoMap(i, clusterLocalMap, vtxPtr, vtxInd, currCommAss, numUniqueClusters);
-					//Calculate the max
-					localTarget = maxNoMap(i, clusterLocalMap, vtxPtr, selfLoop, cInfo, vDegree[i], currCommAss[i], constantForSecondTerm, numUniqueClusters);
-				} else {
-					localTarget = -1;
-				}					
-				//Update prepare
-				if(localTarget != currCommAss[i] && localTarget != -1) {
-          #pragma omp atomic update
-          cUpdate[localTarget].degree += vDegree[i];
-          #pragma omp atomic update
-          cUpdate[localTarget].size += 1;
-          #pragma omp atomic update
-          cUpdate[currCommAss[i]].degree -= vDegree[i];
-          #pragma omp atomic update
-          cUpdate[currCommAss[i]].size -=1;
-      /*
-					__sync_fetch_and_add(&cUpdate[localTarget].degree, vDegree[i]);
-	         			__sync_fetch_and_add(&cUpdate[localTarget].size, 1);
-					__sync_fetch_and_sub(&cUpdate[currCommAss[i]].degree, vDegree[i]);
-					__sync_fetch_and_sub(&cUpdate[currCommAss[i]].size, 1);*/
-				}//End of If()
-				currCommAss[i] = localTarget;      
-				//clusterLocalMap.clear();
-			}//End of for(i)
-			
-			// UPDATE
-#pragma omp parallel for  
-			for (long i=0; i<NV; i++) {
-				cInfo[i].size += cUpdate[i].size;
-				cInfo[i].degree += cUpdate[i].degree;
+						//Find unique cluster ids and #of edges incident (eicj) to them
+						selfLoop = buildLocalMapCounterNoMap(i, clusterLocalMap, vtxPtr, vtxInd, currCommAss, numUniqueClusters);
+						//Calculate the max
+						localTarget = maxNoMap(i, clusterLocalMap, vtxPtr, selfLoop, cInfo, vDegree[i], currCommAss[i], constantForSecondTerm, numUniqueClusters);
+					} else {
+						localTarget = -1;
+					}					
+					//Update prepare
+					if(localTarget != currCommAss[i] && localTarget != -1) {
+              moved++;
+              markCommunityChanged(localTarget, commChanged, changedList, &numChanged);
+              markCommunityChanged(currCommAss[i], commChanged, changedList, &numChanged);
+              #pragma omp atomic update
+              cUpdate[localTarget].degree += vDegree[i];
+              #pragma omp atomic update
+              cUpdate[localTarget].size += 1;
+              #pragma omp atomic update
+              cUpdate[currCommAss[i]].degree -= vDegree[i];
+              #pragma omp atomic update
+              cUpdate[currCommAss[i]].size -=1;
+          /*
+						__sync_fetch_and_add(&cUpdate[localTarget].degree, vDegree[i]);
+		         			__sync_fetch_and_add(&cUpdate[localTarget].size, 1);
+						__sync_fetch_and_sub(&cUpdate[currCommAss[i]].degree, vDegree[i]);
+						__sync_fetch_and_sub(&cUpdate[currCommAss[i]].size, 1);*/
+					}//End of If()
+					currCommAss[i] = localTarget;      
+					//clusterLocalMap.clear();
+				}//End of for(i)
+				__sync_fetch_and_add(&numMoved, moved);
+				threadBusy[slot] += omp_get_wtime() - tBusy;
+			});
+			double maxBusy = 0, sumBusy = 0;
+			for (int t=0; t<classTeam; t++) {
+				sumBusy += threadBusy[t];
+				if (threadBusy[t] > maxBusy) maxBusy = threadBusy[t];
 			}
+			idleTime += classTeam*maxBusy - sumBusy;
+			if (classTeam == 1) serialClasses++;
+			itrMaxBusy += classTeam*maxBusy;
+			itrSumBusy += sumBusy;
+			//Hubs of the class: the adjacency of each one is split across the threads
+			for (long h=0; h<sched.numHubs; h++) {
+				long i = sched.hubs[h];
+				if (color[i] != ci)
+					continue;
+				double ownWeight = 0;
+				long localTarget = hubBestCommunity(&sched, i, vtxPtr, vtxInd, currCommAss, cInfo, vDegree[i],
+				                                    constantForSecondTerm, &ownWeight);
+				if(localTarget != currCommAss[i]) {
+					numMoved++;
+					markCommunityChanged(localTarget, commChanged, changedList, &numChanged);
+					markCommunityChanged(currCommAss[i], commChanged, changedList, &numChanged);
+					cUpdate[localTarget].degree += vDegree[i];
+					cUpdate[localTarget].size += 1;
+					cUpdate[currCommAss[i]].degree -= vDegree[i];
+					cUpdate[currCommAss[i]].size -=1;
+				}
+				currCommAss[i] = localTarget;
+			}
+			
+			// UPDATE: only the communities touched by this color class
+			applyChangedCommunities(cInfo, cUpdate, commChanged, changedList, numChanged);
+			numChanged = 0;
 		}//End of Color loop						
 		time2 = omp_get_wtime();
 		
@@ -233,16 +293,30 @@ double algoLouvainWithDistOneColoringNoMap(graph* G, long *C, int nThreads, int*
 		for (long i =0; i<NV;i++){
 			clusterWeightInternal[i] = 0;
 		}
-#pragma omp parallel for  //Parallelize on each vertex
-		for (long i=0; i<NV; i++) {
-			long adj1 = vtxPtr[i];
-			long adj2 = vtxPtr[i+1];
-			for(long j=adj1; j<adj2; j++) {
-				if(currCommAss[vtxInd[j].tail] == currCommAss[i]){
-					clusterWeightInternal[i] += vtxInd[j].weight;
+#pragma omp parallel for schedule(static,1)
+		for (int t=0; t<sched.nT; t++) {
+			for (long i=sched.bounds[t]; i<sched.bounds[t+1]; i++) {
+				if (isHub(&sched, vtxPtr, i))
+					continue;
+				long adj1 = vtxPtr[i];
+				long adj2 = vtxPtr[i+1];
+				for(long j=adj1; j<adj2; j++) {
+					if(currCommAss[vtxInd[j].tail] == currCommAss[i]){
+						clusterWeightInternal[i] += vtxInd[j].weight;
+					}
 				}
 			}
-		}		
+		}
+		for (long h=0; h<sched.numHubs; h++) {
+			long i = sched.hubs[h];
+			double internal = 0;
+#pragma omp parallel for reduction(+:internal)
+			for(long j=vtxPtr[i]; j<vtxPtr[i+1]; j++) {
+				if(currCommAss[vtxInd[j].tail] == currCommAss[i])
+					internal += vtxInd[j].weight;
+			}
+			clusterWeightInternal[i] = internal;
+		}
 		
 #pragma omp parallel for \
 reduction(+:e_xx) reduction(+:a2_x)
@@ -256,6 +330,9 @@ reduction(+:e_xx) reduction(+:a2_x)
 		
 		totItr = (time2-time1) + (time4-time3);
 		total += totItr;
+		recordIteration(stats, numItrs, currMod, numMoved, totItr);
+		recordLoadImbalance(stats, (itrSumBusy > 0) ? itrMaxBusy/itrSumBusy : 1);
+		recordIdleTime(stats, itrMaxBusy - itrSumBusy); //Over the color classes
 
 #ifdef PRINT_DETAILED_STATS_  
 		//printf("%d \t %g \t %g \t %lf \t %3.3lf \t %3.3lf  \t %3.3lf\n",numItrs, e_xx, a2_x, currMod, (time2-time1), (time4-time3), totItr );    
@@ -282,9 +359,14 @@ reduction(+:e_xx) reduction(+:a2_x)
 	//printf("Total time for %d iterations is: %lf\n",numItrs, total);  
 	//printf("========================================================================================================\n");
 #endif
+	LOG_DEBUG("Colors: %d, color-class sweeps run on one thread: %ld, thread idle time within classes: %lf sec\n",
+	       numColor, serialClasses, idleTime);
 	//Cleanup:
         free(vDegree); free(cInfo); free(cUpdate); free(clusterWeightInternal);
         free(colorPtr); free(colorIndex); free(colorAdded);
+        free(commChanged); free(changedList);
+        free(workPrefix); free(threadBusy);
+        freeVertexSchedule(&sched);
 	free(pastCommAss);
     free(clusterLocalMap);
 	
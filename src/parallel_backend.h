@@ -0,0 +1,105 @@
+#ifndef __PARALLEL_BACKEND__
+#define __PARALLEL_BACKEND__
+#include "defs.h"
+#include <algorithm>
+#ifdef FASTPG_USE_TBB
+#include <tbb/task_arena.h>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+#endif
+
+//Execution backends of the loops that dominate the clustering time: the sweeps
+//over the vertices of the Louvain kernels, the distance-1 coloring and the
+//contraction of the graph of the next phase. The other loops, short and
+//balanced, always run on OpenMP threads.
+//* BackendOpenMP: a team of threads, each with one range of the loop.
+//* BackendTBB: tasks on a TBB arena of the same number of threads. Idle threads
+//  steal pieces of the ranges of busy ones, and the worker threads are those of
+//  the other TBB code of the process, such as rcpp_parallel_jce().
+#define BackendOpenMP 0
+#define BackendTBB    1
+#define TBBPiecesPerThread 16 //Smallest pieces of a loop: 1/16 of a thread's share
+
+bool parallelBackendAvailable(int backend); //BackendTBB needs a build with FASTPG_USE_TBB
+
+//Sets the number of threads of the OpenMP parallel regions that follow, at
+//least 1, until the object is destroyed, when the previous number is restored.
+//Used instead of omp_set_num_threads(), whose setting would otherwise outlive
+//the call and apply to all the OpenMP code of the R session.
+class ompThreadsScope {
+public:
+  ompThreadsScope(int nThreads) : prevThreads(omp_get_max_threads()) {
+    omp_set_num_threads((nThreads < 1) ? 1 : nThreads);
+  }
+  ~ompThreadsScope() { omp_set_num_threads(prevThreads); }
+private:
+  int prevThreads;
+};
+
+//Selects the backend and the number of threads of the loops below until the
+//object is destroyed, when the previous ones are restored. An unavailable
+//backend falls back on OpenMP with a warning.
+class parallelBackendScope {
+public:
+  parallelBackendScope(int backend, int nThreads);
+  ~parallelBackendScope();
+private:
+  int prevBackend;
+  int prevThreads;
+};
+int parallelBackend(); //Of the innermost scope, BackendOpenMP outside of scopes
+int backendThreads();  //Of the innermost scope, omp_get_max_threads() outside of scopes
+#ifdef FASTPG_USE_TBB
+tbb::task_arena* backendArena(); //Arena of backendThreads() threads
+#endif
+
+//Calls body(begin, end, slot) on pieces [begin, end) that cover [first, last),
+//in parallel. slot, below backendThreads(), is the thread that runs the piece:
+//pieces of the same slot never run at the same time, so accumulators indexed by
+//slot need no synchronization. With OpenMP thread t gets the t-th of
+//backendThreads() equal ranges, as schedule(static) does.
+template <typename Body>
+void parallelForChunks(long first, long last, const Body &body) {
+  int nT = backendThreads();
+  if (last <= first)
+    return;
+#ifdef FASTPG_USE_TBB
+  if ((parallelBackend() == BackendTBB) && (nT > 1)) {
+    long grain = std::max(1L, (last - first) / ((long) nT * TBBPiecesPerThread));
+    backendArena()->execute([&]() {
+      tbb::parallel_for(tbb::blocked_range<long>(first, last, grain), [&](const tbb::blocked_range<long> &r) {
+        body(r.begin(), r.end(), tbb::this_task_arena::current_thread_index());
+      });
+    });
+    return;
+  }
+#endif
+#pragma omp parallel for schedule(static,1) num_threads(nT)
+  for (int t=0; t<nT; t++)
+    body(first + ((last - first) * t) / nT, first + ((last - first) * (t+1)) / nT, t);
+}//End of parallelForChunks()
+
+//As parallelForChunks(), but with OpenMP the pieces are numRanges ranges given
+//by range(t, &begin, &end), such as ranges of about the same work, each on its
+//own thread (slot t). With TBB the ranges are ignored: the pieces are split
+//from [first, last) on demand and balanced by stealing. A single range is run
+//by the calling thread with either backend.
+template <typename Range, typename Body>
+void parallelForRanges(int numRanges, long first, long last, const Range &range, const Body &body) {
+  if (numRanges <= 1) {
+    body(first, last, 0);
+    return;
+  }
+  if (parallelBackend() == BackendTBB) {
+    parallelForChunks(first, last, body);
+    return;
+  }
+#pragma omp parallel for schedule(static,1) num_threads(numRanges)
+  for (int t=0; t<numRanges; t++) {
+    long begin, end;
+    range(t, &begin, &end);
+    body(begin, end, t);
+  }
+}//End of parallelForRanges()
+
+#endif
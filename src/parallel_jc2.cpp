@@ -2,6 +2,7 @@
 using namespace Rcpp;
 
 #include <RcppParallel.h>
+#include "parallel_backend.h"
 #include <vector>
 #include <algorithm>
 #include <limits>
@@ -71,11 +72,15 @@ struct Jce : public Worker {
 
 //' Parallel Jaccard similarity index
 //'
+//' Runs on the TBB worker threads that `parallel_louvain()` uses with
+//' `backend=1`, or on OpenMP threads if the package was built without TBB.
+//'
 //' @param mat A numeric matrix of values
+//' @param numThreads (0) Number of threads to use, all available if 0.
 //' @return A numeric matrix of values
 //' @export
 // [[Rcpp::export]]
-NumericMatrix rcpp_parallel_jce(NumericMatrix mat) {
+NumericMatrix rcpp_parallel_jce(NumericMatrix mat, int numThreads = 0) {
   
   // allocate the matrix we will return
   NumericMatrix rmat(mat.nrow()*mat.ncol(),3);
@@ -83,8 +88,13 @@ NumericMatrix rcpp_parallel_jce(NumericMatrix mat) {
   // create the worker
   Jce jce(mat, rmat);
   
-  // call it with parallelFor
-  parallelFor(0, mat.nrow(), jce);
+  // call it on the threads of the clustering
+  int nT = (numThreads > 0) ? numThreads : omp_get_max_threads();
+  bool useTBB = parallelBackendAvailable(BackendTBB);
+  parallelBackendScope backendScope(useTBB ? BackendTBB : BackendOpenMP, nT);
+  parallelForChunks(0, mat.nrow(), [&](long begin, long end, int slot) {
+    jce(begin, end);
+  });
   
   return rmat;
 }
@@ -8,235 +8,177 @@
 #include "basic_comm.h"
 #include "color_comm.h"
 #include "sync_comm.h"
+#include "input_output.h"
+#include "graph_builder.h"
+#include "graph_handle.h"
+#include "parallel_backend.h"
 
 #include <set>
+#include <climits>
+#include <algorithm>
 using namespace Rcpp;
 
-void parse_SNAP(graph * G, NumericMatrix links, std::unordered_map<long, long> &clusterLocalMap) {
- // printf("Parsing a SNAP formatted file as a general graph...\n");
- // printf("WARNING: Assumes that the graph is directed -- an edge is stored only once.\n");
- // printf("       : Graph will be stored as undirected, each edge appears twice.\n");
-  int nthreads = 0;
-#pragma omp parallel
-{
-  nthreads = omp_get_num_threads();
-}
-//printf("parse_SNAP: Number of threads: %d\n ", nthreads);
-
-long   NV=0,  NE=0;
-//string oneLine, myDelimiter(" "), myDelimiter2("\t"), oneWord; //Delimiter is a blank space
-//char comment;
-
-double time1, time2;
-//ifstream fin;
-//fin.open(fileName);
-//if(!fin) {
-//  cerr<<"Within Function: loadSNAPFileFormat() \n";
-//  cerr<<"Could not open the file.. \n";
-//  exit(1);
-//}
+//Build G from a links matrix of columns from, to and optionally weight (one
+//otherwise): node id i becomes vertex i-1, so the number of vertices is the
+//largest node id. The columns are read in place by both passes of the graph
+//builder, without a temporary edge list or a map of the node ids.
+void links_to_graph(graph * G, NumericMatrix links) {
+  long NE = links.nrow();
+  if(links.ncol() < 2)
+    Rcpp::stop("links must have the columns from, to and optionally weight");
+  const double *from = links.begin();
+  const double *to = from + NE;
+  const double *weight = (links.ncol() > 2) ? from + 2*NE : NULL;
 
-/*do { //Parse the comment lines for problem size
-  getline(fin, oneLine);
-  cout<<"Read line: "<<oneLine<<endl;
-  comment = oneLine[0];
-  if (comment == '#') { //Check if this line has problem sizes
-    StringTokenizer* ST = new StringTokenizer(oneLine, myDelimiter);
-    if ( ST->HasMoreTokens() )
-      oneWord = ST->GetNextToken(); //Ignore #
-    if ( ST->HasMoreTokens() )
-      oneWord = ST->GetNextToken(); //Ignore #
-    if(oneWord == "Nodes:") {
-      NV  = atol( ST->GetNextToken().c_str() ); //Number of Vertices
-      oneWord = ST->GetNextToken(); //Ignore Edges:
-      NE  = atol( ST->GetNextToken().c_str() ); //Number of Edges
+  long maxId = 0, numBad = 0;
+#pragma omp parallel for reduction(max: maxId) reduction(+: numBad)
+  for(long i = 0; i < NE; i++) {
+    double ends[2] = {from[i], to[i]};
+    for(int j = 0; j < 2; j++) {
+      if((ends[j] >= 1) && (ends[j] <= INT_MAX) && (ends[j] == floor(ends[j])))
+        maxId = max(maxId, (long) ends[j]);
+      else
+        numBad++; //Also NA and NaN
     }
-    delete ST;
   }
-} while ( comment == '#');*/
-
-NE = links.nrow();
-
-//printf("|V|= %ld, |E|= %ld \n", NV, NE);
-//printf("Weights will read from the file.\n");
-//cout << oneLine <<endl;
-/*---------------------------------------------------------------------*/
-/* Read edge list: a U V W                                             */
-/*---------------------------------------------------------------------*/
-edge *tmpEdgeList = (edge *) malloc( NE * sizeof(edge)); //Every edge stored ONCE
-assert( tmpEdgeList != NULL);
-long Si, Ti;
-
-//std::unordered_map<long, long> clusterLocalMap; //Renumber vertices contiguously from zero
-//std::unordered_map<long, long>::iterator storedAlready;
-std::unordered_map<long,long>::iterator storedAlready;
-long numUniqueVertices = 0;
-
-//Parse the first edge already read from the file and stored in oneLine
-//long i=0;
-double wt = 1.0;
-//do {
-for(long i = 0;i<NE;i++){
-  //StringTokenizer* ST = new StringTokenizer(oneLine, myDelimiter2);
-  //if ( ST->HasMoreTokens() )
-  //  Si  = atol( ST->GetNextToken().c_str() );
-  //if ( ST->HasMoreTokens() )
-  //  Ti  = atol( ST->GetNextToken().c_str() );
-  //if ( ST->HasMoreTokens() )
-  //  wt  = atof( ST->GetNextToken().c_str() );
-  //delete ST;
-  Si = links(i,0);
-  Ti = links(i,1);
-  wt = links(i,2);
-  
-  storedAlready = clusterLocalMap.find(Si); //Check if it already exists
-  if( storedAlready != clusterLocalMap.end() ) {	//Already exists
-    Si = storedAlready->second; //Renumber the cluster id
-  } else {
-    clusterLocalMap[Si] = numUniqueVertices; //Does not exist, add to the map
-    Si = numUniqueVertices; //Renumber the vertex id
-    numUniqueVertices++; //Increment the number
+  if(numBad > 0)
+    Rcpp::stop("Node ids in links must be integers from 1 to the number of nodes");
+
+  long numBlocks = (NE + BuildBlockEdges - 1) / BuildBlockEdges;
+  buildGraphFromEdgeBlocks(G, maxId, NE, numBlocks, [=](long k, std::vector<edge> &block) {
+      long first = k * BuildBlockEdges;
+      long last = min(first + BuildBlockEdges, NE);
+      block.resize(last - first);
+      for(long i = first; i < last; i++) {
+        block[i-first].head   = (long) from[i] - 1;
+        block[i-first].tail   = (long) to[i] - 1;
+        block[i-first].weight = (weight != NULL) ? weight[i] : 1.0;
+      }
+    });
+}//End of links_to_graph()
+
+//The graph the kernels cluster, prepared from an input graph. Vertex following
+//leaves a smaller graph G, with the vertex of it that each input vertex follows
+//in Cfollow (-1 for isolated vertices). A reordering then renumbers vertex v of
+//that graph old2New[v]. Fields are NULL for the steps that leave the graph as it
+//is: with all of them NULL, the input graph is clustered.
+typedef struct {
+  graph *G;
+  long  *Cfollow;
+  long  *old2New;
+} preparedGraph;
+
+void prepare_graph(graph *G, bool followVertices, int reorder, preparedGraph *prepared) {
+  prepared->G = NULL;
+  prepared->Cfollow = NULL;
+  prepared->old2New = NULL;
+  if(followVertices) {
+    long *C = (long *) malloc (G->numVertices * sizeof(long)); assert(C != 0);
+    long numVtxToFix = vertexFollowing(G,C); //Find vertices that follow other vertices
+    if( numVtxToFix > 0) {  //Need to fix things: build a new graph
+      graph *Gnew = (graph *) malloc (sizeof(graph)); assert(Gnew != 0);
+      long numClusters = renumberClustersContiguously(C, G->numVertices);
+      buildNewGraphVF(G, Gnew, C, numClusters);
+      prepared->G = Gnew;
+      prepared->Cfollow = C;
+    } else {
+      free(C); //Free up memory
+    }
   }
-  
-  storedAlready = clusterLocalMap.find(Ti); //Check if it already exists
-  if( storedAlready != clusterLocalMap.end() ) {	//Already exists
-    Ti = storedAlready->second; //Renumber the cluster id
-  } else {
-    clusterLocalMap[Ti] = numUniqueVertices; //Does not exist, add to the map
-    Ti = numUniqueVertices; //Renumber the vertex id
-    numUniqueVertices++; //Increment the number
+  if((reorder >= ReorderRCM) && (reorder <= ReorderCommunity)) {
+    graph *Gin = (prepared->G != NULL) ? prepared->G : G;
+    long *old2New = (long *) malloc (Gin->numVertices * sizeof(long)); assert(old2New != 0);
+    reorderVertices(Gin, old2New, reorder);
+    graph *Gnew = (graph *) malloc (sizeof(graph)); assert(Gnew != 0);
+    permuteGraph(Gin, Gnew, old2New);
+    freeGraph(prepared->G); //The graph of vertex following, if any
+    prepared->G = Gnew;
+    prepared->old2New = old2New;
   }
-  tmpEdgeList[i].head   = Si;  //The S index
-  tmpEdgeList[i].tail   = Ti;  //The T index: One-based indexing
-  tmpEdgeList[i].weight = wt;     //default weight of one
-  //cout<<" Adding edge ("<<Si<<", "<<Ti<<")\n";
-}
-//  i++;
-  //Read-in the next line
-//  getline(fin, oneLine);
-//  if ((i % 99999) == 1) {
-//    cout <<"Reading Line: "<<i<<endl;
-//  }
-//} while ( !fin.eof() );//End of while
-
-//fin.close(); //Close the file
-time2 = omp_get_wtime();
-//printf("Done reading from file: NE= %ld. Time= %lf\n", NE, time2-time1);
-//printf("Number of unique vertices: %ld \n", numUniqueVertices);
-
-NV = numUniqueVertices;
-///////////
-time1 = omp_get_wtime();
-long *edgeListPtr = (long *)  malloc((NV+1) * sizeof(long));
-assert(edgeListPtr != NULL);
-edge *edgeList = (edge *) malloc( 2*NE * sizeof(edge)); //Every edge stored twice
-assert( edgeList != NULL);
-time2 = omp_get_wtime();
-//printf("Time for allocating memory for storing graph = %lf\n", time2 - time1);
-#pragma omp parallel for
-for (long i=0; i <= NV; i++)
-  edgeListPtr[i] = 0; //For first touch purposes
+}//End of prepare_graph()
 
-//////Build the EdgeListPtr Array: Cumulative addition
-time1 = omp_get_wtime();
-#pragma omp parallel for
-for(long i=0; i<NE; i++) {
-  __sync_fetch_and_add(&edgeListPtr[tmpEdgeList[i].head+1], 1); //Leave 0th position intact
-  __sync_fetch_and_add(&edgeListPtr[tmpEdgeList[i].tail+1], 1);
-}
-for (long i=0; i<NV; i++) {
-  edgeListPtr[i+1] += edgeListPtr[i]; //Prefix Sum:
-}
-//The last element of Cumulative will hold the total number of characters
-time2 = omp_get_wtime();
-//printf("Done cumulative addition for edgeListPtrs:  %9.6lf sec.\n", time2 - time1);
-//printf("Sanity Check: 2|E| = %ld, edgeListPtr[NV]= %ld\n", NE*2, edgeListPtr[NV]);
-//printf("*********** (%ld)\n", NV);
-
-//printf("About to build edgeList...\n");
-time1 = omp_get_wtime();
-//Keep track of how many edges have been added for a vertex:
-long  *added  = (long *)  malloc( NV  * sizeof(long)); assert( added != NULL);
-#pragma omp parallel for
-for (long i = 0; i < NV; i++)
-  added[i] = 0;
-//printf("...\n");
-//Build the edgeList from edgeListTmp:
-#pragma omp parallel for
-for(long i=0; i<NE; i++) {
-  long head      = tmpEdgeList[i].head;
-  long tail      = tmpEdgeList[i].tail;
-  double weight  = tmpEdgeList[i].weight;
-  
-  long Where = edgeListPtr[head] + __sync_fetch_and_add(&added[head], 1);
-  edgeList[Where].head = head;
-  edgeList[Where].tail = tail;
-  edgeList[Where].weight = weight;
-  //Now add the counter-edge:
-  Where = edgeListPtr[tail] + __sync_fetch_and_add(&added[tail], 1);
-  edgeList[Where].head = tail;
-  edgeList[Where].tail = head;
-  edgeList[Where].weight = weight;    
-}
-time2 = omp_get_wtime();
-//printf("Time for building edgeList = %lf\n", time2 - time1);
-
-///////Store the vertex ids in a file////////
-/*char filename2[256];
-sprintf(filename2,"%s_vertexMap.txt", fileName);
-//printf("Writing vertex map (new id -- old id) in file: %s\n", filename2);
-FILE *fout;
-fout = fopen(filename2, "w");
-if (!fout) {
- // printf("Could not open the file \n");
-  exit(1);
-}*/
-//Write the edges (lower triangle only):
-//storedAlready = clusterLocalMap.begin();
-//FILE *fout;
-//fout = fopen("clustInfo.txt", "w");
-//while (storedAlready != clusterLocalMap.end()) {
-//  fprintf(fout, "%ld %ld\n", storedAlready->first, storedAlready->second);
-//  storedAlready++;
-//}
-//fclose(fout);
-//printf("Vertex map has been stored in file: %s\n",filename2);
+//Sort every adjacency list by neighbor id, as the full-sync kernels do in place
+void sort_adjacency_lists(graph *G) {
+#pragma omp parallel for schedule(guided)
+  for(long i = 0; i < G->numVertices; i++) {
+    std::stable_sort(G->edgeList + G->edgeListPtrs[i], G->edgeList + G->edgeListPtrs[i+1],
+                     [](const edge &a, const edge &b) { return a.tail < b.tail; });
+  }
+}//End of sort_adjacency_lists()
+
+//One run of a strong-scaling benchmark. Times are in seconds, the stage times
+//summed over the phases.
+typedef struct {
+  int    threads;
+  int    repetition;
+  long   numPhases;
+  double timeColoring;
+  double timeClustering;
+  double timeBuilding;
+  double timeTotal;      //Of the whole multi-phase clustering
+  double modularity;     //Of the communities of the run
+} scalingRun;
 
-G->sVertices    = NV;
-G->numVertices  = NV;
-G->numEdges     = NE;
-G->edgeListPtrs = edgeListPtr;
-G->edgeList     = edgeList;
+//Strong-scaling mode of find_communities(): the clustering is run repeats times
+//with each number of threads, and every run is appended to runs
+typedef struct {
+  std::vector<int>        threads;
+  int                     repeats;
+  std::vector<scalingRun> runs;
+} scalingPlan;
 
-//Clean up
-free(tmpEdgeList);
-free(added);
-}//End of parse_SNAP()
+void free_prepared_graph(preparedGraph *prepared) {
+  freeGraph(prepared->G);
+  free(prepared->Cfollow);
+  free(prepared->old2New);
+}//End of free_prepared_graph()
 
+//communities: the community of each vertex, written at index vertexIds[i]-1 for
+//vertex i, or at index i if vertexIds is NULL; -1 for vertices without edges.
+//reorder: ReorderNone, or the vertex order (ReorderRCM, ReorderDegree or
+//ReorderCommunity) in which the graph is renumbered before clustering.
+//numThreads: the number of threads of the clustering, 0 for all the available
+//ones. It applies to this call only: the OpenMP setting of the caller is restored
+//on return.
+//scaling: if not NULL, the clustering is run as planned by it instead of once
+//with numThreads (strong scaling); the communities and the statistics are those
+//of the last run.
+//sampling: SampleNone, or the sampling of the vertices of the Approx kernel
+//(SampleUniform, SampleDegree or SampleGain), which then starts from
+//samplePercentage % of them. Only applies without coloring and syncType.
+//backend: BackendOpenMP or BackendTBB, the execution backend of the kernel
+//sweeps, the coloring and the contraction.
+//prepared: the result of prepare_graph(G) from an earlier call, which is used
+//and left to the caller; if NULL, the graph is prepared here
 double find_communities(graph * G, 
-                        long* C_orig, 
+                        int* communities, 
+                        const long* vertexIds, 
                         int minGraphSz ,
                         double C_thresh ,
                         double threshold ,
                         int numColors ,
-                        bool strongScaling ,
+                        int numThreads ,
+                        scalingPlan *scaling ,
                         int coloring ,
                         int syncType ,
-                        int basicOpt ){
+                        int basicOpt ,
+                        int sampling ,
+                        int samplePercentage ,
+                        bool incrementalColoring ,
+                        clusteringStats *stats ,
+                        int backend ,
+                        int reorder = ReorderNone,
+                        preparedGraph *prepared = NULL){
   
+  if((sampling < SampleNone) || (sampling > SampleGain))
+    Rcpp::stop("sampling must be 0, 1, 2 or 3");
+  if((sampling != SampleNone) && ((samplePercentage < 1) || (samplePercentage > 100)))
+    Rcpp::stop("samplePercentage must be between 1 and 100");
   long minGraphSize = (long) minGraphSz;
-  int nT = 1; //Default is one thread
-#pragma omp parallel
-{
-  nT = omp_get_num_threads();
-}
-if (nT < 1) {
- // printf("The number of threads should be greater than one.\n");
-  return 0;
-}
+  int nT = (numThreads > 0) ? numThreads : omp_get_max_threads();
+ompThreadsScope threadsScope(nT); //Restored on return
+parallelBackendScope backendScope(backend, nT); //Also for the preparation of the graph
 
-// File Loading
-double time1, time2;
 //graph* G = (graph *) malloc (sizeof(graph));
 double final_modularity = -1; 
 
@@ -261,29 +203,22 @@ int replaceMap = 1;
 
 bool VF = true;
 
+//G belongs to the caller and is not modified. With vertex following or a
+//reordering, the drivers cluster another graph and the result is mapped back to G.
+long NVin = G->numVertices;
+preparedGraph myPrepared = {NULL, NULL, NULL};
+
 /* Vertex Following option */
-//if( opts.VF ) {
-if (VF){
- // printf("Vertex following is enabled.\n");
-  time1 = omp_get_wtime();
-  long numVtxToFix = 0; //Default zero
-  long *C = (long *) malloc (G->numVertices * sizeof(long)); assert(C != 0);
-  numVtxToFix = vertexFollowing(G,C); //Find vertices that follow other vertices
-  if( numVtxToFix > 0) {  //Need to fix things: build a new graph
-   // printf("Graph will be modified -- %ld vertices need to be fixed.\n", numVtxToFix);
-    graph *Gnew = (graph *) malloc (sizeof(graph));
-    long numClusters = renumberClustersContiguously(C, G->numVertices);
-    buildNewGraphVF(G, Gnew, C, numClusters);
-    //Get rid of the old graph and store the new graph
-    free(G->edgeListPtrs);
-    free(G->edgeList);
-    free(G);
-    G = Gnew;
-  }
-  free(C); //Free up memory
- // printf("Graph after modifications:\n");
- // displayGraphCharacteristics(G);
-}//End of if( VF == 1 )
+if (prepared == NULL) {
+  prepare_graph(G, VF, reorder, &myPrepared);
+  prepared = &myPrepared;
+}
+long *Cfollow = prepared->Cfollow; //Vertex of the reduced graph that each input vertex follows
+long *old2New = prepared->old2New; //Number of each vertex of the reduced graph in the reordered one
+if (prepared->G != NULL)
+  G = prepared->G; //Cluster the reduced or reordered graph
+//The kernels number the communities of the clustered graph in longs
+long *C_orig = (long *) malloc (G->numVertices * sizeof(long)); assert(C_orig != 0);
 
 
 // Datastructures to store clustering information
@@ -294,47 +229,55 @@ long NV = G->numVertices;
 
 std::set<long> clustkeys;
 
-graph* G_orig = (graph *) malloc (sizeof(graph)); //The original version of the graph
-duplicateGivenGraph(G, G_orig);
-
 //Call the clustering algorithm:
-if(strongScaling){
-  //Retain the original copy of the graph:
-  graph* G_original = (graph *) malloc (sizeof(graph)); //The original version of the graph
-  time1 = omp_get_wtime();
-  duplicateGivenGraph(G, G_original);
-  time2 = omp_get_wtime();
- // printf("Time to duplicate : %lf\n", time2-time1);
-  
-  //Run the algorithm in powers of two for the maximum number of threads available
-  int curThread = 2; //Start with two threads
-  while (curThread <= nT) {
-   // printf("\n\n***************************************\n");
-   // printf("Starting run with %d threads.\n", curThread);
-   // printf("***************************************\n");
-    //Call the clustering algorithm:
+if(scaling != NULL){
+  //Every run clusters the same graph, without a copy. The full-sync kernels sort
+  //the adjacency lists they visit unless already sorted: sorted once here, the
+  //graph is not modified by the runs.
+  if(syncType != 0)
+    sort_adjacency_lists(G);
+  clusteringStats runStats;
+  for (size_t k=0; k<scaling->threads.size(); k++) {
+    int curThread = scaling->threads[k];
+    ompThreadsScope runThreads(curThread);
+    parallelBackendScope runBackend(parallelBackend(), curThread);
+    for (int rep=0; rep<scaling->repeats; rep++) {
 #pragma omp parallel for
-    for (long i=0; i<G->numVertices; i++) {
-      C_orig[i] = -1;
-    }
-    //if(opts.coloring != 0){
-    if(coloring != 0) {
-      runMultiPhaseColoring(G, C_orig, coloring, numColors, replaceMap, minGraphSize, threshold, C_thresh, curThread, threadsOpt);
-    }else if(syncType != 0){
-      runMultiPhaseSyncType(G, C_orig, syncType, minGraphSize, threshold, C_thresh, curThread, threadsOpt);
-    }else{
-      runMultiPhaseBasic(G, C_orig, basicOpt, minGraphSize, threshold, C_thresh, curThread,threadsOpt);
-    }
-    //Increment thread and revert back to original graph
-    if (curThread < nT) {
-      //Skip copying at the very end
-      //Old graph is already destroyed in the above function
-      G = (graph *) malloc (sizeof(graph)); //Allocate new space
-      duplicateGivenGraph(G_original, G); //Copy the original graph to G
-    }
-    curThread = curThread*2; //Increment by powers of two
-  }//End of while()
-} else { //No strong scaling -- run once with max threads
+      for (long i=0; i<NV; i++) {
+        C_orig[i] = -1;
+      }
+      runStats.clear();
+      double time1 = omp_get_wtime();
+      if(coloring != 0) {
+        final_modularity = runMultiPhaseColoring(G, C_orig, coloring, numColors, replaceMap, minGraphSize, threshold, C_thresh, curThread, threadsOpt, incrementalColoring, &runStats);
+      }else if(syncType != 0){
+        runMultiPhaseSyncType(G, C_orig, syncType, minGraphSize, threshold, C_thresh, curThread, threadsOpt, &runStats);
+      }else if(sampling != SampleNone){
+        final_modularity = runMultiPhaseBasicApprox(G, C_orig, basicOpt, minGraphSize, threshold, C_thresh, curThread, threadsOpt, samplePercentage, sampling, &runStats);
+      }else{
+        runMultiPhaseBasic(G, C_orig, basicOpt, minGraphSize, threshold, C_thresh, curThread, threadsOpt, &runStats);
+      }
+      scalingRun run;
+      run.timeTotal      = omp_get_wtime() - time1;
+      run.threads        = curThread;
+      run.repetition     = rep + 1;
+      run.numPhases      = (long) runStats.size();
+      run.timeColoring   = 0;
+      run.timeClustering = 0;
+      run.timeBuilding   = 0;
+      for (size_t p=0; p<runStats.size(); p++) {
+        run.timeColoring   += runStats[p].timeColoring;
+        run.timeClustering += runStats[p].timeClustering;
+        run.timeBuilding   += runStats[p].timeBuilding;
+      }
+      run.modularity = computeModularity(G, C_orig);
+      final_modularity = run.modularity; //Of the last run
+      scaling->runs.push_back(run);
+    }//End of for(rep)
+  }//End of for(k)
+  if(stats != NULL)
+    *stats = runStats; //Of the last run
+} else { //No strong scaling -- run once with nT threads
 
  
 #pragma omp parallel for
@@ -343,12 +286,16 @@ if(strongScaling){
   }
   //if(opts.coloring != 0){
   if(coloring != 0) {
-    final_modularity = runMultiPhaseColoring(G, C_orig, coloring, numColors, replaceMap, minGraphSize, threshold, C_thresh, nT, threadsOpt);
+    final_modularity = runMultiPhaseColoring(G, C_orig, coloring, numColors, replaceMap, minGraphSize, threshold, C_thresh, nT, threadsOpt, incrementalColoring, stats);
     //}else if(opts.syncType != 0){
   }else if(syncType != 0){
-    runMultiPhaseSyncType(G, C_orig, syncType, minGraphSize, threshold, C_thresh, nT,threadsOpt);
+    runMultiPhaseSyncType(G, C_orig, syncType, minGraphSize, threshold, C_thresh, nT,threadsOpt, stats);
+    final_modularity = computeModularity(G, C_orig); //The kernel does not return it
+  }else if(sampling != SampleNone){
+    final_modularity = runMultiPhaseBasicApprox(G, C_orig, basicOpt, minGraphSize, threshold, C_thresh, nT, threadsOpt, samplePercentage, sampling, stats);
   }else{
-    runMultiPhaseBasic(G, C_orig, basicOpt, minGraphSize, threshold, C_thresh, nT,threadsOpt);
+    runMultiPhaseBasic(G, C_orig, basicOpt, minGraphSize, threshold, C_thresh, nT,threadsOpt, stats);
+    final_modularity = computeModularity(G, C_orig); //The kernel does not return it
   }
 }
 
@@ -379,9 +326,87 @@ if(strongScaling){
 //return NumericVector(C_orig,C_orig+(sizeof(C_orig)/sizeof(*C_orig)));
 //return NumericVector(C_ints,C_ints+NV);
 //return C_orig;
+
+//Map the clusters of the reduced and reordered graph back to the input vertices,
+//in the order of the caller
+#pragma omp parallel for
+for (long i=0; i<NVin; i++) {
+  long v = (Cfollow == NULL) ? i : Cfollow[i];
+  long c = (v < 0) ? -1 : C_orig[(old2New == NULL) ? v : old2New[v]]; //Isolated vertices stay unassigned
+  communities[(vertexIds != NULL) ? vertexIds[i] - 1 : i] = (int) c;
+}
+free(C_orig);
+free_prepared_graph(&myPrepared);
+logFlush();
 return final_modularity;
 }//End of main()
 
+//Flatten the clustering statistics into a data.frame with one row per
+//iteration; the phase-level columns are repeated for each iteration of a phase
+DataFrame stats_to_df(const clusteringStats &stats) {
+  long nRows = 0;
+  for(size_t p = 0; p < stats.size(); p++)
+    nRows += stats[p].iterations.size();
+  IntegerVector phase(nRows), iteration(nRows), numColors(nRows);
+  NumericVector numVertices(nRows), numEdges(nRows), modularity(nRows), numMoved(nRows);
+  NumericVector timeIteration(nRows), timeColoring(nRows), timeClustering(nRows);
+  NumericVector timeBuilding(nRows), scratchBytes(nRows), loadImbalance(nRows), idleTime(nRows);
+  long row = 0;
+  for(size_t p = 0; p < stats.size(); p++) {
+    const phaseStats &ps = stats[p];
+    for(size_t i = 0; i < ps.iterations.size(); i++, row++) {
+      phase[row]          = (int) ps.phase;
+      iteration[row]      = ps.iterations[i].iteration;
+      numVertices[row]    = (double) ps.numVertices;
+      numEdges[row]       = (double) ps.numEdges;
+      numColors[row]      = ps.numColors;
+      modularity[row]     = ps.iterations[i].modularity;
+      numMoved[row]       = (double) ps.iterations[i].numMoved;
+      timeIteration[row]  = ps.iterations[i].time;
+      timeColoring[row]   = ps.timeColoring;
+      timeClustering[row] = ps.timeClustering;
+      timeBuilding[row]   = ps.timeBuilding;
+      scratchBytes[row]   = (double) ps.scratchBytes;
+      loadImbalance[row]  = (ps.iterations[i].loadImbalance > 0) ? ps.iterations[i].loadImbalance : NA_REAL;
+      idleTime[row]       = (ps.iterations[i].loadImbalance > 0) ? ps.iterations[i].idleTime : NA_REAL;
+    }
+  }
+  return DataFrame::create(Named("phase")          = phase,
+                           Named("iteration")      = iteration,
+                           Named("numVertices")    = numVertices,
+                           Named("numEdges")       = numEdges,
+                           Named("numColors")      = numColors,
+                           Named("modularity")     = modularity,
+                           Named("numMoved")       = numMoved,
+                           Named("timeIteration")  = timeIteration,
+                           Named("timeColoring")   = timeColoring,
+                           Named("timeClustering") = timeClustering,
+                           Named("timeBuilding")   = timeBuilding,
+                           Named("scratchBytes")   = scratchBytes,
+                           Named("loadImbalance")  = loadImbalance,
+                           Named("idleTime")       = idleTime);
+}//End of stats_to_df()
+
+
+//numThreads argument of the R functions: the number of threads, 0 for all the
+//available ones
+int clustering_threads(int numThreads) {
+  if(numThreads < 0)
+    Rcpp::stop("numThreads must be 0 or more");
+  return (numThreads > 0) ? numThreads : omp_get_max_threads();
+}//End of clustering_threads()
+
+//Result list of parallel_louvain() and parallel_louvain_file()
+Rcpp::List clustering_result(double modularity, IntegerVector communities, clusteringStats *stats) {
+  if(stats != NULL) {
+    return Rcpp::List::create(Rcpp::Named("modularity")=modularity,
+                              Rcpp::Named("communities")=communities,
+                              Rcpp::Named("stats")=stats_to_df(*stats));
+  }
+  return Rcpp::List::create(Rcpp::Named("modularity")=modularity,
+                            Rcpp::Named("communities")=communities);
+}
+
 
 //' Parallel Louvain clustering
 //'
@@ -406,8 +431,10 @@ return final_modularity;
 //' of the identified clusters, and in practice allows for the analysis of
 //' larger networks than a serial Louvain implementation.
 //'
-//' @param links A numeric matrix of network edges.
-//' @param coloring (1) An integer between 0 and 3 that controls the
+//' @param links A numeric matrix of network edges, one per row: the node ids
+//'   `from` and `to`, integers from 1 to the number of nodes, and optionally a
+//'   weight (1 if the matrix has two columns). Each edge is listed once.
+//' @param coloring (1) An integer between 0 and 4 that controls the
 //'   distance-1 graph coloring heuristic used to partition vertices for
 //'   parallel processing.
 //'   * 0 - No coloring.
@@ -416,6 +443,9 @@ return final_modularity;
 //'   * 2 - As 1, rebalanced so there are a similar number of vertices labeled
 //'   with each color.
 //'   * 3 - Incomplete coloring, limited to `numColors`, by default 16.
+//'   * 4 - As 1, but vertices are colored in largest-degree-first order
+//'   (Jones-Plassmann). Usually needs fewer colors, so fewer sequential
+//'   sub-steps are needed in each Louvain iteration.
 //' @param numColors (16) An integer between 1 and 1024. Limits graph
 //'   coloring. Only used if `coloring=3`, incomplete coloring, is set.
 //' @param C_thresh (1e-6) A numeric value > 0 and < 1. When coloring is
@@ -450,13 +480,86 @@ return final_modularity;
 //'   be slowed when there are large numbers of communities or when the
 //'   algorithm converges only slowly. Better for data with fewer communities
 //'   or with tight community clusters.
+//' @param incrementalColoring (FALSE) If TRUE, the graphs of later phases are
+//'   not colored from scratch. Each collapsed vertex inherits the color of
+//'   one of the vertices it replaces, and only the resulting conflicts are
+//'   recolored. Speeds up coloring on phases 2 and later, but the number of
+//'   colors is not reduced below what earlier phases used. Applies to
+//'   `coloring` 1, 2 and 4.
+//' @param stats (FALSE) If TRUE, timing and progress statistics of every
+//'   phase and iteration are collected and returned as a third list element.
+//' @param reorder (0) An integer between 0 and 3 that selects a vertex order
+//'   for the clustering. The graph is renumbered once so that neighboring
+//'   vertices get close numbers, which speeds up the Louvain iterations on
+//'   large graphs listed in an arbitrary order, such as kNN graphs of cells.
+//'   Communities are returned in the order of the input. Costs a copy of the
+//'   graph, and results can differ slightly as vertices are processed in
+//'   another order.
+//'   * 0 - (Default) No reordering.
+//'   * 1 - Reverse Cuthill-McKee: breadth-first order from a low-degree vertex.
+//'   * 2 - Decreasing degree.
+//'   * 3 - Community order: vertices grouped by a few rounds of label
+//'   propagation.
+//' @param backend (0) An integer, 0 or 1, that selects how the threads share
+//'   the Louvain iterations, the coloring and the building of the graph of
+//'   the next phase.
+//'   * 0 - (Default) OpenMP. Each thread gets a range of vertices of about the
+//'   same work.
+//'   * 1 - TBB. Idle threads steal work from busy ones, and the threads are
+//'   the TBB worker threads that `rcpp_parallel_jce()` also uses, so an R
+//'   session that runs both does not keep two sets of threads. The other,
+//'   shorter steps still run on OpenMP threads. Falls back on 0 with a
+//'   warning if the package was built without TBB.
+//' @param numThreads (0) The number of threads used to build and cluster the
+//'   graph, 0 for all the available ones. Applies to this call only: the
+//'   number of OpenMP threads of the R session is left unchanged.
+//' @param sampling (0) An integer between 0 and 3. Above 0, a faster
+//'   approximate clustering: each Louvain iteration only looks for a better
+//'   community for a sample of the nodes, `samplePercentage` % of them at
+//'   first. The percentage is doubled when the modularity gain of an
+//'   iteration falls below `threshold`, or below 30% of the gain of the first
+//'   iteration with the same percentage. The clustering ends as usual once an
+//'   iteration over all the nodes no longer improves the best modularity, or
+//'   after 200 iterations of a phase. Only applies if `coloring=0` and
+//'   `syncType=0`.
+//'   * 0 - (Default) No sampling.
+//'   * 1 - Uniform: every node is as likely to be sampled.
+//'   * 2 - Degree: nodes are sampled in proportion to their degree, so that
+//'   hubs, which weigh most on the modularity, are visited more often.
+//'   * 3 - Gain: only nodes that moved, or next to a node that moved, in the
+//'   previous iteration are sampled, uniformly among them; the others, unlikely
+//'   to gain from a move, are skipped. Once the percentage reaches 100, an
+//'   iteration over all the nodes checks the clustering, and the sampled
+//'   iterations resume while these checks improve it.
+//' @param samplePercentage (25) An integer between 1 and 100, the percentage
+//'   of nodes sampled by the first iterations when `sampling` is above 0.
 //' 
 //' @return A list with two elements:
 //' * `modularity` - A measure of the connectedness of a clustered network.
 //' When comparing different clusterings of the same network, the one with the
 //' higher modularity is "better".
-//' * `communities` - A vector where the i'th value is the cluster number that
-//' the i'th node in the links matrix has been assigned to.
+//' * `communities` - An integer vector where the i'th value is the cluster number
+//' that node i has been assigned to. Nodes without edges are not clustered and
+//' get -1.
+//'
+//' If `stats=TRUE`, a third element `stats` holds a data.frame with one row
+//' per Louvain iteration and the columns:
+//' * `phase`, `iteration` - The phase and the iteration within that phase.
+//' * `numVertices`, `numEdges` - The size of the graph clustered in the phase.
+//' * `numColors` - Colors used in the phase, 0 if it ran without coloring.
+//' * `modularity` - Modularity at the end of the iteration.
+//' * `numMoved` - Vertices that changed community in the iteration.
+//' * `timeIteration` - Seconds spent in the iteration.
+//' * `timeColoring`, `timeClustering`, `timeBuilding` - Seconds spent in the
+//' phase on coloring, on the Louvain iterations and on building the graph of
+//' the next phase.
+//' * `scratchBytes` - Scratch memory allocated by the clustering kernel of the
+//' phase, in bytes.
+//' * `loadImbalance` - Time of the busiest thread over the mean in the sweep over
+//' the vertices of the iteration, 1 when perfectly balanced.
+//' * `idleTime` - Seconds the threads spent waiting for the busiest one in the
+//' sweep of the iteration. With `coloring` above 0 the threads wait at the end
+//' of every color class, and this is the sum over the color classes.
 //' @export
 // [[Rcpp::export]]
 Rcpp::List parallel_louvain(NumericMatrix links, 
@@ -466,36 +569,492 @@ Rcpp::List parallel_louvain(NumericMatrix links,
                             int numColors = 16,
                             int coloring = 1,
                             int syncType = 0,
-                            int basicOpt = 1){
+                            int basicOpt = 1,
+                            bool incrementalColoring = false,
+                            bool stats = false,
+                            int reorder = 0,
+                            int backend = 0,
+                            int numThreads = 0,
+                            int sampling = 0,
+                            int samplePercentage = 25){
 
   double modularity = -1;
-  bool strongScaling = false;
+  ompThreadsScope threadsScope(clustering_threads(numThreads)); //Restored on return
 
-  graph* G = (graph *) malloc (sizeof(graph));
-  
-  std::unordered_map<long,long> clusterLocalMap;
-  
-  parse_SNAP(G,links,clusterLocalMap);
+  graphHandle G; //Freed on every exit, also by Rcpp::stop()
+  links_to_graph(G.get(), links);
 
-  NumericVector res(G->numVertices);
-  
-  long *C_orig = (long *) malloc (G->numVertices * sizeof(long)); assert(C_orig != 0);
+  IntegerVector res(Rcpp::no_init(G->numVertices)); //Every element is written
+  clusteringStats phaseStatsList;
   
-  modularity = find_communities(G,
-                                C_orig,
+  modularity = find_communities(G.get(),
+                                res.begin(),
+                                NULL,
                                 minGraphSize,
                                 C_thresh,
                                 threshold,
                                 numColors,
-                                strongScaling,
+                                numThreads,
+                                NULL,
                                 coloring,
                                 syncType,
-                                basicOpt);
+                                basicOpt,
+                                sampling,
+                                samplePercentage,
+                                incrementalColoring,
+                                stats ? &phaseStatsList : NULL,
+                                backend,
+                                reorder);
   
-  for(auto it = clusterLocalMap.begin();it != clusterLocalMap.end(); ++it){
-    res[it->first-1]=(int)C_orig[it->second];
+  return clustering_result(modularity, res, stats ? &phaseStatsList : NULL);
+}
+
+//Data frame of the runs of a strong-scaling benchmark, with the speedup and the
+//efficiency of every run over the median time with the fewest threads
+DataFrame scaling_to_df(const std::vector<scalingRun> &runs) {
+  long n = (long) runs.size();
+  int baseThreads = INT_MAX;
+  for(long i = 0; i < n; i++)
+    baseThreads = min(baseThreads, runs[i].threads);
+  std::vector<double> baseTimes;
+  for(long i = 0; i < n; i++) {
+    if(runs[i].threads == baseThreads)
+      baseTimes.push_back(runs[i].timeTotal);
   }
-  
-  return Rcpp::List::create(Rcpp::Named("modularity")=modularity,
-                            Rcpp::Named("communities")=res);
+  std::sort(baseTimes.begin(), baseTimes.end());
+  long m = (long) baseTimes.size();
+  double baseTime = (m % 2 == 1) ? baseTimes[m/2] : (baseTimes[m/2 - 1] + baseTimes[m/2]) / 2;
+
+  IntegerVector threads(n), repetition(n), numPhases(n);
+  NumericVector timeColoring(n), timeClustering(n), timeBuilding(n), timeTotal(n);
+  NumericVector modularity(n), speedup(n), efficiency(n);
+  for(long i = 0; i < n; i++) {
+    const scalingRun &r = runs[i];
+    threads[i]        = r.threads;
+    repetition[i]     = r.repetition;
+    numPhases[i]      = (int) r.numPhases;
+    timeColoring[i]   = r.timeColoring;
+    timeClustering[i] = r.timeClustering;
+    timeBuilding[i]   = r.timeBuilding;
+    timeTotal[i]      = r.timeTotal;
+    modularity[i]     = r.modularity;
+    speedup[i]        = baseTime / r.timeTotal;
+    efficiency[i]     = speedup[i] * baseThreads / r.threads;
+  }
+  return DataFrame::create(Named("threads")        = threads,
+                           Named("repetition")     = repetition,
+                           Named("numPhases")      = numPhases,
+                           Named("timeColoring")   = timeColoring,
+                           Named("timeClustering") = timeClustering,
+                           Named("timeBuilding")   = timeBuilding,
+                           Named("timeTotal")      = timeTotal,
+                           Named("modularity")     = modularity,
+                           Named("speedup")        = speedup,
+                           Named("efficiency")     = efficiency);
+}//End of scaling_to_df()
+
+//' Strong-scaling benchmark of parallel_louvain()
+//'
+//' Clusters the graph of `links` several times with each number of threads
+//' and times every run, to choose `numThreads` for a machine and a data size,
+//' or to see which steps of the clustering stop scaling. The graph is built
+//' once, and every run clusters the same graph, so the runs differ only by
+//' their number of threads.
+//'
+//' @param links A numeric matrix of network edges, as for `parallel_louvain()`.
+//' @param threads (NULL) An integer vector of the numbers of threads to run
+//'   with, in this order. By default 1, the powers of two below the number of
+//'   available threads, and that number.
+//' @param repeats (3) The number of runs with each number of threads.
+//' @inheritParams parallel_louvain
+//' @return A data.frame with one row per run and the columns:
+//' * `threads`, `repetition` - The number of threads and the run with it,
+//' from 1 to `repeats`.
+//' * `numPhases` - Phases of the clustering.
+//' * `timeColoring`, `timeClustering`, `timeBuilding` - Seconds spent on
+//' coloring, on the Louvain iterations and on building the graphs of the next
+//' phases, summed over the phases.
+//' * `timeTotal` - Seconds of the whole clustering, without building the graph
+//' from `links` or reordering it.
+//' * `modularity` - Modularity of the communities found by the run.
+//' * `speedup` - The median `timeTotal` of the runs with the fewest threads
+//' over the `timeTotal` of the run.
+//' * `efficiency` - `speedup` divided by the ratio of `threads` to the fewest
+//' threads, 1 for perfect scaling.
+//' @export
+// [[Rcpp::export]]
+DataFrame parallel_louvain_scaling(NumericMatrix links,
+                                   Rcpp::Nullable<IntegerVector> threads = R_NilValue,
+                                   int repeats = 3,
+                                   int minGraphSize = 1000,
+                                   double C_thresh = 0.000001,
+                                   double threshold = 0.000000001,
+                                   int numColors = 16,
+                                   int coloring = 1,
+                                   int syncType = 0,
+                                   int basicOpt = 1,
+                                   bool incrementalColoring = false,
+                                   int reorder = 0,
+                                   int backend = 0,
+                                   int sampling = 0,
+                                   int samplePercentage = 25){
+  scalingPlan plan;
+  int maxThreads = omp_get_max_threads();
+  if(threads.isNotNull()) {
+    IntegerVector t(threads);
+    for(int i = 0; i < t.size(); i++) {
+      if((t[i] == NA_INTEGER) || (t[i] < 1))
+        Rcpp::stop("threads must be numbers of threads of 1 or more");
+      plan.threads.push_back(t[i]);
+    }
+  } else {
+    for(int t = 1; t < maxThreads; t *= 2)
+      plan.threads.push_back(t);
+    plan.threads.push_back(maxThreads);
+  }
+  if(plan.threads.empty())
+    Rcpp::stop("threads must not be empty");
+  if(repeats < 1)
+    Rcpp::stop("repeats must be 1 or more");
+  plan.repeats = repeats;
+
+  int buildThreads = *std::max_element(plan.threads.begin(), plan.threads.end());
+  ompThreadsScope threadsScope(buildThreads); //Restored on return
+  graphHandle G;
+  links_to_graph(G.get(), links);
+
+  IntegerVector res(Rcpp::no_init(G->numVertices));
+  find_communities(G.get(),
+                   res.begin(),
+                   NULL,
+                   minGraphSize,
+                   C_thresh,
+                   threshold,
+                   numColors,
+                   buildThreads,
+                   &plan,
+                   coloring,
+                   syncType,
+                   basicOpt,
+                   sampling,
+                   samplePercentage,
+                   incrementalColoring,
+                   NULL,
+                   backend,
+                   reorder);
+
+  return scaling_to_df(plan.runs);
+}
+
+//' Write a graph file for parallel_louvain_file()
+//'
+//' Builds the graph of `links` as `parallel_louvain()` does and writes it in
+//' the FastPG CSR format, a versioned binary format that
+//' `parallel_louvain_file()` memory maps instead of parsing. Node i of `links`
+//' is vertex i of the file, so communities come back in the same order as from
+//' `parallel_louvain()`.
+//'
+//' @param links A numeric matrix of network edges, as for `parallel_louvain()`.
+//' @param fileName Path of the file to write.
+//' @param indexBytes (0) Layout of the edges.
+//'   * 0 - (Default) Edge records in the in-memory layout of the clustering
+//'   code. Used in place from the memory map, so clustering starts without
+//'   copying the graph. 24 bytes per edge and direction.
+//'   * 4, 8 - 32 or 64-bit neighbor ids, plus weights only if some weight is
+//'   not 1. Smaller files, but the edges are copied when the file is read.
+//' @return `fileName`.
+//' @export
+// [[Rcpp::export]]
+SEXP write_graph_file(NumericMatrix links, std::string fileName, int indexBytes = 0) {
+  graphHandle G;
+  links_to_graph(G.get(), links);
+  bool ok = writeGraphCSR(G.get(), fileName.c_str(), indexBytes, NULL);
+  logFlush();
+  if(!ok)
+    Rcpp::stop("Could not write the graph file " + fileName);
+  return Rcpp::wrap(fileName);
+}
+
+//' Parallel Louvain clustering of a graph file
+//'
+//' Runs `parallel_louvain()` on a graph file. Files written by
+//' `write_graph_file()` are opened read-only and memory mapped. In the default
+//' edge layout they are used as the graph without parsing or copying, so
+//' repeated clusterings of the same graph skip the graph construction. The page
+//' cache also shares the graph between R sessions that cluster the same file.
+//' Graphs produced outside R can be read from text files, which are memory
+//' mapped and parsed by all threads in parallel.
+//'
+//' @param fileName Path of the graph file.
+//' @param format ("csr") The format of the file.
+//'   * "csr" - (Default) A file written by `write_graph_file()`.
+//'   * "snap" - An edge list with one edge "from to" or "from to weight" per line.
+//'   Fields are separated by blanks, tabs or commas, lines starting with `#`
+//'   or `%` are comments and a missing weight is 1.
+//'   * "mtx" - A Matrix Market coordinate matrix (real, integer or pattern,
+//'   general or symmetric). Diagonal entries are ignored; a general matrix
+//'   `A` is read as the graph of `(A + t(A))/2`.
+//'   * "metis" - A METIS graph file, with every edge listed by both ends.
+//'   * "pajek" - A Pajek network with `*Vertices` and `*Edges` (or `*Arcs`,
+//'   read as undirected) sections, each edge listed once.
+//' @inheritParams parallel_louvain
+//' @return As for `parallel_louvain()`. If the file stores node ids, which
+//' must be 1 to the number of nodes, each once, `communities` is ordered by
+//' node id as in `parallel_louvain()`; otherwise
+//' by vertex number in the file. The vertices of an edge list are numbered in
+//' increasing order of node id, so with node ids 1 to n `communities` is
+//' ordered as from `parallel_louvain()`.
+//' @export
+// [[Rcpp::export]]
+Rcpp::List parallel_louvain_file(std::string fileName,
+                                 std::string format = "csr",
+                                 int minGraphSize = 1000,
+                                 double C_thresh = 0.000001,
+                                 double threshold = 0.000000001,
+                                 int numColors = 16,
+                                 int coloring = 1,
+                                 int syncType = 0,
+                                 int basicOpt = 1,
+                                 bool incrementalColoring = false,
+                                 bool stats = false,
+                                 int reorder = 0,
+                                 int backend = 0,
+                                 int numThreads = 0,
+                                 int sampling = 0,
+                                 int samplePercentage = 25){
+  ompThreadsScope threadsScope(clustering_threads(numThreads)); //Also for the parsers
+  graphHandle G; //Freed, or the file closed, on every exit
+  char *name = const_cast<char *>(fileName.c_str());
+  bool loaded;
+  if(format == "csr")
+    loaded = openGraphCSR(G.get(), name, G.file());
+  else if(format == "snap")
+    loaded = parse_SNAP(G.get(), name);
+  else if(format == "mtx")
+    loaded = parse_MatrixMarket(G.get(), name);
+  else if(format == "metis")
+    loaded = loadMetisFileFormat(G.get(), name);
+  else if(format == "pajek")
+    loaded = parse_PajekFormat(G.get(), name);
+  else
+    Rcpp::stop("Unknown graph file format " + format);
+  if(!loaded) {
+    logFlush();
+    Rcpp::stop("Could not read the graph file " + fileName);
+  }
+  long NV = G->numVertices;
+  if(NV > INT_MAX)
+    Rcpp::stop("Graphs of more than INT_MAX nodes cannot be clustered from R");
+  const long *vertexIds = G.file()->vertexIds;
+  if(vertexIds != NULL) {
+    //Every node id once: the communities of a repeated id would be overwritten
+    //and those of the missing ids never written
+    std::vector<bool> seen(NV, false);
+    for(long i = 0; i < NV; i++) {
+      if((vertexIds[i] < 1) || (vertexIds[i] > NV)) {
+        Rcpp::stop("Node ids in " + fileName + " are not 1 to the number of nodes");
+      }
+      if(seen[vertexIds[i] - 1]) {
+        Rcpp::stop("Node id " + std::to_string(vertexIds[i]) + " appears twice in " + fileName);
+      }
+      seen[vertexIds[i] - 1] = true;
+    }
+  }
+
+  IntegerVector res(Rcpp::no_init(NV));
+  clusteringStats phaseStatsList;
+  double modularity = find_communities(G.get(),
+                                       res.begin(),
+                                       vertexIds,
+                                       minGraphSize,
+                                       C_thresh,
+                                       threshold,
+                                       numColors,
+                                       numThreads,
+                                       NULL,
+                                       coloring,
+                                       syncType,
+                                       basicOpt,
+                                       sampling,
+                                       samplePercentage,
+                                       incrementalColoring,
+                                       stats ? &phaseStatsList : NULL,
+                                       backend,
+                                       reorder);
+
+  return clustering_result(modularity, res, stats ? &phaseStatsList : NULL);
+}
+
+//A graph kept between calls from R, with the result of vertex following and
+//reordering: the graph the kernels cluster is built once. Deleted by the
+//finalizer of the external pointer.
+//The full-sync kernels sort the adjacency lists they visit in place: they get a
+//sorted copy of the clustered graph, made on first use, so that the other
+//kernels cluster the graph as parallel_louvain() builds it.
+class fpgGraph {
+public:
+  graphHandle input;
+  preparedGraph prepared;
+  graph *sorted; //NULL until a full-sync clustering
+  fpgGraph() : sorted(NULL) { prepared.G = NULL; prepared.Cfollow = NULL; prepared.old2New = NULL; }
+  ~fpgGraph() { free_prepared_graph(&prepared); freeGraph(sorted); }
+  graph* clustered() { return (prepared.G != NULL) ? prepared.G : input.get(); }
+  //prepared, with the sorted copy as the clustered graph
+  preparedGraph preparedSorted() {
+    if (sorted == NULL) {
+      sorted = (graph *) malloc (sizeof(graph)); assert(sorted != 0);
+      duplicateGivenGraph(clustered(), sorted);
+      sort_adjacency_lists(sorted);
+    }
+    preparedGraph p = prepared;
+    p.G = sorted;
+    return p;
+  }
+};
+
+//' Build a graph for repeated clustering
+//'
+//' Builds the graph of `links` once, with the vertex following step of the
+//' clustering, and keeps it in memory for `fpg_cluster()`. Parameter sweeps
+//' then skip the graph construction on every call. The memory is released when
+//' the object is garbage collected. The object cannot be saved and restored
+//' across R sessions.
+//'
+//' The `syncType` kernels sort the adjacency lists of the graph in place: the
+//' first clustering with `coloring=0` and `syncType` above 0 makes a sorted
+//' copy of the graph, kept with it for the following ones. The other
+//' clusterings are not affected, and give the communities of
+//' `parallel_louvain()` with the same parameters.
+//'
+//' @param links A numeric matrix of network edges, as for `parallel_louvain()`.
+//' @param reorder (0) The vertex order of the kept graph, as for
+//'   `parallel_louvain()`. Every clustering of the graph uses it.
+//' @param numThreads (0) The number of threads used to build the graph, 0 for
+//'   all the available ones. `fpg_cluster()` has its own.
+//' @return An object of class `fpg_graph`.
+//' @export
+// [[Rcpp::export]]
+SEXP fpg_graph(NumericMatrix links, int reorder = 0, int numThreads = 0) {
+  ompThreadsScope threadsScope(clustering_threads(numThreads)); //Restored on return
+  Rcpp::XPtr<fpgGraph> g(new fpgGraph(), true); //Registers the finalizer first
+  links_to_graph(g->input.get(), links);
+  prepare_graph(g->input.get(), true, reorder, &g->prepared);
+  logFlush();
+  g.attr("class") = "fpg_graph";
+  return g;
+}
+
+//' Cluster a graph built by fpg_graph()
+//'
+//' Runs the clustering of `parallel_louvain()` on a graph built by
+//' `fpg_graph()`, without copying or rebuilding it. The graph is not modified,
+//' so it can be clustered any number of times with different parameters.
+//'
+//' @param graph An `fpg_graph` object.
+//' @inheritParams parallel_louvain
+//' @return As for `parallel_louvain()`.
+//' @export
+// [[Rcpp::export]]
+Rcpp::List fpg_cluster(SEXP graph,
+                       int minGraphSize = 1000,
+                       double C_thresh = 0.000001,
+                       double threshold = 0.000000001,
+                       int numColors = 16,
+                       int coloring = 1,
+                       int syncType = 0,
+                       int basicOpt = 1,
+                       bool incrementalColoring = false,
+                       bool stats = false,
+                       int backend = 0,
+                       int numThreads = 0,
+                       int sampling = 0,
+                       int samplePercentage = 25){
+  clustering_threads(numThreads); //Checks it
+  if(!Rf_inherits(graph, "fpg_graph"))
+    Rcpp::stop("graph must be an object built by fpg_graph()");
+  Rcpp::XPtr<fpgGraph> g(graph);
+  if(g.get() == NULL)
+    Rcpp::stop("The graph was saved and restored: build it again with fpg_graph()");
+
+  preparedGraph prepared = g->prepared;
+  if((coloring == 0) && (syncType != 0)) {
+    ompThreadsScope threadsScope(clustering_threads(numThreads)); //For the copy
+    prepared = g->preparedSorted();
+  }
+
+  long NV = g->input->numVertices;
+  IntegerVector res(Rcpp::no_init(NV));
+  clusteringStats phaseStatsList;
+  double modularity = find_communities(g->input.get(),
+                                       res.begin(),
+                                       NULL,
+                                       minGraphSize,
+                                       C_thresh,
+                                       threshold,
+                                       numColors,
+                                       numThreads,
+                                       NULL,
+                                       coloring,
+                                       syncType,
+                                       basicOpt,
+                                       sampling,
+                                       samplePercentage,
+                                       incrementalColoring,
+                                       stats ? &phaseStatsList : NULL,
+                                       backend,
+                                       ReorderNone,
+                                       &prepared);
+
+  return clustering_result(modularity, res, stats ? &phaseStatsList : NULL);
+}
+
+//' Set the verbosity of the clustering code
+//'
+//' Controls how much progress and diagnostic output the C++ clustering code
+//' prints. By default only errors and warnings are printed.
+//'
+//' @param level An integer between 0 and 4.
+//'   * 0 - Silent.
+//'   * 1 - Errors only.
+//'   * 2 - (Default) Errors and warnings.
+//'   * 3 - Also phase-level progress and summaries.
+//'   * 4 - Also per-iteration tables and timings from the kernels.
+//' @return The previous level.
+//' @export
+// [[Rcpp::export]]
+int set_verbosity(int level = 2) {
+  return setLogLevel(level);
+}
+
+//' Pin the clustering threads to CPUs
+//'
+//' On machines with several memory nodes (NUMA), such as dual-socket servers,
+//' a thread that moves to another socket reads its vertices from remote
+//' memory. The graph arrays are placed for the threads that process them, so
+//' pinning the threads keeps these accesses local. The binding applies to the
+//' OpenMP threads of the following calls until it is changed. Only supported
+//' on Linux.
+//'
+//' The R thread, thread 0 of the clustering, is not pinned: threads started
+//' from it later, such as the TBB workers of `backend = 1` and
+//' `rcpp_parallel_jce()` or the threads of `RcppHNSW`, can run on all the
+//' allowed CPUs. OpenMP teams larger than the bound one get unbound extra
+//' threads; call `bind_threads()` again after raising the number of threads.
+//'
+//' @param bind (2) An integer between 0 and 2.
+//'   * 0 - No binding: threads may run on any CPU allowed to the process.
+//'   * 1 - Close: thread i runs on the i'th allowed CPU.
+//'   * 2 - (Default) Spread: threads are spread evenly over the allowed CPUs,
+//'   and so over the sockets when the CPUs of a socket are numbered together.
+//' @return An integer vector with the CPU of every thread, -1 if not bound
+//' (always for the R thread).
+//' @export
+// [[Rcpp::export]]
+IntegerVector bind_threads(int bind = 2) {
+  if ((bind < BindNone) || (bind > BindSpread))
+    Rcpp::stop("bind must be 0, 1 or 2");
+  IntegerVector cpus(omp_get_max_threads());
+  if (bindThreads(bind, cpus.begin()) < 0)
+    Rcpp::stop("Could not bind the threads: only supported on Linux");
+  return cpus;
 }
@@ -0,0 +1,75 @@
+#ifndef __PARALLEL_SCAN__
+#define __PARALLEL_SCAN__
+#include "defs.h"
+#include <vector>
+#include <algorithm>
+
+//Prefix sums of a[0..N) in place, in rounds of ScanBlockSize entries per
+//thread: every thread sums its block, the block sums are scanned, then every
+//thread scans its block from the sum of the blocks before it, while the block
+//is still in its cache. Integer sums do not depend on the number of threads;
+//floating-point sums are rounded in another order than by a serial scan.
+//Short arrays are scanned by the calling thread.
+#define SerialScanSize 65536
+#define ScanBlockSize  32768
+template <typename T>
+T parallelScan(T *a, long N, bool inclusive) {
+  int nT = omp_get_max_threads();
+  if ((nT == 1) || (N < SerialScanSize)) {
+    T sum = 0;
+    for (long i=0; i<N; i++) {
+      T x = a[i];
+      a[i] = inclusive ? sum + x : sum;
+      sum += x;
+    }
+    return sum;
+  }
+  std::vector<T> blockSum(nT + 1);
+  T carry = 0; //Sum of the entries of the previous rounds
+#pragma omp parallel num_threads(nT)
+  {
+    int  t  = omp_get_thread_num();
+    int  nB = omp_get_num_threads();
+    for (long base=0; base<N; base+=(long) nB*ScanBlockSize) {
+      long roundSize = std::min((long) nB*ScanBlockSize, N - base);
+      long first = base + (roundSize * t) / nB;
+      long last  = base + (roundSize * (t+1)) / nB;
+      T sum = 0;
+      for (long i=first; i<last; i++)
+        sum += a[i];
+      blockSum[t+1] = sum;
+#pragma omp barrier
+#pragma omp single
+      {
+        blockSum[0] = carry;
+        for (int b=0; b<nB; b++)
+          blockSum[b+1] += blockSum[b];
+        carry = blockSum[nB];
+      }//Implicit barrier
+      sum = blockSum[t];
+      for (long i=first; i<last; i++) {
+        T x = a[i];
+        a[i] = inclusive ? sum + x : sum;
+        sum += x;
+      }
+#pragma omp barrier //blockSum is rewritten in the next round
+    }
+  }
+  return carry;
+}//End of parallelScan()
+
+//a[i] becomes a[0] + ... + a[i]. Returns the sum of a. The CSR pointers of
+//NV vertices from the degrees stored in p[1..NV] (p[0] = 0) are
+//parallelInclusiveScan(p, NV+1).
+template <typename T>
+T parallelInclusiveScan(T *a, long N) {
+  return parallelScan(a, N, true);
+}
+
+//a[i] becomes a[0] + ... + a[i-1], a[0] becomes 0. Returns the sum of a.
+template <typename T>
+T parallelExclusiveScan(T *a, long N) {
+  return parallelScan(a, N, false);
+}
+
+#endif
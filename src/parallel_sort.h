@@ -0,0 +1,38 @@
+#ifndef __PARALLEL_SORT__
+#define __PARALLEL_SORT__
+#include "defs.h"
+#include <algorithm>
+
+//Sort a[0..N) with one chunk per thread, then merge pairs of chunks in rounds.
+//The result does not depend on the number of threads when less() is a total
+//order; ties may end up in any order otherwise. Short arrays are sorted by the
+//calling thread.
+#define SerialSortSize 4096
+template <typename T, typename Compare>
+void parallelSort(T *a, long N, Compare less) {
+  int nT = omp_get_max_threads();
+  if ((nT == 1) || (N < SerialSortSize)) {
+    std::sort(a, a + N, less);
+    return;
+  }
+  std::vector<long> bounds(nT + 1);
+  for (int t=0; t<=nT; t++)
+    bounds[t] = (N * t) / nT;
+#pragma omp parallel for
+  for (int t=0; t<nT; t++)
+    std::sort(a + bounds[t], a + bounds[t+1], less);
+  for (int width=1; width<nT; width*=2) {
+#pragma omp parallel for
+    for (int t=0; t<nT; t+=2*width) {
+      if (t + width < nT)
+        std::inplace_merge(a + bounds[t], a + bounds[t+width], a + bounds[std::min(t + 2*width, nT)], less);
+    }
+  }
+}//End of parallelSort()
+
+template <typename T>
+void parallelSort(T *a, long N) {
+  parallelSort(a, N, std::less<T>());
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include "defs.h"
+
+clustering_parameters::clustering_parameters()
+: inFile(NULL), ftype(8), strongScaling(false), output(false), VF(false),
+  coloring(1), replaceMap(true), numColors(16), syncType(0), basicOpt(1),
+  threadsOpt(true), C_thresh(0.000001), minGraphSize(1000), threshold(0.000000001),
+  percentage(80), compute_metrics(false)
+{}
+
+void clustering_parameters::usage()
+{
+  LOG_ERROR("***************************************************************************************\n");
+  LOG_ERROR("Basic usage: <Options> FileName\n");
+  LOG_ERROR("***************************************************************************************\n");
+  LOG_ERROR("Input Options: \n");
+  LOG_ERROR("***************************************************************************************\n");
+  LOG_ERROR("File-type  : -f <1-9>   -- default=8\n");
+  LOG_ERROR("           : 1 = Matrix Market coordinate matrix, general or symmetric\n");
+  LOG_ERROR("           : 3 = Pajek: \"*Vertices N\", then \"*Edges\" with each edge once\n");
+  LOG_ERROR("           : 5 = Metis (DIMACS#10)\n");
+  LOG_ERROR("           : 7 = Binary CSR format, as written by writeGraphBinaryFormatNew()\n");
+  LOG_ERROR("           : 8 = SNAP edge list: \"u v [w]\" per line, '#' starts a comment\n");
+  LOG_ERROR("           : 9 = FastPG CSR, as written by writeGraphCSR() (memory mapped)\n");
+  LOG_ERROR("           : 2, 4, 6 (DIMACS#9, Pajek with edges twice, edge list) are not supported yet\n");
+  LOG_ERROR("--------------------------------------------------------------------------------------\n");
+  LOG_ERROR("Strong scaling : -s         -- default=false\n");
+  LOG_ERROR("VF             : -v         -- default=false\n");
+  LOG_ERROR("Output         : -o         -- default=false\n");
+  LOG_ERROR("Coloring       : -c <0-4>   -- default=1\n");
+  LOG_ERROR("Num colors     : -p <int>   -- default=16 (used with -c 3)\n");
+  LOG_ERROR("Sync type      : -y <0-4>   -- default=0 (used with -c 0)\n");
+  LOG_ERROR("Basic option   : -b <0-1>   -- default=1 (vector instead of map)\n");
+  LOG_ERROR("Threads option : -n         -- default=true (clear to use the Scale kernel)\n");
+  LOG_ERROR("Replace map    : -r         -- default=true (clear to use maps with coloring)\n");
+  LOG_ERROR("Min graph size : -m <int>   -- default=1000\n");
+  LOG_ERROR("C threshold    : -d <float> -- default=0.000001\n");
+  LOG_ERROR("Threshold      : -t <float> -- default=0.000000001\n");
+  LOG_ERROR("Percentage     : -x <1-100> -- default=80 (Approx kernel)\n");
+  LOG_ERROR("Metrics        : -z         -- default=false\n");
+  LOG_ERROR("***************************************************************************************\n");
+}//end of usage()
+
+//Options that take no argument toggle their default
+bool clustering_parameters::parse(int argc, char *argv[])
+{
+  static const char *opt_string = "f:c:p:y:b:m:d:t:x:svonrz";
+  int opt = getopt(argc, argv, opt_string);
+  while (opt != -1) {
+    switch (opt) {
+      case 'f': ftype = atoi(optarg);
+        if ((ftype > 9)||(ftype < 1)) {
+          LOG_ERROR("File type must be an integer between 1 and 9.\n");
+          return false;
+        }
+        break;
+      case 'c': coloring = atoi(optarg);
+        if ((coloring > 4)||(coloring < 0)) {
+          LOG_ERROR("Coloring must be an integer between 0 and 4.\n");
+          return false;
+        }
+        break;
+      case 'p': numColors = atoi(optarg);
+        if ((numColors > 1024)||(numColors < 1)) {
+          LOG_ERROR("Number of colors must be an integer between 1 and 1024.\n");
+          return false;
+        }
+        break;
+      case 'y': syncType = atoi(optarg);
+        if ((syncType > 4)||(syncType < 0)) {
+          LOG_ERROR("Sync type must be an integer between 0 and 4.\n");
+          return false;
+        }
+        break;
+      case 'b': basicOpt = atoi(optarg);
+        if ((basicOpt > 1)||(basicOpt < 0)) {
+          LOG_ERROR("Basic option must be 0 or 1.\n");
+          return false;
+        }
+        break;
+      case 'm': minGraphSize = atol(optarg);
+        if (minGraphSize < 0) {
+          LOG_ERROR("Minimum graph size must be non-negative.\n");
+          return false;
+        }
+        break;
+      case 'd': C_thresh = atof(optarg);
+        if (C_thresh <= 0) {
+          LOG_ERROR("C threshold must be positive.\n");
+          return false;
+        }
+        break;
+      case 't': threshold = atof(optarg);
+        if (threshold <= 0) {
+          LOG_ERROR("Threshold must be positive.\n");
+          return false;
+        }
+        break;
+      case 'x': percentage = atoi(optarg);
+        if ((percentage > 100)||(percentage < 1)) {
+          LOG_ERROR("Percentage must be an integer between 1 and 100.\n");
+          return false;
+        }
+        break;
+      case 's': strongScaling = !strongScaling; break;
+      case 'v': VF = !VF; break;
+      case 'o': output = !output; break;
+      case 'n': threadsOpt = !threadsOpt; break;
+      case 'r': replaceMap = !replaceMap; break;
+      case 'z': compute_metrics = !compute_metrics; break;
+      default:
+        usage();
+        return false;
+    }
+    opt = getopt(argc, argv, opt_string);
+  }
+
+  if (argc - optind != 1) {
+    LOG_ERROR("Problem name not specified. Exiting.\n");
+    usage();
+    return false;
+  }
+  inFile = argv[optind];
+
+  if ((ftype == 2)||(ftype == 4)||(ftype == 6)) {
+    LOG_ERROR("File type %d is not supported yet.\n", ftype);
+    return false;
+  }
+  return true;
+}//end of parse()
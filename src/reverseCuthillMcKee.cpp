@@ -26,254 +26,139 @@
 /*---------------------------------------------------------------------------*/
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "dataStructureHeap.h"
+#include "parallel_sort.h"
+#include <climits>
 
-// Perform reverse Cuthill-McKee operation on the graph
-// SSize indicates the size of Source
-// Sets the pointer in isChordal from one direction ONLY
-void algoReverseCuthillMcKee( graph *G, long *pOrder, int nThreads )
+//Levels with at most this many vertices are expanded and sorted by one thread
+#define SerialLevelSize   1024
+//Breadth-first searches tried per component to find a pseudo-peripheral vertex
+#define PeripheralRounds  8
+
+//Level-synchronous breadth-first search of the component of source. The vertices
+//are written to R level by level, and levels of more than SerialLevelSize vertices
+//are expanded in parallel. mark[v] is set to stamp when v is reached. Returns the
+//number of levels, the size of the component in compSize, the start of the last
+//level in R in lastLevel and the size of the largest level in width. The search
+//stops and returns 0 as soon as a level has widthLimit vertices or more.
+//With sortLevels, every level is sorted in Cuthill-McKee order: by the rank in R
+//of the first parent, then by degree, then by id. pos[v] then holds the rank of v.
+//The order does not depend on the number of threads.
+static long levelSynchronousBFS(graph *G, long source, long stamp, long *mark, long *pos,
+                                long *parentRank, long *R, bool sortLevels,
+                                long widthLimit, long *compSize, long *lastLevel, long *width)
 {
-    printf("Within algoReverseCuthillMcKee() \n");
-    if (nThreads < 1)
-        omp_set_num_threads(1);
-    else
-        omp_set_num_threads(nThreads);
-    int nT;
-#pragma omp parallel
-    {
-        nT = omp_get_num_threads();
-    }
-    
-    double time1=0, time2=0, total=0, totalTime=0;
-    long    NV        = G->numVertices;
-    long    NS        = G->sVertices;
-    long    NT        = NV - NS;
-    bool    isSym     = true;
-    if(NT > 0)
-        isSym = false; //A bipartite graph
-    long    NE        = G->numEdges;
-    long    *vtxPtr   = G->edgeListPtrs;
-    edge    *vtxInd   = G->edgeList;
-    printf("Vertices:%ld  Edges:%ld\n", NV, NE);
-    
-    //////STEP 1: Sort the vertices in order of their degree
-    
-    //Compute the degree of each vertex:
-    time1 = omp_get_wtime();
-    long *degree  = (long *) malloc (NV * sizeof(long)); assert(degree != 0);
-#pragma omp parallel for
-    for (long i=0; i<NV; i++) {
-        degree[i] = vtxPtr[i+1] - vtxPtr[i];
-    }
-    //Add the vertices to a heap data structure:
-    heap *myHeap = (heap*) malloc (sizeof(heap));
-    heapInitializeToN(myHeap, NV);
-    printf("Max heap size: %ld\n", myHeap->maxsize);
-    term newTerm;
-    
-    long *visited  = (long *) malloc (NV * sizeof(long)); assert(visited != 0);
-    long *R = (long *) malloc (NV * sizeof(long)); assert(R != 0);
-    //Initialize the Vectors:
-#pragma omp parallel for
-    for (long i=0; i<NV; i++) {
-        visited[i]= 0; //zero means not visited
-        R[i] = -1; //Initialize the rank as -1
-    }
-    long howManyAdded = 0; //How many vertices have been added to the queue
-    //Do not add isolated (degree=0) vertices:
-    for (int i=0; i<NV; i++) {
-        if(degree[i] > 0) {
-            newTerm.id = i;
-            newTerm.weight = degree[i];
-            heapAdd(myHeap, newTerm); //Has to be added in serial
-        } else {
-            R[howManyAdded] = i; //Add them directly to the stack
-            visited[i] = 1;
-            howManyAdded++;
-        }
-    }
-    printf("Heap size: %ld\n", myHeap->size);
-    free(degree);
-    time2 = omp_get_wtime();
-    printf("Time for adding %ld elements to the heap: %lf\n",NV, time2-time1);
-    totalTime += time2-time1;
-    
-    ////////STEP 2: Now perform the BFS
-    
-    
-    //The Queue Data Structure for the Dominating Set:
-    //The Queues are important for synchornizing the concurrency:
-    //Have two queues - read from one, write into another
-    // at the end, swap the two.
-    long *Q    = (long *) malloc (NV * sizeof(long)); assert(Q != 0);
-    long *Qtmp = (long *) malloc (NV * sizeof(long)); assert(Qtmp != 0);
-    long *Qswap;
-    
-#pragma omp parallel for
-    for (long i=0; i<NV; i++) {
-        Q[i]= -1;
-        Qtmp[i]= -1;
-    }
-    long QTail=0; //Tail of the queue (implicitly will represent the size)
-    long QtmpTail=0; //Tail of the queue (implicitly will represent the size)
-    
-    //Get the smallest degree as the first source vertex
-    term *data = myHeap->elements;
-    heapRemoveMin(myHeap);     //Remove it from the heap
-    printf("Source vertex: %ld\n", data[0].id);
-    Q[0] = data[0].id; //Add the smallest vertex to the queue
-    QTail = 1; //Increment the queue tail
-    visited[data[0].id] = 1; //Mark the vertex as visited
-    R[howManyAdded] = data[0].id; //Enter the vertex in the vector
-    howManyAdded++;
-    printf("R[0] = %ld\n", data[0].id);
-    
-    long nCC = 1;
-    
-    while (howManyAdded < NV) { //Process until all the vertices have been added to the queue
-        printf("***********************************************\n");
-        printf("Connected component       : %d     \n",    nCC);
-        printf("***********************************************\n");
-        //The size of Q1 is now QTail+1; the elements are contained in Q1[0] through Q1[Q1Tail]
-        int nLoops=0; //Count number of iterations in the while loop
-        while ( QTail > 0 ) {
-            printf("Loop %d, QSize= %ld\n",nLoops,QTail);
-            //KEY IDEA: Process all the members of the queue concurrently:
-            time1 = omp_get_wtime();
-#pragma omp parallel for
-            for (long Qi=0; Qi<QTail; Qi++) {
-                long v = Q[Qi];
-                long adj1 = vtxPtr[v];
-                long adj2 = vtxPtr[v+1];
-                for(long k = adj1; k < adj2; k++) {
+    long *vtxPtr = G->edgeListPtrs;
+    edge *vtxInd = G->edgeList;
+    auto byDegree = [=](long a, long b) {
+        long da = vtxPtr[a+1] - vtxPtr[a], db = vtxPtr[b+1] - vtxPtr[b];
+        return (da < db) || ((da == db) && (a < b));
+    };
+    R[0] = source;
+    mark[source] = stamp;
+    pos[source] = 0;
+    long levelStart = 0, levelEnd = 1, nLevels = 1;
+    *width = 1;
+    while (true) {
+        long tail = levelEnd;
+        if ((levelEnd - levelStart <= SerialLevelSize) || (omp_get_max_threads() == 1)) {
+            //Expand the level in rank order: the first vertex to reach x is the parent
+            //of smallest rank, so only the children of each parent need sorting
+            for (long Qi=levelStart; Qi<levelEnd; Qi++) {
+                long v = R[Qi];
+                long children = tail;
+                for (long k=vtxPtr[v]; k<vtxPtr[v+1]; k++) {
                     long x = vtxInd[k].tail;
-                    //Has this neighbor been visited?
-                    if ( __sync_fetch_and_add(&visited[x], 1) == 0 ) {
-                        //Not visited: add it to the Queue
-                        long whereInQ = __sync_fetch_and_add(&QtmpTail, 1);
-                        Qtmp[whereInQ] = x;
-                        long whereInR = __sync_fetch_and_add(&howManyAdded, 1);
-                        //printf("R[%ld] = %ld\n", whereInR, x);
-                        R[whereInR] = x; //Add it to the ranked list
+                    if (mark[x] != stamp) {
+                        mark[x] = stamp;
+                        R[tail++] = x;
                     }
-                } //End of for loop on k: the neighborhood of v
-            } //End of for(Qi)
-            // Also end of the parallel region
-            // Swap the two queues:
-            Qswap = Q;
-            Q = Qtmp; //Q now points to the second vector
-            Qtmp = Qswap;
-            QTail = QtmpTail; //Number of elements
-            QtmpTail = 0; //Symbolic emptying of the second queue
-            nLoops++;
-            time2  = omp_get_wtime();
-            total += time2-time1;
-        } //end of while ( !Q.empty() )
-        printf("***********************************************\n");
-        printf("Number of iterations       : %d     \n", nLoops);
-        printf("Time for Graph-traversal   : %lf sec\n", total);
-        printf("Number of elements added   : %ld    \n", howManyAdded);
-        printf("***********************************************\n");
-        
-        /////Now look for the next smallest id:
-        bool found = 1;
-        if(howManyAdded < NV) {
-            printf("Looking for the next source vertex...(Heap size = %ld)\n", myHeap->size);
-            term *data;
-            do {
-                data = myHeap->elements;
-                //printf("Processing vertex: %ld Visited: %ld -- (Heap size = %ld)\n", data[0].id+1, visited[data[0].id], myHeap->size);
-                heapRemoveMin(myHeap);
-                if (myHeap->size == 0) { //No more elements to look at
-                    found = 0;
-                    printf("Quitting because there is nothing in the heap...(Heap size = %ld)\n", myHeap->size);
-                    break;
+                }//End of for(k)
+                if (sortLevels) {
+                    std::sort(R + children, R + tail, byDegree);
+                    for (long i=children; i<tail; i++)
+                        pos[R[i]] = i;
                 }
-                //printf("Id: %ld  -- status: %ld\n", data[0].id, visited[data[0].id]);
-            } while(visited[data[0].id] > 0); //Check if it has already been visited
-            if (found == 0) {
-                break; //break from the main loop
-            } else { //Add the new source to the list
-                printf("New source vertex: %ld\n", data[0].id);
-                Q[0] = data[0].id; //Add the smallest vertex to the queue
-                QTail = 1; //Increment the queue tail
-                visited[data[0].id] = 1; //Mark the vertex as visited
-                R[howManyAdded] = data[0].id; //Enter the vertex in the vector
-                //printf("R[%ld] = %ld\n", howManyAdded, data[0].id);
-                howManyAdded++; //Increment the #vertices that have been added to the stack
-            }
-        }//End of if()
-        nCC++;
-        totalTime += total;
-        total = 0;
-    }
-    //Clean Up:
-    free(Q);
-    free(Qtmp);
-    free(visited);
-    free(myHeap->elements);
-    free(myHeap);
-    
-    assert(howManyAdded == NV); //Sanity check before moving to next step
-    //////STEP 3: Received a valid vector; reverse the order:
-    if (isSym) { //A symmetric matrix
-        for (long i=0; i<NV; i++) {
-            //pOrder[i]= R[NV - i - 1];
-            pOrder[R[i]]= NV - i - 1; //pOrder is a old2New index mapping
+            }//End of for(Qi)
+            if (tail == levelEnd)
+                break; //No new level
+            if (tail - levelEnd >= widthLimit)
+                return 0;
+            *width = std::max(*width, tail - levelEnd);
+            levelStart = levelEnd;
+            levelEnd = tail;
+            nLevels++;
+            continue;
         }
-    } else { //A bipartite graph:
-        //STEP 3.1: Segregate the row and column vertices
-        long rowCounter = 0;
-        long colCounter = NS;
-        long *Rprime    = (long *) malloc (NV * sizeof(long)); assert(Rprime != 0);
-        for (long i=0; i<NV; i++) {
-            Rprime[i]= -1;
-        }
-        for (long i=(NV-1); i>=0; i--) { //Go through the list in a reverse order
-            if(R[i] < NS) { //A row vertex
-                Rprime[rowCounter] = R[i];
-                rowCounter++;
-            } else { //A column vertex
-                Rprime[colCounter] = R[i];
-                colCounter++;
-            }
-        }//End of for(i)
-        assert(rowCounter==NS); assert(colCounter==NV); //Sanity check
-        //STEP 3.2: Now build the old2New map:
-        for (long i=0; i<NV; i++) {
-            pOrder[Rprime[i]] = i; //pOrder is a old2New index mapping
+        //Expand the level: claim the unreached neighbors of its vertices
+#pragma omp parallel for schedule(guided)
+        for (long Qi=levelStart; Qi<levelEnd; Qi++) {
+            long v = R[Qi];
+            for (long k=vtxPtr[v]; k<vtxPtr[v+1]; k++) {
+                long x = vtxInd[k].tail;
+                long old = mark[x];
+                if ((old != stamp) && __sync_bool_compare_and_swap(&mark[x], old, stamp)) {
+                    pos[x] = LONG_MAX; //Not ranked yet
+                    R[__sync_fetch_and_add(&tail, 1)] = x;
+                }
+            }//End of for(k)
+        }//End of for(Qi)
+        if (tail == levelEnd)
+            break; //No new level
+        long levelSize = tail - levelEnd;
+        if (levelSize >= widthLimit)
+            return 0;
+        *width = std::max(*width, levelSize);
+        if (sortLevels) {
+            //The first parent of x is its neighbor of smallest rank: neighbors in
+            //earlier levels would have reached x before, and the ones in its own
+            //level are not ranked yet
+#pragma omp parallel for schedule(guided) if(levelSize > SerialLevelSize)
+            for (long Qi=levelEnd; Qi<tail; Qi++) {
+                long x = R[Qi];
+                long parent = LONG_MAX;
+                for (long k=vtxPtr[x]; k<vtxPtr[x+1]; k++) {
+                    long y = vtxInd[k].tail;
+                    if ((mark[y] == stamp) && (pos[y] < parent))
+                        parent = pos[y];
+                }
+                parentRank[x] = parent;
+            }//End of for(Qi)
+            parallelSort(R + levelEnd, levelSize, [=](long a, long b) {
+                if (parentRank[a] != parentRank[b])
+                    return parentRank[a] < parentRank[b];
+                return byDegree(a, b);
+            });
+#pragma omp parallel for if(levelSize > SerialLevelSize)
+            for (long Qi=levelEnd; Qi<tail; Qi++)
+                pos[R[Qi]] = Qi;
         }
-        //Clean up:
-        free(Rprime);
-    }//End of else(bipartite graph)
-    
-    printf("***********************************************\n");
-    printf("Number of connected components       : %d     \n", nCC);
-    printf("Total Time                           : %lf sec\n", totalTime);
-    printf("***********************************************\n");
-    
-    //Clean Up:
-    free(R);
-    
-} //End of algoReverseCuthillMcKee
+        levelStart = levelEnd;
+        levelEnd = tail;
+        nLevels++;
+    }//End of while()
+    *compSize = levelEnd;
+    *lastLevel = levelStart;
+    return nLevels;
+}//End of levelSynchronousBFS()
 
-// Perform reverse Cuthill-McKee operation on the graph: Strict variant
-// SSize indicates the size of Source
-// Sets the pointer in isChordal from one direction ONLY
-void algoReverseCuthillMcKeeStrict( graph *G, long *pOrder, int nThreads )
+// Perform reverse Cuthill-McKee operation on the graph
+// Every connected component is numbered by a level-synchronous breadth-first
+// search. The start vertex is searched as for a pseudo-peripheral vertex (George
+// and Liu): starting from a vertex of minimum degree, move to a vertex of minimum
+// degree in the last level as long as this increases the number of levels. Of the
+// vertices tried, the one with the narrowest level structure is kept, as in Gibbs,
+// Poole and Stockmeyer: the bandwidth is bounded by the size of two consecutive
+// levels, and on clustered kNN graphs the deepest structure is often not the
+// narrowest. The components follow each other in the order of their first vertex
+// of minimum degree. pOrder is an old2New index mapping.
+void algoReverseCuthillMcKee( graph *G, long *pOrder, int nThreads )
 {
-    printf("Within algoReverseCuthillMcKee() \n");
-    if (nThreads < 1)
-        omp_set_num_threads(1);
-    else
-        omp_set_num_threads(nThreads);
-    int nT;
-#pragma omp parallel
-    {
-        nT = omp_get_num_threads();
-    }
-    
-    double time1=0, time2=0, total=0, totalTime=0;
+    LOG_DEBUG("Within algoReverseCuthillMcKee() \n");
+    ompThreadsScope threadsScope(nThreads); //Restored on return
+
+    double time1=0, time2=0;
     long    NV        = G->numVertices;
     long    NS        = G->sVertices;
     long    NT        = NV - NS;
@@ -282,190 +167,82 @@ void algoReverseCuthillMcKeeStrict( graph *G, long *pOrder, int nThreads )
         isSym = false; //A bipartite graph
     long    NE        = G->numEdges;
     long    *vtxPtr   = G->edgeListPtrs;
-    edge    *vtxInd   = G->edgeList;
-    printf("Vertices:%ld  Edges:%ld\n", NV, NE);
-    
-    //////STEP 1: Sort the vertices in order of their degree
-    
-    //Compute the degree of each vertex:
+    LOG_DEBUG("Vertices:%ld  Edges:%ld\n", NV, NE);
+
+    //////STEP 1: Queue the vertices by degree: the candidate start vertices of
+    //////the components
     time1 = omp_get_wtime();
-    long *degree  = (long *) malloc (NV * sizeof(long)); assert(degree != 0);
-#pragma omp parallel for
+    long *mark       = (long *) malloc (NV * sizeof(long)); assert(mark != 0);
+    long *pos        = (long *) malloc (NV * sizeof(long)); assert(pos != 0);
+    long *parentRank = (long *) malloc (NV * sizeof(long)); assert(parentRank != 0);
+    long *R          = (long *) malloc (NV * sizeof(long)); assert(R != 0);
+    long *S          = (long *) malloc (NV * sizeof(long)); assert(S != 0); //Candidate orders
+    long maxDegree = 0;
+#pragma omp parallel for reduction(max: maxDegree)
     for (long i=0; i<NV; i++) {
-        degree[i] = vtxPtr[i+1] - vtxPtr[i];
+        mark[i] = 0; //zero means not reached by any search
+        maxDegree = std::max(maxDegree, vtxPtr[i+1] - vtxPtr[i]);
     }
-    //Add the vertices to a heap data structure:
-    heap *myHeap = (heap*) malloc (sizeof(heap));
-    heapInitializeToN(myHeap, NV);
-    printf("Max heap size: %ld\n", myHeap->maxsize);
-    term newTerm;
-    
-    long *visited  = (long *) malloc (NV * sizeof(long)); assert(visited != 0);
-    long *R = (long *) malloc (NV * sizeof(long)); assert(R != 0);
-    long *oneLevel = (long *) malloc (NV * sizeof(long)); assert(oneLevel != 0);
-    //Initialize the Vectors:
-#pragma omp parallel for
-    for (long i=0; i<NV; i++) {
-        visited[i]= 0; //zero means not visited
-        R[i] = -1; //Initialize the rank as -1
-        oneLevel[i] = -1; //Hold vertices at a given level
-    }
-    long howManyAdded = 0; //How many vertices have been added to the queue
-    long howManyAddedLevel = 0;
-    //Do not add isolated (degree=0) vertices:
-    for (int i=0; i<NV; i++) {
-        if(degree[i] > 0) {
-            newTerm.id = i;
-            newTerm.weight = degree[i];
-            heapAdd(myHeap, newTerm); //Has to be added in serial
-        } else {
-            R[howManyAdded] = i; //Add them directly to the stack
-            visited[i] = 1;
-            howManyAdded++;
-        }
-    }
-    printf("Heap size: %ld\n", myHeap->size);
-    free(degree);
+    bucketQueue byDegree(NV, maxDegree); //Smallest degree, then smallest id first
+    for (long i=0; i<NV; i++)
+        byDegree.push(i, vtxPtr[i+1] - vtxPtr[i]);
     time2 = omp_get_wtime();
-    printf("Time for adding %ld elements to the heap: %lf\n",NV, time2-time1);
-    totalTime += time2-time1;
-    
-    ////////STEP 2: Now perform the BFS
-    
-    
-    //The Queue Data Structure for the Dominating Set:
-    //The Queues are important for synchornizing the concurrency:
-    //Have two queues - read from one, write into another
-    // at the end, swap the two.
-    long *Q    = (long *) malloc (NV * sizeof(long)); assert(Q != 0);
-    long *Qtmp = (long *) malloc (NV * sizeof(long)); assert(Qtmp != 0);
-    long *Qswap;
-    
-#pragma omp parallel for
-    for (long i=0; i<NV; i++) {
-        Q[i]= -1;
-        Qtmp[i]= -1;
-    }
-    long QTail=0; //Tail of the queue (implicitly will represent the size)
-    long QtmpTail=0; //Tail of the queue (implicitly will represent the size)
-    
-    //Get the smallest degree as the first source vertex
-    term *data = myHeap->elements;
-    heapRemoveMin(myHeap);     //Remove it from the heap
-    printf("Source vertex: %ld\n", data[0].id);
-    Q[0] = data[0].id; //Add the smallest vertex to the queue
-    QTail = 1; //Increment the queue tail
-    visited[data[0].id] = 1; //Mark the vertex as visited
-    R[howManyAdded] = data[0].id; //Enter the vertex in the vector
-    howManyAdded++;
-    printf("R[0] = %ld\n", data[0].id);
-    
-    long nCC = 1;
-    
-    while (howManyAdded < NV) { //Process until all the vertices have been added to the queue
-        printf("***********************************************\n");
-        printf("Connected component       : %d     \n",    nCC);
-        printf("***********************************************\n");
-        //The size of Q1 is now QTail+1; the elements are contained in Q1[0] through Q1[Q1Tail]
-        int nLoops=0; //Count number of iterations in the while loop
-        while ( QTail > 0 ) {
-            printf("Loop %d, QSize= %ld\n",nLoops,QTail);
-            //KEY IDEA: Process all the members of the queue concurrently:
-            time1 = omp_get_wtime();
-            //#pragma omp parallel for
-            for (long Qi=0; Qi<QTail; Qi++) {
-                long v = Q[Qi];
-                long adj1 = vtxPtr[v];
-                long adj2 = vtxPtr[v+1];
-                for(long k = adj1; k < adj2; k++) {
-                    long x = vtxInd[k].tail;
-                    //Has this neighbor been visited?
-                    if ( __sync_fetch_and_add(&visited[x], 1) == 0 ) {
-                        //Not visited: add it to the Queue
-                        long whereInQ = __sync_fetch_and_add(&QtmpTail, 1);
-                        Qtmp[whereInQ] = x;
-                        //printf("R[%ld] = %ld\n", whereInR, x);
-                    }
-                } //End of for loop on k: the neighborhood of v
-            } //End of for(Qi)
-            // Also end of the parallel region
-            //Now add all the vertices into R in a sorted order:
-            heap *myTmpHeap = (heap*) malloc (sizeof(heap));
-            heapInitializeToN(myTmpHeap, QtmpTail);
-            for (int Ti=0; Ti<QtmpTail; Ti++) {
-                newTerm.id = Qtmp[Ti];
-                newTerm.weight = degree[Qtmp[Ti]];
-                heapAdd(myTmpHeap, newTerm); //Has to be added in serial
-            }
-            //printf("Added %ld vertices to the queue\n", QtmpTail);
-            term *tmpData;
-            for (int Ti=0; Ti<QtmpTail; Ti++) {
-                //printf("Removing %ld id.\n", Ti+1);
-                tmpData = myTmpHeap->elements;
-                heapRemoveMin(myTmpHeap);
-                long whereInR = __sync_fetch_and_add(&howManyAdded, 1);
-                R[whereInR] = tmpData[0].id; //Add it to the ranked list
-            }
-            free(myTmpHeap->elements);
-            free(myTmpHeap);
-            // Swap the two queues:
-            Qswap = Q;
-            Q = Qtmp; //Q now points to the second vector
-            Qtmp = Qswap;
-            QTail = QtmpTail; //Number of elements
-            QtmpTail = 0; //Symbolic emptying of the second queue
-            nLoops++;
-            time2  = omp_get_wtime();
-            total += time2-time1;
-        } //end of while ( !Q.empty() )
-        printf("***********************************************\n");
-        printf("Number of iterations       : %d     \n", nLoops);
-        printf("Time for Graph-traversal   : %lf sec\n", total);
-        printf("Number of elements added   : %ld    \n", howManyAdded);
-        printf("***********************************************\n");
-        
-        /////Now look for the next smallest id:
-        bool found = 1;
-        if(howManyAdded < NV) {
-            printf("Looking for the next source vertex...(Heap size = %ld)\n", myHeap->size);
-            term *data;
-            do {
-                data = myHeap->elements;
-                //printf("Processing vertex: %ld Visited: %ld -- (Heap size = %ld)\n", data[0].id+1, visited[data[0].id], myHeap->size);
-                heapRemoveMin(myHeap);
-                if (myHeap->size == 0) { //No more elements to look at
-                    found = 0;
-                    printf("Quitting because there is nothing in the heap...(Heap size = %ld)\n", myHeap->size);
-                    break;
-                }
-                //printf("Id: %ld  -- status: %ld\n", data[0].id, visited[data[0].id]);
-            } while(visited[data[0].id] > 0); //Check if it has already been visited
-            if (found == 0) {
-                break; //break from the main loop
-            } else { //Add the new source to the list
-                printf("New source vertex: %ld\n", data[0].id);
-                Q[0] = data[0].id; //Add the smallest vertex to the queue
-                QTail = 1; //Increment the queue tail
-                visited[data[0].id] = 1; //Mark the vertex as visited
-                R[howManyAdded] = data[0].id; //Enter the vertex in the vector
-                //printf("R[%ld] = %ld\n", howManyAdded, data[0].id);
-                howManyAdded++; //Increment the #vertices that have been added to the stack
+    LOG_DEBUG("Time for queuing %ld vertices by degree: %lf\n", NV, time2-time1);
+
+    ////////STEP 2: Now perform the searches, one component at a time
+    time1 = omp_get_wtime();
+    long howManyAdded = 0; //How many vertices have been ranked
+    long stamp = 0;
+    long nCC = 0, nSearches = 0;
+    while (howManyAdded < NV) {
+        while (mark[byDegree.top()] != 0)
+            byDegree.pop(); //Its component has been ranked
+        long source = byDegree.top();
+        long *Rc = R + howManyAdded; //The component is ranked after the previous ones
+        long compSize, lastLevel, width;
+        long nLevels = levelSynchronousBFS(G, source, ++stamp, mark, pos, parentRank, Rc,
+                                           true, LONG_MAX, &compSize, &lastLevel, &width);
+        nSearches++;
+        for (int round=0; (round < PeripheralRounds) && (nLevels > 1); round++) {
+            long candidate = Rc[lastLevel];
+            for (long i=lastLevel+1; i<compSize; i++) {
+                long x = Rc[i];
+                long dx = vtxPtr[x+1] - vtxPtr[x], dc = vtxPtr[candidate+1] - vtxPtr[candidate];
+                if ((dx < dc) || ((dx == dc) && (x < candidate)))
+                    candidate = x;
             }
-        }//End of if()
+            //A candidate at least as wide as the start cannot replace it: its search
+            //is abandoned, and so is the search for a farther vertex. Otherwise its
+            //order, already sorted, replaces the one of the start
+            long candidateLast, candidateWidth;
+            long candidateLevels = levelSynchronousBFS(G, candidate, ++stamp, mark, pos, parentRank,
+                                                       S, true, width, &compSize, &candidateLast,
+                                                       &candidateWidth);
+            nSearches++;
+            if (candidateLevels == 0)
+                break;
+            memcpy(Rc, S, compSize * sizeof(long));
+            width = candidateWidth;
+            if (candidateLevels <= nLevels)
+                break; //Not farther
+            nLevels = candidateLevels;
+            lastLevel = candidateLast;
+        }//End of for(round)
+        howManyAdded += compSize;
         nCC++;
-        totalTime += total;
-        total = 0;
-    }
+    }//End of while()
+    time2 = omp_get_wtime();
+    LOG_DEBUG("Time for %ld searches in %ld components: %lf\n", nSearches, nCC, time2-time1);
     //Clean Up:
-    free(Q);
-    free(Qtmp);
-    free(visited);
-    free(myHeap->elements);
-    free(myHeap);
-    
+    free(mark);
+    free(pos);
+    free(parentRank);
+    free(S);
+
     assert(howManyAdded == NV); //Sanity check before moving to next step
     //////STEP 3: Received a valid vector; reverse the order:
     if (isSym) { //A symmetric matrix
+#pragma omp parallel for
         for (long i=0; i<NV; i++) {
             //pOrder[i]= R[NV - i - 1];
             pOrder[R[i]]= NV - i - 1; //pOrder is a old2New index mapping
@@ -496,13 +273,11 @@ void algoReverseCuthillMcKeeStrict( graph *G, long *pOrder, int nThreads )
         free(Rprime);
     }//End of else(bipartite graph)
     
-    printf("***********************************************\n");
-    printf("Number of connected components       : %d     \n", nCC);
-    printf("Total Time                           : %lf sec\n", totalTime);
-    printf("***********************************************\n");
+    LOG_DEBUG("***********************************************\n");
+    LOG_DEBUG("Number of connected components       : %ld     \n", nCC);
+    LOG_DEBUG("***********************************************\n");
     
     //Clean Up:
     free(R);
     
-} //End of algoEdgeApproxDominatingEdgesLinearSearch
-
+} //End of algoReverseCuthillMcKee
@@ -40,23 +40,26 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "basic_comm.h"
 #include "basic_util.h"
+#include "utilityClusteringFunctions.h"
 
 using namespace std;
-//WARNING: This will overwrite the original graph data structure to
-//         minimize memory footprint
 // Return: C_orig will hold the cluster ids for vertices in the original graph
 //         Assume C_orig is initialized appropriately
-//WARNING: Graph G will be destroyed at the end of this routine
-void runMultiPhaseBasicApprox(graph *G, long *C_orig, int basicOpt, long minGraphSize,
-                        double threshold, double C_threshold, int numThreads, int threadsOpt, int percentage)
+//Graph G still belongs to the caller and is not freed: only the graphs built
+//for later phases are freed here
+double runMultiPhaseBasicApprox(graph *G, long *C_orig, int basicOpt, long minGraphSize,
+                        double threshold, double C_threshold, int numThreads, int threadsOpt, int percentage,
+                        int sampling, clusteringStats *stats)
 {
+    ompThreadsScope threadsScope(numThreads); //Also for the steps between the kernels
     double totTimeClustering=0, totTimeBuildingPhase=0, totTimeColoring=0, tmpTime=0;
     int tmpItr=0, totItr = 0;
     long NV = G->numVertices;
+    graph *Ginput = G; //Owned by the caller, never freed here
     
-    long percentange = 80;
     /* Step 1: Find communities */
     double prevMod = -1;
     double currMod = -1;
@@ -72,27 +75,30 @@ void runMultiPhaseBasicApprox(graph *G, long *C_orig, int basicOpt, long minGrap
     }
     
     while(1){
-        printf("===============================\n");
-        printf("Phase %ld\n", phase);
-        printf("===============================\n");
+        LOG_INFO("===============================\n");
+        LOG_INFO("Phase %ld\n", phase);
+        LOG_INFO("===============================\n");
         prevMod = currMod;
         
         
-        if(basicOpt == 1){
-            currMod = parallelLouvianMethodNoMap(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr);
-        }else if(threadsOpt == 1){
-            //currMod = parallelLouvianMethod(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr);
-	    currMod = parallelLouvianMethodApprox(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr, percentage);
-        }else{
-            currMod = parallelLouvianMethodScale(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr);
-        }
+        //Statistics of the current phase
+        phaseStats pStats;
+        if(stats != NULL)
+            initPhaseStats(&pStats, phase, G);
+        currMod = parallelLouvianMethodApprox(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr, percentage,
+                                              sampling, (stats != NULL) ? &pStats : NULL);
         
         totTimeClustering += tmpTime;
         totItr += tmpItr;
+        if(stats != NULL) {
+            pStats.timeClustering = tmpTime;
+            pStats.numIterations = tmpItr;
+            stats->push_back(pStats);
+        }
         
         //Renumber the clusters contiguiously
         numClusters = renumberClustersContiguously(C, G->numVertices);
-        printf("Number of unique clusters: %ld\n", numClusters);
+        LOG_INFO("Number of unique clusters: %ld\n", numClusters);
         
         //printf("About to update C_orig\n");
         //Keep track of clusters in C_orig
@@ -109,7 +115,7 @@ void runMultiPhaseBasicApprox(graph *G, long *C_orig, int basicOpt, long minGrap
                     C_orig[i] = C[C_orig[i]]; //Each cluster in a previous phase becomes a vertex
             }
         }
-        printf("Done updating C_orig\n");
+        LOG_INFO("Done updating C_orig\n");
         
         //Break if too many phases or iterations
         if((phase > 200)||(totItr > 10000)) {
@@ -122,10 +128,12 @@ void runMultiPhaseBasicApprox(graph *G, long *C_orig, int basicOpt, long minGrap
             Gnew = (graph *) malloc (sizeof(graph)); assert(Gnew != 0);
             tmpTime =  buildNextLevelGraphOpt(G, Gnew, C, numClusters, numThreads);
             totTimeBuildingPhase += tmpTime;
-            //Free up the previous graph
-            free(G->edgeListPtrs);
-            free(G->edgeList);
-            free(G);
+            if(stats != NULL)
+                stats->back().timeBuilding = tmpTime;
+            //Free up the previous graph, unless it is the input graph
+            if(G != Ginput) {
+                freeGraph(G);
+            }
             G = Gnew; //Swap the pointers
             G->edgeListPtrs = Gnew->edgeListPtrs;
             G->edgeList = Gnew->edgeList;
@@ -145,25 +153,26 @@ void runMultiPhaseBasicApprox(graph *G, long *C_orig, int basicOpt, long minGrap
         
     } //End of while(1)
     
-    printf("********************************************\n");
-    printf("*********    Compact Summary   *************\n");
-    printf("********************************************\n");
-    printf("Number of threads              : %ld\n", numThreads);
-    printf("Total number of phases         : %ld\n", phase);
-    printf("Total number of iterations     : %ld\n", totItr);
-    printf("Final number of clusters       : %ld\n", numClusters);
-    printf("Final modularity               : %lf\n", prevMod);
-    printf("Total time for clustering      : %lf\n", totTimeClustering);
-    printf("Total time for building phases : %lf\n", totTimeBuildingPhase);
-    printf("********************************************\n");
-    printf("TOTAL TIME                     : %lf\n", (totTimeClustering+totTimeBuildingPhase+totTimeColoring) );
-    printf("********************************************\n");
+    LOG_INFO("********************************************\n");
+    LOG_INFO("*********    Compact Summary   *************\n");
+    LOG_INFO("********************************************\n");
+    LOG_INFO("Number of threads              : %ld\n", numThreads);
+    LOG_INFO("Total number of phases         : %ld\n", phase);
+    LOG_INFO("Total number of iterations     : %ld\n", totItr);
+    LOG_INFO("Final number of clusters       : %ld\n", numClusters);
+    LOG_INFO("Final modularity               : %lf\n", currMod);
+    LOG_INFO("Total time for clustering      : %lf\n", totTimeClustering);
+    LOG_INFO("Total time for building phases : %lf\n", totTimeBuildingPhase);
+    LOG_INFO("********************************************\n");
+    LOG_INFO("TOTAL TIME                     : %lf\n", (totTimeClustering+totTimeBuildingPhase+totTimeColoring) );
+    LOG_INFO("********************************************\n");
     
     //Clean up:
     free(C);
-    if(G != 0) {
-        free(G->edgeListPtrs);
-        free(G->edgeList);
-        free(G);
+    if((G != 0) && (G != Ginput)) {
+        freeGraph(G);
     }
+    //The kernel reports at least the modularity of the previous phase, even when
+    //sampled iterations lowered it: computed again on the input graph
+    return computeModularity(Ginput, C_orig);
 }//End of runMultiPhaseLouvainAlgorithm()
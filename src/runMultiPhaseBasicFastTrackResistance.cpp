@@ -40,22 +40,25 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "basic_comm.h"
 #include "basic_util.h"
 
 using namespace std;
-//WARNING: This will overwrite the original graph data structure to
-//         minimize memory footprint
 // Return: C_orig will hold the cluster ids for vertices in the original graph
 //         Assume C_orig is initialized appropriately
-//WARNING: Graph G will be destroyed at the end of this routine
+//Graph G still belongs to the caller and is not freed: only the graphs built
+//for later phases are freed here
 //Runs the Louvain algorithm with Fast Track Resistance (Arenas et al., 2012)
 void runMultiPhaseBasicFastTrackResistance(graph *G, long *C_orig, int basicOpt, long minGraphSize,
-                        double threshold, double C_threshold, int numThreads, int threadsOpt)
+                        double threshold, double C_threshold, int numThreads, int threadsOpt,
+                        clusteringStats *stats)
 {
+    ompThreadsScope threadsScope(numThreads); //Also for the steps between the kernels
     double totTimeClustering=0, totTimeBuildingPhase=0, totTimeColoring=0, tmpTime=0;
     int tmpItr=0, totItr = 0;
     long NV = G->numVertices;
+    graph *Ginput = G; //Owned by the caller, never freed here
     double rmin = 0.0;
     double finMod = -1.0;
     
@@ -74,10 +77,14 @@ void runMultiPhaseBasicFastTrackResistance(graph *G, long *C_orig, int basicOpt,
     }
     
     while(1){
-        printf("===============================\n");
-        printf("Phase %ld\n", phase);
-        printf("===============================\n");
+        LOG_INFO("===============================\n");
+        LOG_INFO("Phase %ld\n", phase);
+        LOG_INFO("===============================\n");
         
+        //Statistics of the current phase; the kernel only reports the iteration count
+        phaseStats pStats;
+        if(stats != NULL)
+            initPhaseStats(&pStats, phase, G);
         // TODO add coloring routines when the basic has stabilized
         if(basicOpt == 1){
             currModAFG = parallelLouvianMethodNoMapFastTrackResistance(G, C, numThreads, currModAFG, threshold, &tmpTime, &tmpItr, phase, &rmin, &finMod);
@@ -89,10 +96,15 @@ void runMultiPhaseBasicFastTrackResistance(graph *G, long *C_orig, int basicOpt,
         
         totTimeClustering += tmpTime;
         totItr += tmpItr;
+        if(stats != NULL) {
+            pStats.timeClustering = tmpTime;
+            pStats.numIterations = tmpItr;
+            stats->push_back(pStats);
+        }
         
         //Renumber the clusters contiguously
         numClusters = renumberClustersContiguously(C, G->numVertices);
-        printf("Number of unique clusters: %ld\n", numClusters);
+        LOG_INFO("Number of unique clusters: %ld\n", numClusters);
         
         //Keep track of clusters in C_orig
         if(phase == 1) {
@@ -120,10 +132,12 @@ void runMultiPhaseBasicFastTrackResistance(graph *G, long *C_orig, int basicOpt,
             Gnew = (graph *) malloc (sizeof(graph)); assert(Gnew != 0);
             tmpTime =  buildNextLevelGraphOpt(G, Gnew, C, numClusters, numThreads);
             totTimeBuildingPhase += tmpTime;
-            //Free up the previous graph
-            free(G->edgeListPtrs);
-            free(G->edgeList);
-            free(G);
+            if(stats != NULL)
+                stats->back().timeBuilding = tmpTime;
+            //Free up the previous graph, unless it is the input graph
+            if(G != Ginput) {
+                freeGraph(G);
+            }
             G = Gnew; //Swap the pointers
             G->edgeListPtrs = Gnew->edgeListPtrs;
             G->edgeList = Gnew->edgeList;
@@ -142,26 +156,24 @@ void runMultiPhaseBasicFastTrackResistance(graph *G, long *C_orig, int basicOpt,
         }
     } //End of while(1)
     
-    printf("********************************************\n");
-    printf("*********    Compact Summary   *************\n");
-    printf("********************************************\n");
-    printf("Number of threads              : %ld\n", numThreads);
-    printf("Total number of phases         : %ld\n", phase);
-    printf("Total number of iterations     : %ld\n", totItr);
-    printf("Final number of clusters       : %ld\n", numClusters);
-    printf("Resistance (r_min)             : %lf\n", rmin);
-    printf("Final Modularity               : %lf\n", finMod);
-    printf("Total time for clustering      : %lf\n", totTimeClustering);
-    printf("Total time for building phases : %lf\n", totTimeBuildingPhase);
-    printf("********************************************\n");
-    printf("TOTAL TIME                     : %lf\n", (totTimeClustering+totTimeBuildingPhase+totTimeColoring) );
-    printf("********************************************\n");
+    LOG_INFO("********************************************\n");
+    LOG_INFO("*********    Compact Summary   *************\n");
+    LOG_INFO("********************************************\n");
+    LOG_INFO("Number of threads              : %ld\n", numThreads);
+    LOG_INFO("Total number of phases         : %ld\n", phase);
+    LOG_INFO("Total number of iterations     : %ld\n", totItr);
+    LOG_INFO("Final number of clusters       : %ld\n", numClusters);
+    LOG_INFO("Resistance (r_min)             : %lf\n", rmin);
+    LOG_INFO("Final Modularity               : %lf\n", finMod);
+    LOG_INFO("Total time for clustering      : %lf\n", totTimeClustering);
+    LOG_INFO("Total time for building phases : %lf\n", totTimeBuildingPhase);
+    LOG_INFO("********************************************\n");
+    LOG_INFO("TOTAL TIME                     : %lf\n", (totTimeClustering+totTimeBuildingPhase+totTimeColoring) );
+    LOG_INFO("********************************************\n");
     
     //Clean up:
     free(C);
-    if(G != 0) {
-        free(G->edgeListPtrs);
-        free(G->edgeList);
-        free(G);
+    if((G != 0) && (G != Ginput)) {
+        freeGraph(G);
     }
 }//End of runMultiPhaseLouvainAlgorithm()
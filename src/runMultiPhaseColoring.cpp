@@ -40,23 +40,90 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "basic_comm.h"
 #include "color_comm.h"
 using namespace std;
-//WARNING: This will overwrite the original graph data structure to
-//         minimize memory footprint
+
+//Color the vertices of G with the scheme selected by coloring (1-4)
+//Return: the number of colors (the largest color index plus one)
+static int colorGraph(graph *G, int *colors, int coloring, int numColors, int numThreads, double *totTime)
+{
+    int nColors = 0;
+    *totTime = 0;
+    if((coloring == 1)||(coloring == 2)) {
+        nColors = algoDistanceOneVertexColoringOpt(G, colors, numThreads, totTime)+1;
+        //Check if balanced coloring is enabled:
+        if(coloring == 2)
+            vBaseRedistribution(G, colors, nColors, 0);
+    }
+    //Check if incomplete coloring is requested:
+    if(coloring == 3) {
+        //maxColor = 2 * nHash * nItrs; //Two colors for each hash per iteration
+        int nHash = 2; //Use two hash functions
+        int nItrs = (int) (ceil(numColors / 4)); //Round off to the number of iterations
+        if (nItrs <= 0)
+            nItrs = 1;
+        nColors = algoColoringMultiHashMaxMin(G, colors, numThreads, totTime, nHash, nItrs)+1;
+    }
+    //Degree-ordered (largest degree first) Jones-Plassmann coloring:
+    if(coloring == 4) {
+        nColors = algoDistanceOneVertexColoringLDF(G, colors, numThreads, totTime)+1;
+    }
+    return nColors;
+}//End of colorGraph()
+
+//Seed the colors of the next-level graph from the current coloring: cluster c
+//(vertex c in the next phase) takes the color of its representative, the vertex
+//with the smallest id in the cluster. Assume C has been renumbered contiguously.
+static void seedColorsFromClusters(long NV, long *C, long numClusters, int *colors)
+{
+    long *rep = (long *) malloc (numClusters * sizeof(long)); assert(rep != 0);
+    int *seed = (int *) malloc (numClusters * sizeof(int)); assert(seed != 0);
+#pragma omp parallel for
+    for (long c=0; c<numClusters; c++) {
+        rep[c] = NV;
+    }
+#pragma omp parallel for
+    for (long v=0; v<NV; v++) {
+        long c = C[v];
+        if (c < 0)
+            continue;
+        long cur = rep[c];
+        while ((v < cur) && !__sync_bool_compare_and_swap(&rep[c], cur, v))
+            cur = rep[c];
+    }
+#pragma omp parallel for
+    for (long c=0; c<numClusters; c++) {
+        seed[c] = (rep[c] < NV) ? colors[rep[c]] : -1;
+    }
+#pragma omp parallel for
+    for (long c=0; c<numClusters; c++) {
+        colors[c] = seed[c];
+    }
+    free(rep);
+    free(seed);
+}//End of seedColorsFromClusters()
+
 // Return: C_orig will hold the cluster ids for vertices in the original graph
 //         Assume C_orig is initialized appropriately
-//WARNING: Graph G will be destroyed at the end of this routine
+//Graph G still belongs to the caller and is not freed: only the graphs built
+//for later phases are freed here
+//If incrementalColoring is set, the graphs of later phases are colored by repairing
+//the coloring inherited from the previous phase (coloring 1, 2 and 4)
+//If stats is not NULL, one entry per phase is appended to it
 //void runMultiPhaseColoring(graph *G, long *C_orig, int coloring, int numColors, int replaceMap, long minGraphSize,
 double runMultiPhaseColoring(graph *G, long *C_orig, int coloring, int numColors, int replaceMap, long minGraphSize,
-                           double threshold, double C_threshold, int numThreads, int threadsOpt)
+                           double threshold, double C_threshold, int numThreads, int threadsOpt, int incrementalColoring,
+                           clusteringStats *stats)
 {
+    ompThreadsScope threadsScope(numThreads); //Also for the steps between the kernels
    // printf("Within runMultiPhaseColoring()\n");
-    assert((coloring>0) && (coloring<4)); //Check for the correct coloring specification
+    assert((coloring>0) && (coloring<5)); //Check for the correct coloring specification
     double totTimeClustering=0, totTimeBuildingPhase=0, totTimeColoring=0, tmpTime;
     int tmpItr=0, totItr = 0;
     long NV = G->numVertices;
+    graph *Ginput = G; //Owned by the caller, never freed here
     //long minGraphSize = 100000; //Need at least 100,000 vertices to turn coloring on
 
     int *colors = (int *) malloc (G->numVertices * sizeof(int)); assert (colors != 0);
@@ -64,28 +131,10 @@ double runMultiPhaseColoring(graph *G, long *C_orig, int coloring, int numColors
     for (long i=0; i<G->numVertices; i++) {
         colors[i] = -1;
     }
-    int nColors = 0;
     // Coloring Steps
-    if((coloring == 1)||(coloring == 2)) {
-        nColors = algoDistanceOneVertexColoringOpt(G, colors, numThreads, &tmpTime)+1;
-        totTimeColoring += tmpTime;
-        //printf("Number of colors used: %d\n", nColors);
-        //Check if balanced coloring is enabled:
-        if(coloring == 2)
-            vBaseRedistribution(G, colors, nColors, 0);
-    }
-    //Check if incomplete coloring is requested:
-    if(coloring == 3) {
-        //maxColor = 2 * nHash * nItrs; //Two colors for each hash per iteration
-        int nHash = 2; //Use two hash functions
-        int nItrs = (int) (ceil(numColors / 4)); //Round off to the number of iterations
-        if (nItrs <= 0)
-            nItrs = 1;
-        //int nItrs = numColors / 4;
-        nColors = algoColoringMultiHashMaxMin(G, colors, numThreads, &tmpTime, nHash, nItrs)+1;
-       // printf("Number of colors used: %d\n", nColors);
-        totTimeColoring += tmpTime;
-    }
+    int nColors = colorGraph(G, colors, coloring, numColors, numThreads, &tmpTime);
+    totTimeColoring += tmpTime;
+    double phaseTimeColoring = tmpTime; //Coloring time spent for the current phase
 
     /* Step 3: Find communities */
     double prevMod = -1;
@@ -107,24 +156,39 @@ double runMultiPhaseColoring(graph *G, long *C_orig, int coloring, int numColors
        // printf("Phase %ld\n", phase);
        // printf("===============================\n");
         prevMod = currMod;
+        //Statistics of the current phase, only kept if stats is requested
+        phaseStats pStats;
+        phaseStats *phStats = (stats != NULL) ? &pStats : NULL;
+        if(stats != NULL)
+            initPhaseStats(&pStats, phase, G);
         //Compute clusters
         if(nonColor == false) {
 			//Use higher modularity for the first few iterations when graph is big enough
         	if (replaceMap == 1)
-        		currMod = algoLouvainWithDistOneColoringNoMap(G, C, numThreads, colors, nColors, currMod, C_threshold, &tmpTime, &tmpItr);
+        		currMod = algoLouvainWithDistOneColoringNoMap(G, C, numThreads, colors, nColors, currMod, C_threshold, &tmpTime, &tmpItr, phStats);
         	else
-        	    currMod = algoLouvainWithDistOneColoring(G, C, numThreads, colors, nColors, currMod, C_threshold, &tmpTime, &tmpItr);
+        	    currMod = algoLouvainWithDistOneColoring(G, C, numThreads, colors, nColors, currMod, C_threshold, &tmpTime, &tmpItr, phStats);
             totTimeClustering += tmpTime;
             totItr += tmpItr;
         } else {
 			if (replaceMap == 1)
-		    	currMod = parallelLouvianMethodNoMap(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr);
+		    	currMod = parallelLouvianMethodNoMap(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr, phStats);
         	else
-            	currMod = parallelLouvianMethod(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr);
+            	currMod = parallelLouvianMethod(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr, phStats);
             totTimeClustering += tmpTime;
             totItr += tmpItr;
             nonColor = true;
         }
+        LOG_INFO("Phase %ld: |V|= %ld  colors= %d  coloring time= %3.3lf  Louvain time= %3.3lf  itrs= %d  mod= %lf\n",
+               phase, G->numVertices, (nonColor ? 0 : nColors), phaseTimeColoring, tmpTime, tmpItr, currMod);
+        if(stats != NULL) {
+            pStats.numColors = (nonColor ? 0 : nColors);
+            pStats.timeColoring = phaseTimeColoring;
+            pStats.timeClustering = tmpTime;
+            pStats.numIterations = tmpItr;
+            stats->push_back(pStats);
+        }
+        phaseTimeColoring = 0;
         //Renumber the clusters contiguiously
         numClusters = renumberClustersContiguously(C, G->numVertices);
        // printf("Number of unique clusters: %ld\n", numClusters);
@@ -155,10 +219,21 @@ double runMultiPhaseColoring(graph *G, long *C_orig, int coloring, int numColors
             Gnew = (graph *) malloc (sizeof(graph)); assert(Gnew != 0);
             tmpTime =  buildNextLevelGraphOpt(G, Gnew, C, numClusters, numThreads);
             totTimeBuildingPhase += tmpTime;
-            //Free up the previous graph
-            free(G->edgeListPtrs);
-            free(G->edgeList);
-            free(G);
+            if(stats != NULL)
+                stats->back().timeBuilding = tmpTime;
+            //Incremental recoloring: carry the colors over before C is released
+            bool recolor = (incrementalColoring != 0)&&(coloring != 3)&&
+                           (Gnew->numVertices > minGraphSize)&&(nonColor == false);
+            double seedTime = 0;
+            if(recolor) {
+                seedTime = omp_get_wtime();
+                seedColorsFromClusters(G->numVertices, C, numClusters, colors);
+                seedTime = omp_get_wtime() - seedTime;
+            }
+            //Free up the previous graph, unless it is the input graph
+            if(G != Ginput) {
+                freeGraph(G);
+            }
             G = Gnew; //Swap the pointers
             G->edgeListPtrs = Gnew->edgeListPtrs;
             G->edgeList = Gnew->edgeList;
@@ -171,31 +246,20 @@ double runMultiPhaseColoring(graph *G, long *C_orig, int coloring, int numColors
             }
             phase++; //Increment phase number
             //If coloring is enabled & graph is of minimum size, recolor the new graph
-            if((coloring > 0)&&(G->numVertices > minGraphSize)&&(nonColor == false)){
+            if(recolor) {
+                nColors = algoDistanceOneVertexRecoloring(G, colors, numThreads, &tmpTime)+1;
+                if(coloring == 2)
+                    vBaseRedistribution(G, colors, nColors, 0);
+                totTimeColoring += seedTime + tmpTime;
+                phaseTimeColoring = seedTime + tmpTime;
+            } else if((coloring > 0)&&(G->numVertices > minGraphSize)&&(nonColor == false)){
 #pragma omp parallel for
                 for (long i=0; i<G->numVertices; i++){
                     colors[i] = -1;
                 }
-                nColors = 0;
-                // Coloring Steps
-                if((coloring == 1)||(coloring == 2)) {
-                    nColors = algoDistanceOneVertexColoringOpt(G, colors, numThreads, &tmpTime)+1;
-                    totTimeColoring += tmpTime;
-                    //Check if balanced coloring is enabled:
-                    if(coloring == 2)
-                        vBaseRedistribution(G, colors, nColors, 0);
-                }
-                //Check if incomplete coloring is requested:
-                if(coloring == 3) {
-                    //maxColor = 2 * nHash * nItrs; //Two colors for each hash per iteration
-                    int nHash = 2; //Use two hash functions
-                    int nItrs = (int) (ceil((float)(numColors / 4))); //Round off to the number of iterations
-                    if (nItrs <= 0)
-                        nItrs = 1;
-                    //int nItrs = numColors / 4;
-                    nColors = algoColoringMultiHashMaxMin(G, colors, numThreads, &tmpTime, nHash, nItrs)+1;
-                    totTimeColoring += tmpTime;
-                }
+                nColors = colorGraph(G, colors, coloring, numColors, numThreads, &tmpTime);
+                totTimeColoring += tmpTime;
+                phaseTimeColoring = tmpTime;
             }
         } else { //To force another phase with coloring again
             if ( (coloring > 0)&&(nonColor == false) ) {
@@ -228,10 +292,8 @@ double runMultiPhaseColoring(graph *G, long *C_orig, int coloring, int numColors
 
     //Clean up:
     free(C);
-    if(G != 0) {
-        free(G->edgeListPtrs);
-        free(G->edgeList);
-        free(G);
+    if((G != 0) && (G != Ginput)) {
+        freeGraph(G);
     }
 
     if(coloring > 0) {
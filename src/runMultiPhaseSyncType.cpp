@@ -40,20 +40,25 @@
 // ************************************************************************
 
 #include "defs.h"
+#include "parallel_backend.h"
 #include "sync_comm.h"
 
 using namespace std;
-//WARNING: This will overwrite the original graph data structure to
-//         minimize memory footprint
 // Return: C_orig will hold the cluster ids for vertices in the original graph
 //         Assume C_orig is initialized appropriately
-//WARNING: Graph G will be destroyed at the end of this routine
+//Graph G still belongs to the caller and is not freed: only the graphs built
+//for later phases are freed here
+//The full-sync kernels sort the adjacency lists of G by neighbor id
+//If stats is not NULL, one entry per phase is appended to it
 void runMultiPhaseSyncType(graph *G, long *C_orig, int syncType, long minGraphSize,
-                           double threshold, double C_threshold, int numThreads, int threadsOpt)
+                           double threshold, double C_threshold, int numThreads, int threadsOpt,
+                           clusteringStats *stats)
 {
+    ompThreadsScope threadsScope(numThreads); //Also for the steps between the kernels
     double totTimeClustering=0, totTimeBuildingPhase=0, totTimeColoring=0, tmpTime=0;
     int tmpItr=0, totItr = 0;
     long NV = G->numVertices;
+    graph *Ginput = G; //Owned by the caller, never freed here
     
     
     /* Step 1: Find communities */
@@ -73,38 +78,43 @@ void runMultiPhaseSyncType(graph *G, long *C_orig, int syncType, long minGraphSi
     
     bool nonET = false; //Make sure that at least one phase with lower threshold runs
     while(1){
-        printf("===============================\n");
-        printf("Phase %ld\n", phase);
-        printf("===============================\n");
+        LOG_INFO("===============================\n");
+        LOG_INFO("Phase %ld\n", phase);
+        LOG_INFO("===============================\n");
         prevMod = currMod;
+        //Statistics of the current phase, only kept if stats is requested
+        phaseStats pStats;
+        phaseStats *phStats = (stats != NULL) ? &pStats : NULL;
+        if(stats != NULL)
+            initPhaseStats(&pStats, phase, G);
         //Compute clusters
         if(nonET == false) {
             switch (syncType){
                 case 2:
-                    currMod = parallelLouvainMethodFullSync(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr,syncType, freedom);
+                    currMod = parallelLouvainMethodFullSync(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr,syncType, freedom, phStats);
                     break;
                 case 4:
-                    currMod = parallelLouvainMethodFullSyncEarly(G, C, numThreads, currMod, C_threshold, &tmpTime, &tmpItr,syncType, freedom);
+                    currMod = parallelLouvainMethodFullSyncEarly(G, C, numThreads, currMod, C_threshold, &tmpTime, &tmpItr,syncType, freedom, phStats);
                     break;
                 case 3:
-                    currMod = parallelLouvianMethodEarlyTerminate(G, C, numThreads, currMod, C_threshold, &tmpTime, &tmpItr); break;
+                    currMod = parallelLouvianMethodEarlyTerminate(G, C, numThreads, currMod, C_threshold, &tmpTime, &tmpItr, phStats); break;
                 default:
-                    currMod = parallelLouvainMethodFullSync(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr,syncType, freedom);
+                    currMod = parallelLouvainMethodFullSync(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr,syncType, freedom, phStats);
                     break;
             }
         } else {
             switch (syncType){
                 case 2:
-                    currMod = parallelLouvainMethodFullSync(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr,syncType, freedom);
+                    currMod = parallelLouvainMethodFullSync(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr,syncType, freedom, phStats);
                     break;
                 case 4:
-                    currMod = parallelLouvainMethodFullSyncEarly(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr,syncType, freedom);
+                    currMod = parallelLouvainMethodFullSyncEarly(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr,syncType, freedom, phStats);
                     break;
                 case 3:
-                    currMod = parallelLouvianMethodEarlyTerminate(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr);
+                    currMod = parallelLouvianMethodEarlyTerminate(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr, phStats);
                     break;
                 default:
-                    currMod = parallelLouvainMethodFullSync(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr,syncType, freedom);
+                    currMod = parallelLouvainMethodFullSync(G, C, numThreads, currMod, threshold, &tmpTime, &tmpItr,syncType, freedom, phStats);
                     break;
             }
             nonET = true;
@@ -112,10 +122,15 @@ void runMultiPhaseSyncType(graph *G, long *C_orig, int syncType, long minGraphSi
         
         totTimeClustering += tmpTime;
         totItr += tmpItr;
+        if(stats != NULL) {
+            pStats.timeClustering = tmpTime;
+            pStats.numIterations = tmpItr;
+            stats->push_back(pStats);
+        }
         
         //Renumber the clusters contiguiously
         numClusters = renumberClustersContiguously(C, G->numVertices);
-        printf("Number of unique clusters: %ld\n", numClusters);
+        LOG_INFO("Number of unique clusters: %ld\n", numClusters);
         
         //printf("About to update C_orig\n");
         //Keep track of clusters in C_orig
@@ -132,7 +147,7 @@ void runMultiPhaseSyncType(graph *G, long *C_orig, int syncType, long minGraphSi
                     C_orig[i] = C[C_orig[i]]; //Each cluster in a previous phase becomes a vertex
             }
         }
-        printf("Done updating C_orig\n");
+        LOG_INFO("Done updating C_orig\n");
         
         //Break if too many phases or iterations
         if((phase > 200)||(totItr > 10000)) {
@@ -145,10 +160,12 @@ void runMultiPhaseSyncType(graph *G, long *C_orig, int syncType, long minGraphSi
             Gnew = (graph *) malloc (sizeof(graph)); assert(Gnew != 0);
             tmpTime =  buildNextLevelGraphOpt(G, Gnew, C, numClusters, numThreads);
             totTimeBuildingPhase += tmpTime;
-            //Free up the previous graph
-            free(G->edgeListPtrs);
-            free(G->edgeList);
-            free(G);
+            if(stats != NULL)
+                stats->back().timeBuilding = tmpTime;
+            //Free up the previous graph, unless it is the input graph
+            if(G != Ginput) {
+                freeGraph(G);
+            }
             G = Gnew; //Swap the pointers
             G->edgeListPtrs = Gnew->edgeListPtrs;
             G->edgeList = Gnew->edgeList;
@@ -164,7 +181,7 @@ void runMultiPhaseSyncType(graph *G, long *C_orig, int syncType, long minGraphSi
             phase++; //Increment phase number
         } else { //To force another phase with coloring again
             if ( ((syncType == 3)||(syncType == 4))&&(nonET == false) ) {
-                printf("Forcing ET with lower threshold\n");
+                LOG_INFO("Forcing ET with lower threshold\n");
                 nonET = true; //Run at least one loop of ET routine with smaller threshold
             }
             else {
@@ -174,25 +191,23 @@ void runMultiPhaseSyncType(graph *G, long *C_orig, int syncType, long minGraphSi
         
     } //End of while(1)
     
-    printf("********************************************\n");
-    printf("*********    Compact Summary   *************\n");
-    printf("********************************************\n");
-    printf("Number of threads              : %ld\n", numThreads);
-    printf("Total number of phases         : %ld\n", phase);
-    printf("Total number of iterations     : %ld\n", totItr);
-    printf("Final number of clusters       : %ld\n", numClusters);
-    printf("Final modularity               : %lf\n", prevMod);
-    printf("Total time for clustering      : %lf\n", totTimeClustering);
-    printf("Total time for building phases : %lf\n", totTimeBuildingPhase);
-    printf("********************************************\n");
-    printf("TOTAL TIME                     : %lf\n", (totTimeClustering+totTimeBuildingPhase+totTimeColoring) );
-    printf("********************************************\n");
+    LOG_INFO("********************************************\n");
+    LOG_INFO("*********    Compact Summary   *************\n");
+    LOG_INFO("********************************************\n");
+    LOG_INFO("Number of threads              : %ld\n", numThreads);
+    LOG_INFO("Total number of phases         : %ld\n", phase);
+    LOG_INFO("Total number of iterations     : %ld\n", totItr);
+    LOG_INFO("Final number of clusters       : %ld\n", numClusters);
+    LOG_INFO("Final modularity               : %lf\n", prevMod);
+    LOG_INFO("Total time for clustering      : %lf\n", totTimeClustering);
+    LOG_INFO("Total time for building phases : %lf\n", totTimeBuildingPhase);
+    LOG_INFO("********************************************\n");
+    LOG_INFO("TOTAL TIME                     : %lf\n", (totTimeClustering+totTimeBuildingPhase+totTimeColoring) );
+    LOG_INFO("********************************************\n");
     
     //Clean up:
     free(C);
-    if(G != 0) {
-        free(G->edgeListPtrs);
-        free(G->edgeList);
-        free(G);
+    if((G != 0) && (G != Ginput)) {
+        freeGraph(G);
     }
 }//End of runMultiPhaseLouvainAlgorithm()
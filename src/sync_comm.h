@@ -3,18 +3,20 @@
 
 #include "basic_util.h"
 #include "utilityClusteringFunctions.h"
+#include "clustering_stats.h"
 
 void runMultiPhaseSyncType(graph *G, long *C_orig, int syncType, long minGraphSize,
-			double threshold, double C_threshold, int numThreads, int threadsOpt);
+			double threshold, double C_threshold, int numThreads, int threadsOpt,
+			clusteringStats *stats = NULL);
 
 double parallelLouvainMethodFullSyncEarly(graph *G, long *C, int nThreads, double Lower,
-				double thresh, double *totTime, int *numItr,int ytype, int freedom);
+				double thresh, double *totTime, int *numItr,int ytype, int freedom, phaseStats *stats = NULL);
 				
 double parallelLouvainMethodFullSync(graph *G, long *C, int nThreads, double Lower,
-				double thresh, double *totTime, int *numItr,int ytype, int freedom);
+				double thresh, double *totTime, int *numItr,int ytype, int freedom, phaseStats *stats = NULL);
 				
 double parallelLouvianMethodEarlyTerminate(graph *G, long *C, int nThreads, double Lower,
-				double thresh, double *totTime, int *numItr);
+				double thresh, double *totTime, int *numItr, phaseStats *stats = NULL);
 				
 // Define in fullSyncUtility.cpp
 double buildAndLockLocalMapCounter(long v, mapElement* clusterLocalMap, long* vtxPtr, edge* vtxInd,
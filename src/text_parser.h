@@ -0,0 +1,256 @@
+#ifndef __TEXT_PARSER__
+#define __TEXT_PARSER__
+#include "defs.h"
+#include "graph_builder.h"
+
+//Chunked parallel parsing of text graph files (utilityTextParser.cpp). The file
+//is memory mapped and split into chunks that start at the beginning of a line;
+//threads parse whole chunks with the scanners below, which never read past the
+//end of the mapping (a mapped file is not NUL terminated).
+
+char* mapInputFile(const char *fileName, size_t *length, bool *mapped);
+void unmapInputFile(char *base, size_t length, bool mapped);
+long ingestMemoryLimit();
+
+//Split [begin, end) into numChunks ranges starts[c] .. starts[c+1], each starting
+//at the beginning of a line. Some ranges may be empty.
+long numTextChunks(const char *begin, const char *end);
+void splitTextChunks(const char *begin, const char *end, long numChunks, const char **starts);
+long countTextLines(const char *begin, const char *end);
+
+//The chunks of a text, with the number of lines before every chunk
+typedef struct {
+  long numChunks;
+  const char **starts;  //numChunks+1 chunk boundaries
+  long *firstLine;      //numChunks+1 line counts; firstLine[numChunks] is the total
+} textChunks;
+void splitTextLines(const char *begin, const char *end, textChunks *chunks);
+void freeTextChunks(textChunks *chunks);
+
+inline const char* endOfLine(const char *p, const char *end) {
+  if (p >= end)
+    return end;
+  const char *nl = (const char *) memchr(p, '\n', (size_t) (end - p));
+  return (nl != NULL) ? nl : end;
+}
+
+//Fields are separated by blanks, tabs or commas
+inline bool isFieldSeparator(char c) {
+  return (c == ' ') || (c == '\t') || (c == '\r') || (c == ',') || (c == '\n');
+}
+
+inline const char* skipBlanks(const char *p, const char *end) {
+  while ((p < end) && isFieldSeparator(*p))
+    p++;
+  return p;
+}
+
+//True if only separators remain before end, or a comment starting with one of the
+//characters of comments (may be NULL)
+inline bool atLineEnd(const char *p, const char *end, const char *comments) {
+  p = skipBlanks(p, end);
+  return (p == end) || ((comments != NULL) && (strchr(comments, *p) != NULL));
+}
+
+//Scan a decimal integer after leading separators. Return: false, with *pos
+//unchanged, if there is none
+inline bool scanLong(const char **pos, const char *end, long *value) {
+  const char *p = skipBlanks(*pos, end);
+  bool negative = false;
+  if ((p < end) && ((*p == '-') || (*p == '+'))) {
+    negative = (*p == '-');
+    p++;
+  }
+  const char *digits = p;
+  unsigned long v = 0;
+  while ((p < end) && ((unsigned) (*p - '0') < 10) && (p - digits < 18)) {
+    v = v * 10 + (unsigned) (*p - '0');
+    p++;
+  }
+  if ((p == digits) || ((p < end) && !isFieldSeparator(*p)))
+    return false; //No digits, more than 18, or not an integer
+  *value = negative ? -(long) v : (long) v;
+  *pos = p;
+  return true;
+}
+
+double scanDoubleSlow(const char *p, const char *end, const char **stop);
+
+//Scan a floating point number after leading separators: the mantissa is collected as
+//an integer and scaled by an exact power of ten, which is correctly rounded for
+//up to 15 significant digits and exponents up to 22. Anything else (longer
+//mantissas, larger exponents, inf, nan, hexadecimal) goes to strtod.
+//Return: false, with *pos unchanged, if there is no number
+inline bool scanDouble(const char **pos, const char *end, double *value) {
+  static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                       1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+                                       1e20, 1e21, 1e22};
+  const char *start = skipBlanks(*pos, end);
+  const char *p = start;
+  bool negative = false;
+  if ((p < end) && ((*p == '-') || (*p == '+'))) {
+    negative = (*p == '-');
+    p++;
+  }
+  unsigned long mantissa = 0;
+  int numDigits = 0, scale = 0;
+  while ((p < end) && ((unsigned) (*p - '0') < 10)) {
+    mantissa = mantissa * 10 + (unsigned) (*p - '0');
+    numDigits++;
+    p++;
+  }
+  if ((p < end) && (*p == '.')) {
+    p++;
+    while ((p < end) && ((unsigned) (*p - '0') < 10)) {
+      mantissa = mantissa * 10 + (unsigned) (*p - '0');
+      numDigits++;
+      scale--;
+      p++;
+    }
+  }
+  if ((numDigits == 0) && !((p < end) && isalpha((unsigned char) *p))) //Not inf or nan either
+    return false;
+  if ((p < end) && ((*p == 'e') || (*p == 'E'))) {
+    const char *q = p + 1;
+    bool negativeExponent = false;
+    if ((q < end) && ((*q == '-') || (*q == '+'))) {
+      negativeExponent = (*q == '-');
+      q++;
+    }
+    int exponent = 0;
+    const char *expDigits = q;
+    while ((q < end) && ((unsigned) (*q - '0') < 10) && (q - expDigits < 4)) {
+      exponent = exponent * 10 + (*q - '0');
+      q++;
+    }
+    if (q > expDigits) { //Otherwise the 'e' is not part of the number
+      scale += negativeExponent ? -exponent : exponent;
+      p = q;
+    }
+  }
+  if ((numDigits == 0) || (numDigits > 15) || (scale < -22) || (scale > 22) ||
+      ((p < end) && !isFieldSeparator(*p))) {
+    const char *stop;
+    double slow = scanDoubleSlow(start, end, &stop);
+    if ((stop == start) || ((stop < end) && !isFieldSeparator(*stop)))
+      return false;
+    *value = slow;
+    *pos = stop;
+    return true;
+  }
+  double v = (double) mantissa;
+  v = (scale < 0) ? v / powersOfTen[-scale] : v * powersOfTen[scale];
+  *value = negative ? -v : v;
+  *pos = p;
+  return true;
+}
+
+//Parse the lines of chunk c, calling parseLine(line, lineEnd, &e) for each: it
+//returns 1 if it stored an edge in e, 0 to skip the line and -1 if the line
+//cannot be parsed. visit(e) is called for every edge.
+//Return: -1, or the first line (counted from one) that cannot be parsed
+template <typename F, typename V>
+long parseChunkLines(const textChunks *chunks, long c, F parseLine, V visit) {
+  const char *end = chunks->starts[c+1];
+  long line = chunks->firstLine[c];
+  for (const char *p = chunks->starts[c]; p < end; line++) {
+    const char *lineEnd = endOfLine(p, end);
+    edge e;
+    int r = parseLine(p, lineEnd, &e);
+    if (r < 0)
+      return line + 1;
+    if (r > 0)
+      visit(e);
+    p = lineEnd + 1;
+  }
+  return -1;
+}//End of parseChunkLines()
+
+//Parse the lines of all chunks in parallel into a newly allocated edge list
+//(free() it), with parseLine as for parseChunkLines(). Every chunk writes its
+//edges behind the line count of the chunks before it, so no edge list is grown
+//and the edges keep the order of the file.
+//Return: the number of edges, or -1 with *badLine set to the first line (counted
+//from one) that cannot be parsed
+template <typename F>
+long parseEdgeLines(const textChunks *chunks, F parseLine, edge **edgeList, long *badLine) {
+  long numChunks = chunks->numChunks;
+  long *numFound = (long *) malloc (numChunks * sizeof(long)); assert(numFound != 0);
+  long *firstBad = (long *) malloc (numChunks * sizeof(long)); assert(firstBad != 0);
+  edge *edges = (edge *) malloc ((chunks->firstLine[numChunks] + 1) * sizeof(edge)); assert(edges != 0);
+#pragma omp parallel for schedule(dynamic)
+  for (long c=0; c<numChunks; c++) {
+    edge *out = edges + chunks->firstLine[c];
+    long found = 0;
+    firstBad[c] = parseChunkLines(chunks, c, parseLine, [&](const edge &e) { out[found++] = e; });
+    numFound[c] = found;
+  }
+
+  long NE = 0;
+  *badLine = -1;
+  for (long c=0; c<numChunks; c++) {
+    if (firstBad[c] >= 0) {
+      *badLine = firstBad[c];
+      break;
+    }
+    if (NE != chunks->firstLine[c]) //Close the gaps left by comments and skipped lines
+      memmove(edges + NE, edges + chunks->firstLine[c], numFound[c] * sizeof(edge));
+    NE += numFound[c];
+  }
+  free(numFound);
+  free(firstBad);
+  if (*badLine >= 0) {
+    free(edges);
+    return -1;
+  }
+  *edgeList = edges;
+  return NE;
+}//End of parseEdgeLines()
+
+//Build G from the edges of the chunks, with parseLine as for parseChunkLines()
+//storing vertex ids in [0, NV). If a temporary edge list of one edge per line
+//fits in ingestMemoryLimit(), the edges are parsed once into it; otherwise they
+//are parsed again by each pass of the graph builder instead of being stored,
+//which bounds the memory to the graph itself. allocate is as for
+//buildGraphFromEdgeBlocks().
+//Return: -1, or the first line (counted from one) that cannot be parsed; G is
+//not built in that case, nor if allocate fails (*built is false)
+template <typename F, typename A>
+long buildGraphFromTextChunks(graph *G, long NV, const textChunks *chunks, F parseLine, A allocate,
+                              bool *built) {
+  long numLines = chunks->firstLine[chunks->numChunks];
+  long badLine = -1;
+  *built = false;
+  if ((double) numLines * sizeof(edge) <= (double) ingestMemoryLimit()) {
+    edge *tmpEdgeList; //Every edge stored ONCE
+    long NE = parseEdgeLines(chunks, parseLine, &tmpEdgeList, &badLine);
+    if (NE < 0)
+      return badLine;
+    long numBlocks = (NE + BuildBlockEdges - 1) / BuildBlockEdges;
+    *built = buildGraphFromEdgeBlocks(G, NV, NE, numBlocks, [=](long k, std::vector<edge> &block) {
+        long first = k * BuildBlockEdges;
+        block.assign(tmpEdgeList + first, tmpEdgeList + std::min(first + BuildBlockEdges, NE));
+      }, allocate);
+    free(tmpEdgeList);
+    return -1;
+  }
+  LOG_INFO("Edges do not fit the ingest memory limit: parsing the file in every pass\n");
+  *built = buildGraphFromEdgeBlocks(G, NV, numLines, chunks->numChunks,
+    [&](long c, std::vector<edge> &block) {
+      block.clear();
+      long bad = parseChunkLines(chunks, c, parseLine, [&](const edge &e) { block.push_back(e); });
+      if (bad >= 0) {
+#pragma omp critical
+        {
+          if ((badLine < 0) || (bad < badLine))
+            badLine = bad;
+        }
+      }
+    },
+    [&](long numVertices, long numEntries, long **edgeListPtrs, edge **edgeList) {
+      return (badLine < 0) && allocate(numVertices, numEntries, edgeListPtrs, edgeList);
+    });
+  return badLine;
+}//End of buildGraphFromTextChunks()
+
+#endif
@@ -41,6 +41,7 @@
 
 #include "defs.h"
 #include "utilityClusteringFunctions.h"
+#include "parallel_scan.h"
 #include <algorithm>
 
 using namespace std;
@@ -53,10 +54,10 @@ void computeCommunityComparisons(vector<long>& C1, long N1, vector<long>& C2, lo
     {
         nT = omp_get_num_threads();
     }
-    printf("Within computeCommunityComparisons() with %d threads\n", nT);
+    LOG_INFO("Within computeCommunityComparisons() with %d threads\n", nT);
     
-    printf("Within computeCommunityComparisons() function...\n");
-    printf("WARNING: Assumes that communities are numbered contiguously\n");
+    LOG_INFO("Within computeCommunityComparisons() function...\n");
+    LOG_INFO("WARNING: Assumes that communities are numbered contiguously\n");
     assert(N1>0 && N2>0);
     //Compute number of communities in each set:
     //Assume zero is a valid community id
@@ -109,7 +110,7 @@ void computeCommunityComparisons(vector<long>& C1, long N1, vector<long>& C2, lo
     }//End of for(i)
     if(found)
         nC2++;
-    printf("Number of unique communities in C1= %d, and C2=%d\n", nC1, nC2);
+    LOG_INFO("Number of unique communities in C1= %d, and C2=%d\n", nC1, nC2);
     
     //////////STEP 1: Create a CSR-like datastructure for communities in C1
     long * commPtr1 = (long *) malloc ((nC1+1) * sizeof(long)); assert(commPtr1 != 0);
@@ -137,9 +138,7 @@ void computeCommunityComparisons(vector<long>& C1, long N1, vector<long>& C2, lo
         clusterDist1[i] = commPtr1[i+1]; //Zeroth position is not valid
     }
     //Prefix sum:
-    for(long i=0; i<nC1; i++) {
-        commPtr1[i+1] += commPtr1[i];
-    }
+    parallelInclusiveScan(commPtr1, nC1+1);
     //Group vertices with the same community in particular order
 #pragma omp parallel for
     for (long i=0; i<N1; i++) {
@@ -150,7 +149,7 @@ void computeCommunityComparisons(vector<long>& C1, long N1, vector<long>& C2, lo
         commIndex1[Where] = i; //The vertex id
     }
     free(commAdded1);
-    printf("Done building structure for C1...\n");
+    LOG_INFO("Done building structure for C1...\n");
     
     //////////STEP 2: Create a CSR-like datastructure for communities in C2
     long * commPtr2 = (long *) malloc ((nC2+1) * sizeof(long)); assert(commPtr2 != 0);
@@ -178,9 +177,7 @@ void computeCommunityComparisons(vector<long>& C1, long N1, vector<long>& C2, lo
         clusterDist2[i] = commPtr2[i+1]; //Zeroth position is not valid
     }
     //Prefix sum:
-    for(long i=0; i<nC2; i++) {
-        commPtr2[i+1] += commPtr2[i];
-    }
+    parallelInclusiveScan(commPtr2, nC2+1);
     //Group vertices with the same community in particular order
 #pragma omp parallel for
     for (long i=0; i<N2; i++) {
@@ -191,7 +188,7 @@ void computeCommunityComparisons(vector<long>& C1, long N1, vector<long>& C2, lo
         commIndex2[Where] = i; //The vertex id
     }
     free(commAdded2);
-    printf("Done building structure for C2...\n");
+    LOG_INFO("Done building structure for C2...\n");
     
     //////////STEP 3:  Compute statistics:
     long tSameSame[nT], tSameDiff[nT], tDiffSame[nT], nAgree[nT];
@@ -202,7 +199,7 @@ void computeCommunityComparisons(vector<long>& C1, long N1, vector<long>& C2, lo
         tDiffSame[i] = 0;
         nAgree[i]    = 0;
     }
-    printf("Start parsing C1...\n");
+    LOG_INFO("Start parsing C1...\n");
     //Compare all pairs of vertices from the perspective of C1 (ground truth):
 #pragma omp parallel
     {
@@ -227,8 +224,8 @@ void computeCommunityComparisons(vector<long>& C1, long N1, vector<long>& C2, lo
             }//End of for(i)
         }//End of for(ci)
     }//End of parallel region
-    printf("Done parsing C1...\n");
-    printf("Start parsing C2...\n");
+    LOG_INFO("Done parsing C1...\n");
+    LOG_INFO("Start parsing C2...\n");
 #pragma omp parallel
     {
         int myRank = omp_get_thread_num();
@@ -254,7 +251,7 @@ void computeCommunityComparisons(vector<long>& C1, long N1, vector<long>& C2, lo
             }//End of for(i)
         }//End of for(ci)
     }//End of parallel region
-    printf("Done parsing C2...\n");
+    LOG_INFO("Done parsing C2...\n");
     
     long SameSame = 0, SameDiff = 0, DiffSame = 0, Agree = 0;
 #pragma omp parallel for reduction(+:SameSame) reduction(+:SameDiff) \
@@ -276,25 +273,25 @@ reduction(+:DiffSame) reduction(+:Agree)
     double Gini1 = computeGiniCoefficient(clusterDist1, nC1);
     double Gini2 = computeGiniCoefficient(clusterDist2, nC2);
     
-    printf("*******************************************\n");
-    printf("Cluster comparison statistics: \n");
-    printf("*******************************************\n");
-    printf("|C1| (truth)          : %ld\n", N1);
-    printf("Num communities in C1 : %ld\n", nC1);
-    printf("|C2| (output)         : %ld\n", N2);
-    printf("Num communities in C2 : %ld\n", nC2);
-    printf("-------------------------------------------\n");
-    printf("Same-Same (True positive)  : %ld\n", SameSame);
-    printf("Same-Diff (False negative) : %ld\n", SameDiff);
-    printf("Diff-Same (False positive) : %ld\n", DiffSame);
-    printf("-------------------------------------------\n");
-    printf("Precision             :  %lf (%3.2lf%%)\n", precision, (precision*100));
-    printf("Recall                :  %lf (%3.2lf%%)\n", recall, (recall*100));
-    printf("F-score               :  %lf\n", fScore);
-    printf("-------------------------------------------\n");
-    printf("Gini coefficient, C1  :  %lf \n", Gini1);
-    printf("Gini coefficient, C2  :  %lf \n", Gini2);
-    printf("*******************************************\n");
+    LOG_INFO("*******************************************\n");
+    LOG_INFO("Cluster comparison statistics: \n");
+    LOG_INFO("*******************************************\n");
+    LOG_INFO("|C1| (truth)          : %ld\n", N1);
+    LOG_INFO("Num communities in C1 : %ld\n", nC1);
+    LOG_INFO("|C2| (output)         : %ld\n", N2);
+    LOG_INFO("Num communities in C2 : %ld\n", nC2);
+    LOG_INFO("-------------------------------------------\n");
+    LOG_INFO("Same-Same (True positive)  : %ld\n", SameSame);
+    LOG_INFO("Same-Diff (False negative) : %ld\n", SameDiff);
+    LOG_INFO("Diff-Same (False positive) : %ld\n", DiffSame);
+    LOG_INFO("-------------------------------------------\n");
+    LOG_INFO("Precision             :  %lf (%3.2lf%%)\n", precision, (precision*100));
+    LOG_INFO("Recall                :  %lf (%3.2lf%%)\n", recall, (recall*100));
+    LOG_INFO("F-score               :  %lf\n", fScore);
+    LOG_INFO("-------------------------------------------\n");
+    LOG_INFO("Gini coefficient, C1  :  %lf \n", Gini1);
+    LOG_INFO("Gini coefficient, C2  :  %lf \n", Gini2);
+    LOG_INFO("*******************************************\n");
     
     //Cleanup:
     free(commPtr1); free(commIndex1);
@@ -303,6 +300,67 @@ reduction(+:DiffSame) reduction(+:Agree)
     
 } //End of computeCommunityComparisons()
 
+//Pair-counting precision, recall and F-score of C2 against the truth C1 (the same
+//scores as computeCommunityComparisons()), plus the normalized mutual information
+//2*I(C1,C2)/(H(C1)+H(C2)). Counts come from sorting the (C1,C2) pairs instead of
+//comparing all pairs of vertices within a community, so the cost is O(N log N)
+//whatever the community sizes. Community ids need not be contiguous; vertices with
+//a negative id are singletons.
+static inline double pairsOf(long n) { return 0.5 * (double) n * (double) (n - 1); }
+
+void computeCommunityComparisonScores(long *C1, long *C2, long N, double *precision, double *recall,
+                                      double *fScore, double *nmi) {
+    assert(N > 0);
+    vector< pair<long,long> > cells(N);
+    vector<long> ids2(N);
+#pragma omp parallel for
+    for (long i=0; i<N; i++) {
+        long c1 = (C1[i] >= 0) ? C1[i] : -(i+1); //Unique negative id for a singleton
+        long c2 = (C2[i] >= 0) ? C2[i] : -(i+1);
+        cells[i] = make_pair(c1, c2);
+        ids2[i] = c2;
+    }
+    sort(cells.begin(), cells.end());
+    sort(ids2.begin(), ids2.end());
+
+    //Runs of equal cells give the contingency table, runs of equal C1 ids the truth sizes
+    double sameSame = 0, pairs1 = 0, pairs2 = 0;
+    double H1 = 0, H2 = 0, H12 = 0;
+    double dN = (double) N;
+    long cellSize = 1, size1 = 1;
+    for (long i=1; i<=N; i++) {
+        if ((i < N) && (cells[i] == cells[i-1])) {
+            cellSize++;
+        } else {
+            sameSame += pairsOf(cellSize);
+            H12 -= (cellSize / dN) * log(cellSize / dN);
+            cellSize = 1;
+        }
+        if ((i < N) && (cells[i].first == cells[i-1].first)) {
+            size1++;
+        } else {
+            pairs1 += pairsOf(size1);
+            H1 -= (size1 / dN) * log(size1 / dN);
+            size1 = 1;
+        }
+    }
+    long size2 = 1;
+    for (long i=1; i<=N; i++) {
+        if ((i < N) && (ids2[i] == ids2[i-1])) {
+            size2++;
+        } else {
+            pairs2 += pairsOf(size2);
+            H2 -= (size2 / dN) * log(size2 / dN);
+            size2 = 1;
+        }
+    }
+
+    *precision = (pairs2 > 0) ? sameSame / pairs2 : 0; //SameSame / (SameSame + DiffSame)
+    *recall    = (pairs1 > 0) ? sameSame / pairs1 : 0; //SameSame / (SameSame + SameDiff)
+    *fScore    = ((*precision + *recall) > 0) ? 2 * (*precision * *recall) / (*precision + *recall) : 0;
+    *nmi       = ((H1 + H2) > 0) ? 2 * (H1 + H2 - H12) / (H1 + H2) : 1;
+} //End of computeCommunityComparisonScores()
+
 
 //WARNING: Assume that colorSize is populated with the frequency for each color
 //Will sort the array within the function
@@ -312,14 +370,14 @@ double computeGiniCoefficient(long *colorSize, int numColors) {
     double time1 = omp_get_wtime();
     sort(colorSize, colorSize+numColors);
     double time2 = omp_get_wtime();
-    printf("Time for sorting: %g secs\n", time2-time1);
+    LOG_INFO("Time for sorting: %g secs\n", time2-time1);
     //Step 2: Compute Gini coefficient
     double numFunc=0.0, denFunc=0.0;
     for (long i=0; i < numColors; i++) {
         numFunc = numFunc + ((i+1)*colorSize[i]);
         denFunc = denFunc + colorSize[i];
     }
-    printf("Numerator = %g  Denominator = %g\n", numFunc, denFunc);
+    LOG_INFO("Numerator = %g  Denominator = %g\n", numFunc, denFunc);
     //printf("Negative component = %g\n", ((double)(numColors+1)/(double)numColors));
     double giniCoeff = ((2*numFunc)/(numColors*denFunc)) - ((double)(numColors+1)/(double)numColors);
     
@@ -366,9 +424,7 @@ double computeMerkinMetric(long* C1, long N1, long* C2, long N2) {
         __sync_fetch_and_add(&commPtr1[(long)C1[i]+1],1);
     }
     //Prefix sum:
-    for(long i=0; i<nC1; i++) {
-        commPtr1[i+1] += commPtr1[i];
-    }
+    parallelInclusiveScan(commPtr1, nC1+1);
     //Group vertices with the same color in particular order
 #pragma omp parallel for
     for (long i=0; i<N1; i++) {
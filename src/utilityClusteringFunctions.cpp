@@ -40,6 +40,10 @@
 // ************************************************************************
 
 #include "utilityClusteringFunctions.h"
+#include "parallel_sort.h"
+#include "parallel_scan.h"
+#include <algorithm>
+#include <climits>
 
 using namespace std;
 
@@ -66,19 +70,26 @@ void updateAxForOpt(Comm* cInfo, long* currCommAss, double* vDegree, long NV)
    }
   }
 }
+//Hubs are not split here: every degree is summed in adjacency order, so the
+//results of the kernels do not depend on the number of threads
 void sumVertexDegree(edge* vtxInd, long* vtxPtr, double* vDegree, long NV, Comm* cInfo) {
-#pragma omp parallel for
-  for (long i=0; i<NV; i++) {
-    long adj1 = vtxPtr[i];	    //Begin
-    long adj2 = vtxPtr[i+1];	//End
-    double totalWt = 0;
-    for(long j=adj1; j<adj2; j++) {
-      totalWt += vtxInd[j].weight;
+  vertexSchedule sched;
+  buildVertexSchedule(vtxPtr, NV, omp_get_max_threads(), false, &sched);
+#pragma omp parallel for schedule(static,1)
+  for (int t=0; t<sched.nT; t++) {
+    for (long i=sched.bounds[t]; i<sched.bounds[t+1]; i++) {
+      long adj1 = vtxPtr[i];	    //Begin
+      long adj2 = vtxPtr[i+1];	//End
+      double totalWt = 0;
+      for(long j=adj1; j<adj2; j++) {
+        totalWt += vtxInd[j].weight;
+      }
+      vDegree[i] = totalWt;	//Degree of each node
+      cInfo[i].degree = totalWt;	//Initialize the community
+      cInfo[i].size = 1;
     }
-    vDegree[i] = totalWt;	//Degree of each node
-    cInfo[i].degree = totalWt;	//Initialize the community
-    cInfo[i].size = 1;
   }
+  freeVertexSchedule(&sched);
 }//End of sumVertexDegree()
 
 double calConstantForSecondTerm(double* vDegree, long NV) {
@@ -90,6 +101,275 @@ double calConstantForSecondTerm(double* vDegree, long NV) {
   return (double)1/totalEdgeWeightTwice;
 }//End of calConstantForSecondTerm()
 
+//Modularity of the clustering C of G (cluster ids in [0, NV); negative ids are ignored)
+double computeModularity(graph *G, long *C) {
+  long NV = G->numVertices;
+  long *vtxPtr = G->edgeListPtrs;
+  edge *vtxInd = G->edgeList;
+  double *clusterDegree = (double *) malloc (NV * sizeof(double)); assert(clusterDegree != 0);
+#pragma omp parallel for
+  for (long i=0; i<NV; i++) {
+    clusterDegree[i] = 0;
+  }
+  double e_xx = 0, totalEdgeWeightTwice = 0;
+  vertexSchedule sched;
+  buildVertexSchedule(vtxPtr, NV, omp_get_max_threads(), true, &sched);
+#pragma omp parallel for schedule(static,1) reduction(+:e_xx, totalEdgeWeightTwice)
+  for (int t=0; t<sched.nT; t++) {
+    for (long i=sched.bounds[t]; i<sched.bounds[t+1]; i++) {
+      if (isHub(&sched, vtxPtr, i))
+        continue;
+      double degree = 0;
+      for (long j=vtxPtr[i]; j<vtxPtr[i+1]; j++) {
+        degree += vtxInd[j].weight;
+        if ((C[i] >= 0) && (C[vtxInd[j].tail] == C[i]))
+          e_xx += vtxInd[j].weight;
+      }
+      totalEdgeWeightTwice += degree;
+      if (C[i] >= 0) {
+        assert(C[i] < NV);
+        #pragma omp atomic update
+        clusterDegree[C[i]] += degree;
+      }
+    }
+  }
+  for (long h=0; h<sched.numHubs; h++) {
+    long i = sched.hubs[h];
+    double degree = 0, internal = 0;
+#pragma omp parallel for reduction(+:degree, internal)
+    for (long j=vtxPtr[i]; j<vtxPtr[i+1]; j++) {
+      degree += vtxInd[j].weight;
+      if ((C[i] >= 0) && (C[vtxInd[j].tail] == C[i]))
+        internal += vtxInd[j].weight;
+    }
+    e_xx += internal;
+    totalEdgeWeightTwice += degree;
+    if (C[i] >= 0) {
+      assert(C[i] < NV);
+      clusterDegree[C[i]] += degree;
+    }
+  }
+  freeVertexSchedule(&sched);
+  double a2_x = 0;
+#pragma omp parallel for reduction(+:a2_x)
+  for (long i=0; i<NV; i++) {
+    a2_x += clusterDegree[i] * clusterDegree[i];
+  }
+  free(clusterDegree);
+  if (totalEdgeWeightTwice == 0)
+    return 0;
+  double constant = 1 / totalEdgeWeightTwice;
+  return (e_xx * constant) - (a2_x * constant * constant);
+}//End of computeModularity()
+
+//Add community c to the list of communities with pending updates (once per color class)
+void markCommunityChanged(long c, char* commChanged, long* changedList, long* numChanged) {
+  if( (commChanged[c] == 0) && __sync_bool_compare_and_swap(&commChanged[c], 0, 1) ) {
+    long where = __sync_fetch_and_add(numChanged, 1);
+    changedList[where] = c;
+  }
+}//End of markCommunityChanged()
+
+//Fold the pending updates into cInfo and reset cUpdate, touching only the changed communities
+void applyChangedCommunities(Comm* cInfo, Comm* cUpdate, char* commChanged, long* changedList, long numChanged) {
+#pragma omp parallel for if(numChanged > ColorClassMinWork)
+  for (long k=0; k<numChanged; k++) {
+    long c = changedList[k];
+    cInfo[c].size   += cUpdate[c].size;
+    cInfo[c].degree += cUpdate[c].degree;
+    cUpdate[c].size   = 0;
+    cUpdate[c].degree = 0;
+    commChanged[c]    = 0;
+  }
+}//End of applyChangedCommunities()
+
+//Work of the vertices in colorIndex order: workPrefix[K+1]-workPrefix[K] is the
+//work (degree + 1) of vertex colorIndex[K], one for the hubs of sched, which are
+//processed apart. workPrefix should have NV+1 entries.
+void buildColorClassWork(long* colorIndex, long* vtxPtr, long NV, const vertexSchedule* sched, long* workPrefix) {
+  workPrefix[0] = 0;
+#pragma omp parallel for
+  for (long K=0; K<NV; K++) {
+    long i = colorIndex[K];
+    workPrefix[K+1] = isHub(sched, vtxPtr, i) ? 1 : (vtxPtr[i+1] - vtxPtr[i] + 1);
+  }
+  //Prefix sum:
+  parallelInclusiveScan(workPrefix, NV+1);
+}//End of buildColorClassWork()
+
+//Split the color class [colorAdj1, colorAdj2) of colorIndex into nT ranges of
+//about the same work; thread tid processes positions [*kBegin, *kEnd)
+void colorClassThreadRange(long* workPrefix, long colorAdj1, long colorAdj2,
+                           int tid, int nT, long* kBegin, long* kEnd) {
+  long base  = workPrefix[colorAdj1];
+  long total = workPrefix[colorAdj2] - base;
+  long lo = base + (total * tid) / nT;
+  long hi = base + (total * (tid+1)) / nT;
+  *kBegin = lower_bound(workPrefix+colorAdj1, workPrefix+colorAdj2+1, lo) - workPrefix;
+  *kEnd   = lower_bound(workPrefix+colorAdj1, workPrefix+colorAdj2+1, hi) - workPrefix;
+}//End of colorClassThreadRange()
+
+//Work of the vertices before i, hubs counting one unit each
+static long scheduleWork(const vertexSchedule* sched, const long* vtxPtr, long i) {
+  long k = lower_bound(sched->hubs, sched->hubs + sched->numHubs, i) - sched->hubs; //Hubs before i
+  return vtxPtr[i] + i - sched->hubExcess[k];
+}
+
+//Find the hubs (with splitHubs and more than one thread) and split the remaining
+//work into nT ranges by binary search on the work prefix; the prefix is not stored
+//as the hubs are few (at most 2*nT): it is vtxPtr[i] + i less the hub edges before i
+void buildVertexSchedule(const long* vtxPtr, long NV, int nT, bool splitHubs, vertexSchedule* sched) {
+  assert(nT >= 1);
+  sched->nT        = nT;
+  sched->bounds    = (long *) malloc ((nT+1) * sizeof(long)); assert(sched->bounds != 0);
+  sched->hubs      = (long *) malloc (2 * nT * sizeof(long)); assert(sched->hubs != 0);
+  sched->hubExcess = (long *) malloc ((2*nT + 1) * sizeof(long)); assert(sched->hubExcess != 0);
+  sched->bestCid   = (long *) malloc (nT * sizeof(long)); assert(sched->bestCid != 0);
+  sched->bestGain  = (double *) malloc (nT * sizeof(double)); assert(sched->bestGain != 0);
+  sched->scratch   = NULL;
+  sched->numHubs   = 0;
+  sched->hubDegree = LONG_MAX;
+  long totalWork = vtxPtr[NV] + NV;
+  if (splitHubs && (nT > 1)) {
+    //Rounded up, so that fewer than 2*nT vertices can reach it
+    sched->hubDegree = max((long)HubMinDegree, (totalWork + 2*nT - 1) / (2*nT));
+    long numHubs = 0;
+#pragma omp parallel for
+    for (long i=0; i<NV; i++) {
+      if (isHub(sched, vtxPtr, i))
+        sched->hubs[__sync_fetch_and_add(&numHubs, 1)] = i;
+    }
+    sched->numHubs = numHubs;
+    sort(sched->hubs, sched->hubs + numHubs);
+  }
+  long maxHubDegree = 0;
+  sched->hubExcess[0] = 0;
+  for (long k=0; k<sched->numHubs; k++) {
+    long degree = vtxPtr[sched->hubs[k]+1] - vtxPtr[sched->hubs[k]];
+    sched->hubExcess[k+1] = sched->hubExcess[k] + degree;
+    maxHubDegree = max(maxHubDegree, degree);
+  }
+  if (maxHubDegree > 0) {
+    sched->scratch = (hubEdge *) malloc (maxHubDegree * sizeof(hubEdge)); assert(sched->scratch != 0);
+  }
+  totalWork -= sched->hubExcess[sched->numHubs];
+  sched->bounds[0]  = 0;
+  sched->bounds[nT] = NV;
+  for (int t=1; t<nT; t++) {
+    long target = (totalWork * t) / nT;
+    long lo = sched->bounds[t-1], hi = NV; //First vertex with at least target work before it
+    while (lo < hi) {
+      long mid = lo + (hi - lo) / 2;
+      if (scheduleWork(sched, vtxPtr, mid) < target) lo = mid + 1;
+      else hi = mid;
+    }
+    sched->bounds[t] = lo;
+  }
+  if (sched->numHubs > 0)
+    LOG_DEBUG("Edge-balanced schedule: %d ranges of about %ld units, %ld hubs of degree >= %ld\n",
+              nT, totalWork / nT, sched->numHubs, sched->hubDegree);
+}//End of buildVertexSchedule()
+
+void freeVertexSchedule(vertexSchedule* sched) {
+  free(sched->bounds);
+  free(sched->hubs);
+  free(sched->hubExcess);
+  free(sched->scratch);
+  free(sched->bestCid);
+  free(sched->bestGain);
+}//End of freeVertexSchedule()
+
+static bool hubEdgeLess(const hubEdge &a, const hubEdge &b) {
+  return (a.cid < b.cid) || ((a.cid == b.cid) && (a.pos < b.pos));
+}
+
+//Best community of the hub v, with all the threads: the same move as building the
+//local map and calling maxNoMap() (or max()). The edges are sorted by community and
+//position, so each community sums its weights in adjacency order as the local map
+//does, and the gains of the communities are compared in parallel with the same
+//tie-breaking. *ownWeight receives the weight to the current community (e_ix).
+long hubBestCommunity(vertexSchedule* sched, long v, long* vtxPtr, edge* vtxInd, long* currCommAss,
+                      Comm* cInfo, double degree, double constant, double* ownWeight) {
+  int  nT = sched->nT;
+  long adj1 = vtxPtr[v];
+  long numEdges = vtxPtr[v+1] - adj1;
+  long sc = currCommAss[v];
+  hubEdge *e = sched->scratch;
+#pragma omp parallel for num_threads(nT)
+  for (long k=0; k<numEdges; k++) {
+    e[k].cid = currCommAss[vtxInd[adj1+k].tail];
+    e[k].pos = k;
+  }
+  parallelSort(e, numEdges, hubEdgeLess);
+
+  //Edges to the current community (self loops included):
+  hubEdge first = {sc, 0};
+  double eSelf = 0, selfLoop = 0;
+  for (long k=lower_bound(e, e+numEdges, first, hubEdgeLess) - e; (k<numEdges) && (e[k].cid==sc); k++) {
+    edge *x = &vtxInd[adj1 + e[k].pos];
+    if (x->tail == v)
+      selfLoop += x->weight;
+    eSelf += x->weight;
+  }
+  double eix = eSelf - selfLoop;
+  double ax  = cInfo[sc].degree - degree;
+
+  //Each range evaluates the communities whose first edge it holds
+#pragma omp parallel for schedule(static,1) num_threads(nT)
+  for (int t=0; t<nT; t++) {
+    long   maxIndex = sc;
+    double maxGain  = 0;
+    for (long k=(numEdges*t)/nT; k<(numEdges*(t+1))/nT; k++) {
+      long y = e[k].cid;
+      if ((y == sc) || ((k > 0) && (e[k-1].cid == y)))
+        continue;
+      double eiy = 0;
+      for (long l=k; (l<numEdges) && (e[l].cid==y); l++)
+        eiy += vtxInd[adj1 + e[l].pos].weight;
+      double ay = cInfo[y].degree;
+      double curGain = 2*(eiy - eix) - 2*degree*(ay - ax)*constant;
+      if( (curGain > maxGain) || ((curGain==maxGain) && (curGain != 0) && (y < maxIndex)) ) {
+        maxGain  = curGain;
+        maxIndex = y;
+      }
+    }
+    sched->bestCid[t]  = maxIndex;
+    sched->bestGain[t] = maxGain;
+  }
+  long   maxIndex = sc;
+  double maxGain  = 0;
+  for (int t=0; t<nT; t++) {
+    double curGain = sched->bestGain[t];
+    if( (curGain > maxGain) || ((curGain==maxGain) && (curGain != 0) && (sched->bestCid[t] < maxIndex)) ) {
+      maxGain  = curGain;
+      maxIndex = sched->bestCid[t];
+    }
+  }
+  if(cInfo[maxIndex].size == 1 && cInfo[sc].size ==1 && maxIndex > sc) { //Swap protection
+    maxIndex = sc;
+  }
+  *ownWeight = eSelf;
+  return maxIndex;
+}//End of hubBestCommunity()
+
+double threadImbalance(double* threadBusy, int nT) {
+  double maxBusy = 0, sumBusy = 0;
+  for (int t=0; t<nT; t++) {
+    sumBusy += threadBusy[t];
+    if (threadBusy[t] > maxBusy) maxBusy = threadBusy[t];
+  }
+  return (sumBusy > 0) ? (nT * maxBusy / sumBusy) : 1;
+}//End of threadImbalance()
+
+double threadIdleTime(double* threadBusy, int nT) {
+  double maxBusy = 0, sumBusy = 0;
+  for (int t=0; t<nT; t++) {
+    sumBusy += threadBusy[t];
+    if (threadBusy[t] > maxBusy) maxBusy = threadBusy[t];
+  }
+  return nT * maxBusy - sumBusy;
+}//End of threadIdleTime()
+
 void initCommAss(long* pastCommAss, long* currCommAss, long NV) {
 #pragma omp parallel for
   for (long i=0; i<NV; i++) {
@@ -50,6 +50,49 @@ void sumVertexDegree(edge* vtxInd, long* vtxPtr, double* vDegree, long NV, Comm*
 
 double calConstantForSecondTerm(double* vDegree, long NV);
 
+double computeModularity(graph *G, long *C);
+
+//Bookkeeping for communities changed within a color class (used by the coloring-based kernels)
+void markCommunityChanged(long c, char* commChanged, long* changedList, long* numChanged);
+void applyChangedCommunities(Comm* cInfo, Comm* cUpdate, char* commChanged, long* changedList, long numChanged);
+
+//Edge-balanced scheduling of the vertices (used by the kernels): range t holds the
+//vertices [bounds[t], bounds[t+1]), about 1/nT of the work (degree + 1). Hubs, vertices
+//with more than half a range of work, count as one unit: they are skipped in the
+//ranges and processed one at a time by all the threads, splitting their adjacency.
+#define HubMinDegree 4096
+typedef struct {
+  long cid;  //Community of the tail
+  long pos;  //Position in the adjacency of the hub
+} hubEdge;
+typedef struct {
+  int     nT;
+  long    *bounds;    //nT+1 entries
+  long    hubDegree;  //Vertices of this degree or more are hubs
+  long    numHubs;
+  long    *hubs;      //Increasing ids
+  long    *hubExcess; //hubExcess[k]: edges of the first k hubs, left out of the ranges
+  hubEdge *scratch;   //Edges of the hub being processed, sorted by community
+  long    *bestCid;   //Per-range best move of the hub being processed
+  double  *bestGain;
+} vertexSchedule;
+void buildVertexSchedule(const long* vtxPtr, long NV, int nT, bool splitHubs, vertexSchedule* sched);
+void freeVertexSchedule(vertexSchedule* sched);
+inline bool isHub(const vertexSchedule* sched, const long* vtxPtr, long i) {
+  return (vtxPtr[i+1] - vtxPtr[i]) >= sched->hubDegree;
+}
+long hubBestCommunity(vertexSchedule* sched, long v, long* vtxPtr, edge* vtxInd, long* currCommAss,
+                      Comm* cInfo, double degree, double constant, double* ownWeight);
+double threadImbalance(double* threadBusy, int nT); //Busiest range over the mean
+double threadIdleTime(double* threadBusy, int nT);  //Time the others wait for the busiest range
+
+//Degree-weighted scheduling of color classes (used by the coloring-based kernels):
+//a color class gets one thread per ColorClassMinWork units of work (edges + vertices)
+#define ColorClassMinWork 4096
+void buildColorClassWork(long* colorIndex, long* vtxPtr, long NV, const vertexSchedule* sched, long* workPrefix);
+void colorClassThreadRange(long* workPrefix, long colorAdj1, long colorAdj2,
+                           int tid, int nT, long* kBegin, long* kEnd);
+
 void initCommAss(long* pastCommAss, long* currCommAss, long NV);
 
 void initCommAssOpt(long* pastCommAss, long* currCommAss, long NV, 
@@ -69,6 +112,8 @@ long maxNoMap(long v, mapElement* clusterLocalMap, long* vtxPtr, double selfLoop
               long sc, double constant, long numUniqueClusters );
 
 void computeCommunityComparisons(vector<long>& C1, long N1, vector<long>& C2, long N2);
+void computeCommunityComparisonScores(long *C1, long *C2, long N, double *precision, double *recall,
+                                      double *fScore, double *nmi);
 
 double computeGiniCoefficient(long *colorSize, int numColors);
 double computeMerkinMetric(long* C1, long N1, long* C2, long N2);
@@ -81,7 +81,7 @@ void heapRemoveMin(heap *myHeap) {
         data[0].weight = data[myHeap->size-1].weight;
         myHeap->size--; //Decrement the size to reflect the deletion
     } else {
-        printf("Within heapRemoveMin(): Heap is empty\n");
+        LOG_DEBUG("Within heapRemoveMin(): Heap is empty\n");
     }
     //Rebuild the heap only if it is still not empty
     if ( myHeap->size > 0 ){
@@ -40,38 +40,23 @@
 // ************************************************************************
 
 #include "defs.h"
-#include "RngStream.h"
+#include "basic_util.h"
+#include "graph_builder.h"
+#include "utilityClusteringFunctions.h"
+#include "parallel_scan.h"
+#include <vector>
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 using namespace std;
 
+//Uniform random numbers in [0,1); the same for any number of threads
 void generateRandomNumbers(double *RandVec, long size) {
-    int nT;
-#pragma omp parallel
-    {
-        nT = omp_get_num_threads();
+#pragma omp parallel for schedule(static)
+    for (long i=0; i<size; i++) {
+        RandVec[i] = hashRandomU01(i, RandomSeed, 0);
     }
-#ifdef PRINT_DETAILED_STATS_
-    //printf("Within generateRandomNumbers() -- Number of threads: %d\n", nT);
-#endif
-    //Initialize parallel pseudo-random number generator
-    unsigned long seed[6] = {1, 2, 3, 4, 5, 6};
-    RngStream::SetPackageSeed(seed);
-    RngStream RngArray[nT]; //array of RngStream Objects
-    
-    long block = size / nT;
-#ifdef PRINT_DETAILED_STATS_
-    //cout<<"Each thread will add "<<block<<" edges\n";
-#endif
-    //Each thread will generate m/nT edges each
-    double start = omp_get_wtime();
-#pragma omp parallel
-    {
-        int myRank = omp_get_thread_num();
-#pragma omp for schedule(static)
-        for (long i=0; i<size; i++) {
-            RandVec[i] =  RngArray[myRank].RandU01();
-        }
-    }//End of parallel region
 } //End of generateRandomNumbers()
 
 void displayGraph(graph *G) {
@@ -79,18 +64,18 @@ void displayGraph(graph *G) {
     long    NE        = G->numEdges;
     long    *vtxPtr   = G->edgeListPtrs;
     edge    *vtxInd   = G->edgeList;
-    printf("***********************************");
-    printf("|V|= %ld, |E|= %ld \n", NV, NE);
-    printf("***********************************");
+    LOG_INFO("***********************************");
+    LOG_INFO("|V|= %ld, |E|= %ld \n", NV, NE);
+    LOG_INFO("***********************************");
     for (long i = 0; i < NV; i++) {
         long adj1 = vtxPtr[i];
         long adj2 = vtxPtr[i+1];
-        printf("\nVtx: %ld [%ld]: ",i+1,adj2-adj1);
+        LOG_INFO("\nVtx: %ld [%ld]: ",i+1,adj2-adj1);
         for(long j=adj1; j<adj2; j++) {
-            printf("%ld (%g), ", vtxInd[j].tail+1, vtxInd[j].weight);
+            LOG_INFO("%ld (%g), ", vtxInd[j].tail+1, vtxInd[j].weight);
         }
     }
-    printf("\n***********************************\n");
+    LOG_INFO("\n***********************************\n");
 }
 
 void duplicateGivenGraph(graph *Gin, graph *Gout) {
@@ -134,21 +119,213 @@ void duplicateGivenGraph(graph *Gin, graph *Gout) {
     Gout->edgeList     = edgeList;
 } //End of duplicateGivenGraph()
 
+//Free a graph allocated with malloc(), as built by the parsers, duplicateGivenGraph()
+//and the builders of the next phase, with its CSR arrays
+void freeGraph(graph *G) {
+    if (G == NULL)
+        return;
+    free(G->edgeListPtrs);
+    free(G->edgeList);
+    free(G);
+} //End of freeGraph()
+
+//Write the edges of every vertex with the edge-balanced schedule of the kernels
+//(the adjacency of a hub in one slice per thread), so that their pages are local
+//to the thread that will process them
+void firstTouchEdges(edge *edgeList, const long *edgeListPtrs, long NV) {
+    vertexSchedule sched;
+    buildVertexSchedule(edgeListPtrs, NV, omp_get_max_threads(), true, &sched);
+#pragma omp parallel for schedule(static,1)
+    for (int t = 0; t < sched.nT; t++) {
+        for (long i = sched.bounds[t]; i < sched.bounds[t+1]; i++)
+            if (!isHub(&sched, edgeListPtrs, i))
+                memset(edgeList + edgeListPtrs[i], 0, (edgeListPtrs[i+1] - edgeListPtrs[i]) * sizeof(edge));
+    }
+    for (long h = 0; h < sched.numHubs; h++) {
+        long first = edgeListPtrs[sched.hubs[h]];
+        long numEdges = edgeListPtrs[sched.hubs[h]+1] - first;
+#pragma omp parallel for schedule(static,1)
+        for (int t = 0; t < sched.nT; t++) {
+            long k1 = first + (numEdges * t) / sched.nT, k2 = first + (numEdges * (t+1)) / sched.nT;
+            memset(edgeList + k1, 0, (k2 - k1) * sizeof(edge));
+        }
+    }
+    freeVertexSchedule(&sched);
+} //End of firstTouchEdges()
+
+//Pin the OpenMP threads of a team of omp_get_max_threads() to CPUs allowed to
+//the process when first called: with BindClose thread t runs on the t-th of
+//them, with BindSpread the threads are spread evenly over them (over both
+//sockets when the CPUs of a socket are numbered together), BindNone lets them
+//run anywhere again. Pinned threads keep the pages they first touch local.
+//The calling thread, thread 0 of the team, is never pinned: threads created
+//later inherit its mask, such as the TBB workers or the extra threads of a
+//larger OpenMP team, and they would all share its CPU.
+//cpuOfThread, if not NULL, receives the CPU of every thread (-1 if unbound).
+//Return: the number of threads, -1 if the threads could not be bound
+int bindThreads(int bind, int *cpuOfThread) {
+#ifdef __linux__
+    static cpu_set_t allowed;
+    static bool haveAllowed = false;
+    if (!haveAllowed) {
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+            return -1;
+        haveAllowed = true;
+    }
+    std::vector<int> cpus;
+    for (int c = 0; c < CPU_SETSIZE; c++)
+        if (CPU_ISSET(c, &allowed))
+            cpus.push_back(c);
+    int nT = omp_get_max_threads();
+    int numCpus = (int) cpus.size();
+    bool ok = (numCpus > 0);
+#pragma omp parallel num_threads(nT) reduction(&&: ok)
+    {
+        int t = omp_get_thread_num();
+        int cpu = -1;
+        cpu_set_t mask = allowed;
+        if ((bind != BindNone) && (numCpus > 0) && (t > 0)) {
+            cpu = (bind == BindClose) ? cpus[t % numCpus] : cpus[((long) t * numCpus / nT) % numCpus];
+            CPU_ZERO(&mask);
+            CPU_SET(cpu, &mask);
+        }
+        ok = (sched_setaffinity(0, sizeof(mask), &mask) == 0); //0: the calling thread
+        if (cpuOfThread != NULL)
+            cpuOfThread[t] = cpu;
+    }
+    if (ok)
+        LOG_INFO("Bound %d threads to %d CPUs (mode %d)\n", nT, numCpus, bind);
+    return ok ? nT : -1;
+#else
+    return -1;
+#endif
+} //End of bindThreads()
+
+//Edge entries per bucket of the graph builder: a bucket and the edge pointers
+//of its vertices stay in cache while it is sorted by vertex
+#define BuildBucketEntries  (1L << 16)
+
+//Buckets of about BuildBucketEntries entries for expectedEdges edges
+void initEdgeBuckets(edgeBuckets *eb, long NV, long expectedEdges) {
+    int shift = 0;
+    while (((1L << shift) < NV) &&
+           ((double) 2*expectedEdges * (1L << shift) < (double) BuildBucketEntries * NV))
+        shift++;
+    eb->shift = shift;
+    eb->numBuckets = (NV > 0) ? ((NV - 1) >> shift) + 1 : 1;
+    eb->numParts = omp_get_max_threads();
+    eb->partPos = (long *) malloc(eb->numParts * eb->numBuckets * sizeof(long));
+    assert(eb->partPos != NULL);
+    eb->bucketStart = (long *) malloc((eb->numBuckets+1) * sizeof(long));
+    assert(eb->bucketStart != NULL);
+}//End of initEdgeBuckets()
+
+//Turn the counts of every part into its first position in every bucket: the
+//entries of part p follow those of parts < p
+//Return: the number of entries
+long startEdgeBuckets(edgeBuckets *eb) {
+    long pos = 0;
+    for (long b = 0; b < eb->numBuckets; b++) {
+        eb->bucketStart[b] = pos;
+        for (long p = 0; p < eb->numParts; p++) {
+            long count = eb->partPos[p * eb->numBuckets + b];
+            eb->partPos[p * eb->numBuckets + b] = pos;
+            pos += count;
+        }
+    }
+    eb->bucketStart[eb->numBuckets] = pos;
+    return pos;
+}//End of startEdgeBuckets()
+
+//The entries of every part are spread over all the buckets: place the pages of
+//the edge list bucket by bucket first, as the kernels will read it vertex by vertex
+void firstTouchEdgeBuckets(edgeBuckets *eb, long NV, long *edgeListPtr, edge *edgeList) {
+#pragma omp parallel for schedule(static)
+    for (long i = 0; i <= NV; i++)
+        edgeListPtr[i] = 0;
+#pragma omp parallel for schedule(static)
+    for (long b = 0; b < eb->numBuckets; b++)
+        memset(edgeList + eb->bucketStart[b], 0, (eb->bucketStart[b+1] - eb->bucketStart[b]) * sizeof(edge));
+}//End of firstTouchEdgeBuckets()
+
+//Sort every bucket by vertex, stably, set the edge pointers of its vertices and
+//free the buckets
+void sortEdgeBuckets(edgeBuckets *eb, long NV, long *edgeListPtr, edge *edgeList) {
+    int shift = eb->shift;
+    edgeListPtr[NV] = eb->bucketStart[eb->numBuckets];
+#pragma omp parallel
+    {
+        long *added = (long *) malloc(((1L << shift) + 1) * sizeof(long));
+        assert(added != NULL);
+        edge *bucket = NULL;
+        long bucketSize = 0;
+#pragma omp for schedule(dynamic)
+        for (long b = 0; b < eb->numBuckets; b++) {
+            long vFirst = b << shift;
+            long vLast = min(vFirst + (1L << shift), NV);
+            long start = eb->bucketStart[b], size = eb->bucketStart[b+1] - start;
+            if (vFirst >= vLast)
+                continue;
+            if (size > bucketSize) {
+                free(bucket);
+                bucket = (edge *) malloc(size * sizeof(edge));
+                assert(bucket != NULL);
+                bucketSize = size;
+            }
+            memcpy(bucket, edgeList + start, size * sizeof(edge));
+            for (long v = 0; v <= vLast - vFirst; v++)
+                added[v] = 0;
+            for (long i = 0; i < size; i++)
+                added[bucket[i].head - vFirst + 1]++;
+            for (long v = 0; v < vLast - vFirst; v++) {
+                added[v+1] += added[v]; //Prefix Sum
+                edgeListPtr[vFirst + v] = start + added[v];
+            }
+            for (long i = 0; i < size; i++)
+                edgeList[start + added[bucket[i].head - vFirst]++] = bucket[i];
+        }
+        free(bucket);
+        free(added);
+    }
+    free(eb->partPos);
+    free(eb->bucketStart);
+}//End of sortEdgeBuckets()
+
+bool allocateGraphMemory(long NV, long numEntries, long **edgeListPtrs, edge **edgeList) {
+    *edgeListPtrs = (long *) malloc((NV+1) * sizeof(long));
+    assert(*edgeListPtrs != NULL);
+    *edgeList = (edge *) malloc((numEntries+1) * sizeof(edge));
+    assert(*edgeList != NULL);
+    return true;
+}
+
+//Build G in CSR form from NE edges stored once (head, tail in [0, NV)):
+//every edge is stored twice in G, once for each endpoint, and the adjacency of a
+//vertex lists its edges in the order of tmpEdgeList (graph_builder.h)
+void buildGraphFromEdgeList(graph *G, long NV, long NE, edge *tmpEdgeList) {
+    long numBlocks = (NE + BuildBlockEdges - 1) / BuildBlockEdges;
+    buildGraphFromEdgeBlocks(G, NV, NE, numBlocks, [=](long k, std::vector<edge> &block) {
+        long first = k * BuildBlockEdges;
+        block.assign(tmpEdgeList + first, tmpEdgeList + min(first + BuildBlockEdges, NE));
+    });
+} //End of buildGraphFromEdgeList()
+
 void displayGraphEdgeList(graph *G) {
     long    NV        = G->numVertices;
     long    NE        = G->numEdges;
     long    *vtxPtr   = G->edgeListPtrs;
     edge    *vtxInd   = G->edgeList;
-    printf("***********************************");
-    printf("|V|= %ld, |E|= %ld \n", NV, NE);
+    LOG_INFO("***********************************");
+    LOG_INFO("|V|= %ld, |E|= %ld \n", NV, NE);
     for (long i = 0; i < NV; i++) {
         long adj1 = vtxPtr[i];
         long adj2 = vtxPtr[i+1];
         for(long j=adj1; j<adj2; j++) {
-            printf("%ld %ld %g\n", i+1, vtxInd[j].tail+1, vtxInd[j].weight);
+            LOG_INFO("%ld %ld %g\n", i+1, vtxInd[j].tail+1, vtxInd[j].weight);
         }
     }
-    printf("\n***********************************\n");
+    LOG_INFO("\n***********************************\n");
 }
 
 void displayGraphEdgeList(graph *G, FILE* out) {
@@ -156,7 +333,7 @@ void displayGraphEdgeList(graph *G, FILE* out) {
     long    NE        = G->numEdges;
     long    *vtxPtr   = G->edgeListPtrs;
     edge    *vtxInd   = G->edgeList;
-    printf("********PRINT OUTPUT********************");
+    LOG_INFO("********PRINT OUTPUT********************");
     fprintf(out,"p sp %ld %ld \n", NV, NE/2);
     for (long i = 0; i < NV; i++) {
         long adj1 = vtxPtr[i];
@@ -186,7 +363,7 @@ void writeEdgeListToFile(graph *G, FILE* out) {
 }
 
 void displayGraphCharacteristics(graph *G) {
-    printf("Within displayGraphCharacteristics()\n");
+    LOG_INFO("Within displayGraphCharacteristics()\n");
     long    sum = 0, sum_sq = 0;
     double  average, avg_sq, variance, std_dev;
     long    maxDegree = 0;
@@ -216,20 +393,20 @@ void displayGraphCharacteristics(graph *G) {
         variance = avg_sq - (average*average);
         std_dev  = sqrt(variance);
         
-        printf("*******************************************\n");
-        printf("General Graph: Characteristics :\n");
-        printf("*******************************************\n");
-        printf("Number of vertices   :  %ld\n", NV);
-        printf("Number of edges      :  %ld\n", NE);
-        printf("Maximum out-degree is:  %ld\n", maxDegree);
-        printf("Average out-degree is:  %lf\n",average);
-        printf("Expected value of X^2:  %lf\n",avg_sq);
-        printf("Variance is          :  %lf\n",variance);
-        printf("Standard deviation   :  %lf\n",std_dev);
-        printf("Isolated vertices    :  %ld (%3.2lf%%)\n", isolated, ((double)isolated/tNV)*100);
-        printf("Degree-one vertices  :  %ld (%3.2lf%%)\n", degreeOne, ((double)degreeOne/tNV)*100);
-        printf("Density              :  %lf%%\n",((double)NE/(NV*NV))*100);
-        printf("*******************************************\n");
+        LOG_INFO("*******************************************\n");
+        LOG_INFO("General Graph: Characteristics :\n");
+        LOG_INFO("*******************************************\n");
+        LOG_INFO("Number of vertices   :  %ld\n", NV);
+        LOG_INFO("Number of edges      :  %ld\n", NE);
+        LOG_INFO("Maximum out-degree is:  %ld\n", maxDegree);
+        LOG_INFO("Average out-degree is:  %lf\n",average);
+        LOG_INFO("Expected value of X^2:  %lf\n",avg_sq);
+        LOG_INFO("Variance is          :  %lf\n",variance);
+        LOG_INFO("Standard deviation   :  %lf\n",std_dev);
+        LOG_INFO("Isolated vertices    :  %ld (%3.2lf%%)\n", isolated, ((double)isolated/tNV)*100);
+        LOG_INFO("Degree-one vertices  :  %ld (%3.2lf%%)\n", degreeOne, ((double)degreeOne/tNV)*100);
+        LOG_INFO("Density              :  %lf%%\n",((double)NE/(NV*NV))*100);
+        LOG_INFO("*******************************************\n");
         
     }//End of nonbipartite graph
     else { //Bipartite graph
@@ -251,21 +428,21 @@ void displayGraphCharacteristics(graph *G) {
         variance = avg_sq - (average*average);
         std_dev  = sqrt(variance);
         
-        printf("*******************************************\n");
-        printf("Bipartite Graph: Characteristics of S:\n");
-        printf("*******************************************\n");
-        printf("Number of S vertices :  %ld\n", NS);
-        printf("Number of T vertices :  %ld\n", NT);
-        printf("Number of edges      :  %ld\n", NE);
-        printf("Maximum out-degree is:  %ld\n", maxDegree);
-        printf("Average out-degree is:  %lf\n",average);
-        printf("Expected value of X^2:  %lf\n",avg_sq);
-        printf("Variance is          :  %lf\n",variance);
-        printf("Standard deviation   :  %lf\n",std_dev);
-        printf("Isolated (S)vertices :  %ld (%3.2lf%%)\n", isolated, ((double)isolated/NS)*100);
-        printf("Degree-one vertices  :  %ld (%3.2lf%%)\n", degreeOne, ((double)degreeOne/tNV)*100);
-        printf("Density              :  %lf%%\n",((double)NE/(NS*NS))*100);
-        printf("*******************************************\n");
+        LOG_INFO("*******************************************\n");
+        LOG_INFO("Bipartite Graph: Characteristics of S:\n");
+        LOG_INFO("*******************************************\n");
+        LOG_INFO("Number of S vertices :  %ld\n", NS);
+        LOG_INFO("Number of T vertices :  %ld\n", NT);
+        LOG_INFO("Number of edges      :  %ld\n", NE);
+        LOG_INFO("Maximum out-degree is:  %ld\n", maxDegree);
+        LOG_INFO("Average out-degree is:  %lf\n",average);
+        LOG_INFO("Expected value of X^2:  %lf\n",avg_sq);
+        LOG_INFO("Variance is          :  %lf\n",variance);
+        LOG_INFO("Standard deviation   :  %lf\n",std_dev);
+        LOG_INFO("Isolated (S)vertices :  %ld (%3.2lf%%)\n", isolated, ((double)isolated/NS)*100);
+        LOG_INFO("Degree-one vertices  :  %ld (%3.2lf%%)\n", degreeOne, ((double)degreeOne/tNV)*100);
+        LOG_INFO("Density              :  %lf%%\n",((double)NE/(NS*NS))*100);
+        LOG_INFO("*******************************************\n");
         
         sum = 0;
         sum_sq = 0;
@@ -289,20 +466,20 @@ void displayGraphCharacteristics(graph *G) {
         variance = avg_sq - (average*average);
         std_dev  = sqrt(variance);
         
-        printf("Bipartite Graph: Characteristics of T:\n");
-        printf("*******************************************\n");
-        printf("Number of T vertices :  %ld\n", NT);
-        printf("Number of S vertices :  %ld\n", NS);
-        printf("Number of edges      :  %ld\n", NE);
-        printf("Maximum out-degree is:  %ld\n", maxDegree);
-        printf("Average out-degree is:  %lf\n",average);
-        printf("Expected value of X^2:  %lf\n",avg_sq);
-        printf("Variance is          :  %lf\n",variance);
-        printf("Standard deviation   :  %lf\n",std_dev);
-        printf("Isolated (T)vertices :  %ld (%3.2lf%%)\n", isolated, ((double)isolated/NT)*100);
-        printf("Degree-one vertices  :  %ld (%3.2lf%%)\n", degreeOne, ((double)degreeOne/tNV)*100);
-        printf("Density              :  %lf%%\n",((double)NE/(NT*NT))*100);
-        printf("*******************************************\n");
+        LOG_INFO("Bipartite Graph: Characteristics of T:\n");
+        LOG_INFO("*******************************************\n");
+        LOG_INFO("Number of T vertices :  %ld\n", NT);
+        LOG_INFO("Number of S vertices :  %ld\n", NS);
+        LOG_INFO("Number of edges      :  %ld\n", NE);
+        LOG_INFO("Maximum out-degree is:  %ld\n", maxDegree);
+        LOG_INFO("Average out-degree is:  %lf\n",average);
+        LOG_INFO("Expected value of X^2:  %lf\n",avg_sq);
+        LOG_INFO("Variance is          :  %lf\n",variance);
+        LOG_INFO("Standard deviation   :  %lf\n",std_dev);
+        LOG_INFO("Isolated (T)vertices :  %ld (%3.2lf%%)\n", isolated, ((double)isolated/NT)*100);
+        LOG_INFO("Degree-one vertices  :  %ld (%3.2lf%%)\n", degreeOne, ((double)degreeOne/tNV)*100);
+        LOG_INFO("Density              :  %lf%%\n",((double)NE/(NT*NT))*100);
+        LOG_INFO("*******************************************\n");
     }//End of bipartite graph
 }
 
@@ -310,7 +487,7 @@ void displayGraphCharacteristics(graph *G) {
 //Convert a directed graph into an undirected graph:
 //Parse through the directed graph and add edges in both directions
 graph * convertDirected2Undirected(graph *G) {
-    printf("Within convertDirected2Undirected()\n");
+    LOG_INFO("Within convertDirected2Undirected()\n");
     int nthreads;
 #pragma omp parallel
     {
@@ -323,7 +500,7 @@ graph * convertDirected2Undirected(graph *G) {
     long NEdge    = G->numEdges;       //Returns the correct number of edges (not twice)
     long *verPtr  = G->edgeListPtrs;   //Vertex Pointer: pointers to endV
     edge *verInd  = G->edgeList;       //Vertex Index: destination id of an edge (src -> dest)
-    printf("N= %ld  NE=%ld\n", NVer, NEdge);
+    LOG_INFO("N= %ld  NE=%ld\n", NVer, NEdge);
     
     long *degrees = (long *) malloc ((NVer+1) * sizeof(long));
     assert(degrees != NULL);
@@ -350,10 +527,10 @@ graph * convertDirected2Undirected(graph *G) {
     }
     //Sanity check:
     if(degrees[NVer] != 2*m) {
-        printf("Number of edges added is not correct (%ld, %ld)\n", degrees[NVer], 2*m);
+        LOG_INFO("Number of edges added is not correct (%ld, %ld)\n", degrees[NVer], 2*m);
         exit(1);
     }
-    printf("Done building pointer array\n");
+    LOG_INFO("Done building pointer array\n");
     
     //Build CSR for Undirected graph:
     long* counter = (long *) malloc (NVer * sizeof(long));
@@ -378,7 +555,7 @@ graph * convertDirected2Undirected(graph *G) {
             //Add edge v --> w
             long location = degrees[v] + __sync_fetch_and_add(&counter[v], 1);
             if (location >= 2*m) {
-                printf("location is out of bound: %ld \n", location);
+                LOG_INFO("location is out of bound: %ld \n", location);
                 exit(1);
             }
             eList[location].head   = v;
@@ -388,7 +565,7 @@ graph * convertDirected2Undirected(graph *G) {
             //Add edge w --> v
             location = degrees[w] + __sync_fetch_and_add(&counter[w], 1);
             if (location >= 2*m) {
-                printf("location is out of bound: %ld \n", location);
+                LOG_INFO("location is out of bound: %ld \n", location);
                 exit(1);
             }
             eList[location].head   = w;
@@ -414,7 +591,7 @@ graph * convertDirected2Undirected(graph *G) {
 
 
 long removeEdges(long NV, long NE, edge *edgeList) {
-    printf("Within removeEdges()\n");
+    LOG_INFO("Within removeEdges()\n");
     long NGE = 0;
     long *head = (long *) malloc(NV * sizeof(long));     /* head of linked list points to an edge */
     long *next = (long *) malloc(NE * sizeof(long));     /* ptr to next edge in linked list       */
@@ -456,10 +633,10 @@ long removeEdges(long NV, long NE, edge *edgeList) {
             next[i] = next[k];
         }
     }
-    printf("About to free memory\n");
+    LOG_INFO("About to free memory\n");
     free(head);
     free(next);
-    printf("Exiting removeEdges()\n");
+    LOG_INFO("Exiting removeEdges()\n");
     return NGE;
 }//End of removeEdges()
 
@@ -538,8 +715,8 @@ void SortNodeEdgesByIndex(long NV, edge *list1, edge *list2, long *ptrs) {
 //C = Community assignments for each vertex stored in an order
 //old2NewMap = Stores the output of this routine
 void buildOld2NewMap(long N, long *C, long *commIndex) {
-    printf("Within buildOld2NewMap(%ld) function...\n", N);
-    printf("WARNING: Assumes that communities are numbered contiguously\n");
+    LOG_INFO("Within buildOld2NewMap(%ld) function...\n", N);
+    LOG_INFO("WARNING: Assumes that communities are numbered contiguously\n");
     assert(N > 0);
     //Compute number of communities:
     //Assume zero is a valid community id
@@ -555,17 +732,17 @@ void buildOld2NewMap(long N, long *C, long *commIndex) {
             nC = C[i];
         }
     }
-    printf("Largest community id observed: %ld\n", nC);
+    LOG_INFO("Largest community id observed: %ld\n", nC);
     if(isZero) {
-        printf("Zero is a valid community id\n");
+        LOG_INFO("Zero is a valid community id\n");
         nC++;
     }
     if(isNegative) {
-        printf("Some vertices have not been assigned communities\n");
+        LOG_INFO("Some vertices have not been assigned communities\n");
         nC++; //Place to store all the unassigned vertices
     }
     assert(nC>0);
-    printf("Number of unique communities in C= %d\n", nC);
+    LOG_INFO("Number of unique communities in C= %d\n", nC);
     
     //////////STEP 1: Create a CSR-like datastructure for communities in C
     long * commPtr = (long *) malloc ((nC+1) * sizeof(long)); assert(commPtr != 0);
@@ -592,9 +769,7 @@ void buildOld2NewMap(long N, long *C, long *commIndex) {
         }
     }//End of for(i)
     //Prefix sum:
-    for(long i=0; i<nC; i++) {
-        commPtr[i+1] += commPtr[i];
-    }
+    parallelInclusiveScan(commPtr, nC+1);
     //Group vertices with the same community in an order
 #pragma omp parallel for
     for (long i=0; i<N; i++) {
@@ -612,7 +787,7 @@ void buildOld2NewMap(long N, long *C, long *commIndex) {
         commIndex[Where] = i; //The vertex id
         }
     }
-    printf("Done building structure for C...\n");
+    LOG_INFO("Done building structure for C...\n");
     
     //////////STEP 2: Create the old2New map:
     //This step will now be handled outside the routine
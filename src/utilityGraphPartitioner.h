@@ -124,15 +124,15 @@ extern "C" {
 //METIS Graph Partitioner:
 void MetisGraphPartitioner( graph *G, long *VertexPartitioning, int numParts ) {
 
-  printf("Within MetisGraphPartitioner(): \n");
-  printf("Number of partitions requested: %ld\n", numParts);
+  LOG_DEBUG("Within MetisGraphPartitioner(): \n");
+  LOG_DEBUG("Number of partitions requested: %ld\n", numParts);
   
   //Get the iterators for the graph:
   long   NV        = G->numVertices;  
   long   NE        = G->numEdges;
   long   *vtxPtr   = G->edgeListPtrs;
   edge   *vtxInd   = G->edgeList;  
-  printf("|V|= %ld, |E|= %ld \n", NV, NE);
+  LOG_DEBUG("|V|= %ld, |E|= %ld \n", NV, NE);
 
   idx_t nvtxs = (idx_t) NV;
   idx_t *xadj = (idx_t *) malloc ((NV+1) * sizeof(idx_t));
@@ -179,12 +179,12 @@ void MetisGraphPartitioner( graph *G, long *VertexPartitioning, int numParts ) {
 		                      &nparts, NULL, NULL, options, &objval, part);
 
   if(returnVal == METIS_OK)
-     printf("Edge cut: %ld\n", objval);
+     LOG_DEBUG("Edge cut: %ld\n", objval);
   else {
      if(returnVal == METIS_ERROR_MEMORY)
-        printf("Metis could not allocate memory.\n");
+        LOG_ERROR("Metis could not allocate memory.\n");
      else 
-        printf("Metis error: %ld\n", returnVal);
+        LOG_DEBUG("Metis error: %ld\n", returnVal);
   }
 
 #pragma omp parallel for
@@ -195,7 +195,7 @@ void MetisGraphPartitioner( graph *G, long *VertexPartitioning, int numParts ) {
   //Cleaup:
   free(xadj); free(adjncy); free(adjwgt);
   free(part);
-  printf("Returning back from Metis\n");
+  LOG_DEBUG("Returning back from Metis\n");
 }
 
 #endif
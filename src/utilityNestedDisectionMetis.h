@@ -95,14 +95,14 @@ using namespace std;
 //METIS Graph Partitioner:
 void MetisNDReorder( graph *G, long *old2NewMap ) {
     
-    printf("Within MetisNDReorder(): \n");
+    LOG_DEBUG("Within MetisNDReorder(): \n");
     
     //Get the iterators for the graph:
     long   NV        = G->numVertices;
     long   NE        = G->numEdges;
     long   *vtxPtr   = G->edgeListPtrs;
     edge   *vtxInd   = G->edgeList;
-    printf("|V|= %ld, |E|= %ld \n", NV, NE);
+    LOG_DEBUG("|V|= %ld, |E|= %ld \n", NV, NE);
     int status=0;
     
     idx_t nvtxs = (idx_t) NV;
@@ -156,14 +156,14 @@ void MetisNDReorder( graph *G, long *old2NewMap ) {
     status = METIS_NodeND(&nvtxs, xadj, adjncy, NULL, options, perm, iperm);
     
     if(status == METIS_OK)
-        printf("Nested dissection returned correctly. Will store the permutations in vectors perm and iperm.\n");
+        LOG_DEBUG("Nested dissection returned correctly. Will store the permutations in vectors perm and iperm.\n");
     else {
         if(status == METIS_ERROR_MEMORY)
-            printf("Metis could not allocate memory.\n");
+            LOG_ERROR("Metis could not allocate memory.\n");
         else if(status == METIS_ERROR_INPUT)
-            printf("Metis had issues with input.\n");
+            LOG_DEBUG("Metis had issues with input.\n");
         else
-            printf("Some other Metis error: %ld\n", status);
+            LOG_DEBUG("Some other Metis error: %ld\n", status);
     }
     
 #pragma omp parallel for
@@ -174,7 +174,7 @@ void MetisNDReorder( graph *G, long *old2NewMap ) {
     //Cleaup:
     free(xadj); free(adjncy); free(adjwgt);
     free(perm); free(iperm);
-    printf("Returning back from Metis\n");
+    LOG_DEBUG("Returning back from Metis\n");
 }
 
 #endif
@@ -125,7 +125,7 @@ void mergeSort(edge *arr, long l, long r) {
 } //End of mergeSort()
 
 void SortNeighborListUsingInsertionAndMergeSort(graph *G) {
-    printf("Within SortNeighborListUsingInsertionAndMergeSort()\n");
+    LOG_DEBUG("Within SortNeighborListUsingInsertionAndMergeSort()\n");
     double time1=0, time2=0;
     //Get the iterators for the graph:
     long NVer     = G->numVertices;
@@ -163,7 +163,7 @@ void SortNeighborListUsingInsertionAndMergeSort(graph *G) {
 
 //WARNING: Assume that the neighbor lists are sorted
 double* computeEdgeSimilarityMetrics(graph *G) {
-    printf("Within computeEdgeSimilarityMetrics()\n");
+    LOG_DEBUG("Within computeEdgeSimilarityMetrics()\n");
     double time1=0, time2=0;
     //Get the iterators for the graph:
     long NVer     = G->numVertices;
@@ -218,7 +218,7 @@ double* computeEdgeSimilarityMetrics(graph *G) {
         }//End of for(i)
     }//End of for(v)
     time2 = omp_get_wtime();
-    printf("Time to compute similarities: %9.6lf sec.\n", time2 - time1);
+    LOG_DEBUG("Time to compute similarities: %9.6lf sec.\n", time2 - time1);
     
     return(simWeights);
 }
@@ -0,0 +1,165 @@
+#include "defs.h"
+#include "text_parser.h"
+#include <algorithm>
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+//Bytes of text per chunk: large enough to amortize scheduling, small enough
+//that dynamic scheduling balances lines of very different lengths
+#define TextChunkSize  (8L << 20)
+
+//Map the file privately: pages are shared with the page cache, and with other
+//processes that cluster the same graph, until they are written to (the full-sync
+//kernels sort adjacency lists of CSR files in place). Writes are never carried to
+//the file. Without mmap (Windows), or for an empty file, the file is read into
+//memory.
+//Return: NULL if the file cannot be read
+char* mapInputFile(const char *fileName, size_t *length, bool *mapped) {
+#ifdef O_BINARY
+  int fd = open(fileName, O_RDONLY | O_BINARY);
+#else
+  int fd = open(fileName, O_RDONLY);
+#endif
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return NULL;
+  }
+  *length = (size_t) st.st_size;
+  char *base = NULL;
+#ifndef _WIN32
+  if (*length > 0) {
+    void *addr = mmap(NULL, *length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      base = (char *) addr;
+      *mapped = true;
+    }
+  }
+#endif
+  if (base == NULL) {
+    base = (char *) malloc(*length + 1); assert(base != NULL);
+    size_t done = 0;
+    while (done < *length) {
+      ssize_t n = read(fd, base + done, *length - done);
+      if (n <= 0)
+        break;
+      done += (size_t) n;
+    }
+    if (done < *length) {
+      free(base);
+      base = NULL;
+    }
+    *mapped = false;
+  }
+  close(fd);
+  return base;
+}//End of mapInputFile()
+
+void unmapInputFile(char *base, size_t length, bool mapped) {
+#ifndef _WIN32
+  if (mapped) {
+    munmap(base, length);
+    return;
+  }
+#endif
+  free(base);
+}//End of unmapInputFile()
+
+//Bytes of temporary data a parser may hold besides the graph; 0 for a quarter
+//of the physical memory
+static long ingestLimit = 0;
+
+//Return: the previous limit
+long setIngestMemoryLimit(long bytes) {
+  long previous = ingestLimit;
+  ingestLimit = (bytes > 0) ? bytes : 0;
+  return previous;
+}
+
+long ingestMemoryLimit() {
+  if (ingestLimit > 0)
+    return ingestLimit;
+#ifdef _SC_PHYS_PAGES
+  long pages = sysconf(_SC_PHYS_PAGES), pageSize = sysconf(_SC_PAGE_SIZE);
+  if ((pages > 0) && (pageSize > 0))
+    return (long) ((double) pages * pageSize / 4);
+#endif
+  return 1L << 30;
+}
+
+//Enough chunks for every thread to get several, for load balance
+long numTextChunks(const char *begin, const char *end) {
+  long numChunks = (long) ((end - begin) / TextChunkSize) + 1;
+  return std::max(numChunks, 4L * omp_get_max_threads());
+}
+
+void splitTextChunks(const char *begin, const char *end, long numChunks, const char **starts) {
+  long length = (long) (end - begin);
+  starts[0] = begin;
+  starts[numChunks] = end;
+#pragma omp parallel for
+  for (long c=1; c<numChunks; c++) {
+    const char *p = begin + (long) ((double) length * c / numChunks);
+    if ((p > begin) && (p[-1] != '\n')) { //Move to the start of the next line
+      p = endOfLine(p, end);
+      if (p < end)
+        p++;
+    }
+    starts[c] = p; //Equal to the next start if a long line covers both
+  }
+}//End of splitTextChunks()
+
+//Number of lines, including a last line without a newline
+long countTextLines(const char *begin, const char *end) {
+  long numLines = 0;
+  const char *p = begin;
+  while (p < end) {
+    const char *nl = (const char *) memchr(p, '\n', end - p);
+    if (nl == NULL)
+      return numLines + 1;
+    numLines++;
+    p = nl + 1;
+  }
+  return numLines;
+}//End of countTextLines()
+
+//Split [begin, end) into chunks and count the lines of every chunk in parallel
+void splitTextLines(const char *begin, const char *end, textChunks *chunks) {
+  long numChunks = numTextChunks(begin, end);
+  chunks->numChunks = numChunks;
+  chunks->starts = (const char **) malloc ((numChunks+1) * sizeof(const char *));
+  assert(chunks->starts != 0);
+  chunks->firstLine = (long *) malloc ((numChunks+1) * sizeof(long)); assert(chunks->firstLine != 0);
+  splitTextChunks(begin, end, numChunks, chunks->starts);
+  chunks->firstLine[0] = 0;
+#pragma omp parallel for schedule(dynamic)
+  for (long c=0; c<numChunks; c++)
+    chunks->firstLine[c+1] = countTextLines(chunks->starts[c], chunks->starts[c+1]);
+  for (long c=0; c<numChunks; c++)
+    chunks->firstLine[c+1] += chunks->firstLine[c]; //Prefix sum: lines before each chunk
+}//End of splitTextLines()
+
+void freeTextChunks(textChunks *chunks) {
+  free(chunks->starts);
+  free(chunks->firstLine);
+}
+
+//Numbers the fast scanner does not handle, through a NUL terminated copy
+double scanDoubleSlow(const char *p, const char *end, const char **stop) {
+  char token[64];
+  long n = 0;
+  while ((p + n < end) && (n < 63) && !isFieldSeparator(p[n])) {
+    token[n] = p[n];
+    n++;
+  }
+  token[n] = '\0';
+  char *tokenEnd;
+  double value = strtod(token, &tokenEnd);
+  *stop = p + (tokenEnd - token);
+  return value;
+}//End of scanDoubleSlow()
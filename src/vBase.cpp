@@ -6,7 +6,7 @@
 int vBaseRedistribution(graph* G, int* vtxColor, int ncolors, int type)
 {
 #ifdef PRINT_DETAILED_STATS_
-  printf("Vertex base redistribution\n");
+  LOG_DEBUG("Vertex base redistribution\n");
 #endif
 	
   double time1=0, time2=0, totalTime=0;
@@ -17,19 +17,14 @@ int vBaseRedistribution(graph* G, int* vtxColor, int ncolors, int type)
   edge *verInd = G->edgeList;       //Vertex Index: destination id of an edge (src -> dest)
 
 #ifdef PRINT_DETAILED_STATS_
-  printf("Vertices: %ld  Edges: %ld\n", NVer, NEdge);
+  LOG_DEBUG("Vertices: %ld  Edges: %ld\n", NVer, NEdge);
 #endif
 
-  //Build a vector of random numbers
-  double *randValues = (double*) malloc (NVer * sizeof(double));
-  assert(randValues != 0);
-  generateRandomNumbers(randValues, NVer);
-
 	long *Q    = (long *) malloc (NVer * sizeof(long)); assert(Q != 0);
   long *Qtmp = (long *) malloc (NVer * sizeof(long)); assert(Qtmp != 0);
   long *Qswap;    
   if( (Q == NULL) || (Qtmp == NULL) ) {
-    printf("Not enough memory to allocate for the two queues \n");
+    LOG_ERROR("Not enough memory to allocate for the two queues \n");
     exit(1);
   }
 	
@@ -85,7 +80,7 @@ int vBaseRedistribution(graph* G, int* vtxColor, int ncolors, int type)
 			overSize[ci]= true;
 
 	/* Begining of Redistribution */
-	std::cout << "VR start "<< std::endl;
+	LOG_DEBUG("VR start \n");
 
 
 	// Coloring Main Loop
@@ -108,7 +103,7 @@ int vBaseRedistribution(graph* G, int* vtxColor, int ncolors, int type)
 			int permissable = 0;
 			
 			if(type == 0){	// First Fit
-				for (myColor=0; myColor<=ncolors; myColor++) {
+				for (myColor=0; myColor<ncolors; myColor++) {
 					if ( (mark[myColor] == false) && (freq[myColor]<avg) && (overSize[myColor]!= true))
 						break;
 				}
@@ -142,7 +137,7 @@ int vBaseRedistribution(graph* G, int* vtxColor, int ncolors, int type)
 		#pragma omp parallel for
 		for (long Qi=0; Qi<QTail; Qi++) {
 			long v = Q[Qi]; //Q.pop_front();
-			distanceOneConfResolution(G, v, vtxColor, randValues, &QtmpTail, Qtmp, freq, 1);
+			distanceOneConfResolution(G, v, vtxColor, &QtmpTail, Qtmp, freq, 1);
 		} //End of outer for loop: for each vertex
   
 		time2  = omp_get_wtime() - time2;
@@ -151,8 +146,8 @@ int vBaseRedistribution(graph* G, int* vtxColor, int ncolors, int type)
 		nLoops++;
 
 #ifdef PRINT_DETAILED_STATS_
-    printf("Num conflicts      : %ld \n", QtmpTail);
-    printf("Time for detection : %lf sec\n", time2);
+    LOG_DEBUG("Num conflicts      : %ld \n", QtmpTail);
+    LOG_DEBUG("Time for detection : %lf sec\n", time2);
 #endif
 
     //Swap the two queues:
@@ -165,5 +160,11 @@ int vBaseRedistribution(graph* G, int* vtxColor, int ncolors, int type)
 
 	//Sanity check;
 	distanceOneChecked(G,NVer,vtxColor);
+
+	//Cleanup
+	free(Q);
+	free(Qtmp);
+	free(baseColors);
+	return ncolors;
 }
 
@@ -41,6 +41,8 @@
 
 #include "defs.h"
 #include "basic_comm.h"
+#include "basic_util.h"
+#include "parallel_scan.h"
 using namespace std;
 
 long vertexFollowing(graph *G, long *C)
@@ -177,9 +179,7 @@ double buildNewGraphVF(graph *Gin, graph *Gout, long *C, long numUniqueClusters)
 	}//End of for(j)
   }//End of for(i)  
   //Prefix sum:
-  for(long i=0; i<NV_out; i++) {
-	vtxPtrOut[i+1] += vtxPtrOut[i];
-  }
+  parallelInclusiveScan(vtxPtrOut, NV_out+1);
   
   time2 = omp_get_wtime();
   TotTime += (time2-time1);
@@ -196,6 +196,7 @@ double buildNewGraphVF(graph *Gin, graph *Gout, long *C, long numUniqueClusters)
   long realEdges  = NE_out + NE_self; //Self-loops appear once, others appear twice
   edge *vtxIndOut = (edge *) malloc (numEdges * sizeof(edge));
   assert (vtxIndOut != 0);
+  firstTouchEdges(vtxIndOut, vtxPtrOut, NV_out); //Edges are added to both endpoints below
   long *Added = (long *) malloc (NV_out * sizeof(long)); //Keep track of what got added
   assert (Added != 0);
 